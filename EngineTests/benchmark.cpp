@@ -0,0 +1,497 @@
+//-------------------------------------------------------------------------------------
+// benchmark.cpp
+//
+// Benchmarks of the engine kernels, each compared with the implementation it
+// replaced. Not run by ctest, build with BUILD_BENCHMARKS. Returns non-zero
+// when an output differs from the one of the replaced implementation.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//-------------------------------------------------------------------------------------
+
+#include "UVAtlas.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "isomap.h"
+#include "maxheap.hpp"
+
+using namespace DirectX;
+using namespace Isochart;
+
+namespace
+{
+    // Runs work repeatedly for about 0.2 second and returns the fastest call,
+    // in microseconds. prepare runs before each call and is not timed.
+    double TimeCall(const std::function<void()> &prepare, const std::function<void()> &work)
+    {
+        double fBest = 1e30;
+        double fTotal = 0;
+        for (size_t i = 0; i < 3 || fTotal < 2e5; i++)
+        {
+            prepare();
+            auto start = std::chrono::steady_clock::now();
+            work();
+            double fTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            fBest = std::min(fBest, fTime);
+            fTotal += fTime;
+        }
+        return fBest;
+    }
+
+    //---------------------------------------------------------------------------------
+    // CIsoMap::Init, double centering of the landmark distance matrix
+    //---------------------------------------------------------------------------------
+
+    // The centering before it was fused into two passes: square, average the
+    // columns, remove them, average the rows, remove them and scale, each in a
+    // pass over the matrix.
+    void CenterInSeparatePasses(size_t dwDim, float *pfMatrix, float *pfColumnAverage)
+    {
+        std::unique_ptr<float[]> average(new float[dwDim]);
+        float *pfAverage = average.get();
+
+        float *pRow = pfMatrix;
+        for (size_t i = 0; i < dwDim; i++)
+        {
+            for (size_t j = 0; j < dwDim; j++)
+            {
+                pRow[j] *= pRow[j];
+            }
+            pRow += dwDim;
+        }
+
+        for (size_t i = 0; i < dwDim; i++)
+        {
+            pfAverage[i] = 0;
+            for (size_t j = 0; j < dwDim; j++)
+            {
+                pfAverage[i] += pfMatrix[j * dwDim + i];
+            }
+            pfAverage[i] /= float(dwDim);
+        }
+        memcpy(pfColumnAverage, pfAverage, dwDim * sizeof(float));
+
+        pRow = pfMatrix;
+        for (size_t i = 0; i < dwDim; i++)
+        {
+            for (size_t j = 0; j < dwDim; j++)
+            {
+                pRow[j] -= pfAverage[j];
+            }
+            pRow += dwDim;
+        }
+
+        pRow = pfMatrix;
+        for (size_t i = 0; i < dwDim; i++)
+        {
+            pfAverage[i] = 0;
+            for (size_t j = 0; j < dwDim; j++)
+            {
+                pfAverage[i] += pRow[j];
+            }
+            pfAverage[i] /= float(dwDim);
+            pRow += dwDim;
+        }
+
+        pRow = pfMatrix;
+        for (size_t i = 0; i < dwDim; i++)
+        {
+            for (size_t j = 0; j < dwDim; j++)
+            {
+                pRow[j] -= pfAverage[i];
+            }
+            pRow += dwDim;
+        }
+
+        pRow = pfMatrix;
+        for (size_t i = 0; i < dwDim; i++)
+        {
+            for (size_t j = 0; j < dwDim; j++)
+            {
+                pRow[j] *= -0.5f;
+            }
+            pRow += dwDim;
+        }
+    }
+
+    // Distances between dwDim pseudo-random points of a unit cube
+    std::vector<float> CreateDistanceMatrix(size_t dwDim)
+    {
+        std::vector<float> points(dwDim * 3);
+        uint32_t seed = 12345;
+        for (auto &p : points)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            p = float(seed >> 8) / float(1u << 24);
+        }
+
+        std::vector<float> matrix(dwDim * dwDim);
+        for (size_t i = 0; i < dwDim; i++)
+        {
+            for (size_t j = 0; j < dwDim; j++)
+            {
+                float dx = points[i * 3] - points[j * 3];
+                float dy = points[i * 3 + 1] - points[j * 3 + 1];
+                float dz = points[i * 3 + 2] - points[j * 3 + 2];
+                matrix[i * dwDim + j] = sqrtf(dx * dx + dy * dy + dz * dz);
+            }
+        }
+        return matrix;
+    }
+
+    bool BenchmarkIsoMapInit(size_t maxThreadCount)
+    {
+        const UVAtlasExecutor executor = { maxThreadCount, nullptr };
+        static const size_t s_dims[] = { 25, 86, 250, 500, 1000, 2000 };
+
+        printf("CIsoMap::Init, %zu thread(s)\n", maxThreadCount);
+        printf("%8s %14s %14s %8s %s\n", "n", "old (us)", "new (us)", "speedup", "output");
+
+        bool bSucceeded = true;
+        for (size_t dwDim : s_dims)
+        {
+            std::vector<float> distance = CreateDistanceMatrix(dwDim);
+            std::vector<float> oldMatrix(distance.size());
+            std::vector<float> newMatrix(distance.size());
+            std::vector<float> oldAverage(dwDim);
+
+            double fOld = TimeCall(
+                [&]() { oldMatrix = distance; },
+                [&]() { CenterInSeparatePasses(dwDim, oldMatrix.data(), oldAverage.data()); });
+
+            CIsoMap isoMap;
+            HRESULT hr = S_OK;
+            double fNew = TimeCall(
+                [&]() { newMatrix = distance; isoMap.Clear(); },
+                [&]() { hr = isoMap.Init(dwDim, newMatrix.data(), &executor); });
+
+            bool bSame = SUCCEEDED(hr)
+                && memcmp(oldMatrix.data(), newMatrix.data(), distance.size() * sizeof(float)) == 0
+                && memcmp(oldAverage.data(), isoMap.GetAverageColumn(), dwDim * sizeof(float)) == 0;
+            bSucceeded = bSucceeded && bSame;
+
+            printf("%8zu %14.1f %14.1f %7.2fx %s\n", dwDim, fOld, fNew, fOld / fNew, bSame ? "identical" : "DIFFERENT");
+        }
+        return bSucceeded;
+    }
+
+    //---------------------------------------------------------------------------------
+    // Shortest path queries on the chart adjacency
+    //---------------------------------------------------------------------------------
+
+    // The adjacency as ISOCHARTVERTEX holds it: per-vertex lists of adjacent
+    // vertices and of edges, the edges in a separate array.
+    struct LISTEDGE
+    {
+        uint32_t dwVertexID[2];
+        float fLength;
+    };
+
+    struct LISTVERTEX
+    {
+        std::vector<uint32_t> vertAdjacent;
+        std::vector<uint32_t> edgeAdjacent;
+    };
+
+    // The adjacency as SHORTESTPATHTOPOLOGY holds it, in vertAdjacent order
+    struct FLATNEIGHBOR
+    {
+        uint32_t dwVertID;
+        float fLength;
+    };
+
+    struct ShortestPathMesh
+    {
+        std::vector<LISTVERTEX> verts;
+        std::vector<LISTEDGE> edges;
+        std::vector<uint32_t> rowStart;
+        std::vector<FLATNEIGHBOR> neighbors;
+    };
+
+    // A bumpy torus of n x n/2 vertices, whose regular rings give many
+    // vertices at equal distances
+    ShortestPathMesh CreateShortestPathMesh(uint32_t n)
+    {
+        uint32_t m = n / 2;
+        std::vector<float> positions;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            for (uint32_t j = 0; j < m; j++)
+            {
+                float u = 6.2831853f * float(i) / float(n);
+                float v = 6.2831853f * float(j) / float(m);
+                float r = 0.35f + 0.05f * sinf(7 * u) * sinf(5 * v);
+                positions.push_back((1 + r * cosf(v)) * cosf(u));
+                positions.push_back((1 + r * cosf(v)) * sinf(u));
+                positions.push_back(r * sinf(v));
+            }
+        }
+
+        ShortestPathMesh mesh;
+        mesh.verts.resize(size_t(n) * m);
+
+        std::map<std::pair<uint32_t, uint32_t>, uint32_t> edgeIDs;
+        auto addEdge = [&](uint32_t a, uint32_t b)
+            {
+                auto key = std::make_pair(std::min(a, b), std::max(a, b));
+                if (edgeIDs.count(key))
+                    return;
+
+                float dx = positions[a * 3] - positions[b * 3];
+                float dy = positions[a * 3 + 1] - positions[b * 3 + 1];
+                float dz = positions[a * 3 + 2] - positions[b * 3 + 2];
+                uint32_t dwEdgeID = static_cast<uint32_t>(mesh.edges.size());
+                mesh.edges.push_back({ { a, b }, sqrtf(dx * dx + dy * dy + dz * dz) });
+                edgeIDs[key] = dwEdgeID;
+
+                mesh.verts[a].edgeAdjacent.push_back(dwEdgeID);
+                mesh.verts[b].edgeAdjacent.push_back(dwEdgeID);
+            };
+
+        for (uint32_t i = 0; i < n; i++)
+        {
+            for (uint32_t j = 0; j < m; j++)
+            {
+                uint32_t a = i * m + j;
+                uint32_t b = ((i + 1) % n) * m + j;
+                uint32_t c = ((i + 1) % n) * m + (j + 1) % m;
+                uint32_t d = i * m + (j + 1) % m;
+                addEdge(a, b);
+                addEdge(b, c);
+                addEdge(a, c);
+                addEdge(c, d);
+                addEdge(d, a);
+            }
+        }
+
+        // vertAdjacent walks around the vertex, unlike edgeAdjacent which
+        // follows the creation of the edges
+        for (uint32_t i = 0; i < n; i++)
+        {
+            for (uint32_t j = 0; j < m; j++)
+            {
+                uint32_t ip = (i + 1) % n;
+                uint32_t im = (i + n - 1) % n;
+                uint32_t jp = (j + 1) % m;
+                uint32_t jm = (j + m - 1) % m;
+                mesh.verts[i * m + j].vertAdjacent = {
+                    ip * m + j, ip * m + jp, i * m + jp, im * m + j, im * m + jm, i * m + jm };
+            }
+        }
+
+        mesh.rowStart.push_back(0);
+        for (uint32_t i = 0; i < mesh.verts.size(); i++)
+        {
+            for (uint32_t dwAdjacentID : mesh.verts[i].vertAdjacent)
+            {
+                uint32_t dwEdgeID = edgeIDs[std::make_pair(std::min(i, dwAdjacentID), std::max(i, dwAdjacentID))];
+                mesh.neighbors.push_back({ dwAdjacentID, mesh.edges[dwEdgeID].fLength });
+            }
+            mesh.rowStart.push_back(static_cast<uint32_t>(mesh.neighbors.size()));
+        }
+        return mesh;
+    }
+
+    // The Dijkstra query before SHORTESTPATHTOPOLOGY: relax through
+    // edgeAdjacent and m_edges, update the heap through vertAdjacent, on
+    // CMaxHeap and an array of CMaxHeapItem.
+    void DijkstraOnLists(
+        const ShortestPathMesh &mesh,
+        uint32_t dwSourceVertID,
+        float *pfDistance,
+        uint32_t *pdwPrevious,
+        uint32_t *pdwSettleOrder)
+    {
+        size_t dwVertNumber = mesh.verts.size();
+        std::unique_ptr<bool[]> vertProcessed(new bool[dwVertNumber]);
+        std::unique_ptr<CMaxHeapItem<float, uint32_t>[]> heapItem(new CMaxHeapItem<float, uint32_t>[dwVertNumber]);
+        bool *pbVertProcessed = vertProcessed.get();
+        auto pHeapItem = heapItem.get();
+        memset(pbVertProcessed, 0, sizeof(bool) * dwVertNumber);
+
+        CMaxHeap<float, uint32_t> heap;
+        heap.resize(dwVertNumber);
+
+        for (size_t i = 0; i < dwVertNumber; i++)
+        {
+            pfDistance[i] = FLT_MAX;
+            pdwPrevious[i] = UINT32_MAX;
+        }
+
+        pbVertProcessed[dwSourceVertID] = true;
+        pfDistance[dwSourceVertID] = 0;
+        pHeapItem[dwSourceVertID].m_weight = 0;
+        pHeapItem[dwSourceVertID].m_data = dwSourceVertID;
+        heap.insert(pHeapItem + dwSourceVertID);
+
+        for (size_t i = 0; i < dwVertNumber; i++)
+        {
+            CMaxHeapItem<float, uint32_t> *pTop = heap.cutTop();
+            if (!pTop)
+                break;
+
+            uint32_t dwCurrentID = pTop->m_data;
+            const LISTVERTEX &vertex = mesh.verts[dwCurrentID];
+            pbVertProcessed[dwCurrentID] = true;
+            pdwSettleOrder[i] = dwCurrentID;
+
+            for (uint32_t dwEdgeID : vertex.edgeAdjacent)
+            {
+                const LISTEDGE &edge = mesh.edges[dwEdgeID];
+                uint32_t dwAdjacentID = (edge.dwVertexID[0] == dwCurrentID) ? edge.dwVertexID[1] : edge.dwVertexID[0];
+                if (!pbVertProcessed[dwAdjacentID] && pfDistance[dwAdjacentID] > pfDistance[dwCurrentID] + edge.fLength)
+                {
+                    pfDistance[dwAdjacentID] = pfDistance[dwCurrentID] + edge.fLength;
+                    pdwPrevious[dwAdjacentID] = dwCurrentID;
+                }
+            }
+
+            for (uint32_t dwAdjacentID : vertex.vertAdjacent)
+            {
+                if (pbVertProcessed[dwAdjacentID])
+                    continue;
+
+                if (pHeapItem[dwAdjacentID].isItemInHeap())
+                {
+                    heap.update(pHeapItem + dwAdjacentID, -pfDistance[dwAdjacentID]);
+                }
+                else
+                {
+                    pHeapItem[dwAdjacentID].m_data = dwAdjacentID;
+                    pHeapItem[dwAdjacentID].m_weight = -pfDistance[dwAdjacentID];
+                    heap.insert(pHeapItem + dwAdjacentID);
+                }
+            }
+        }
+    }
+
+    // The Dijkstra query of CIsochartMesh::CalculateDijkstraPathToVertex, on
+    // the flat adjacency and CMaxIndexHeap.
+    void DijkstraOnFlatAdjacency(
+        const ShortestPathMesh &mesh,
+        uint32_t dwSourceVertID,
+        float *pfDistance,
+        uint32_t *pdwPrevious,
+        uint32_t *pdwSettleOrder)
+    {
+        size_t dwVertNumber = mesh.verts.size();
+        const uint32_t *pdwRowStart = mesh.rowStart.data();
+        const FLATNEIGHBOR *pNeighbors = mesh.neighbors.data();
+
+        std::unique_ptr<bool[]> vertProcessed(new bool[dwVertNumber]);
+        bool *pbVertProcessed = vertProcessed.get();
+        memset(pbVertProcessed, 0, sizeof(bool) * dwVertNumber);
+
+        CMaxIndexHeap<float> heap;
+        heap.resize(dwVertNumber);
+
+        for (size_t i = 0; i < dwVertNumber; i++)
+        {
+            pfDistance[i] = FLT_MAX;
+            pdwPrevious[i] = UINT32_MAX;
+        }
+
+        pbVertProcessed[dwSourceVertID] = true;
+        pfDistance[dwSourceVertID] = 0;
+        heap.insert(dwSourceVertID, 0);
+
+        size_t dwSettled = 0;
+        uint32_t dwCurrentID = 0;
+        while (heap.cutTop(dwCurrentID))
+        {
+            pbVertProcessed[dwCurrentID] = true;
+            pdwSettleOrder[dwSettled++] = dwCurrentID;
+
+            const FLATNEIGHBOR *pRowBegin = pNeighbors + pdwRowStart[dwCurrentID];
+            const FLATNEIGHBOR *pRowEnd = pNeighbors + pdwRowStart[dwCurrentID + 1];
+            for (const FLATNEIGHBOR *pNeighbor = pRowBegin; pNeighbor < pRowEnd; pNeighbor++)
+            {
+                uint32_t dwAdjacentID = pNeighbor->dwVertID;
+                if (!pbVertProcessed[dwAdjacentID] && pfDistance[dwAdjacentID] > pfDistance[dwCurrentID] + pNeighbor->fLength)
+                {
+                    pfDistance[dwAdjacentID] = pfDistance[dwCurrentID] + pNeighbor->fLength;
+                    pdwPrevious[dwAdjacentID] = dwCurrentID;
+                }
+            }
+
+            for (const FLATNEIGHBOR *pNeighbor = pRowBegin; pNeighbor < pRowEnd; pNeighbor++)
+            {
+                uint32_t dwAdjacentID = pNeighbor->dwVertID;
+                if (pbVertProcessed[dwAdjacentID])
+                    continue;
+
+                if (heap.isItemInHeap(dwAdjacentID))
+                {
+                    heap.update(dwAdjacentID, -pfDistance[dwAdjacentID]);
+                }
+                else
+                {
+                    heap.insert(dwAdjacentID, -pfDistance[dwAdjacentID]);
+                }
+            }
+        }
+    }
+
+    bool BenchmarkShortestPath()
+    {
+        static const uint32_t s_rings[] = { 64, 180, 360, 720 };
+
+        printf("\nDijkstra query, per-vertex lists + CMaxHeap vs flat adjacency + CMaxIndexHeap\n");
+        printf("%8s %14s %14s %8s %s\n", "verts", "old (us)", "new (us)", "speedup", "output");
+
+        bool bSucceeded = true;
+        for (uint32_t n : s_rings)
+        {
+            ShortestPathMesh mesh = CreateShortestPathMesh(n);
+            size_t dwVertNumber = mesh.verts.size();
+            uint32_t dwSourceVertID = static_cast<uint32_t>(dwVertNumber / 3);
+
+            std::vector<float> oldDistance(dwVertNumber), newDistance(dwVertNumber);
+            std::vector<uint32_t> oldPrevious(dwVertNumber), newPrevious(dwVertNumber);
+            std::vector<uint32_t> oldOrder(dwVertNumber), newOrder(dwVertNumber);
+
+            double fOld = TimeCall(
+                []() {},
+                [&]() { DijkstraOnLists(mesh, dwSourceVertID, oldDistance.data(), oldPrevious.data(), oldOrder.data()); });
+            double fNew = TimeCall(
+                []() {},
+                [&]() { DijkstraOnFlatAdjacency(mesh, dwSourceVertID, newDistance.data(), newPrevious.data(), newOrder.data()); });
+
+            bool bSame = memcmp(oldDistance.data(), newDistance.data(), dwVertNumber * sizeof(float)) == 0
+                && oldPrevious == newPrevious
+                && oldOrder == newOrder;
+            bSucceeded = bSucceeded && bSame;
+
+            printf("%8zu %14.1f %14.1f %7.2fx %s\n", dwVertNumber, fOld, fNew, fOld / fNew, bSame ? "identical" : "DIFFERENT");
+        }
+        return bSucceeded;
+    }
+}
+
+// usage: uvatlasbench [maxThreadCount]
+int main(int argc, char *argv[])
+{
+    size_t maxThreadCount = (argc > 1) ? size_t(strtoul(argv[1], nullptr, 10)) : 1;
+
+    bool bSucceeded = BenchmarkIsoMapInit(maxThreadCount);
+    bSucceeded = BenchmarkShortestPath() && bSucceeded;
+
+    return bSucceeded ? 0 : 1;
+}
@@ -0,0 +1,471 @@
+//-------------------------------------------------------------------------------------
+// stress.cpp
+//
+// Multi-threaded stress test of the UVAtlas engine: concurrent UVAtlasCreate
+// calls, UVAtlasCreateAsync jobs with and without a job system, and batches
+// on a job system, all compared with a single-threaded run of the same mesh.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//-------------------------------------------------------------------------------------
+
+#include "UVAtlas.h"
+
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct TestMesh
+    {
+        const char *name;
+        std::vector<XMFLOAT3> positions;
+        std::vector<uint32_t> indices;
+        std::vector<uint32_t> adjacency;
+        std::vector<float> imt;
+    };
+
+    void GenerateAdjacency(TestMesh &mesh)
+    {
+        size_t nFaces = mesh.indices.size() / 3;
+        mesh.adjacency.assign(nFaces * 3, uint32_t(-1));
+
+        std::map<std::pair<uint32_t, uint32_t>, uint32_t> edges;
+        for (size_t f = 0; f < nFaces; f++)
+        {
+            for (size_t e = 0; e < 3; e++)
+            {
+                edges[{ mesh.indices[f * 3 + e], mesh.indices[f * 3 + (e + 1) % 3] }] = uint32_t(f);
+            }
+        }
+
+        for (size_t f = 0; f < nFaces; f++)
+        {
+            for (size_t e = 0; e < 3; e++)
+            {
+                auto it = edges.find({ mesh.indices[f * 3 + (e + 1) % 3], mesh.indices[f * 3 + e] });
+                if (it != edges.end())
+                {
+                    mesh.adjacency[f * 3 + e] = it->second;
+                }
+            }
+        }
+    }
+
+    // A closed mesh, cut into several charts
+    TestMesh CreateTorus(uint32_t n, uint32_t m)
+    {
+        TestMesh mesh;
+        mesh.name = "torus";
+        for (uint32_t i = 0; i < n; i++)
+        {
+            for (uint32_t j = 0; j < m; j++)
+            {
+                float u = 6.2831853f * float(i) / float(n);
+                float v = 6.2831853f * float(j) / float(m);
+                float r = 0.35f + 0.05f * sinf(7 * u) * sinf(5 * v);
+                mesh.positions.emplace_back(
+                    (1 + r * cosf(v)) * cosf(u),
+                    (1 + r * cosf(v)) * sinf(u),
+                    r * sinf(v));
+            }
+        }
+
+        for (uint32_t i = 0; i < n; i++)
+        {
+            for (uint32_t j = 0; j < m; j++)
+            {
+                uint32_t a = i * m + j;
+                uint32_t b = ((i + 1) % n) * m + j;
+                uint32_t c = ((i + 1) % n) * m + (j + 1) % m;
+                uint32_t d = i * m + (j + 1) % m;
+                mesh.indices.insert(mesh.indices.end(), { a, b, c, a, c, d });
+            }
+        }
+
+        GenerateAdjacency(mesh);
+        return mesh;
+    }
+
+    // An open mesh with a bump, with an IMT so the signal distance is used
+    TestMesh CreateBump(uint32_t n)
+    {
+        TestMesh mesh;
+        mesh.name = "bump";
+        for (uint32_t i = 0; i <= n; i++)
+        {
+            for (uint32_t j = 0; j <= n; j++)
+            {
+                float x = float(i) / float(n) - 0.5f;
+                float y = float(j) / float(n) - 0.5f;
+                mesh.positions.emplace_back(x, y, 0.6f * expf(-(x * x + y * y) * 20));
+            }
+        }
+
+        for (uint32_t i = 0; i < n; i++)
+        {
+            for (uint32_t j = 0; j < n; j++)
+            {
+                uint32_t a = i * (n + 1) + j;
+                uint32_t b = (i + 1) * (n + 1) + j;
+                mesh.indices.insert(mesh.indices.end(), { a, b, b + 1, a, b + 1, a + 1 });
+            }
+        }
+
+        size_t nFaces = mesh.indices.size() / 3;
+        mesh.imt.resize(nFaces * 3);
+        for (size_t f = 0; f < nFaces; f++)
+        {
+            float s = (f % 7) ? 1.f : 4.f;
+            mesh.imt[f * 3] = s;
+            mesh.imt[f * 3 + 1] = 0.1f;
+            mesh.imt[f * 3 + 2] = s;
+        }
+
+        GenerateAdjacency(mesh);
+        return mesh;
+    }
+
+    UVAtlasBatchMesh GetBatchMesh(const TestMesh &mesh)
+    {
+        UVAtlasBatchMesh batchMesh = {};
+        batchMesh.positions = mesh.positions.data();
+        batchMesh.nVerts = mesh.positions.size();
+        batchMesh.indices = mesh.indices.data();
+        batchMesh.indexFormat = DXGI_FORMAT_R32_UINT;
+        batchMesh.nFaces = mesh.indices.size() / 3;
+        batchMesh.maxChartNumber = 0;
+        batchMesh.maxStretch = 0.1667f;
+        batchMesh.width = 512;
+        batchMesh.height = 512;
+        batchMesh.gutter = 2.f;
+        batchMesh.adjacency = mesh.adjacency.data();
+        batchMesh.falseEdgeAdjacency = nullptr;
+        batchMesh.pIMTArray = mesh.imt.empty() ? nullptr : mesh.imt.data();
+        batchMesh.options = UVATLAS_DETERMINISTIC;
+        return batchMesh;
+    }
+
+    HRESULT CreateAtlas(const TestMesh &mesh, const UVAtlasExecutor &executor, UVAtlasBatchResult &result)
+    {
+        UVAtlasBatchMesh batchMesh = GetBatchMesh(mesh);
+        result.hr = UVAtlasCreate(
+            batchMesh.positions, batchMesh.nVerts,
+            batchMesh.indices, batchMesh.indexFormat, batchMesh.nFaces,
+            batchMesh.maxChartNumber, batchMesh.maxStretch,
+            batchMesh.width, batchMesh.height, batchMesh.gutter,
+            batchMesh.adjacency, batchMesh.falseEdgeAdjacency, batchMesh.pIMTArray,
+            nullptr, UVATLAS_DEFAULT_CALLBACK_FREQUENCY,
+            batchMesh.options,
+            result.vMeshOutVertexBuffer,
+            result.vMeshOutIndexBuffer,
+            &result.vFacePartitioning,
+            &result.vVertexRemapArray,
+            &result.maxStretchOut,
+            &result.numChartsOut,
+            &executor);
+        return result.hr;
+    }
+
+    bool IsSameResult(const UVAtlasBatchResult &a, const UVAtlasBatchResult &b)
+    {
+        if (a.hr != b.hr
+            || a.numChartsOut != b.numChartsOut
+            || a.vMeshOutVertexBuffer.size() != b.vMeshOutVertexBuffer.size()
+            || a.vMeshOutIndexBuffer != b.vMeshOutIndexBuffer
+            || a.vFacePartitioning != b.vFacePartitioning
+            || a.vVertexRemapArray != b.vVertexRemapArray)
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < a.vMeshOutVertexBuffer.size(); i++)
+        {
+            if (memcmp(&a.vMeshOutVertexBuffer[i], &b.vMeshOutVertexBuffer[i], sizeof(UVAtlasVertex)) != 0)
+                return false;
+        }
+        return true;
+    }
+
+    // A minimal job system for UVAtlasExecutor::submit: a queue served by a
+    // fixed number of threads.
+    class JobSystem
+    {
+    public:
+        explicit JobSystem(size_t threadCount) : m_bExit(false)
+        {
+            for (size_t i = 0; i < threadCount; i++)
+            {
+                m_threads.emplace_back([this]() { Work(); });
+            }
+        }
+
+        ~JobSystem()
+        {
+            {
+                std::lock_guard<std::mutex> guard(m_lock);
+                m_bExit = true;
+            }
+            m_signal.notify_all();
+            for (auto &t : m_threads)
+            {
+                t.join();
+            }
+        }
+
+        JobSystem(const JobSystem &) = delete;
+        JobSystem &operator=(const JobSystem &) = delete;
+
+        void Submit(std::function<void()> work)
+        {
+            {
+                std::lock_guard<std::mutex> guard(m_lock);
+                m_queue.push_back(std::move(work));
+            }
+            m_signal.notify_one();
+        }
+
+    private:
+        void Work()
+        {
+            for (;;)
+            {
+                std::function<void()> work;
+                {
+                    std::unique_lock<std::mutex> guard(m_lock);
+                    m_signal.wait(guard, [this]() { return m_bExit || !m_queue.empty(); });
+                    if (m_queue.empty())
+                        return;
+                    work = std::move(m_queue.front());
+                    m_queue.pop_front();
+                }
+                work();
+            }
+        }
+
+        std::mutex m_lock;
+        std::condition_variable m_signal;
+        std::deque<std::function<void()>> m_queue;
+        std::vector<std::thread> m_threads;
+        bool m_bExit;
+    };
+}
+
+int main(int argc, char *argv[])
+{
+    size_t jobCount = (argc > 1) ? size_t(strtoul(argv[1], nullptr, 10)) : 4;
+    if (jobCount < 1)
+        jobCount = 1;
+
+    std::vector<TestMesh> meshes;
+    meshes.push_back(CreateTorus(40, 20));
+    meshes.push_back(CreateBump(24));
+
+    // Single-threaded reference results
+    const UVAtlasExecutor serial = { 1, nullptr };
+    std::vector<UVAtlasBatchResult> references(meshes.size());
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        if (FAILED(CreateAtlas(meshes[i], serial, references[i])))
+        {
+            printf("FAILED: %s reference run failed (%08X)\n", meshes[i].name, static_cast<unsigned int>(references[i].hr));
+            return 1;
+        }
+    }
+
+    size_t failures = 0;
+    auto check = [&](const char *test, size_t job, const UVAtlasBatchResult &result)
+        {
+            const TestMesh &mesh = meshes[job % meshes.size()];
+            if (!IsSameResult(result, references[job % meshes.size()]))
+            {
+                printf("FAILED: %s job %zu (%s): hr %08X differs from the single-threaded run\n",
+                    test, job, mesh.name, static_cast<unsigned int>(result.hr));
+                failures++;
+            }
+        };
+
+    // 1. Concurrent blocking calls, each with its own worker threads
+    {
+        const UVAtlasExecutor executor = { 2, nullptr };
+        std::vector<UVAtlasBatchResult> results(jobCount);
+        std::vector<std::thread> threads;
+        for (size_t j = 0; j < jobCount; j++)
+        {
+            threads.emplace_back([&, j]()
+                {
+                    CreateAtlas(meshes[j % meshes.size()], executor, results[j]);
+                });
+        }
+        for (auto &t : threads)
+        {
+            t.join();
+        }
+        for (size_t j = 0; j < jobCount; j++)
+        {
+            check("UVAtlasCreate", j, results[j]);
+        }
+    }
+
+    // 2. Asynchronous jobs on threads created by the library, and on a shared job system
+    {
+        JobSystem jobSystem(3);
+        UVAtlasExecutor executors[2] = {};
+        executors[0].maxThreadCount = 2;
+        executors[1].maxThreadCount = 2;
+        executors[1].submit = [&jobSystem](std::function<void __cdecl()> work)
+            {
+                jobSystem.Submit(std::move(work));
+            };
+
+        std::mutex completionLock;
+        size_t completions = 0;
+        std::vector<std::shared_ptr<UVAtlasJob>> jobs(jobCount * 2);
+        for (size_t j = 0; j < jobs.size(); j++)
+        {
+            HRESULT hr = UVAtlasCreateAsync(
+                GetBatchMesh(meshes[j % meshes.size()]),
+                [&](const UVAtlasBatchResult &)
+                {
+                    std::lock_guard<std::mutex> guard(completionLock);
+                    completions++;
+                },
+                UVATLAS_DEFAULT_CALLBACK_FREQUENCY,
+                jobs[j],
+                &executors[j % 2]);
+            if (FAILED(hr))
+            {
+                printf("FAILED: UVAtlasCreateAsync job %zu could not start (%08X)\n", j, static_cast<unsigned int>(hr));
+                failures++;
+            }
+        }
+
+        for (size_t j = 0; j < jobs.size(); j++)
+        {
+            if (jobs[j])
+            {
+                check("UVAtlasCreateAsync", j, UVAtlasJobWait(*jobs[j]));
+            }
+        }
+
+        // Releasing the handles while the job system is alive, the jobs may
+        // still be finishing their completion
+        jobs.clear();
+
+        {
+            std::lock_guard<std::mutex> guard(completionLock);
+            if (completions != jobCount * 2)
+            {
+                printf("FAILED: %zu of %zu completions were called\n", completions, jobCount * 2);
+                failures++;
+            }
+        }
+
+        // Released jobs still complete, whether the caller releases the
+        // handle while the job runs or the completion releases it. The lock
+        // keeps the completion from running before the handle is set.
+        std::condition_variable completionSignal;
+        for (size_t j = 0; j < 2; j++)
+        {
+            for (bool bReleaseInCompletion : { false, true })
+            {
+                std::shared_ptr<UVAtlasJob> job;
+                bool bCompleted = false;
+
+                std::unique_lock<std::mutex> guard(completionLock);
+                HRESULT hr = UVAtlasCreateAsync(
+                    GetBatchMesh(meshes[0]),
+                    [&, bReleaseInCompletion](const UVAtlasBatchResult &)
+                    {
+                        std::lock_guard<std::mutex> completionGuard(completionLock);
+                        if (bReleaseInCompletion)
+                        {
+                            job.reset();
+                        }
+                        bCompleted = true;
+                        completionSignal.notify_all();
+                    },
+                    UVATLAS_DEFAULT_CALLBACK_FREQUENCY,
+                    job,
+                    &executors[j]);
+                if (FAILED(hr))
+                {
+                    printf("FAILED: released job %zu could not start (%08X)\n", j, static_cast<unsigned int>(hr));
+                    failures++;
+                    continue;
+                }
+
+                if (!bReleaseInCompletion)
+                {
+                    job.reset();
+                }
+                completionSignal.wait(guard, [&bCompleted]() { return bCompleted; });
+            }
+        }
+    }
+
+    // 3. Concurrent batches on a shared job system
+    {
+        JobSystem jobSystem(3);
+        UVAtlasExecutor executor = {};
+        executor.maxThreadCount = 4;
+        executor.submit = [&jobSystem](std::function<void __cdecl()> work)
+            {
+                jobSystem.Submit(std::move(work));
+            };
+
+        std::vector<UVAtlasBatchMesh> batchMeshes;
+        for (size_t j = 0; j < jobCount; j++)
+        {
+            batchMeshes.push_back(GetBatchMesh(meshes[j % meshes.size()]));
+        }
+
+        std::vector<std::vector<UVAtlasBatchResult>> results(2);
+        std::vector<std::thread> threads;
+        for (size_t b = 0; b < results.size(); b++)
+        {
+            threads.emplace_back([&, b]()
+                {
+                    UVAtlasCreateBatch(
+                        batchMeshes.data(), batchMeshes.size(),
+                        nullptr, UVATLAS_DEFAULT_CALLBACK_FREQUENCY,
+                        results[b], &executor);
+                });
+        }
+        for (auto &t : threads)
+        {
+            t.join();
+        }
+        for (auto &batchResults : results)
+        {
+            for (size_t j = 0; j < batchResults.size(); j++)
+            {
+                check("UVAtlasCreateBatch", j, batchResults[j]);
+            }
+        }
+    }
+
+    if (failures)
+    {
+        printf("%zu failures\n", failures);
+        return 1;
+    }
+
+    printf("%zu concurrent jobs passed\n", jobCount);
+    return 0;
+}
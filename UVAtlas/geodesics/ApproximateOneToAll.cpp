@@ -21,14 +21,14 @@ void CApproximateOneToAll::CutHeapTopData(EdgeWindow &EdgeWindowOut)
         TypeEdgeWindowsHeap::item_type *pItem = m_EdgeWindowsHeap.cutTop();
 
         uint32_t dwIdxSelf = FLAG_INVALIDDWORD;
-        for (size_t i = 0; i < pItem->m_data.pEdge->WindowsList.size(); ++i)
+        for (size_t i = 0; i < m_EdgeList[pItem->m_data.dwEdgeIdx].WindowsList.size(); ++i)
         {
-            if (!pItem->m_data.pEdge->WindowsList[i].pHeapItem)
+            if (!m_EdgeList[pItem->m_data.dwEdgeIdx].WindowsList[i].pHeapItem)
             {
                 continue;
             }
 
-            if (pItem->m_data.pEdge->WindowsList[i].pHeapItem == pItem)
+            if (m_EdgeList[pItem->m_data.dwEdgeIdx].WindowsList[i].pHeapItem == pItem)
             {
                 // here we get a byproduct, because we actually need the idx of the popped off window itself
                 dwIdxSelf = static_cast<uint32_t>(i);
@@ -39,7 +39,7 @@ void CApproximateOneToAll::CutHeapTopData(EdgeWindow &EdgeWindowOut)
 
             // in pWindowLeft and pWindowRight, one is the the popped off window itself, the other one is the possible found adjacent window
             EdgeWindow *pWindowLeft = &(pItem->m_data);
-            EdgeWindow *pWindowRight = &(pItem->m_data.pEdge->WindowsList[i].theWindow);
+            EdgeWindow *pWindowRight = &(m_EdgeList[pItem->m_data.dwEdgeIdx].WindowsList[i].theWindow);
 
             if ((pWindowLeft->b0 == pWindowRight->b1 || pWindowLeft->b1 == pWindowRight->b0) /*&&
                 (pWindowLeft->dwFaceIdxPropagatedFrom == pWindowRight->dwFaceIdxPropagatedFrom)*/
@@ -304,8 +304,8 @@ void CApproximateOneToAll::CutHeapTopData(EdgeWindow &EdgeWindowOut)
                         // the idx of the popped off window is not yet set, so search for it here
                         // we only need to search from i + 1 (rather than from 0), because the previous ones have already been searched
 
-                        for (size_t t = (i + 1); t < pItem->m_data.pEdge->WindowsList.size(); ++t)
-                            if (pItem->m_data.pEdge->WindowsList[t].pHeapItem == pItem)
+                        for (size_t t = (i + 1); t < m_EdgeList[pItem->m_data.dwEdgeIdx].WindowsList.size(); ++t)
+                            if (m_EdgeList[pItem->m_data.dwEdgeIdx].WindowsList[t].pHeapItem == pItem)
                             {
                                 dwIdxSelf = static_cast<uint32_t>(t);
                                 break;
@@ -313,15 +313,15 @@ void CApproximateOneToAll::CutHeapTopData(EdgeWindow &EdgeWindowOut)
                     }
 
                     // remove the found adjacent window from the heap and from the edge it is on
-                    m_EdgeWindowsHeap.remove(pItem->m_data.pEdge->WindowsList[i].pHeapItem);
-                    delete pItem->m_data.pEdge->WindowsList[i].pHeapItem;
-                    pItem->m_data.pEdge->WindowsList.erase(pItem->m_data.pEdge->WindowsList.begin() + ptrdiff_t(i));
+                    m_EdgeWindowsHeap.remove(m_EdgeList[pItem->m_data.dwEdgeIdx].WindowsList[i].pHeapItem);
+                    m_HeapItemPool.Free(m_EdgeList[pItem->m_data.dwEdgeIdx].WindowsList[i].pHeapItem);
+                    m_EdgeList[pItem->m_data.dwEdgeIdx].WindowsList.erase(i);
                     if (dwIdxSelf > i)
                     {
                         --dwIdxSelf;
                     }
 
-                    EdgeWindow *pTheWindow = &(pItem->m_data.pEdge->WindowsList[dwIdxSelf].theWindow);
+                    EdgeWindow *pTheWindow = &(m_EdgeList[pItem->m_data.dwEdgeIdx].WindowsList[dwIdxSelf].theWindow);
 
                     pTheWindow->b0 = b0pie;
                     pTheWindow->b1 = b1pie;
@@ -331,17 +331,15 @@ void CApproximateOneToAll::CutHeapTopData(EdgeWindow &EdgeWindowOut)
                     pTheWindow->d1 = SqrtMin0(SquredD2Dist(DVector2(b1pie, 0), spie));
                     pTheWindow->ksi = ksi;
                     pTheWindow->dwPseuSrcVertexIdx = FLAG_INVALIDDWORD;
-                    pTheWindow->pPseuSrcVertex = nullptr;
                     /*pTheWindow->pHeapItem = nullptr ;
 
                     EdgeWindowOut = *pTheWindow ;
                     delete pItem ;
                     return ;*/
 
-                    pItem->m_data.pEdge->WindowsList[dwIdxSelf].pHeapItem =
-                        new TypeEdgeWindowsHeap::item_type(std::min(pTheWindow->d0, pTheWindow->d1) + pTheWindow->dPseuSrcToSrcDistance, *pTheWindow);
-                    m_EdgeWindowsHeap.insert(pItem->m_data.pEdge->WindowsList[dwIdxSelf].pHeapItem);
-                    delete pItem;
+                    m_EdgeList[pItem->m_data.dwEdgeIdx].WindowsList[dwIdxSelf].pHeapItem = NewHeapItem(*pTheWindow);
+                    m_EdgeWindowsHeap.insert(m_EdgeList[pItem->m_data.dwEdgeIdx].WindowsList[dwIdxSelf].pHeapItem);
+                    m_HeapItemPool.Free(pItem);
 
                     // continue to pop the next window in heap and test whether any merge is possible
                     goto l_outter_while_again;
@@ -351,23 +349,23 @@ void CApproximateOneToAll::CutHeapTopData(EdgeWindow &EdgeWindowOut)
 
         if (dwIdxSelf == FLAG_INVALIDDWORD)
         {
-            for (size_t i = 0; i < pItem->m_data.pEdge->WindowsList.size(); ++i)
+            for (size_t i = 0; i < m_EdgeList[pItem->m_data.dwEdgeIdx].WindowsList.size(); ++i)
             {
-                if (pItem->m_data.pEdge->WindowsList[i].pHeapItem == pItem)
+                if (m_EdgeList[pItem->m_data.dwEdgeIdx].WindowsList[i].pHeapItem == pItem)
                 {
-                    pItem->m_data.pEdge->WindowsList[i].pHeapItem = nullptr;
+                    m_EdgeList[pItem->m_data.dwEdgeIdx].WindowsList[i].pHeapItem = nullptr;
                     break;
                 }
             }
 
             EdgeWindowOut = pItem->m_data;
-            delete pItem;
+            m_HeapItemPool.Free(pItem);
             return;
         }
 
-        pItem->m_data.pEdge->WindowsList[dwIdxSelf].pHeapItem = nullptr;
+        m_EdgeList[pItem->m_data.dwEdgeIdx].WindowsList[dwIdxSelf].pHeapItem = nullptr;
         EdgeWindowOut = pItem->m_data;
-        delete pItem;
+        m_HeapItemPool.Free(pItem);
 
         return;
 
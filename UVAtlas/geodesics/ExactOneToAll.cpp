@@ -14,6 +14,12 @@
 
 using namespace GeodesicDist;
 
+namespace
+{
+    // number of windows propagated between two calls of the stop check
+    constexpr size_t STOP_CHECK_WINDOWS = 1024;
+}
+
 CExactOneToAll::CExactOneToAll()
     : m_pVertices(nullptr),
     m_pIndices(nullptr),
@@ -21,20 +27,138 @@ CExactOneToAll::CExactOneToAll()
     m_dwNumBytesPerVertex(0),
     m_dwNumFaces(0),
     m_dwNumVertices(0),
-    m_dwSrcVertexIdx(0)
+    m_dwSrcVertexIdx(0),
+    m_pTopology(nullptr),
+    m_dMaxDistance(DBL_MAX),
+    m_pdwTargets(nullptr),
+    m_dwTargetNumber(0),
+    m_dwTargetCount(0)
 {
-    m_EdgeWindowsHeap.SetManageMode(Isochart::AUTOMATIC);
 }
 
-void CExactOneToAll::SetSrcVertexIdx(const uint32_t dwSrcVertexIdx)
+namespace
 {
-    m_dwSrcVertexIdx = dwSrcVertexIdx;
+    // compressed rows of the lists of items each vertex is in, the items
+    // having dwItemSize vertices each
+    void BuildVertexRows(size_t dwVertexNumber,
+        const std::vector<uint32_t> &itemVertices,
+        size_t dwItemSize,
+        std::vector<uint32_t> &rowStart,
+        std::vector<uint32_t> &rows)
+    {
+        rowStart.assign(dwVertexNumber + 1, 0);
+        for (uint32_t dwVertexIdx : itemVertices)
+        {
+            rowStart[dwVertexIdx + 1]++;
+        }
+        for (size_t i = 0; i < dwVertexNumber; ++i)
+        {
+            rowStart[i + 1] += rowStart[i];
+        }
 
-    while (!m_EdgeWindowsHeap.empty())
+        rows.resize(itemVertices.size());
+        std::vector<uint32_t> next(rowStart.begin(), rowStart.end() - 1);
+        for (size_t i = 0; i < itemVertices.size(); ++i)
+        {
+            rows[next[itemVertices[i]]++] = static_cast<uint32_t>(i / dwItemSize);
+        }
+    }
+}
+
+void MeshTopology::Build()
+{
+    const size_t dwEdgeNumber = GetEdgeNumber();
+    const size_t dwFaceNumber = GetFaceNumber();
+
+    edgeLengths.resize(dwEdgeNumber);
+    for (size_t i = 0; i < dwEdgeNumber; ++i)
+    {
+        edgeLengths[i] = sqrt(SquredD3Dist(vertexPositions[edgeVertices[2 * i]], vertexPositions[edgeVertices[2 * i + 1]]));
+    }
+
+    vertexAngles.assign(GetVertexNumber(), 0.0);
+    for (size_t i = 0; i < dwFaceNumber; ++i)
     {
-        delete m_EdgeWindowsHeap.cutTop();
+        const uint32_t *pdwFace = &faceVertices[3 * i];
+        const DVector3 &v0 = vertexPositions[pdwFace[0]];
+        const DVector3 &v1 = vertexPositions[pdwFace[1]];
+        const DVector3 &v2 = vertexPositions[pdwFace[2]];
+
+        vertexAngles[pdwFace[2]] += ComputeAngleBetween2Lines(v2, v0, v1);
+        vertexAngles[pdwFace[1]] += ComputeAngleBetween2Lines(v1, v0, v2);
+        vertexAngles[pdwFace[0]] += ComputeAngleBetween2Lines(v0, v1, v2);
     }
 
+    BuildVertexRows(GetVertexNumber(), faceVertices, 3, vertexFaceStart, vertexFaces);
+    BuildVertexRows(GetVertexNumber(), edgeVertices, 2, vertexEdgeStart, vertexEdges);
+}
+
+void CExactOneToAll::Init(const MeshTopology &topology)
+{
+    m_pTopology = &topology;
+
+    m_VertexList.assign(topology.GetVertexNumber(), Vertex());
+    m_EdgeList.assign(topology.GetEdgeNumber(), Edge());
+    m_FaceList.assign(topology.GetFaceNumber(), Face());
+
+    for (size_t i = 0; i < m_VertexList.size(); ++i)
+    {
+        Vertex &thisVertex = m_VertexList[i];
+
+        thisVertex.x = topology.vertexPositions[i].x;
+        thisVertex.y = topology.vertexPositions[i].y;
+        thisVertex.z = topology.vertexPositions[i].z;
+        thisVertex.bBoundary = topology.vertexBoundary[i] != 0;
+        thisVertex.dAngle = topology.vertexAngles[i];
+        thisVertex.bUsed = topology.vertexFaceStart[i + 1] > topology.vertexFaceStart[i];
+    }
+
+    for (size_t i = 0; i < m_EdgeList.size(); ++i)
+    {
+        Edge &thisEdge = m_EdgeList[i];
+
+        thisEdge.dwVertexIdx0 = topology.edgeVertices[2 * i];
+        thisEdge.pVertex0 = &m_VertexList[thisEdge.dwVertexIdx0];
+        thisEdge.dwVertexIdx1 = topology.edgeVertices[2 * i + 1];
+        thisEdge.pVertex1 = &m_VertexList[thisEdge.dwVertexIdx1];
+
+        thisEdge.dwAdjFaceIdx0 = topology.edgeFaces[2 * i];
+        thisEdge.pAdjFace0 = &m_FaceList[thisEdge.dwAdjFaceIdx0];
+        thisEdge.dwAdjFaceIdx1 = topology.edgeFaces[2 * i + 1];
+        thisEdge.pAdjFace1 = thisEdge.dwAdjFaceIdx1 == FLAG_INVALIDDWORD ? nullptr : &m_FaceList[thisEdge.dwAdjFaceIdx1];
+
+        thisEdge.dEdgeLength = topology.edgeLengths[i];
+    }
+
+    for (size_t i = 0; i < m_FaceList.size(); ++i)
+    {
+        Face &thisFace = m_FaceList[i];
+
+        thisFace.dwEdgeIdx0 = topology.faceEdges[3 * i];
+        thisFace.pEdge0 = &m_EdgeList[thisFace.dwEdgeIdx0];
+        thisFace.dwEdgeIdx1 = topology.faceEdges[3 * i + 1];
+        thisFace.pEdge1 = &m_EdgeList[thisFace.dwEdgeIdx1];
+        thisFace.dwEdgeIdx2 = topology.faceEdges[3 * i + 2];
+        thisFace.pEdge2 = &m_EdgeList[thisFace.dwEdgeIdx2];
+
+        thisFace.dwVertexIdx0 = topology.faceVertices[3 * i];
+        thisFace.pVertex0 = &m_VertexList[thisFace.dwVertexIdx0];
+        thisFace.dwVertexIdx1 = topology.faceVertices[3 * i + 1];
+        thisFace.pVertex1 = &m_VertexList[thisFace.dwVertexIdx1];
+        thisFace.dwVertexIdx2 = topology.faceVertices[3 * i + 2];
+        thisFace.pVertex2 = &m_VertexList[thisFace.dwVertexIdx2];
+    }
+}
+
+void CExactOneToAll::SetSrcVertexIdx(const uint32_t dwSrcVertexIdx)
+{
+    m_dwSrcVertexIdx = dwSrcVertexIdx;
+
+    // a run stopped early leaves windows in the heap
+    m_EdgeWindowsHeap.clear();
+    m_HeapItemPool.Reset();
+    m_WindowListArena.Reset();
+
     for (size_t i = 0; i < m_VertexList.size(); ++i)
     {
         m_VertexList[i].dGeoDistanceToSrc = DBL_MAX;
@@ -45,61 +169,112 @@ void CExactOneToAll::SetSrcVertexIdx(const uint32_t dwSrcVertexIdx)
 
     for (size_t i = 0; i < m_EdgeList.size(); ++i)
     {
-        Edge &thisEdge = m_EdgeList[i];
-
-        thisEdge.WindowsList.clear();
+        m_EdgeList[i].WindowsList.clear();
+    }
 
-        if (!thisEdge.HasVertexIdx(dwSrcVertexIdx) &&
-            ((thisEdge.pAdjFace0 && thisEdge.pAdjFace0->HasVertexIdx(dwSrcVertexIdx)) ||
-                (thisEdge.pAdjFace1 && thisEdge.pAdjFace1->HasVertexIdx(dwSrcVertexIdx))))
+    // the initial windows are on the edges opposite to the source in its
+    // faces, in the order of the edges
+    m_SrcEdges.clear();
+    for (uint32_t i = m_pTopology->vertexFaceStart[dwSrcVertexIdx]; i < m_pTopology->vertexFaceStart[dwSrcVertexIdx + 1]; ++i)
+    {
+        const uint32_t dwEdgeIdx = m_FaceList[m_pTopology->vertexFaces[i]].GetOpposingEdgeIdx(dwSrcVertexIdx);
+        if (!m_EdgeList[dwEdgeIdx].HasVertexIdx(dwSrcVertexIdx))
         {
-            EdgeWindow tmpEdgeWindow;
-
-            // generate a window covering the whole edge as one of the initial windows
-            tmpEdgeWindow.SetEdgeIdx(m_EdgeList, static_cast<uint32_t>(i));
-            tmpEdgeWindow.dPseuSrcToSrcDistance = 0;
-            tmpEdgeWindow.b0 = 0;
-            tmpEdgeWindow.b1 = tmpEdgeWindow.pEdge->dEdgeLength;
-            tmpEdgeWindow.d0 = sqrt(SquredD3Dist(*tmpEdgeWindow.pEdge->pVertex0, m_VertexList[dwSrcVertexIdx]));
-            tmpEdgeWindow.d1 = sqrt(SquredD3Dist(*tmpEdgeWindow.pEdge->pVertex1, m_VertexList[dwSrcVertexIdx]));
-            ParameterizePt3ToPt2(*tmpEdgeWindow.pEdge->pVertex0, *tmpEdgeWindow.pEdge->pVertex1, m_VertexList[dwSrcVertexIdx], tmpEdgeWindow.dv2Src);
-            tmpEdgeWindow.SetPseuSrcVertexIdx(m_VertexList, dwSrcVertexIdx);
-            tmpEdgeWindow.SetMarkFromEdgeVertexIdx(m_VertexList, tmpEdgeWindow.pEdge->dwVertexIdx0);
-            if (tmpEdgeWindow.pEdge->pAdjFace0->HasVertexIdx(dwSrcVertexIdx))
-                tmpEdgeWindow.SetFaceIdxPropagatedFrom(m_FaceList, tmpEdgeWindow.pEdge->dwAdjFaceIdx0);
-            else
-                tmpEdgeWindow.SetFaceIdxPropagatedFrom(m_FaceList, tmpEdgeWindow.pEdge->dwAdjFaceIdx1);
-
-            AddWindowToHeapAndEdge(tmpEdgeWindow);
+            m_SrcEdges.push_back(dwEdgeIdx);
         }
     }
+    std::sort(m_SrcEdges.begin(), m_SrcEdges.end());
+    m_SrcEdges.erase(std::unique(m_SrcEdges.begin(), m_SrcEdges.end()), m_SrcEdges.end());
+
+    for (uint32_t dwEdgeIdx : m_SrcEdges)
+    {
+        EdgeWindow tmpEdgeWindow;
+
+        // generate a window covering the whole edge as one of the initial windows
+        tmpEdgeWindow.dwEdgeIdx = dwEdgeIdx;
+        tmpEdgeWindow.dPseuSrcToSrcDistance = 0;
+        tmpEdgeWindow.b0 = 0;
+        tmpEdgeWindow.b1 = m_EdgeList[tmpEdgeWindow.dwEdgeIdx].dEdgeLength;
+        tmpEdgeWindow.d0 = sqrt(SquredD3Dist(*m_EdgeList[tmpEdgeWindow.dwEdgeIdx].pVertex0, m_VertexList[dwSrcVertexIdx]));
+        tmpEdgeWindow.d1 = sqrt(SquredD3Dist(*m_EdgeList[tmpEdgeWindow.dwEdgeIdx].pVertex1, m_VertexList[dwSrcVertexIdx]));
+        ParameterizePt3ToPt2(*m_EdgeList[tmpEdgeWindow.dwEdgeIdx].pVertex0, *m_EdgeList[tmpEdgeWindow.dwEdgeIdx].pVertex1, m_VertexList[dwSrcVertexIdx], tmpEdgeWindow.dv2Src);
+        tmpEdgeWindow.dwPseuSrcVertexIdx = dwSrcVertexIdx;
+        tmpEdgeWindow.dwMarkFromEdgeVertexIdx = m_EdgeList[tmpEdgeWindow.dwEdgeIdx].dwVertexIdx0;
+        if (m_EdgeList[tmpEdgeWindow.dwEdgeIdx].pAdjFace0->HasVertexIdx(dwSrcVertexIdx))
+            tmpEdgeWindow.dwFaceIdxPropagatedFrom = m_EdgeList[tmpEdgeWindow.dwEdgeIdx].dwAdjFaceIdx0;
+        else
+            tmpEdgeWindow.dwFaceIdxPropagatedFrom = m_EdgeList[tmpEdgeWindow.dwEdgeIdx].dwAdjFaceIdx1;
+
+        AddWindowToHeapAndEdge(tmpEdgeWindow);
+    }
 
     m_VertexList[m_dwSrcVertexIdx].dGeoDistanceToSrc = 0;
 }
 
+void CExactOneToAll::SetStopCheck(std::function<bool()> fnIsStopped)
+{
+    m_fnIsStopped = std::move(fnIsStopped);
+}
+
+void CExactOneToAll::SetBound(double dMaxDistance, const uint32_t *pdwTargets, size_t dwTargetNumber, size_t dwTargetCount)
+{
+    assert(dwTargetCount <= dwTargetNumber);
+    assert(pdwTargets != nullptr || dwTargetNumber == 0);
+
+    m_dMaxDistance = dMaxDistance;
+    m_pdwTargets = pdwTargets;
+    m_dwTargetNumber = dwTargetNumber;
+    m_dwTargetCount = dwTargetCount;
+}
+
+// The windows leave the heap by increasing distance, and the windows they
+// produce are farther, so a vertex reached within the distance of the window
+// just popped keeps its distance.
+bool CExactOneToAll::AreTargetsSettled(double dDistance) const
+{
+    size_t dwSettled = 0;
+    for (size_t i = 0; i < m_dwTargetNumber; ++i)
+    {
+        if (m_VertexList[m_pdwTargets[i]].dGeoDistanceToSrc <= dDistance && ++dwSettled == m_dwTargetCount)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// a heap item of the window, weighted by its distance to the source
+TypeEdgeWindowsHeap::item_type *CExactOneToAll::NewHeapItem(const EdgeWindow &Window)
+{
+    auto pItem = m_HeapItemPool.Allocate();
+    pItem->m_weight = std::min(Window.d0, Window.d1) + Window.dPseuSrcToSrcDistance;
+    pItem->m_data = Window;
+    return pItem;
+}
+
 void CExactOneToAll::AddWindowToHeapAndEdge(const EdgeWindow &WindowToAdd)
 {
     // add the new window to heap and the edge
-    auto pItem = new TypeEdgeWindowsHeap::item_type(std::min(WindowToAdd.d0, WindowToAdd.d1) + WindowToAdd.dPseuSrcToSrcDistance, WindowToAdd);
+    auto pItem = NewHeapItem(WindowToAdd);
 
     m_EdgeWindowsHeap.insert(pItem);
-    WindowToAdd.pEdge->WindowsList.push_back(Edge::WindowListElement(pItem, WindowToAdd));
+    m_EdgeList[WindowToAdd.dwEdgeIdx].WindowsList.push_back(m_WindowListArena, WindowListElement(pItem, WindowToAdd));
 
     // update the geodesic distance on vertices affected by this new window
-    WindowToAdd.pMarkFromEdgeVertex->dGeoDistanceToSrc =
-        std::min(WindowToAdd.pMarkFromEdgeVertex->dGeoDistanceToSrc, WindowToAdd.d0 + WindowToAdd.dPseuSrcToSrcDistance);
-    WindowToAdd.pMarkFromEdgeVertex->dLengthOfWindowEdgeToThisVertex = 0;
-    if (WindowToAdd.pMarkFromEdgeVertex->dGeoDistanceToSrc == (WindowToAdd.d0 + WindowToAdd.dPseuSrcToSrcDistance))
+    m_VertexList[WindowToAdd.dwMarkFromEdgeVertexIdx].dGeoDistanceToSrc =
+        std::min(m_VertexList[WindowToAdd.dwMarkFromEdgeVertexIdx].dGeoDistanceToSrc, WindowToAdd.d0 + WindowToAdd.dPseuSrcToSrcDistance);
+    m_VertexList[WindowToAdd.dwMarkFromEdgeVertexIdx].dLengthOfWindowEdgeToThisVertex = 0;
+    if (m_VertexList[WindowToAdd.dwMarkFromEdgeVertexIdx].dGeoDistanceToSrc == (WindowToAdd.d0 + WindowToAdd.dPseuSrcToSrcDistance))
     {
-        WindowToAdd.pMarkFromEdgeVertex->pEdgeReportedGeoDist = WindowToAdd.pEdge;
+        m_VertexList[WindowToAdd.dwMarkFromEdgeVertexIdx].pEdgeReportedGeoDist = &m_EdgeList[WindowToAdd.dwEdgeIdx];
     }
 
-    WindowToAdd.pEdge->GetAnotherVertex(WindowToAdd.dwMarkFromEdgeVertexIdx)->dGeoDistanceToSrc =
-        std::min(WindowToAdd.pEdge->GetAnotherVertex(WindowToAdd.dwMarkFromEdgeVertexIdx)->dGeoDistanceToSrc, WindowToAdd.d1 + WindowToAdd.dPseuSrcToSrcDistance);
-    WindowToAdd.pEdge->GetAnotherVertex(WindowToAdd.dwMarkFromEdgeVertexIdx)->dLengthOfWindowEdgeToThisVertex = 0;
-    if (WindowToAdd.pEdge->GetAnotherVertex(WindowToAdd.dwMarkFromEdgeVertexIdx)->dGeoDistanceToSrc == (WindowToAdd.d1 + WindowToAdd.dPseuSrcToSrcDistance))
+    m_EdgeList[WindowToAdd.dwEdgeIdx].GetAnotherVertex(WindowToAdd.dwMarkFromEdgeVertexIdx)->dGeoDistanceToSrc =
+        std::min(m_EdgeList[WindowToAdd.dwEdgeIdx].GetAnotherVertex(WindowToAdd.dwMarkFromEdgeVertexIdx)->dGeoDistanceToSrc, WindowToAdd.d1 + WindowToAdd.dPseuSrcToSrcDistance);
+    m_EdgeList[WindowToAdd.dwEdgeIdx].GetAnotherVertex(WindowToAdd.dwMarkFromEdgeVertexIdx)->dLengthOfWindowEdgeToThisVertex = 0;
+    if (m_EdgeList[WindowToAdd.dwEdgeIdx].GetAnotherVertex(WindowToAdd.dwMarkFromEdgeVertexIdx)->dGeoDistanceToSrc == (WindowToAdd.d1 + WindowToAdd.dPseuSrcToSrcDistance))
     {
-        WindowToAdd.pEdge->GetAnotherVertex(WindowToAdd.dwMarkFromEdgeVertexIdx)->pEdgeReportedGeoDist = WindowToAdd.pEdge;
+        m_EdgeList[WindowToAdd.dwEdgeIdx].GetAnotherVertex(WindowToAdd.dwMarkFromEdgeVertexIdx)->pEdgeReportedGeoDist = &m_EdgeList[WindowToAdd.dwEdgeIdx];
     }
 }
 
@@ -108,16 +283,16 @@ void CExactOneToAll::CutHeapTopData(EdgeWindow &EdgeWindowOut)
 {
     auto pItem = m_EdgeWindowsHeap.cutTop();
 
-    for (size_t i = 0; i < pItem->m_data.pEdge->WindowsList.size(); ++i)
-        if (pItem->m_data.pEdge->WindowsList[i].pHeapItem == pItem)
+    for (size_t i = 0; i < m_EdgeList[pItem->m_data.dwEdgeIdx].WindowsList.size(); ++i)
+        if (m_EdgeList[pItem->m_data.dwEdgeIdx].WindowsList[i].pHeapItem == pItem)
         {
-            pItem->m_data.pEdge->WindowsList[i].pHeapItem = nullptr;
+            m_EdgeList[pItem->m_data.dwEdgeIdx].WindowsList[i].pHeapItem = nullptr;
             break;
         }
 
     EdgeWindowOut = pItem->m_data;
 
-    delete pItem;
+    m_HeapItemPool.Free(pItem);
 }
 
 void CExactOneToAll::Run()
@@ -136,13 +311,29 @@ void CExactOneToAll::InternalRun()
     bool bW2W0OnE0E2, bW2W0OnE1E2, bW2W1OnE0E2, bW2W1OnE1E2;
 
     // the main propagation loop
+    size_t dwWindowCount = 0;
     while (!m_EdgeWindowsHeap.empty())
     {
+        // the heap can hold millions of windows, poll the stop check once
+        // in a while so a long run can be stopped
+        const bool bPoll = (++dwWindowCount % STOP_CHECK_WINDOWS) == 0;
+        if (bPoll && m_fnIsStopped && m_fnIsStopped())
+        {
+            break;
+        }
+
         tmpWindow0.dwEdgeIdx = FLAG_INVALIDDWORD;
 
         CutHeapTopData(WindowToBePropagated);
 
-        if (!WindowToBePropagated.pEdge->pAdjFace0 || !WindowToBePropagated.pEdge->pAdjFace1)
+        // a bounded run stops at the first window past its bound
+        const double dWindowDistance = std::min(WindowToBePropagated.d0, WindowToBePropagated.d1) + WindowToBePropagated.dPseuSrcToSrcDistance;
+        if (dWindowDistance > m_dMaxDistance || (bPoll && m_dwTargetCount > 0 && AreTargetsSettled(dWindowDistance)))
+        {
+            break;
+        }
+
+        if (!m_EdgeList[WindowToBePropagated.dwEdgeIdx].pAdjFace0 || !m_EdgeList[WindowToBePropagated.dwEdgeIdx].pAdjFace1)
         {
             // this is a boundary edge, no need to propagate
             continue;
@@ -154,9 +345,9 @@ void CExactOneToAll::InternalRun()
             continue;
         }
 
-        // pPtE0 = WindowToBePropagated.pMarkFromEdgeVertex;
+        // pPtE0 = &m_VertexList[WindowToBePropagated.dwMarkFromEdgeVertexIdx];
 
-        dwFacePropagateTo = WindowToBePropagated.pEdge->GetAnotherFaceIdx(WindowToBePropagated.dwFaceIdxPropagatedFrom);
+        dwFacePropagateTo = m_EdgeList[WindowToBePropagated.dwEdgeIdx].GetAnotherFaceIdx(WindowToBePropagated.dwFaceIdxPropagatedFrom);
         pFacePropageteTo = &m_FaceList[dwFacePropagateTo];
 
         pFacePropageteTo->GetOtherTwoEdges(WindowToBePropagated.dwEdgeIdx, &pEdge0, &pEdge1);
@@ -170,7 +361,7 @@ void CExactOneToAll::InternalRun()
         dwThirdPtIdxOnFacePropagateTo = pEdge0->GetAnotherVertexIdx(WindowToBePropagated.dwMarkFromEdgeVertexIdx);
         pThridPtOnFacePropagateTo = &m_VertexList[dwThirdPtIdxOnFacePropagateTo];
 
-        dwPtE1Idx = WindowToBePropagated.pEdge->GetAnotherVertexIdx(WindowToBePropagated.dwMarkFromEdgeVertexIdx);
+        dwPtE1Idx = m_EdgeList[WindowToBePropagated.dwEdgeIdx].GetAnotherVertexIdx(WindowToBePropagated.dwMarkFromEdgeVertexIdx);
         pPtE1 = &m_VertexList[dwPtE1Idx];
 
         w0.x = WindowToBePropagated.b0;
@@ -185,13 +376,13 @@ void CExactOneToAll::InternalRun()
         w2 = WindowToBePropagated.dv2Src;
 
         e0.x = e0.y = 0;
-        e1.x = WindowToBePropagated.pEdge->dEdgeLength;
+        e1.x = m_EdgeList[WindowToBePropagated.dwEdgeIdx].dEdgeLength;
         e1.y = 0;
         if (w1.x > e1.x)
         {
             w1.x = e1.x;
         }
-        ParameterizePt3ToPt2(*WindowToBePropagated.pMarkFromEdgeVertex,
+        ParameterizePt3ToPt2(m_VertexList[WindowToBePropagated.dwMarkFromEdgeVertexIdx],
             *pPtE1,
             *pThridPtOnFacePropagateTo, e2);
         e2.y = -e2.y;
@@ -222,10 +413,10 @@ void CExactOneToAll::InternalRun()
                 if (w0.x == e0.x)
                     tmpWindow0.b1 = pEdge0->dEdgeLength;
 
-                tmpWindow0.SetPseuSrcVertexIdx(m_VertexList, WindowToBePropagated.dwPseuSrcVertexIdx);
-                tmpWindow0.SetEdgeIdx(m_EdgeList, dwEdgeIdxPropagateTo0);
+                tmpWindow0.dwPseuSrcVertexIdx = WindowToBePropagated.dwPseuSrcVertexIdx;
+                tmpWindow0.dwEdgeIdx = dwEdgeIdxPropagateTo0;
                 tmpWindow0.dPseuSrcToSrcDistance = WindowToBePropagated.dPseuSrcToSrcDistance;
-                tmpWindow0.SetFaceIdxPropagatedFrom(m_FaceList, dwFacePropagateTo);
+                tmpWindow0.dwFaceIdxPropagatedFrom = dwFacePropagateTo;
                 tmpWindow0.b0 = 0;
                 tmpWindow0.d0 = sqrt(SquredD2Dist(w2, e2));
                 if (w0.x == e0.x)
@@ -237,10 +428,9 @@ void CExactOneToAll::InternalRun()
                     tmpWindow0.d1 = sqrt(SquredD2Dist(w0_to_e0_e2, w2));
                 }
                 ParameterizePt2ToPt2(e2, e0, w2, tmpWindow0.dv2Src);
-                tmpWindow0.SetMarkFromEdgeVertexIdx(m_VertexList, dwThirdPtIdxOnFacePropagateTo);
+                tmpWindow0.dwMarkFromEdgeVertexIdx = dwThirdPtIdxOnFacePropagateTo;
 
                 tmpWindow0.ksi = WindowToBePropagated.ksi;
-                tmpWindow0.pEdgePropagatedFrom = WindowToBePropagated.pEdge;
 
                 if (tmpWindow0.b1 - tmpWindow0.b0 > double(FLT_EPSILON))
                 {
@@ -254,10 +444,10 @@ void CExactOneToAll::InternalRun()
                 if (w1.x == e1.x)
                     tmpWindow0.b1 = pEdge1->dEdgeLength;
 
-                tmpWindow0.SetPseuSrcVertexIdx(m_VertexList, WindowToBePropagated.dwPseuSrcVertexIdx);
-                tmpWindow0.SetEdgeIdx(m_EdgeList, dwEdgeIdxPropagateTo1);
+                tmpWindow0.dwPseuSrcVertexIdx = WindowToBePropagated.dwPseuSrcVertexIdx;
+                tmpWindow0.dwEdgeIdx = dwEdgeIdxPropagateTo1;
                 tmpWindow0.dPseuSrcToSrcDistance = WindowToBePropagated.dPseuSrcToSrcDistance;
-                tmpWindow0.SetFaceIdxPropagatedFrom(m_FaceList, dwFacePropagateTo);
+                tmpWindow0.dwFaceIdxPropagatedFrom = dwFacePropagateTo;
                 tmpWindow0.b0 = 0;
                 tmpWindow0.d0 = sqrt(SquredD2Dist(w2, e2));
                 if (w1.x == e1.x)
@@ -269,10 +459,9 @@ void CExactOneToAll::InternalRun()
                     tmpWindow0.d1 = sqrt(SquredD2Dist(w1_to_e1_e2, w2));
                 }
                 ParameterizePt2ToPt2(e2, e1, w2, tmpWindow0.dv2Src);
-                tmpWindow0.SetMarkFromEdgeVertexIdx(m_VertexList, dwThirdPtIdxOnFacePropagateTo);
+                tmpWindow0.dwMarkFromEdgeVertexIdx = dwThirdPtIdxOnFacePropagateTo;
 
                 tmpWindow0.ksi = WindowToBePropagated.ksi;
-                tmpWindow0.pEdgePropagatedFrom = WindowToBePropagated.pEdge;
 
                 if (tmpWindow0.b1 - tmpWindow0.b0 > double(FLT_EPSILON))
                 {
@@ -284,9 +473,9 @@ void CExactOneToAll::InternalRun()
         // this is the second figure shown in the mail
         else if (bW2W0OnE1E2 && bW2W1OnE1E2)
         {
-            tmpWindow0.SetPseuSrcVertexIdx(m_VertexList, WindowToBePropagated.dwPseuSrcVertexIdx);
-            tmpWindow0.SetEdgeIdx(m_EdgeList, dwEdgeIdxPropagateTo1);
-            tmpWindow0.SetFaceIdxPropagatedFrom(m_FaceList, dwFacePropagateTo);
+            tmpWindow0.dwPseuSrcVertexIdx = WindowToBePropagated.dwPseuSrcVertexIdx;
+            tmpWindow0.dwEdgeIdx = dwEdgeIdxPropagateTo1;
+            tmpWindow0.dwFaceIdxPropagatedFrom = dwFacePropagateTo;
             tmpWindow0.dPseuSrcToSrcDistance = WindowToBePropagated.dPseuSrcToSrcDistance;
             tmpWindow0.b0 = sqrt(SquredD2Dist(w0_to_e1_e2, e2));
             if (tmpWindow0.b0 < double(FLT_EPSILON))
@@ -305,32 +494,30 @@ void CExactOneToAll::InternalRun()
             }
             ParameterizePt2ToPt2(e2, e1, w2, tmpWindow0.dv2Src);
             tmpWindow0.d0 = sqrt(SquredD2Dist(w0_to_e1_e2, w2));
-            tmpWindow0.SetMarkFromEdgeVertexIdx(m_VertexList, dwThirdPtIdxOnFacePropagateTo);
+            tmpWindow0.dwMarkFromEdgeVertexIdx = dwThirdPtIdxOnFacePropagateTo;
 
             tmpWindow0.ksi = WindowToBePropagated.ksi;
-            tmpWindow0.pEdgePropagatedFrom = WindowToBePropagated.pEdge;
 
             if (tmpWindow0.b1 - tmpWindow0.b0 > double(FLT_EPSILON))
             {
                 ProcessNewWindow(&tmpWindow0);
             }
 
-            if (w0.x == e0.x && WindowToBePropagated.pMarkFromEdgeVertex->IsSaddleBoundary())
+            if (w0.x == e0.x && m_VertexList[WindowToBePropagated.dwMarkFromEdgeVertexIdx].IsSaddleBoundary())
             {
-                tmpWindow0.SetPseuSrcVertexIdx(m_VertexList, WindowToBePropagated.dwMarkFromEdgeVertexIdx);
-                tmpWindow0.SetEdgeIdx(m_EdgeList, dwEdgeIdxPropagateTo1);
+                tmpWindow0.dwPseuSrcVertexIdx = WindowToBePropagated.dwMarkFromEdgeVertexIdx;
+                tmpWindow0.dwEdgeIdx = dwEdgeIdxPropagateTo1;
                 tmpWindow0.dPseuSrcToSrcDistance = WindowToBePropagated.dPseuSrcToSrcDistance + WindowToBePropagated.d0;
-                tmpWindow0.SetFaceIdxPropagatedFrom(m_FaceList, dwFacePropagateTo);
+                tmpWindow0.dwFaceIdxPropagatedFrom = dwFacePropagateTo;
                 tmpWindow0.b0 = 0;
                 tmpWindow0.b1 = sqrt(SquredD2Dist(w0_to_e1_e2, e2));
                 tmpWindow0.d0 = pEdge0->dEdgeLength;
                 tmpWindow0.d1 = sqrt(SquredD2Dist(w0_to_e1_e2, e0));
-                tmpWindow0.SetMarkFromEdgeVertexIdx(m_VertexList, dwThirdPtIdxOnFacePropagateTo);
+                tmpWindow0.dwMarkFromEdgeVertexIdx = dwThirdPtIdxOnFacePropagateTo;
                 // ParameterizePt2ToPt2( e2, e1, e0, tmpWindow0.dv2Src ) ;
-                ParameterizePt3ToPt2(*pThridPtOnFacePropagateTo, *pPtE1, *WindowToBePropagated.pMarkFromEdgeVertex, tmpWindow0.dv2Src);
+                ParameterizePt3ToPt2(*pThridPtOnFacePropagateTo, *pPtE1, m_VertexList[WindowToBePropagated.dwMarkFromEdgeVertexIdx], tmpWindow0.dv2Src);
 
                 tmpWindow0.ksi = WindowToBePropagated.ksi;
-                tmpWindow0.pEdgePropagatedFrom = WindowToBePropagated.pEdge;
 
                 if (tmpWindow0.b1 - tmpWindow0.b0 > double(FLT_EPSILON))
                 {
@@ -383,17 +570,16 @@ void CExactOneToAll::InternalRun()
                         {
                             // EdgeWindow newWindow ;
 
-                            tmpWindow0.SetEdgeIdx(m_EdgeList, shadowEdges[v]);
-                            tmpWindow0.SetFaceIdxPropagatedFrom(m_FaceList, shadowFaces[v]);
-                            tmpWindow0.SetMarkFromEdgeVertexIdx(m_VertexList, tmpWindow0.pEdge->dwVertexIdx0);
-                            tmpWindow0.SetPseuSrcVertexIdx(m_VertexList, WindowToBePropagated.dwMarkFromEdgeVertexIdx);
+                            tmpWindow0.dwEdgeIdx = shadowEdges[v];
+                            tmpWindow0.dwFaceIdxPropagatedFrom = shadowFaces[v];
+                            tmpWindow0.dwMarkFromEdgeVertexIdx = m_EdgeList[tmpWindow0.dwEdgeIdx].dwVertexIdx0;
+                            tmpWindow0.dwPseuSrcVertexIdx = WindowToBePropagated.dwMarkFromEdgeVertexIdx;
                             tmpWindow0.b0 = 0;
-                            tmpWindow0.b1 = tmpWindow0.pEdge->dEdgeLength;
-                            tmpWindow0.d0 = sqrt(SquredD3Dist(*tmpWindow0.pEdge->pVertex0, *WindowToBePropagated.pMarkFromEdgeVertex));
-                            tmpWindow0.d1 = sqrt(SquredD3Dist(*tmpWindow0.pEdge->pVertex1, *WindowToBePropagated.pMarkFromEdgeVertex));
+                            tmpWindow0.b1 = m_EdgeList[tmpWindow0.dwEdgeIdx].dEdgeLength;
+                            tmpWindow0.d0 = sqrt(SquredD3Dist(*m_EdgeList[tmpWindow0.dwEdgeIdx].pVertex0, m_VertexList[WindowToBePropagated.dwMarkFromEdgeVertexIdx]));
+                            tmpWindow0.d1 = sqrt(SquredD3Dist(*m_EdgeList[tmpWindow0.dwEdgeIdx].pVertex1, m_VertexList[WindowToBePropagated.dwMarkFromEdgeVertexIdx]));
                             tmpWindow0.dPseuSrcToSrcDistance = WindowToBePropagated.dPseuSrcToSrcDistance + WindowToBePropagated.d0;
-                            ParameterizePt3ToPt2(*tmpWindow0.pEdge->pVertex0, *tmpWindow0.pEdge->pVertex1, *tmpWindow0.pPseuSrcVertex, tmpWindow0.dv2Src);
-                            tmpWindow0.pEdgePropagatedFrom = WindowToBePropagated.pEdge;
+                            ParameterizePt3ToPt2(*m_EdgeList[tmpWindow0.dwEdgeIdx].pVertex0, *m_EdgeList[tmpWindow0.dwEdgeIdx].pVertex1, m_VertexList[tmpWindow0.dwPseuSrcVertexIdx], tmpWindow0.dv2Src);
                             tmpWindow0.ksi = WindowToBePropagated.ksi;
 
                             if (tmpWindow0.b1 - tmpWindow0.b0 > double(FLT_EPSILON))
@@ -409,9 +595,9 @@ void CExactOneToAll::InternalRun()
         // this is the third figure shown in the mail
         else if (bW2W0OnE0E2 && bW2W1OnE0E2)
         {
-            tmpWindow0.SetPseuSrcVertexIdx(m_VertexList, WindowToBePropagated.dwPseuSrcVertexIdx);
-            tmpWindow0.SetEdgeIdx(m_EdgeList, dwEdgeIdxPropagateTo0);
-            tmpWindow0.SetFaceIdxPropagatedFrom(m_FaceList, dwFacePropagateTo);
+            tmpWindow0.dwPseuSrcVertexIdx = WindowToBePropagated.dwPseuSrcVertexIdx;
+            tmpWindow0.dwEdgeIdx = dwEdgeIdxPropagateTo0;
+            tmpWindow0.dwFaceIdxPropagatedFrom = dwFacePropagateTo;
             tmpWindow0.dPseuSrcToSrcDistance = WindowToBePropagated.dPseuSrcToSrcDistance;
             tmpWindow0.b0 = sqrt(SquredD2Dist(w1_to_e0_e2, e2));
             if (tmpWindow0.b0 < double(FLT_EPSILON))
@@ -430,10 +616,9 @@ void CExactOneToAll::InternalRun()
             }
             ParameterizePt2ToPt2(e2, e0, w2, tmpWindow0.dv2Src);
             tmpWindow0.d0 = sqrt(SquredD2Dist(w1_to_e0_e2, w2));
-            tmpWindow0.SetMarkFromEdgeVertexIdx(m_VertexList, dwThirdPtIdxOnFacePropagateTo);
+            tmpWindow0.dwMarkFromEdgeVertexIdx = dwThirdPtIdxOnFacePropagateTo;
 
             tmpWindow0.ksi = WindowToBePropagated.ksi;
-            tmpWindow0.pEdgePropagatedFrom = WindowToBePropagated.pEdge;
 
             if (tmpWindow0.b1 - tmpWindow0.b0 > double(FLT_EPSILON))
             {
@@ -442,19 +627,18 @@ void CExactOneToAll::InternalRun()
 
             if (w1.x == e1.x && pPtE1->IsSaddleBoundary())
             {
-                tmpWindow0.SetPseuSrcVertexIdx(m_VertexList, dwPtE1Idx);
-                tmpWindow0.SetEdgeIdx(m_EdgeList, dwEdgeIdxPropagateTo0);
-                tmpWindow0.SetFaceIdxPropagatedFrom(m_FaceList, dwFacePropagateTo);
+                tmpWindow0.dwPseuSrcVertexIdx = dwPtE1Idx;
+                tmpWindow0.dwEdgeIdx = dwEdgeIdxPropagateTo0;
+                tmpWindow0.dwFaceIdxPropagatedFrom = dwFacePropagateTo;
                 tmpWindow0.dPseuSrcToSrcDistance = WindowToBePropagated.dPseuSrcToSrcDistance + WindowToBePropagated.d1;
                 tmpWindow0.b0 = 0;
                 tmpWindow0.b1 = sqrt(SquredD2Dist(w1_to_e0_e2, e2));
                 tmpWindow0.d0 = pEdge1->dEdgeLength;
                 tmpWindow0.d1 = sqrt(SquredD2Dist(w1_to_e0_e2, e1));
-                tmpWindow0.SetMarkFromEdgeVertexIdx(m_VertexList, dwThirdPtIdxOnFacePropagateTo);
-                ParameterizePt3ToPt2(*pThridPtOnFacePropagateTo, *WindowToBePropagated.pMarkFromEdgeVertex, *pPtE1, tmpWindow0.dv2Src);
+                tmpWindow0.dwMarkFromEdgeVertexIdx = dwThirdPtIdxOnFacePropagateTo;
+                ParameterizePt3ToPt2(*pThridPtOnFacePropagateTo, m_VertexList[WindowToBePropagated.dwMarkFromEdgeVertexIdx], *pPtE1, tmpWindow0.dv2Src);
 
                 tmpWindow0.ksi = WindowToBePropagated.ksi;
-                tmpWindow0.pEdgePropagatedFrom = WindowToBePropagated.pEdge;
 
                 if (tmpWindow0.b1 - tmpWindow0.b0 > double(FLT_EPSILON))
                 {
@@ -469,7 +653,7 @@ void CExactOneToAll::InternalRun()
                     Edge *pBridgeEdge = pEdge1;
                     Face *pShadowFace = pBridgeEdge->GetAnotherFace(dwFacePropagateTo);
                     uint32_t dwShadowFace = pBridgeEdge->GetAnotherFaceIdx(dwFacePropagateTo);
-                    uint32_t dwE1 = WindowToBePropagated.pEdge->GetAnotherVertexIdx(WindowToBePropagated.dwMarkFromEdgeVertexIdx);
+                    uint32_t dwE1 = m_EdgeList[WindowToBePropagated.dwEdgeIdx].GetAnotherVertexIdx(WindowToBePropagated.dwMarkFromEdgeVertexIdx);
                     Edge *pShadowEdge = pShadowFace->GetOpposingEdge(dwE1);
                     uint32_t dwShadowEdge = pShadowFace->GetOpposingEdgeIdx(dwE1);
 
@@ -508,17 +692,16 @@ void CExactOneToAll::InternalRun()
                         {
                             // EdgeWindow newWindow ;
 
-                            tmpWindow0.SetEdgeIdx(m_EdgeList, shadowEdges[v]);
-                            tmpWindow0.SetFaceIdxPropagatedFrom(m_FaceList, shadowFaces[v]);
-                            tmpWindow0.SetMarkFromEdgeVertexIdx(m_VertexList, tmpWindow0.pEdge->dwVertexIdx0);
-                            tmpWindow0.SetPseuSrcVertexIdx(m_VertexList, dwE1);
+                            tmpWindow0.dwEdgeIdx = shadowEdges[v];
+                            tmpWindow0.dwFaceIdxPropagatedFrom = shadowFaces[v];
+                            tmpWindow0.dwMarkFromEdgeVertexIdx = m_EdgeList[tmpWindow0.dwEdgeIdx].dwVertexIdx0;
+                            tmpWindow0.dwPseuSrcVertexIdx = dwE1;
                             tmpWindow0.b0 = 0;
-                            tmpWindow0.b1 = tmpWindow0.pEdge->dEdgeLength;
-                            tmpWindow0.d0 = sqrt(SquredD3Dist(*tmpWindow0.pEdge->pVertex0, m_VertexList[dwE1]));
-                            tmpWindow0.d1 = sqrt(SquredD3Dist(*tmpWindow0.pEdge->pVertex1, m_VertexList[dwE1]));
+                            tmpWindow0.b1 = m_EdgeList[tmpWindow0.dwEdgeIdx].dEdgeLength;
+                            tmpWindow0.d0 = sqrt(SquredD3Dist(*m_EdgeList[tmpWindow0.dwEdgeIdx].pVertex0, m_VertexList[dwE1]));
+                            tmpWindow0.d1 = sqrt(SquredD3Dist(*m_EdgeList[tmpWindow0.dwEdgeIdx].pVertex1, m_VertexList[dwE1]));
                             tmpWindow0.dPseuSrcToSrcDistance = WindowToBePropagated.dPseuSrcToSrcDistance + WindowToBePropagated.d1;
-                            ParameterizePt3ToPt2(*tmpWindow0.pEdge->pVertex0, *tmpWindow0.pEdge->pVertex1, *tmpWindow0.pPseuSrcVertex, tmpWindow0.dv2Src);
-                            tmpWindow0.pEdgePropagatedFrom = WindowToBePropagated.pEdge;
+                            ParameterizePt3ToPt2(*m_EdgeList[tmpWindow0.dwEdgeIdx].pVertex0, *m_EdgeList[tmpWindow0.dwEdgeIdx].pVertex1, m_VertexList[tmpWindow0.dwPseuSrcVertexIdx], tmpWindow0.dv2Src);
                             tmpWindow0.ksi = WindowToBePropagated.ksi;
 
                             if (tmpWindow0.b1 - tmpWindow0.b0 > double(FLT_EPSILON))
@@ -538,10 +721,10 @@ void CExactOneToAll::InternalRun()
         {
             if (m_VertexList[i].dGeoDistanceToSrc == DBL_MAX)
             {
-                for (size_t j = 0; j < m_VertexList[i].edgesAdj.size(); ++j)
+                for (uint32_t j = m_pTopology->vertexEdgeStart[i]; j < m_pTopology->vertexEdgeStart[i + 1]; ++j)
                 {
                     Edge *pEdge;
-                    pEdge = m_VertexList[i].edgesAdj[j];
+                    pEdge = &m_EdgeList[m_pTopology->vertexEdges[j]];
 
                     for (size_t l = 0; l < pEdge->WindowsList.size(); ++l)
                     {
@@ -549,31 +732,31 @@ void CExactOneToAll::InternalRun()
 
                         if (theWindow.dwMarkFromEdgeVertexIdx == i)
                         {
-                            if (theWindow.b0 < theWindow.pMarkFromEdgeVertex->dLengthOfWindowEdgeToThisVertex)
+                            if (theWindow.b0 < m_VertexList[theWindow.dwMarkFromEdgeVertexIdx].dLengthOfWindowEdgeToThisVertex)
                             {
-                                theWindow.pMarkFromEdgeVertex->dLengthOfWindowEdgeToThisVertex = theWindow.b0;
-                                theWindow.pMarkFromEdgeVertex->dGeoDistanceToSrc = theWindow.d0 + theWindow.dPseuSrcToSrcDistance;
+                                m_VertexList[theWindow.dwMarkFromEdgeVertexIdx].dLengthOfWindowEdgeToThisVertex = theWindow.b0;
+                                m_VertexList[theWindow.dwMarkFromEdgeVertexIdx].dGeoDistanceToSrc = theWindow.d0 + theWindow.dPseuSrcToSrcDistance;
                             }
-                            else if (theWindow.b0 == theWindow.pMarkFromEdgeVertex->dLengthOfWindowEdgeToThisVertex)
+                            else if (theWindow.b0 == m_VertexList[theWindow.dwMarkFromEdgeVertexIdx].dLengthOfWindowEdgeToThisVertex)
                             {
-                                theWindow.pMarkFromEdgeVertex->dGeoDistanceToSrc =
-                                    std::min(theWindow.pMarkFromEdgeVertex->dGeoDistanceToSrc, theWindow.d0 + theWindow.dPseuSrcToSrcDistance);
+                                m_VertexList[theWindow.dwMarkFromEdgeVertexIdx].dGeoDistanceToSrc =
+                                    std::min(m_VertexList[theWindow.dwMarkFromEdgeVertexIdx].dGeoDistanceToSrc, theWindow.d0 + theWindow.dPseuSrcToSrcDistance);
                             }
 
-                            if (theWindow.pMarkFromEdgeVertex->dGeoDistanceToSrc == (theWindow.d0 + theWindow.dPseuSrcToSrcDistance))
+                            if (m_VertexList[theWindow.dwMarkFromEdgeVertexIdx].dGeoDistanceToSrc == (theWindow.d0 + theWindow.dPseuSrcToSrcDistance))
                             {
-                                theWindow.pMarkFromEdgeVertex->pEdgeReportedGeoDist = theWindow.pEdge;
+                                m_VertexList[theWindow.dwMarkFromEdgeVertexIdx].pEdgeReportedGeoDist = &m_EdgeList[theWindow.dwEdgeIdx];
                             }
                         }
                         else
                         {
                             Vertex *pAnotherPt = &m_VertexList[i];
-                            if (theWindow.b1 > (theWindow.pEdge->dEdgeLength - pAnotherPt->dLengthOfWindowEdgeToThisVertex))
+                            if (theWindow.b1 > (m_EdgeList[theWindow.dwEdgeIdx].dEdgeLength - pAnotherPt->dLengthOfWindowEdgeToThisVertex))
                             {
-                                pAnotherPt->dLengthOfWindowEdgeToThisVertex = theWindow.pEdge->dEdgeLength - theWindow.b1;
+                                pAnotherPt->dLengthOfWindowEdgeToThisVertex = m_EdgeList[theWindow.dwEdgeIdx].dEdgeLength - theWindow.b1;
                                 pAnotherPt->dGeoDistanceToSrc = theWindow.d1 + theWindow.dPseuSrcToSrcDistance;
                             }
-                            else if (theWindow.b1 == (theWindow.pEdge->dEdgeLength - pAnotherPt->dLengthOfWindowEdgeToThisVertex))
+                            else if (theWindow.b1 == (m_EdgeList[theWindow.dwEdgeIdx].dEdgeLength - pAnotherPt->dLengthOfWindowEdgeToThisVertex))
                             {
                                 pAnotherPt->dGeoDistanceToSrc =
                                     std::min(pAnotherPt->dGeoDistanceToSrc, theWindow.d1 + theWindow.dPseuSrcToSrcDistance);
@@ -581,7 +764,7 @@ void CExactOneToAll::InternalRun()
 
                             if (pAnotherPt->dGeoDistanceToSrc == theWindow.d1 + theWindow.dPseuSrcToSrcDistance)
                             {
-                                pAnotherPt->pEdgeReportedGeoDist = theWindow.pEdge;
+                                pAnotherPt->pEdgeReportedGeoDist = &m_EdgeList[theWindow.dwEdgeIdx];
                             }
                         }
                     }
@@ -593,7 +776,8 @@ void CExactOneToAll::InternalRun()
 
 void CExactOneToAll::ProcessNewWindow(_In_ EdgeWindow *pNewEdgeWindow)
 {
-    std::vector<EdgeWindow> NewWindowsList;
+    std::vector<EdgeWindow> &NewWindowsList = m_NewWindowsList;
+    NewWindowsList.clear();
     NewWindowsList.push_back(*pNewEdgeWindow);
 
     size_t j = 0;
@@ -608,17 +792,14 @@ void CExactOneToAll::ProcessNewWindow(_In_ EdgeWindow *pNewEdgeWindow)
 
         bNewWindowNotAvailable = false;
 
-        for (i = 0; i < pNewEdgeWindow->pEdge->WindowsList.size(); ++i)
+        for (i = 0; i < m_EdgeList[pNewEdgeWindow->dwEdgeIdx].WindowsList.size(); ++i)
         {
             bExistingWindowChanged = false;
             bNewWindowChanged = false;
             bExistingWindowNotAvailable = false;
 
             // get a copy of current window on edge
-            auto pExistingWindowItem =
-                new TypeEdgeWindowsHeap::item_type(
-                    std::min(pNewEdgeWindow->pEdge->WindowsList[i].theWindow.d0, pNewEdgeWindow->pEdge->WindowsList[i].theWindow.d1) + pNewEdgeWindow->pEdge->WindowsList[i].theWindow.dPseuSrcToSrcDistance,
-                    pNewEdgeWindow->pEdge->WindowsList[i].theWindow);
+            auto pExistingWindowItem = NewHeapItem(m_EdgeList[pNewEdgeWindow->dwEdgeIdx].WindowsList[i].theWindow);
 
             // the copy of current window on edge is then tested with the new window for intersection
             // after this test, the copy is possibly changed
@@ -642,28 +823,28 @@ void CExactOneToAll::ProcessNewWindow(_In_ EdgeWindow *pNewEdgeWindow)
             if (bExistingWindowChanged)
             {
                 // whether the window is in heap
-                if (pNewEdgeWindow->pEdge->WindowsList[i].pHeapItem)
+                if (m_EdgeList[pNewEdgeWindow->dwEdgeIdx].WindowsList[i].pHeapItem)
                 {
                     // get the item in heap and remove it from the heap
-                    TypeEdgeWindowsHeap::item_type *pHeapItem = pNewEdgeWindow->pEdge->WindowsList[i].pHeapItem;
+                    TypeEdgeWindowsHeap::item_type *pHeapItem = m_EdgeList[pNewEdgeWindow->dwEdgeIdx].WindowsList[i].pHeapItem;
 
                     m_EdgeWindowsHeap.remove(pHeapItem);
-                    delete pHeapItem;
+                    m_HeapItemPool.Free(pHeapItem);
 
                     // if the existing window still available (b0<b1), we insert the updated one into heap again
                     // and update the one on edge correspondingly
                     if (!bExistingWindowNotAvailable)
                     {
-                        pNewEdgeWindow->pEdge->WindowsList[i].theWindow = pExistingWindowItem->m_data;
+                        m_EdgeList[pNewEdgeWindow->dwEdgeIdx].WindowsList[i].theWindow = pExistingWindowItem->m_data;
                         pExistingWindowItem->m_weight = std::min(pExistingWindowItem->m_data.d0, pExistingWindowItem->m_data.d1) + pExistingWindowItem->m_data.dPseuSrcToSrcDistance;
                         m_EdgeWindowsHeap.insert(pExistingWindowItem);
-                        pNewEdgeWindow->pEdge->WindowsList[i].pHeapItem = pExistingWindowItem;
+                        m_EdgeList[pNewEdgeWindow->dwEdgeIdx].WindowsList[i].pHeapItem = pExistingWindowItem;
                         bDontDelete = true;
                     }
                     else
                     {
                         // we set a flag here, that this window on edge is to be removed
-                        pNewEdgeWindow->pEdge->WindowsList[i].pHeapItem = reinterpret_cast<TypeEdgeWindowsHeap::item_type *>(FLAG_INVALID_SIZE_T);
+                        m_EdgeList[pNewEdgeWindow->dwEdgeIdx].WindowsList[i].pHeapItem = reinterpret_cast<TypeEdgeWindowsHeap::item_type *>(FLAG_INVALID_SIZE_T);
                     }
                 }
                 else
@@ -671,15 +852,15 @@ void CExactOneToAll::ProcessNewWindow(_In_ EdgeWindow *pNewEdgeWindow)
                     // the window is not in heap, so we just update the one on edge
                     if (!bExistingWindowNotAvailable)
                     {
-                        pNewEdgeWindow->pEdge->WindowsList[i].theWindow = pExistingWindowItem->m_data;
+                        m_EdgeList[pNewEdgeWindow->dwEdgeIdx].WindowsList[i].theWindow = pExistingWindowItem->m_data;
                     }
                     else
-                        pNewEdgeWindow->pEdge->WindowsList[i].pHeapItem = reinterpret_cast<TypeEdgeWindowsHeap::item_type *>(FLAG_INVALID_SIZE_T);
+                        m_EdgeList[pNewEdgeWindow->dwEdgeIdx].WindowsList[i].pHeapItem = reinterpret_cast<TypeEdgeWindowsHeap::item_type *>(FLAG_INVALID_SIZE_T);
                 }
             }
 
             if (!bDontDelete)
-                delete pExistingWindowItem;
+                m_HeapItemPool.Free(pExistingWindowItem);
 
             // if the new window is already unavailable during this iteration, we break ;
             if (bNewWindowNotAvailable)
@@ -687,12 +868,12 @@ void CExactOneToAll::ProcessNewWindow(_In_ EdgeWindow *pNewEdgeWindow)
         }
 
         i = 0;
-        while (i < pNewEdgeWindow->pEdge->WindowsList.size())
+        while (i < m_EdgeList[pNewEdgeWindow->dwEdgeIdx].WindowsList.size())
         {
             // test the remove flag set above, and erase the invalidated window from this edge
-            if (reinterpret_cast<size_t>(pNewEdgeWindow->pEdge->WindowsList[i].pHeapItem) == FLAG_INVALID_SIZE_T)
+            if (reinterpret_cast<size_t>(m_EdgeList[pNewEdgeWindow->dwEdgeIdx].WindowsList[i].pHeapItem) == FLAG_INVALID_SIZE_T)
             {
-                pNewEdgeWindow->pEdge->WindowsList.erase(pNewEdgeWindow->pEdge->WindowsList.begin() + ptrdiff_t(i));
+                m_EdgeList[pNewEdgeWindow->dwEdgeIdx].WindowsList.erase(i);
             }
             else
             {
@@ -700,33 +881,33 @@ void CExactOneToAll::ProcessNewWindow(_In_ EdgeWindow *pNewEdgeWindow)
             }
         }
 
-        if (WindowToBeInserted.pMarkFromEdgeVertex != nullptr && WindowToBeInserted.pEdge != nullptr && (WindowToBeInserted.b1 - WindowToBeInserted.b0 > 0))
+        if (WindowToBeInserted.dwMarkFromEdgeVertexIdx != FLAG_INVALIDDWORD && WindowToBeInserted.dwEdgeIdx != FLAG_INVALIDDWORD && (WindowToBeInserted.b1 - WindowToBeInserted.b0 > 0))
         {
-            auto pNewWindowItem = new TypeEdgeWindowsHeap::item_type(std::min(WindowToBeInserted.d0, WindowToBeInserted.d1) + WindowToBeInserted.dPseuSrcToSrcDistance, WindowToBeInserted);
+            auto pNewWindowItem = NewHeapItem(WindowToBeInserted);
 
             m_EdgeWindowsHeap.insert(pNewWindowItem);
 
-            WindowToBeInserted.pEdge->WindowsList.push_back(Edge::WindowListElement(pNewWindowItem, pNewWindowItem->m_data));
+            m_EdgeList[WindowToBeInserted.dwEdgeIdx].WindowsList.push_back(m_WindowListArena, WindowListElement(pNewWindowItem, pNewWindowItem->m_data));
 
             // update the geodesic distance on vertices affected by this new window
             if (WindowToBeInserted.b0 < 0.01)
             {
-                if ((WindowToBeInserted.d0 + WindowToBeInserted.dPseuSrcToSrcDistance) < WindowToBeInserted.pMarkFromEdgeVertex->dGeoDistanceToSrc)
+                if ((WindowToBeInserted.d0 + WindowToBeInserted.dPseuSrcToSrcDistance) < m_VertexList[WindowToBeInserted.dwMarkFromEdgeVertexIdx].dGeoDistanceToSrc)
                 {
-                    WindowToBeInserted.pMarkFromEdgeVertex->dGeoDistanceToSrc = WindowToBeInserted.d0 + WindowToBeInserted.dPseuSrcToSrcDistance;
-                    WindowToBeInserted.pMarkFromEdgeVertex->dLengthOfWindowEdgeToThisVertex = WindowToBeInserted.b0;
-                    WindowToBeInserted.pMarkFromEdgeVertex->pEdgeReportedGeoDist = WindowToBeInserted.pEdge;
+                    m_VertexList[WindowToBeInserted.dwMarkFromEdgeVertexIdx].dGeoDistanceToSrc = WindowToBeInserted.d0 + WindowToBeInserted.dPseuSrcToSrcDistance;
+                    m_VertexList[WindowToBeInserted.dwMarkFromEdgeVertexIdx].dLengthOfWindowEdgeToThisVertex = WindowToBeInserted.b0;
+                    m_VertexList[WindowToBeInserted.dwMarkFromEdgeVertexIdx].pEdgeReportedGeoDist = &m_EdgeList[WindowToBeInserted.dwEdgeIdx];
                 }
             }
 
-            Vertex *pAnotherPt = WindowToBeInserted.pEdge->GetAnotherVertex(WindowToBeInserted.dwMarkFromEdgeVertexIdx);
-            if (pAnotherPt != nullptr && (WindowToBeInserted.b1 > (WindowToBeInserted.pEdge->dEdgeLength - 0.01)))
+            Vertex *pAnotherPt = m_EdgeList[WindowToBeInserted.dwEdgeIdx].GetAnotherVertex(WindowToBeInserted.dwMarkFromEdgeVertexIdx);
+            if (pAnotherPt != nullptr && (WindowToBeInserted.b1 > (m_EdgeList[WindowToBeInserted.dwEdgeIdx].dEdgeLength - 0.01)))
             {
                 if ((WindowToBeInserted.d1 + WindowToBeInserted.dPseuSrcToSrcDistance) < pAnotherPt->dGeoDistanceToSrc)
                 {
                     pAnotherPt->dGeoDistanceToSrc = WindowToBeInserted.d1 + WindowToBeInserted.dPseuSrcToSrcDistance;
-                    pAnotherPt->dLengthOfWindowEdgeToThisVertex = WindowToBeInserted.pEdge->dEdgeLength - WindowToBeInserted.b1;
-                    pAnotherPt->pEdgeReportedGeoDist = WindowToBeInserted.pEdge;
+                    pAnotherPt->dLengthOfWindowEdgeToThisVertex = m_EdgeList[WindowToBeInserted.dwEdgeIdx].dEdgeLength - WindowToBeInserted.b1;
+                    pAnotherPt->pEdgeReportedGeoDist = &m_EdgeList[WindowToBeInserted.dwEdgeIdx];
                 }
             }
         }
@@ -735,31 +916,31 @@ void CExactOneToAll::ProcessNewWindow(_In_ EdgeWindow *pNewEdgeWindow)
         // add it to the edge and heap
         if (!bNewWindowNotAvailable /*pNewEdgeWindow->b0 < pNewEdgeWindow->b1*/)
         {
-            auto pNewWindowItem = new TypeEdgeWindowsHeap::item_type(std::min(pNewEdgeWindow->d0, pNewEdgeWindow->d1) + pNewEdgeWindow->dPseuSrcToSrcDistance, *pNewEdgeWindow);
+            auto pNewWindowItem = NewHeapItem(*pNewEdgeWindow);
 
             m_EdgeWindowsHeap.insert(pNewWindowItem);
 
-            pNewEdgeWindow->pEdge->WindowsList.push_back(Edge::WindowListElement(pNewWindowItem, pNewWindowItem->m_data));
+            m_EdgeList[pNewEdgeWindow->dwEdgeIdx].WindowsList.push_back(m_WindowListArena, WindowListElement(pNewWindowItem, pNewWindowItem->m_data));
 
             // update the geodesic distance on vertices affected by this new window
-            if (pNewEdgeWindow->pMarkFromEdgeVertex != nullptr && (pNewEdgeWindow->b0 < 0.01))
+            if (pNewEdgeWindow->dwMarkFromEdgeVertexIdx != FLAG_INVALIDDWORD && (pNewEdgeWindow->b0 < 0.01))
             {
-                if ((pNewEdgeWindow->d0 + pNewEdgeWindow->dPseuSrcToSrcDistance) < pNewEdgeWindow->pMarkFromEdgeVertex->dGeoDistanceToSrc)
+                if ((pNewEdgeWindow->d0 + pNewEdgeWindow->dPseuSrcToSrcDistance) < m_VertexList[pNewEdgeWindow->dwMarkFromEdgeVertexIdx].dGeoDistanceToSrc)
                 {
-                    pNewEdgeWindow->pMarkFromEdgeVertex->dGeoDistanceToSrc = pNewEdgeWindow->d0 + pNewEdgeWindow->dPseuSrcToSrcDistance;
-                    pNewEdgeWindow->pMarkFromEdgeVertex->dLengthOfWindowEdgeToThisVertex = pNewEdgeWindow->b0;
-                    pNewEdgeWindow->pMarkFromEdgeVertex->pEdgeReportedGeoDist = pNewEdgeWindow->pEdge;
+                    m_VertexList[pNewEdgeWindow->dwMarkFromEdgeVertexIdx].dGeoDistanceToSrc = pNewEdgeWindow->d0 + pNewEdgeWindow->dPseuSrcToSrcDistance;
+                    m_VertexList[pNewEdgeWindow->dwMarkFromEdgeVertexIdx].dLengthOfWindowEdgeToThisVertex = pNewEdgeWindow->b0;
+                    m_VertexList[pNewEdgeWindow->dwMarkFromEdgeVertexIdx].pEdgeReportedGeoDist = &m_EdgeList[pNewEdgeWindow->dwEdgeIdx];
                 }
             }
 
-            Vertex *pAnotherPt = pNewEdgeWindow->pEdge->GetAnotherVertex(pNewEdgeWindow->dwMarkFromEdgeVertexIdx);
-            if (pAnotherPt && (pNewEdgeWindow->b1 > (pNewEdgeWindow->pEdge->dEdgeLength - 0.01)))
+            Vertex *pAnotherPt = m_EdgeList[pNewEdgeWindow->dwEdgeIdx].GetAnotherVertex(pNewEdgeWindow->dwMarkFromEdgeVertexIdx);
+            if (pAnotherPt && (pNewEdgeWindow->b1 > (m_EdgeList[pNewEdgeWindow->dwEdgeIdx].dEdgeLength - 0.01)))
             {
                 if ((pNewEdgeWindow->d1 + pNewEdgeWindow->dPseuSrcToSrcDistance) < pAnotherPt->dGeoDistanceToSrc)
                 {
                     pAnotherPt->dGeoDistanceToSrc = pNewEdgeWindow->d1 + pNewEdgeWindow->dPseuSrcToSrcDistance;
-                    pAnotherPt->dLengthOfWindowEdgeToThisVertex = pNewEdgeWindow->pEdge->dEdgeLength - pNewEdgeWindow->b1;
-                    pAnotherPt->pEdgeReportedGeoDist = pNewEdgeWindow->pEdge;
+                    pAnotherPt->dLengthOfWindowEdgeToThisVertex = m_EdgeList[pNewEdgeWindow->dwEdgeIdx].dEdgeLength - pNewEdgeWindow->b1;
+                    pAnotherPt->pEdgeReportedGeoDist = &m_EdgeList[pNewEdgeWindow->dwEdgeIdx];
                 }
             }
         }
@@ -796,16 +977,15 @@ void CExactOneToAll::IntersectWindow(_In_ EdgeWindow *pExistingWindow,
     if (pExistingWindow->dwMarkFromEdgeVertexIdx != pNewWindow->dwMarkFromEdgeVertexIdx)
     {
         pNewWindow->dwMarkFromEdgeVertexIdx = pExistingWindow->dwMarkFromEdgeVertexIdx;
-        pNewWindow->pMarkFromEdgeVertex = pExistingWindow->pMarkFromEdgeVertex;
         std::swap(pNewWindow->d0, pNewWindow->d1);
         std::swap(pNewWindow->b0, pNewWindow->b1);
-        pNewWindow->b0 = std::max<double>(pNewWindow->pEdge->dEdgeLength - pNewWindow->b0, 0);
+        pNewWindow->b0 = std::max<double>(m_EdgeList[pNewWindow->dwEdgeIdx].dEdgeLength - pNewWindow->b0, 0);
         if (pNewWindow->b0 < double(FLT_EPSILON))
         {
             pNewWindow->b0 = 0;
         }
-        pNewWindow->b1 = pNewWindow->pEdge->dEdgeLength - pNewWindow->b1;
-        pNewWindow->dv2Src.x = pNewWindow->pEdge->dEdgeLength - pNewWindow->dv2Src.x;
+        pNewWindow->b1 = m_EdgeList[pNewWindow->dwEdgeIdx].dEdgeLength - pNewWindow->b1;
+        pNewWindow->dv2Src.x = m_EdgeList[pNewWindow->dwEdgeIdx].dEdgeLength - pNewWindow->dv2Src.x;
     }
 
     double a = std::min(std::min(std::min(pExistingWindow->b0, pExistingWindow->b1), pNewWindow->b0), pNewWindow->b1);
@@ -852,15 +1032,14 @@ void CExactOneToAll::IntersectWindow(_In_ EdgeWindow *pExistingWindow,
             m_NewExistingWindow.b1 = pNewWindow->b0;
             m_NewExistingWindow.dv2Src = pExistingWindow->dv2Src;
             m_NewExistingWindow.d0 = pExistingWindow->d0;
-            m_NewExistingWindow.SetEdgeIdx(m_EdgeList, pExistingWindow->dwEdgeIdx);
-            m_NewExistingWindow.SetFaceIdxPropagatedFrom(m_FaceList, pExistingWindow->dwFaceIdxPropagatedFrom);
-            m_NewExistingWindow.SetMarkFromEdgeVertexIdx(m_VertexList, pExistingWindow->dwMarkFromEdgeVertexIdx);
-            m_NewExistingWindow.SetPseuSrcVertexIdx(m_VertexList, pExistingWindow->dwPseuSrcVertexIdx);
+            m_NewExistingWindow.dwEdgeIdx = pExistingWindow->dwEdgeIdx;
+            m_NewExistingWindow.dwFaceIdxPropagatedFrom = pExistingWindow->dwFaceIdxPropagatedFrom;
+            m_NewExistingWindow.dwMarkFromEdgeVertexIdx = pExistingWindow->dwMarkFromEdgeVertexIdx;
+            m_NewExistingWindow.dwPseuSrcVertexIdx = pExistingWindow->dwPseuSrcVertexIdx;
             m_NewExistingWindow.d1 = sqrt(SquredD2Dist(DVector2(m_NewExistingWindow.b1, 0), m_NewExistingWindow.dv2Src));
             m_NewExistingWindow.dPseuSrcToSrcDistance = pExistingWindow->dPseuSrcToSrcDistance;
 
             m_NewExistingWindow.ksi = pExistingWindow->ksi;
-            m_NewExistingWindow.pEdgePropagatedFrom = pExistingWindow->pEdgePropagatedFrom;
 
             pExistingWindow->b0 = pNewWindow->b0;
             pExistingWindow->d0 = sqrt(SquredD2Dist(DVector2(pExistingWindow->b0, 0), ExistingWindowSrc));
@@ -885,15 +1064,14 @@ void CExactOneToAll::IntersectWindow(_In_ EdgeWindow *pExistingWindow,
             m_AnotherNewWindow.b1 = pExistingWindow->b0;
             m_AnotherNewWindow.dv2Src = pNewWindow->dv2Src;
             m_AnotherNewWindow.d0 = pNewWindow->d0;
-            m_AnotherNewWindow.SetEdgeIdx(m_EdgeList, pNewWindow->dwEdgeIdx);
-            m_AnotherNewWindow.SetFaceIdxPropagatedFrom(m_FaceList, pNewWindow->dwFaceIdxPropagatedFrom);
-            m_AnotherNewWindow.SetMarkFromEdgeVertexIdx(m_VertexList, pNewWindow->dwMarkFromEdgeVertexIdx);
-            m_AnotherNewWindow.SetPseuSrcVertexIdx(m_VertexList, pNewWindow->dwPseuSrcVertexIdx);
+            m_AnotherNewWindow.dwEdgeIdx = pNewWindow->dwEdgeIdx;
+            m_AnotherNewWindow.dwFaceIdxPropagatedFrom = pNewWindow->dwFaceIdxPropagatedFrom;
+            m_AnotherNewWindow.dwMarkFromEdgeVertexIdx = pNewWindow->dwMarkFromEdgeVertexIdx;
+            m_AnotherNewWindow.dwPseuSrcVertexIdx = pNewWindow->dwPseuSrcVertexIdx;
             m_AnotherNewWindow.d1 = sqrt(SquredD2Dist(DVector2(m_AnotherNewWindow.b1, 0), m_AnotherNewWindow.dv2Src));
             m_AnotherNewWindow.dPseuSrcToSrcDistance = pNewWindow->dPseuSrcToSrcDistance;
 
             m_AnotherNewWindow.ksi = pNewWindow->ksi;
-            m_AnotherNewWindow.pEdgePropagatedFrom = pNewWindow->pEdgePropagatedFrom;
 
             pNewWindow->b0 = pExistingWindow->b0;
             pNewWindow->d0 = sqrt(SquredD2Dist(DVector2(pNewWindow->b0, 0), NewWindowSrc));
@@ -1077,25 +1255,23 @@ void CExactOneToAll::GenerateWindowsAroundSaddleOrBoundaryVertex(const EdgeWindo
 {
     WindowsOut.clear();
 
-    for (size_t i = 0; i < m_VertexList[dwSaddleOrBoundaryVertexId].facesAdj.size(); ++i)
+    for (uint32_t i = m_pTopology->vertexFaceStart[dwSaddleOrBoundaryVertexId]; i < m_pTopology->vertexFaceStart[dwSaddleOrBoundaryVertexId + 1]; ++i)
     {
         EdgeWindow tmpWindow;
+        const uint32_t dwFaceIdx = m_pTopology->vertexFaces[i];
 
-        tmpWindow.SetEdgeIdx(m_EdgeList, m_VertexList[dwSaddleOrBoundaryVertexId].facesAdj[i]->GetOpposingEdgeIdx(dwSaddleOrBoundaryVertexId));
-        tmpWindow.SetFaceIdxPropagatedFrom(m_FaceList, static_cast<uint32_t>(reinterpret_cast<intptr_t>(m_VertexList[dwSaddleOrBoundaryVertexId].facesAdj[i]) - reinterpret_cast<intptr_t>(&m_FaceList[0])) / sizeof(Face));
-        tmpWindow.SetMarkFromEdgeVertexIdx(m_VertexList, tmpWindow.pEdge->dwVertexIdx0);
-        tmpWindow.SetPseuSrcVertexIdx(m_VertexList, dwSaddleOrBoundaryVertexId);
+        tmpWindow.dwEdgeIdx = m_FaceList[dwFaceIdx].GetOpposingEdgeIdx(dwSaddleOrBoundaryVertexId);
+        tmpWindow.dwFaceIdxPropagatedFrom = dwFaceIdx;
+        tmpWindow.dwMarkFromEdgeVertexIdx = m_EdgeList[tmpWindow.dwEdgeIdx].dwVertexIdx0;
+        tmpWindow.dwPseuSrcVertexIdx = dwSaddleOrBoundaryVertexId;
         tmpWindow.b0 = 0;
-        tmpWindow.b1 = tmpWindow.pEdge->dEdgeLength;
-        tmpWindow.d0 = sqrt(SquredD3Dist(*tmpWindow.pEdge->pVertex0, m_VertexList[dwSaddleOrBoundaryVertexId]));
-        tmpWindow.d1 = sqrt(SquredD3Dist(*tmpWindow.pEdge->pVertex1, m_VertexList[dwSaddleOrBoundaryVertexId]));
+        tmpWindow.b1 = m_EdgeList[tmpWindow.dwEdgeIdx].dEdgeLength;
+        tmpWindow.d0 = sqrt(SquredD3Dist(*m_EdgeList[tmpWindow.dwEdgeIdx].pVertex0, m_VertexList[dwSaddleOrBoundaryVertexId]));
+        tmpWindow.d1 = sqrt(SquredD3Dist(*m_EdgeList[tmpWindow.dwEdgeIdx].pVertex1, m_VertexList[dwSaddleOrBoundaryVertexId]));
         tmpWindow.dPseuSrcToSrcDistance = (iwindow.dwMarkFromEdgeVertexIdx == dwSaddleOrBoundaryVertexId ? iwindow.d0 : iwindow.d1) + iwindow.dPseuSrcToSrcDistance;
-        ParameterizePt3ToPt2(*tmpWindow.pEdge->pVertex0, *tmpWindow.pEdge->pVertex1, m_VertexList[dwSaddleOrBoundaryVertexId], tmpWindow.dv2Src);
+        ParameterizePt3ToPt2(*m_EdgeList[tmpWindow.dwEdgeIdx].pVertex0, *m_EdgeList[tmpWindow.dwEdgeIdx].pVertex1, m_VertexList[dwSaddleOrBoundaryVertexId], tmpWindow.dv2Src);
 
         tmpWindow.ksi = iwindow.ksi;
-        tmpWindow.pEdgePropagatedFrom = iwindow.pEdge;
-
-        tmpWindow.dwTag = 1;
 
         WindowsOut.push_back(tmpWindow);
     }
@@ -13,6 +13,35 @@
 
 namespace GeodesicDist
 {
+    // The mesh the one-to-all engines run on, with indices in place of
+    // pointers, so it is built once and shared by the engines of several
+    // threads. The faces and edges of each vertex are stored in compressed
+    // rows: the faces of vertex i are vertexFaces[vertexFaceStart[i]] to
+    // vertexFaces[vertexFaceStart[i + 1] - 1], by increasing index.
+    struct MeshTopology
+    {
+        std::vector<DVector3> vertexPositions;
+        std::vector<uint8_t> vertexBoundary;
+        std::vector<uint32_t> edgeVertices; // 2 per edge
+        std::vector<uint32_t> edgeFaces;    // 2 per edge, the second is FLAG_INVALIDDWORD on boundary edges
+        std::vector<uint32_t> faceEdges;    // 3 per face
+        std::vector<uint32_t> faceVertices; // 3 per face
+
+        // computed by Build() from the members above
+        std::vector<double> edgeLengths;
+        std::vector<double> vertexAngles; // the sum of the angles of the faces at each vertex
+        std::vector<uint32_t> vertexFaceStart;
+        std::vector<uint32_t> vertexFaces;
+        std::vector<uint32_t> vertexEdgeStart;
+        std::vector<uint32_t> vertexEdges;
+
+        size_t GetVertexNumber() const noexcept { return vertexPositions.size(); }
+        size_t GetEdgeNumber() const noexcept { return edgeVertices.size() / 2; }
+        size_t GetFaceNumber() const noexcept { return faceVertices.size() / 3; }
+
+        // Throws std::bad_alloc
+        void Build();
+    };
 
     class CExactOneToAll
     {
@@ -25,11 +54,29 @@ namespace GeodesicDist
         size_t m_dwNumVertices;
         uint32_t m_dwSrcVertexIdx;
 
+        const MeshTopology *m_pTopology; // set by Init(), owned by the caller
+
+        // bound of the runs, see SetBound()
+        double m_dMaxDistance;
+        const uint32_t *m_pdwTargets;
+        size_t m_dwTargetNumber;
+        size_t m_dwTargetCount;
+
         EdgeWindow m_AnotherNewWindow;
         EdgeWindow m_NewExistingWindow;
 
         TypeEdgeWindowsHeap m_EdgeWindowsHeap;
 
+        // The heap items and the windows lists of the edges are kept from one
+        // source to the next
+        CObjectPool<TypeEdgeWindowsHeap::item_type> m_HeapItemPool;
+        CWindowListArena m_WindowListArena;
+
+        std::vector<EdgeWindow> m_NewWindowsList; // scratch of ProcessNewWindow()
+        std::vector<uint32_t> m_SrcEdges;         // scratch of SetSrcVertexIdx()
+
+        std::function<bool()> m_fnIsStopped;
+
         virtual void CutHeapTopData(EdgeWindow &EdgeWindowOut);
         void ProcessNewWindow(_In_ EdgeWindow *pNewEdgeWindow);
         void IntersectWindow(_In_ EdgeWindow *pExistingWindow,
@@ -43,6 +90,8 @@ namespace GeodesicDist
             std::vector<EdgeWindow> &WindowsOut);
         void InternalRun();
         void AddWindowToHeapAndEdge(const EdgeWindow &WindowToAdd);
+        bool AreTargetsSettled(double dDistance) const;
+        TypeEdgeWindowsHeap::item_type *NewHeapItem(const EdgeWindow &Window);
 
     public:
         TypeEdgeList m_EdgeList;
@@ -55,9 +104,24 @@ namespace GeodesicDist
         CExactOneToAll();
         virtual ~CExactOneToAll() = default;
 
+        // Builds the lists of the engine from a topology, which must outlive
+        // the engine or the next Init(). Throws std::bad_alloc.
+        void Init(const MeshTopology &topology);
+
         // set the source vertex index before run
         void SetSrcVertexIdx(const uint32_t dwSrcVertexIdx);
 
+        // set a function polled while the algorithm runs, Run() returns early
+        // with incomplete distances when it returns true
+        void SetStopCheck(std::function<bool()> fnIsStopped);
+
+        // Bounds the following runs, which stop once the windows left are all
+        // farther from the source than dMaxDistance, or than dwTargetCount of
+        // the dwTargetNumber vertices of pdwTargets. The distances of the
+        // vertices beyond are left incomplete. pdwTargets must outlive the
+        // runs, SetBound(DBL_MAX, nullptr, 0, 0) for complete runs.
+        void SetBound(double dMaxDistance, const uint32_t *pdwTargets, size_t dwTargetNumber, size_t dwTargetCount);
+
         // run the algorithm
         void Run();
     };
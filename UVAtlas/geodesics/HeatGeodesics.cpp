@@ -0,0 +1,507 @@
+//-------------------------------------------------------------------------------------
+// UVAtlas - HeatGeodesics.cpp
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//-------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "HeatGeodesics.h"
+
+using namespace GeodesicDist;
+
+namespace
+{
+    // faces whose doubled area is below this ratio of their squared longest
+    // edge are degenerate, and left out of the operators
+    constexpr double DEGENERATE_FACE_RATIO = 1e-12;
+
+    // The heat of the single step decays by about exp(-distance / sqrt(t)), so
+    // sqrt(t) is kept above the mesh size over this ratio for the heat to stay
+    // far from underflow at the other end of large meshes.
+    constexpr double MAX_DECAY_LENGTH_RATIO = 500.0;
+
+    // regularization of the Poisson system, relative to the mass matrix
+    // scaled to the magnitude of the Laplacian
+    constexpr double POISSON_REGULARIZATION = 1e-8;
+
+    // edges whose opposite cotangents sum below -DELAUNAY_TOLERANCE are not
+    // Delaunay, the tolerance keeps round-off from flipping edges back and forth
+    constexpr double DELAUNAY_TOLERANCE = 1e-10;
+
+    // bounds the flips, which always terminate in exact arithmetic, times the
+    // face count
+    constexpr size_t MAX_FLIPS_PER_FACE = 16;
+
+    constexpr uint32_t NO_TWIN = UINT32_MAX;
+
+    inline size_t NextHalfEdge(size_t h) noexcept { return 3 * (h / 3) + (h + 1) % 3; }
+    inline size_t PrevHalfEdge(size_t h) noexcept { return 3 * (h / 3) + (h + 2) % 3; }
+
+    // Cotangent of the angle opposite side c, in the triangle of sides a, b
+    // and c. 4 * area is computed by Heron's formula.
+    double OppositeCotangent(double a, double b, double c) noexcept
+    {
+        const double dSquaredArea16 = (a + b + c) * (-a + b + c) * (a - b + c) * (a + b - c);
+        if (!(dSquaredArea16 > 0.0))
+        {
+            return 0.0;
+        }
+        return (a * a + b * b - c * c) / sqrt(dSquaredArea16);
+    }
+
+    double OppositeAngle(double a, double b, double c) noexcept
+    {
+        const double dCos = (a * a + b * b - c * c) / (2.0 * a * b);
+        return acos(std::max(-1.0, std::min(1.0, dCos)));
+    }
+
+    // Flips the edges of a triangulation, given by its edge lengths, until
+    // it is intrinsically Delaunay:
+    //  [FSBS06] FISHER M., SPRINGBORN B., BOBENKO A. I., SCHRODER P.:
+    //  An algorithm for the construction of intrinsic Delaunay triangulations
+    //  with applications to digital geometry processing. SIGGRAPH Courses (2006)
+    //
+    // The surface and its metric are unchanged, only the edges are replaced by
+    // other geodesics on it, so the cotangent weights of the result are all
+    // positive. Half edge h of face h / 3 runs from faceVerts[h] to the next
+    // corner, edgeLengths[h] is its length and twins[h] the opposite half
+    // edge. The edges of fixed faces are not flipped.
+    void FlipToIntrinsicDelaunay(
+        std::vector<uint32_t> &faceVerts,
+        std::vector<double> &edgeLengths,
+        std::vector<uint32_t> &twins,
+        const std::vector<bool> &isFixedFace)
+    {
+        std::vector<size_t> candidates;
+        for (size_t h = 0; h < twins.size(); ++h)
+        {
+            if (twins[h] != NO_TWIN && h < twins[h])
+            {
+                candidates.push_back(h);
+            }
+        }
+
+        const size_t dwMaxFlips = MAX_FLIPS_PER_FACE * isFixedFace.size();
+        size_t dwFlips = 0;
+        while (!candidates.empty() && dwFlips < dwMaxFlips)
+        {
+            // h runs from a to b in face (a, b, c), t from b to a in (b, a, d)
+            const size_t h = candidates.back();
+            candidates.pop_back();
+            const size_t t = twins[h];
+            if (t == NO_TWIN || h / 3 == t / 3 || isFixedFace[h / 3] || isFixedFace[t / 3])
+            {
+                continue;
+            }
+
+            const size_t hn = NextHalfEdge(h);
+            const size_t hp = PrevHalfEdge(h);
+            const size_t tn = NextHalfEdge(t);
+            const size_t tp = PrevHalfEdge(t);
+
+            const double dAB = edgeLengths[h];
+            const double dBC = edgeLengths[hn];
+            const double dCA = edgeLengths[hp];
+            const double dAD = edgeLengths[tn];
+            const double dDB = edgeLengths[tp];
+
+            if (OppositeCotangent(dBC, dCA, dAB) + OppositeCotangent(dAD, dDB, dAB) >= -DELAUNAY_TOLERANCE)
+            {
+                continue;
+            }
+
+            const uint32_t a = faceVerts[h];
+            const uint32_t b = faceVerts[hn];
+            const uint32_t c = faceVerts[hp];
+            const uint32_t d = faceVerts[tp];
+            if (c == d)
+            {
+                continue;
+            }
+
+            // Unfold the two faces around a, the new edge joins c and d
+            const double dAngle = OppositeAngle(dAB, dCA, dBC) + OppositeAngle(dAB, dAD, dDB);
+            const double dCD = sqrt(std::max(0.0, dCA * dCA + dAD * dAD - 2.0 * dCA * dAD * cos(dAngle)));
+            if (!(dCD > 0.0))
+            {
+                continue;
+            }
+
+            const uint32_t dwTwinBC = twins[hn];
+            const uint32_t dwTwinCA = twins[hp];
+            const uint32_t dwTwinAD = twins[tn];
+            const uint32_t dwTwinDB = twins[tp];
+
+            // The faces become (a, d, c) and (d, b, c)
+            const size_t f0 = 3 * (h / 3);
+            const size_t f1 = 3 * (t / 3);
+            const uint32_t dwVerts[6] = { a, d, c, d, b, c };
+            const double dLengths[6] = { dAD, dCD, dCA, dDB, dBC, dCD };
+            const uint32_t dwTwins[6] = { dwTwinAD, uint32_t(f1 + 2), dwTwinCA, dwTwinDB, dwTwinBC, uint32_t(f0 + 1) };
+            for (size_t i = 0; i < 3; ++i)
+            {
+                faceVerts[f0 + i] = dwVerts[i];
+                faceVerts[f1 + i] = dwVerts[3 + i];
+                edgeLengths[f0 + i] = dLengths[i];
+                edgeLengths[f1 + i] = dLengths[3 + i];
+                twins[f0 + i] = dwTwins[i];
+                twins[f1 + i] = dwTwins[3 + i];
+            }
+
+            const size_t dwOuter[4] = { f0, f0 + 2, f1, f1 + 1 };
+            for (const size_t dwHalfEdge : dwOuter)
+            {
+                if (twins[dwHalfEdge] != NO_TWIN)
+                {
+                    twins[twins[dwHalfEdge]] = uint32_t(dwHalfEdge);
+                    candidates.push_back(dwHalfEdge);
+                }
+            }
+            ++dwFlips;
+        }
+    }
+}
+
+bool CHeatGeodesics::Init(
+    const std::vector<DVector3> &vertices,
+    const uint32_t *pdwIndices,
+    size_t dwNumFaces)
+{
+    m_dwNumVertices = vertices.size();
+    m_dwNumFaces = dwNumFaces;
+    m_HeatSolver.Clear();
+    m_DirichletHeatSolver.Clear();
+    m_PoissonSolver.Clear();
+
+    if (m_dwNumVertices == 0 || dwNumFaces == 0 || m_dwNumVertices >= UINT32_MAX || 3 * dwNumFaces >= UINT32_MAX)
+    {
+        return false;
+    }
+
+    m_Indices.assign(pdwIndices, pdwIndices + 3 * dwNumFaces);
+    m_HatGradients.assign(3 * dwNumFaces, DVector3());
+    m_HalfCotangents.assign(3 * dwNumFaces, 0.0);
+    m_CornerPositions.assign(3 * dwNumFaces, DVector3());
+
+    DVector3 minBound = vertices[0];
+    DVector3 maxBound = vertices[0];
+    for (const DVector3 &v : vertices)
+    {
+        minBound.x = std::min(minBound.x, v.x);
+        minBound.y = std::min(minBound.y, v.y);
+        minBound.z = std::min(minBound.z, v.z);
+        maxBound.x = std::max(maxBound.x, v.x);
+        maxBound.y = std::max(maxBound.y, v.y);
+        maxBound.z = std::max(maxBound.z, v.z);
+    }
+
+    // Edge lengths of the mesh, half edge h runs from corner h to the next one
+    std::vector<double> edgeLengths(3 * dwNumFaces);
+    std::vector<bool> isDegenerate(dwNumFaces, false);
+    double dEdgeLengthSum = 0.0;
+
+    for (size_t f = 0; f < dwNumFaces; ++f)
+    {
+        const uint32_t *pdwFace = &m_Indices[3 * f];
+        if (pdwFace[0] >= m_dwNumVertices || pdwFace[1] >= m_dwNumVertices || pdwFace[2] >= m_dwNumVertices)
+        {
+            return false;
+        }
+
+        DVector3 e[3];
+        DVector3Minus(vertices[pdwFace[1]], vertices[pdwFace[0]], e[0]);
+        DVector3Minus(vertices[pdwFace[2]], vertices[pdwFace[1]], e[1]);
+        DVector3Minus(vertices[pdwFace[0]], vertices[pdwFace[2]], e[2]);
+
+        DVector3 normal;
+        DVector3Cross(e[0], e[1], normal);
+
+        double dMaxSquaredEdge = 0.0;
+        for (size_t i = 0; i < 3; ++i)
+        {
+            edgeLengths[3 * f + i] = e[i].Length();
+            dMaxSquaredEdge = std::max(dMaxSquaredEdge, edgeLengths[3 * f + i] * edgeLengths[3 * f + i]);
+            dEdgeLengthSum += edgeLengths[3 * f + i];
+        }
+        isDegenerate[f] = normal.Length() <= DEGENERATE_FACE_RATIO * dMaxSquaredEdge;
+    }
+
+    if (dEdgeLengthSum <= 0.0)
+    {
+        return false;
+    }
+
+    // Pair the half edges of each edge. Boundary vertices are the ends of the
+    // edges used by a single face. Edges of more than two faces, or of two
+    // faces of opposite orientations, are not paired and never flipped.
+    std::vector<std::pair<std::pair<uint32_t, uint32_t>, uint32_t>> edges(3 * dwNumFaces);
+    for (size_t h = 0; h < 3 * dwNumFaces; ++h)
+    {
+        const uint32_t v0 = m_Indices[h];
+        const uint32_t v1 = m_Indices[NextHalfEdge(h)];
+        edges[h] = std::make_pair(std::make_pair(std::min(v0, v1), std::max(v0, v1)), uint32_t(h));
+    }
+    std::sort(edges.begin(), edges.end());
+
+    std::vector<uint32_t> twins(3 * dwNumFaces, NO_TWIN);
+    m_IsBoundary.assign(m_dwNumVertices, false);
+    size_t dwBoundaryCount = 0;
+    for (size_t i = 0; i < edges.size();)
+    {
+        size_t j = i + 1;
+        while (j < edges.size() && edges[j].first == edges[i].first)
+        {
+            ++j;
+        }
+        if (j - i == 1)
+        {
+            for (const uint32_t v : { edges[i].first.first, edges[i].first.second })
+            {
+                if (!m_IsBoundary[v])
+                {
+                    m_IsBoundary[v] = true;
+                    ++dwBoundaryCount;
+                }
+            }
+        }
+        else if (j - i == 2)
+        {
+            const uint32_t h0 = edges[i].second;
+            const uint32_t h1 = edges[i + 1].second;
+            if (m_Indices[h0] == m_Indices[NextHalfEdge(h1)])
+            {
+                twins[h0] = h1;
+                twins[h1] = h0;
+            }
+        }
+        i = j;
+    }
+
+    // The obtuse triangles of the mesh give negative cotangent weights, with
+    // which the heat is no longer a good guide to the distance gradient. The
+    // operators are built on the intrinsic Delaunay triangulation of the
+    // surface instead ([CWW13] 3.2), each face laid out flat on its own.
+    FlipToIntrinsicDelaunay(m_Indices, edgeLengths, twins, isDegenerate);
+
+    std::vector<double> mass(m_dwNumVertices, 0.0);
+    std::vector<CSparseLDLT::Triplet> laplacian;
+    laplacian.reserve(9 * dwNumFaces);
+
+    for (size_t f = 0; f < dwNumFaces; ++f)
+    {
+        const uint32_t *pdwFace = &m_Indices[3 * f];
+        const double dL01 = edgeLengths[3 * f];
+        const double dL12 = edgeLengths[3 * f + 1];
+        const double dL20 = edgeLengths[3 * f + 2];
+        if (isDegenerate[f] || !(dL01 > 0.0))
+        {
+            continue;
+        }
+
+        // corner 0 at the origin, corner 1 on the x axis
+        DVector3 *pCorners = &m_CornerPositions[3 * f];
+        pCorners[1].x = dL01;
+        pCorners[2].x = (dL01 * dL01 + dL20 * dL20 - dL12 * dL12) / (2.0 * dL01);
+        pCorners[2].y = sqrt(std::max(0.0, dL20 * dL20 - pCorners[2].x * pCorners[2].x));
+
+        // e[i] is the edge opposite corner i, counterclockwise
+        DVector3 e[3];
+        DVector3Minus(pCorners[2], pCorners[1], e[0]);
+        DVector3Minus(pCorners[0], pCorners[2], e[1]);
+        DVector3Minus(pCorners[1], pCorners[0], e[2]);
+
+        const double dDoubleArea = dL01 * pCorners[2].y;
+        const double dMaxEdge = std::max(dL01, std::max(dL12, dL20));
+        if (dDoubleArea <= DEGENERATE_FACE_RATIO * dMaxEdge * dMaxEdge)
+        {
+            continue;
+        }
+
+        DVector3 normal;
+        normal.z = 1.0;
+        for (size_t i = 0; i < 3; ++i)
+        {
+            // gradient of the hat function of corner i: (n x e[i]) / (2 * area)
+            DVector3 &gradient = m_HatGradients[3 * f + i];
+            DVector3Cross(normal, e[i], gradient);
+            DVector3ScalarMul(gradient, 1.0 / dDoubleArea);
+
+            // cot of the angle at corner i, between -e[i+2] and e[i+1]
+            const DVector3 &next = e[(i + 1) % 3];
+            const DVector3 &prev = e[(i + 2) % 3];
+            m_HalfCotangents[3 * f + i] = -0.5 * DVector3Dot(prev, next) / dDoubleArea;
+
+            mass[pdwFace[i]] += dDoubleArea / 6.0;
+        }
+
+        // cotangent Laplacian, positive semi-definite
+        for (size_t k = 0; k < 3; ++k)
+        {
+            const uint32_t i = pdwFace[(k + 1) % 3];
+            const uint32_t j = pdwFace[(k + 2) % 3];
+            const double w = m_HalfCotangents[3 * f + k];
+            laplacian.push_back({ i, i, w });
+            laplacian.push_back({ j, j, w });
+            laplacian.push_back({ i, j, -w });
+        }
+    }
+
+    DVector3 diagonal;
+    DVector3Minus(maxBound, minBound, diagonal);
+    const double dMeanEdge = dEdgeLengthSum / double(3 * dwNumFaces);
+    const double dSqrtTime = std::max(dMeanEdge, diagonal.Length() / MAX_DECAY_LENGTH_RATIO);
+    m_dTime = dSqrtTime * dSqrtTime;
+
+    // Vertices of degenerate faces only get an identity row
+    std::vector<CSparseLDLT::Triplet> system;
+    system.reserve(laplacian.size() + m_dwNumVertices);
+
+    for (const CSparseLDLT::Triplet &t : laplacian)
+    {
+        system.push_back({ t.dwRow, t.dwCol, m_dTime * t.dValue });
+    }
+    for (size_t i = 0; i < m_dwNumVertices; ++i)
+    {
+        system.push_back({ uint32_t(i), uint32_t(i), mass[i] > 0.0 ? mass[i] : 1.0 });
+    }
+    if (!m_HeatSolver.Factor(m_dwNumVertices, system))
+    {
+        return false;
+    }
+
+    // Zero heat on the boundary. The boundary rows and columns are removed,
+    // which keeps the system symmetric as the boundary values are zero.
+    if (dwBoundaryCount > 0 && dwBoundaryCount < m_dwNumVertices)
+    {
+        system.clear();
+        for (const CSparseLDLT::Triplet &t : laplacian)
+        {
+            if (!m_IsBoundary[t.dwRow] && !m_IsBoundary[t.dwCol])
+            {
+                system.push_back({ t.dwRow, t.dwCol, m_dTime * t.dValue });
+            }
+        }
+        for (size_t i = 0; i < m_dwNumVertices; ++i)
+        {
+            system.push_back({ uint32_t(i), uint32_t(i), (mass[i] > 0.0 && !m_IsBoundary[i]) ? mass[i] : 1.0 });
+        }
+        if (!m_DirichletHeatSolver.Factor(m_dwNumVertices, system))
+        {
+            m_HeatSolver.Clear();
+            return false;
+        }
+    }
+
+    system.assign(laplacian.begin(), laplacian.end());
+    for (size_t i = 0; i < m_dwNumVertices; ++i)
+    {
+        system.push_back({ uint32_t(i), uint32_t(i), mass[i] > 0.0 ? POISSON_REGULARIZATION * mass[i] / m_dTime : 1.0 });
+    }
+    if (!m_PoissonSolver.Factor(m_dwNumVertices, system))
+    {
+        m_HeatSolver.Clear();
+        m_DirichletHeatSolver.Clear();
+        return false;
+    }
+
+    return true;
+}
+
+void CHeatGeodesics::Run(uint32_t dwSrcVertexIdx, Workspace &workspace) const
+{
+    assert(dwSrcVertexIdx < m_dwNumVertices);
+    assert(m_HeatSolver.IsFactored() && m_PoissonSolver.IsFactored());
+
+    workspace.vdHeat.resize(m_dwNumVertices);
+    workspace.vdWork.resize(m_dwNumVertices);
+    workspace.vdDistance.resize(m_dwNumVertices);
+
+    double *pdHeat = workspace.vdHeat.data();
+    double *pdWork = workspace.vdWork.data();
+    double *pdDistance = workspace.vdDistance.data();
+
+    // 1. Diffuse heat from the source for time t. With a boundary, average
+    //    the Neumann and Dirichlet solutions. The Dirichlet heat of a boundary
+    //    source is zero.
+    std::fill(workspace.vdHeat.begin(), workspace.vdHeat.end(), 0.0);
+    pdHeat[dwSrcVertexIdx] = 1.0;
+    m_HeatSolver.Solve(pdHeat, pdWork);
+
+    if (m_DirichletHeatSolver.IsFactored() && !m_IsBoundary[dwSrcVertexIdx])
+    {
+        workspace.vdDirichletHeat.resize(m_dwNumVertices);
+        double *pdDirichletHeat = workspace.vdDirichletHeat.data();
+
+        std::fill(workspace.vdDirichletHeat.begin(), workspace.vdDirichletHeat.end(), 0.0);
+        pdDirichletHeat[dwSrcVertexIdx] = 1.0;
+        m_DirichletHeatSolver.Solve(pdDirichletHeat, pdWork);
+
+        for (size_t i = 0; i < m_dwNumVertices; ++i)
+        {
+            pdHeat[i] = 0.5 * (pdHeat[i] + pdDirichletHeat[i]);
+        }
+    }
+
+    // 2. Divergence of the normalized opposite heat gradient, which follows the
+    //    distance gradient. The right hand side of L * distance = -divergence.
+    std::fill(workspace.vdDistance.begin(), workspace.vdDistance.end(), 0.0);
+    for (size_t f = 0; f < m_dwNumFaces; ++f)
+    {
+        const uint32_t *pdwFace = &m_Indices[3 * f];
+        const DVector3 *pGradients = &m_HatGradients[3 * f];
+        const DVector3 *pCorners = &m_CornerPositions[3 * f];
+
+        DVector3 gradient;
+        for (size_t i = 0; i < 3; ++i)
+        {
+            gradient.x += pdHeat[pdwFace[i]] * pGradients[i].x;
+            gradient.y += pdHeat[pdwFace[i]] * pGradients[i].y;
+            gradient.z += pdHeat[pdwFace[i]] * pGradients[i].z;
+        }
+
+        const double dLength = gradient.Length();
+        if (!(dLength > 0.0))
+        {
+            continue;
+        }
+        DVector3ScalarMul(gradient, -1.0 / dLength);
+
+        for (size_t i = 0; i < 3; ++i)
+        {
+            const size_t j = (i + 1) % 3;
+            const size_t k = (i + 2) % 3;
+            DVector3 toJ, toK;
+            DVector3Minus(pCorners[j], pCorners[i], toJ);
+            DVector3Minus(pCorners[k], pCorners[i], toK);
+
+            pdDistance[pdwFace[i]] -=
+                m_HalfCotangents[3 * f + k] * DVector3Dot(toJ, gradient) +
+                m_HalfCotangents[3 * f + j] * DVector3Dot(toK, gradient);
+        }
+    }
+
+    // The Laplacian is singular on constants, keep the right hand side
+    // orthogonal to them.
+    double dMean = 0.0;
+    for (size_t i = 0; i < m_dwNumVertices; ++i)
+    {
+        dMean += pdDistance[i];
+    }
+    dMean /= double(m_dwNumVertices);
+    for (size_t i = 0; i < m_dwNumVertices; ++i)
+    {
+        pdDistance[i] -= dMean;
+    }
+
+    // 3. Recover the distance, up to a constant fixed by the source
+    m_PoissonSolver.Solve(pdDistance, pdWork);
+
+    const double dSource = pdDistance[dwSrcVertexIdx];
+    for (size_t i = 0; i < m_dwNumVertices; ++i)
+    {
+        pdDistance[i] = std::max(pdDistance[i] - dSource, 0.0);
+    }
+}
@@ -0,0 +1,82 @@
+//-------------------------------------------------------------------------------------
+// UVAtlas - HeatGeodesics.h
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "datatypes.h"
+#include "SparseLDLT.h"
+
+namespace GeodesicDist
+{
+    // Geodesic distances from one source vertex by the heat method:
+    //  [CWW13] CRANE K., WEISCHEDEL C., WARDETZKY M.:
+    //  Geodesics in Heat: A New Approach to Computing Distance Based on Heat Flow.
+    //  ACM Transactions on Graphics 32, 5 (2013)
+    //
+    // Heat diffused from the source for a short time gives the direction of the
+    // distance gradient on each face, the distance is then recovered from the
+    // divergence of the normalized gradient by a Poisson equation. The
+    // operators are built on the intrinsic Delaunay triangulation of the mesh,
+    // whose cotangent weights are positive even where the mesh has obtuse
+    // triangles. On a mesh with boundary, the heat is the average of the
+    // Neumann and the Dirichlet solutions ([CWW13] 3.2), which keeps the
+    // isolines from bending to meet the boundary at right angles. The linear
+    // systems only depend on the mesh, so they are factored once by Init(),
+    // and each source costs two or three solves. Run() is const, several threads may run different sources
+    // on one instance, each with its own workspace.
+    class CHeatGeodesics
+    {
+    public:
+        // Per thread buffers of Run()
+        struct Workspace
+        {
+            std::vector<double> vdHeat;
+            std::vector<double> vdDirichletHeat;
+            std::vector<double> vdWork;
+            std::vector<double> vdDistance; // The result of Run()
+        };
+
+        CHeatGeodesics() noexcept : m_dwNumVertices(0), m_dwNumFaces(0) {}
+
+        // Builds and factors the operators of a triangle mesh. Throws
+        // std::bad_alloc. Returns false when the mesh is degenerate, the heat
+        // method can't be used then.
+        bool Init(
+            const std::vector<DVector3> &vertices,
+            const uint32_t *pdwIndices,
+            size_t dwNumFaces);
+
+        // Computes the distances from dwSrcVertexIdx into workspace.vdDistance.
+        // Throws std::bad_alloc on the first use of a workspace.
+        void Run(uint32_t dwSrcVertexIdx, Workspace &workspace) const;
+
+        size_t GetVertexNumber() const noexcept { return m_dwNumVertices; }
+
+    private:
+        size_t m_dwNumVertices;
+        size_t m_dwNumFaces;
+
+        std::vector<uint32_t> m_Indices;
+
+        // The faces of the intrinsic Delaunay triangulation, each laid out in
+        // its own plane. For each face corner i: its position in that plane,
+        // the gradient of the hat function of i, and half the cotangent of the
+        // angle at i.
+        std::vector<DVector3> m_CornerPositions;
+        std::vector<DVector3> m_HatGradients;
+        std::vector<double> m_HalfCotangents;
+        std::vector<bool> m_IsBoundary;
+
+        double m_dTime;
+
+        CSparseLDLT m_HeatSolver;          // M + t * L
+        CSparseLDLT m_DirichletHeatSolver; // M + t * L, boundary rows set to the identity
+        CSparseLDLT m_PoissonSolver;       // L, regularized
+    };
+}
@@ -0,0 +1,493 @@
+//-------------------------------------------------------------------------------------
+// UVAtlas - SparseLDLT.cpp
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//-------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "SparseLDLT.h"
+
+using namespace GeodesicDist;
+
+namespace
+{
+    // subsets of the nested dissection at most this large are not split
+    constexpr size_t DISSECTION_LEAF_SIZE = 64;
+
+    constexpr uint32_t NO_PARENT = uint32_t(-1);
+
+    // Nested dissection ordering, see CSparseLDLT.
+    class CNestedDissection
+    {
+    public:
+        CNestedDissection(
+            const std::vector<uint32_t> &adjStart,
+            const std::vector<uint32_t> &adj,
+            std::vector<uint32_t> &order) :
+            m_adjStart(adjStart),
+            m_adj(adj),
+            m_order(order),
+            m_dwNextSubset(0)
+        {
+            const size_t dwDimension = adjStart.size() - 1;
+            m_subset.resize(dwDimension, 0);
+            m_level.resize(dwDimension);
+            m_queue.reserve(dwDimension);
+        }
+
+        void Run()
+        {
+            std::vector<uint32_t> all(m_subset.size());
+            for (size_t i = 0; i < all.size(); ++i)
+            {
+                all[i] = static_cast<uint32_t>(i);
+            }
+            Dissect(all);
+        }
+
+    private:
+        uint32_t NewSubset(const std::vector<uint32_t> &verts)
+        {
+            const uint32_t dwSubset = ++m_dwNextSubset;
+            for (uint32_t v : verts)
+            {
+                m_subset[v] = dwSubset;
+            }
+            return dwSubset;
+        }
+
+        // Breadth first search from dwRoot inside dwSubset. Leaves the reached
+        // vertices in m_queue, by level, and returns the number of levels.
+        uint32_t LevelStructure(uint32_t dwRoot, uint32_t dwSubset)
+        {
+            m_queue.clear();
+            m_queue.push_back(dwRoot);
+            m_level[dwRoot] = 0;
+            m_subset[dwRoot] = ~dwSubset;
+
+            uint32_t dwLevels = 1;
+            for (size_t head = 0; head < m_queue.size(); ++head)
+            {
+                const uint32_t v = m_queue[head];
+                for (uint32_t p = m_adjStart[v]; p < m_adjStart[v + 1]; ++p)
+                {
+                    const uint32_t w = m_adj[p];
+                    if (m_subset[w] == dwSubset)
+                    {
+                        m_subset[w] = ~dwSubset;
+                        m_level[w] = m_level[v] + 1;
+                        dwLevels = std::max(dwLevels, m_level[w] + 1);
+                        m_queue.push_back(w);
+                    }
+                }
+            }
+
+            for (uint32_t v : m_queue)
+            {
+                m_subset[v] = dwSubset;
+            }
+            return dwLevels;
+        }
+
+        // Finds a vertex of large eccentricity to root the level structure, so
+        // that the levels are thin.
+        uint32_t PseudoPeripheralVertex(uint32_t dwStart, uint32_t dwSubset)
+        {
+            uint32_t dwRoot = dwStart;
+            uint32_t dwLevels = LevelStructure(dwRoot, dwSubset);
+            for (size_t iter = 0; iter < 4; ++iter)
+            {
+                uint32_t dwCandidate = dwRoot;
+                uint32_t dwMinDegree = UINT32_MAX;
+                for (size_t i = m_queue.size(); i-- > 0;)
+                {
+                    const uint32_t v = m_queue[i];
+                    if (m_level[v] + 1 != dwLevels)
+                    {
+                        break;
+                    }
+                    const uint32_t dwDegree = m_adjStart[v + 1] - m_adjStart[v];
+                    if (dwDegree < dwMinDegree)
+                    {
+                        dwMinDegree = dwDegree;
+                        dwCandidate = v;
+                    }
+                }
+
+                const uint32_t dwCandidateLevels = LevelStructure(dwCandidate, dwSubset);
+                if (dwCandidateLevels <= dwLevels)
+                {
+                    LevelStructure(dwRoot, dwSubset);
+                    break;
+                }
+                dwRoot = dwCandidate;
+                dwLevels = dwCandidateLevels;
+            }
+            return dwLevels;
+        }
+
+        void Dissect(std::vector<uint32_t> &verts)
+        {
+            uint32_t dwSubset = NewSubset(verts);
+            while (!verts.empty())
+            {
+                if (verts.size() <= DISSECTION_LEAF_SIZE)
+                {
+                    m_order.insert(m_order.end(), verts.begin(), verts.end());
+                    return;
+                }
+
+                LevelStructure(verts[0], dwSubset);
+
+                // Several components, order the one reached, then continue with
+                // the others.
+                if (m_queue.size() < verts.size())
+                {
+                    std::vector<uint32_t> component(m_queue);
+                    std::vector<uint32_t> rest;
+                    rest.reserve(verts.size() - component.size());
+                    const uint32_t dwComponent = NewSubset(component);
+                    for (uint32_t v : verts)
+                    {
+                        if (m_subset[v] != dwComponent)
+                        {
+                            rest.push_back(v);
+                        }
+                    }
+                    Dissect(component);
+                    verts.swap(rest);
+                    dwSubset = NewSubset(verts);
+                    continue;
+                }
+
+                const uint32_t dwLevels = PseudoPeripheralVertex(verts[0], dwSubset);
+                if (dwLevels < 3)
+                {
+                    m_order.insert(m_order.end(), m_queue.begin(), m_queue.end());
+                    return;
+                }
+
+                // The level holding the median vertex separates the levels before
+                // it from the levels after it, each with at most half the vertices.
+                const uint32_t dwSeparatorLevel = m_level[m_queue[m_queue.size() / 2]];
+
+                std::vector<uint32_t> before, separator, after;
+                for (uint32_t v : m_queue)
+                {
+                    if (m_level[v] < dwSeparatorLevel)
+                    {
+                        before.push_back(v);
+                    }
+                    else if (m_level[v] == dwSeparatorLevel)
+                    {
+                        separator.push_back(v);
+                    }
+                    else
+                    {
+                        after.push_back(v);
+                    }
+                }
+
+                Dissect(before);
+                Dissect(after);
+                m_order.insert(m_order.end(), separator.begin(), separator.end());
+                return;
+            }
+        }
+
+        const std::vector<uint32_t> &m_adjStart;
+        const std::vector<uint32_t> &m_adj;
+        std::vector<uint32_t> &m_order;
+
+        std::vector<uint32_t> m_subset; // subset of each vertex, ~subset while visited
+        std::vector<uint32_t> m_level;
+        std::vector<uint32_t> m_queue;
+        uint32_t m_dwNextSubset;
+    };
+}
+
+void CSparseLDLT::Clear() noexcept
+{
+    m_dwDimension = 0;
+    m_Perm.clear();
+    m_IPerm.clear();
+    m_Lp.clear();
+    m_Li.clear();
+    m_Lx.clear();
+    m_D.clear();
+}
+
+void CSparseLDLT::ComputeOrdering(
+    const std::vector<uint32_t> &adjStart,
+    const std::vector<uint32_t> &adj)
+{
+    m_Perm.clear();
+    m_Perm.reserve(m_dwDimension);
+
+    CNestedDissection dissection(adjStart, adj, m_Perm);
+    dissection.Run();
+    assert(m_Perm.size() == m_dwDimension);
+
+    m_IPerm.resize(m_dwDimension);
+    for (size_t k = 0; k < m_dwDimension; ++k)
+    {
+        m_IPerm[m_Perm[k]] = static_cast<uint32_t>(k);
+    }
+}
+
+bool CSparseLDLT::Factor(size_t dwDimension, const std::vector<Triplet> &entries)
+{
+    Clear();
+    if (dwDimension == 0 || dwDimension >= UINT32_MAX)
+    {
+        return false;
+    }
+    m_dwDimension = dwDimension;
+    const size_t n = dwDimension;
+
+    // 1. Symmetric rows of the off-diagonal entries, duplicates summed
+    std::vector<double> diagonal(n, 0.0);
+    std::vector<uint32_t> rowStart(n + 1, 0);
+    for (const Triplet &t : entries)
+    {
+        assert(t.dwRow < n && t.dwCol < n);
+        if (t.dwRow != t.dwCol)
+        {
+            rowStart[t.dwRow + 1]++;
+            rowStart[t.dwCol + 1]++;
+        }
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+        rowStart[i + 1] += rowStart[i];
+    }
+
+    std::vector<uint32_t> col(rowStart[n]);
+    std::vector<double> val(rowStart[n]);
+    {
+        std::vector<uint32_t> fill(rowStart.begin(), rowStart.end() - 1);
+        for (const Triplet &t : entries)
+        {
+            if (t.dwRow == t.dwCol)
+            {
+                diagonal[t.dwRow] += t.dValue;
+            }
+            else
+            {
+                col[fill[t.dwRow]] = t.dwCol;
+                val[fill[t.dwRow]++] = t.dValue;
+                col[fill[t.dwCol]] = t.dwRow;
+                val[fill[t.dwCol]++] = t.dValue;
+            }
+        }
+    }
+
+    std::vector<uint32_t> adjStart(n + 1, 0);
+    std::vector<uint32_t> adj;
+    std::vector<double> adjValue;
+    adj.reserve(col.size());
+    adjValue.reserve(col.size());
+    {
+        std::vector<uint32_t> last(n, UINT32_MAX);
+        for (size_t i = 0; i < n; ++i)
+        {
+            const uint32_t dwRowBegin = static_cast<uint32_t>(adj.size());
+            for (uint32_t p = rowStart[i]; p < rowStart[i + 1]; ++p)
+            {
+                const uint32_t j = col[p];
+                if (last[j] != UINT32_MAX && last[j] >= dwRowBegin)
+                {
+                    adjValue[last[j]] += val[p];
+                }
+                else
+                {
+                    last[j] = static_cast<uint32_t>(adj.size());
+                    adj.push_back(j);
+                    adjValue.push_back(val[p]);
+                }
+            }
+            adjStart[i + 1] = static_cast<uint32_t>(adj.size());
+        }
+    }
+    col.clear();
+    col.shrink_to_fit();
+    val.clear();
+    val.shrink_to_fit();
+
+    // 2. Fill reducing ordering
+    ComputeOrdering(adjStart, adj);
+
+    // 3. Upper triangle of the reordered matrix in compressed columns
+    std::vector<size_t> Ap(n + 1, 0);
+    for (size_t k = 0; k < n; ++k)
+    {
+        const uint32_t r = m_Perm[k];
+        size_t dwCount = 1;
+        for (uint32_t p = adjStart[r]; p < adjStart[r + 1]; ++p)
+        {
+            if (m_IPerm[adj[p]] < k)
+            {
+                dwCount++;
+            }
+        }
+        Ap[k + 1] = Ap[k] + dwCount;
+    }
+
+    std::vector<uint32_t> Ai(Ap[n]);
+    std::vector<double> Ax(Ap[n]);
+    for (size_t k = 0; k < n; ++k)
+    {
+        const uint32_t r = m_Perm[k];
+        size_t q = Ap[k];
+        Ai[q] = static_cast<uint32_t>(k);
+        Ax[q++] = diagonal[r];
+        for (uint32_t p = adjStart[r]; p < adjStart[r + 1]; ++p)
+        {
+            const uint32_t i = m_IPerm[adj[p]];
+            if (i < k)
+            {
+                Ai[q] = i;
+                Ax[q++] = adjValue[p];
+            }
+        }
+    }
+    adj.clear();
+    adj.shrink_to_fit();
+    adjValue.clear();
+    adjValue.shrink_to_fit();
+
+    // 4. Elimination tree and column counts of L
+    std::vector<uint32_t> parent(n, NO_PARENT);
+    std::vector<uint32_t> flag(n);
+    std::vector<size_t> lnz(n, 0);
+    for (size_t k = 0; k < n; ++k)
+    {
+        flag[k] = static_cast<uint32_t>(k);
+        for (size_t p = Ap[k]; p < Ap[k + 1]; ++p)
+        {
+            for (uint32_t i = Ai[p]; i < k && flag[i] != k; i = parent[i])
+            {
+                if (parent[i] == NO_PARENT)
+                {
+                    parent[i] = static_cast<uint32_t>(k);
+                }
+                lnz[i]++;
+                flag[i] = static_cast<uint32_t>(k);
+            }
+        }
+    }
+
+    m_Lp.resize(n + 1);
+    m_Lp[0] = 0;
+    for (size_t k = 0; k < n; ++k)
+    {
+        m_Lp[k + 1] = m_Lp[k] + lnz[k];
+    }
+    m_Li.resize(m_Lp[n]);
+    m_Lx.resize(m_Lp[n]);
+    m_D.resize(n);
+
+    // 5. Numeric factorization, one row of L at a time
+    std::vector<double> y(n, 0.0);
+    std::vector<uint32_t> pattern(n);
+    for (size_t k = 0; k < n; ++k)
+    {
+        size_t top = n;
+        flag[k] = static_cast<uint32_t>(k);
+        lnz[k] = 0;
+        for (size_t p = Ap[k]; p < Ap[k + 1]; ++p)
+        {
+            uint32_t i = Ai[p];
+            y[i] += Ax[p];
+            size_t len = 0;
+            for (; flag[i] != k; i = parent[i])
+            {
+                pattern[len++] = i;
+                flag[i] = static_cast<uint32_t>(k);
+            }
+            while (len > 0)
+            {
+                pattern[--top] = pattern[--len];
+            }
+        }
+
+        double d = y[k];
+        y[k] = 0.0;
+        for (; top < n; ++top)
+        {
+            const uint32_t i = pattern[top];
+            const double yi = y[i];
+            y[i] = 0.0;
+
+            const size_t pEnd = m_Lp[i] + lnz[i];
+            for (size_t p = m_Lp[i]; p < pEnd; ++p)
+            {
+                y[m_Li[p]] -= m_Lx[p] * yi;
+            }
+
+            const double lki = yi / m_D[i];
+            d -= lki * yi;
+            m_Li[pEnd] = static_cast<uint32_t>(k);
+            m_Lx[pEnd] = lki;
+            lnz[i]++;
+        }
+
+        if (!(d > 0.0))
+        {
+            Clear();
+            return false;
+        }
+        m_D[k] = d;
+    }
+
+    return true;
+}
+
+void CSparseLDLT::Solve(double *pdX, double *pdWork) const noexcept
+{
+    assert(IsFactored());
+    const size_t n = m_dwDimension;
+
+    for (size_t k = 0; k < n; ++k)
+    {
+        pdWork[k] = pdX[m_Perm[k]];
+    }
+
+    // L * y = b
+    for (size_t j = 0; j < n; ++j)
+    {
+        const double yj = pdWork[j];
+        if (yj != 0.0)
+        {
+            for (size_t p = m_Lp[j]; p < m_Lp[j + 1]; ++p)
+            {
+                pdWork[m_Li[p]] -= m_Lx[p] * yj;
+            }
+        }
+    }
+
+    // D * z = y
+    for (size_t j = 0; j < n; ++j)
+    {
+        pdWork[j] /= m_D[j];
+    }
+
+    // L^T * x = z
+    for (size_t j = n; j-- > 0;)
+    {
+        double xj = pdWork[j];
+        for (size_t p = m_Lp[j]; p < m_Lp[j + 1]; ++p)
+        {
+            xj -= m_Lx[p] * pdWork[m_Li[p]];
+        }
+        pdWork[j] = xj;
+    }
+
+    for (size_t k = 0; k < n; ++k)
+    {
+        pdX[m_Perm[k]] = pdWork[k];
+    }
+}
@@ -0,0 +1,68 @@
+//-------------------------------------------------------------------------------------
+// UVAtlas - SparseLDLT.h
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+namespace GeodesicDist
+{
+    // Sparse LDL^T factorization of a symmetric positive definite matrix, solved
+    // many times against different right hand sides.
+    //
+    // The rows are reordered by nested dissection on the graph of the matrix,
+    // with separators taken from breadth first level structures, which keeps the
+    // fill of mesh Laplacians near n*log(n). The factorization is up-looking,
+    // on the elimination tree of the reordered matrix.
+    //
+    // Factor() throws std::bad_alloc, Solve() does not allocate and is const, so
+    // several threads may solve with one factorization.
+    class CSparseLDLT
+    {
+    public:
+        // One entry of the matrix. Entries with the same row and column are
+        // summed, only one of (i, j) and (j, i) must be given.
+        struct Triplet
+        {
+            uint32_t dwRow;
+            uint32_t dwCol;
+            double dValue;
+        };
+
+        CSparseLDLT() noexcept : m_dwDimension(0) {}
+
+        // Factors the matrix of dimension dwDimension. Returns false when a
+        // pivot is not positive, the factorization is then empty.
+        bool Factor(size_t dwDimension, const std::vector<Triplet> &entries);
+
+        // Solves A * x = b in place, pdX holds b on input. pdWork holds
+        // GetDimension() values.
+        void Solve(double *pdX, double *pdWork) const noexcept;
+
+        size_t GetDimension() const noexcept { return m_dwDimension; }
+        size_t GetFactorNonZeros() const noexcept { return m_Li.size(); }
+        bool IsFactored() const noexcept { return !m_D.empty(); }
+
+        void Clear() noexcept;
+
+    private:
+        void ComputeOrdering(
+            const std::vector<uint32_t> &adjStart,
+            const std::vector<uint32_t> &adj);
+
+        size_t m_dwDimension;
+
+        std::vector<uint32_t> m_Perm;  // row of the original matrix at each position
+        std::vector<uint32_t> m_IPerm; // position of each original row
+
+        // Unit lower triangular L in compressed columns, and diagonal D
+        std::vector<size_t> m_Lp;
+        std::vector<uint32_t> m_Li;
+        std::vector<double> m_Lx;
+        std::vector<double> m_D;
+    };
+}
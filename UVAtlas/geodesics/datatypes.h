@@ -96,95 +96,258 @@ namespace GeodesicDist
     typedef CMinHeap<double, EdgeWindow> TypeEdgeWindowsHeap;
 
     // one window on an edge (see the paper)
+    //
+    // Windows are copied in and out of the heap and the windows lists of the
+    // edges, so they only hold indices into the lists of the engine. The fields
+    // read to order and intersect the windows come first, those only read when
+    // a window is propagated come last.
     struct EdgeWindow
     {
-        uint32_t dwTag;
-
-        uint32_t dwEdgeIdx; // which edge this window is on, this is the index in TypeEdgeList (following are in the similar pattern)
-        Edge *pEdge;        // pointer to that edge in TypeEdgeList
-
-        uint32_t dwMarkFromEdgeVertexIdx; // b0 count from this edge vertex
-        Vertex *pMarkFromEdgeVertex;      // pointer to that vertex
-
-        uint32_t dwPseuSrcVertexIdx; // the pseudo source vertex index
-        Vertex *pPseuSrcVertex;      // pointer to that vertex
-
         double b0, b1; // b0, b1, d0, d1 of the window, see the paper
         double d0, d1;
-        DVector2 dv2Src; // the parameterized 2d pseudo source with regard to the edge this window is on
 
         double dPseuSrcToSrcDistance; // the distance from the pseudo source to the real source
 
-        uint32_t dwFaceIdxPropagatedFrom; // which face this window is propagated from, this is used to determine the next face the window will propagate to
-        Face *pFacePropagatedFrom;        // pointer to that face
+        DVector2 dv2Src; // the parameterized 2d pseudo source with regard to the edge this window is on
+
+        uint32_t dwEdgeIdx;               // which edge this window is on, this is the index in TypeEdgeList (following are in the similar pattern)
+        uint32_t dwMarkFromEdgeVertexIdx; // b0 count from this edge vertex
 
-        Edge *pEdgePropagatedFrom; // pointer to the edge that contain the window that produced this window
+        uint32_t dwPseuSrcVertexIdx;      // the pseudo source vertex index, FLAG_INVALIDDWORD for a merged window
+        uint32_t dwFaceIdxPropagatedFrom; // which face this window is propagated from, this is used to determine the next face the window will propagate to
 
         double ksi; // the accumulated error used in approximate algorithm
 
-    #ifdef _PREFAST_
-    #pragma warning(push)
-    #pragma warning(disable : 26495)
-    #endif
-
-        EdgeWindow() : dwTag(0),
-            dwEdgeIdx(0),
-            pEdge(nullptr),
-            dwMarkFromEdgeVertexIdx(0),
-            pMarkFromEdgeVertex(nullptr),
-            dwPseuSrcVertexIdx(0),
-            pPseuSrcVertex(nullptr),
-            b0(0.0),
+        EdgeWindow() : b0(0.0),
             b1(0.0),
             d0(0.0),
             d1(0.0),
-            dv2Src{},
             dPseuSrcToSrcDistance(0.0),
-            dwFaceIdxPropagatedFrom(0),
-            pFacePropagatedFrom(nullptr),
-            pEdgePropagatedFrom(nullptr),
+            dv2Src{},
+            dwEdgeIdx(FLAG_INVALIDDWORD),
+            dwMarkFromEdgeVertexIdx(FLAG_INVALIDDWORD),
+            dwPseuSrcVertexIdx(FLAG_INVALIDDWORD),
+            dwFaceIdxPropagatedFrom(FLAG_INVALIDDWORD),
             ksi(0.0)
         {}
-        // trick constructor
-        EdgeWindow(const uint32_t R)
-        {
-            if (R == 0)
-            {
-                EdgeWindow();
-            }
-        }
+        // the window the heap returns for 0 when it is empty
+        EdgeWindow(const uint32_t) : EdgeWindow() {}
 
         EdgeWindow(const EdgeWindow &) = default;
         EdgeWindow &operator=(const EdgeWindow &) = default;
 
         EdgeWindow(EdgeWindow &&) noexcept = default;
         EdgeWindow &operator=(EdgeWindow &&) noexcept = default;
+    };
 
-    #ifdef _PREFAST_
-    #pragma warning(pop)
-    #endif
+    // one element of the windows list of an edge
+    struct WindowListElement
+    {
+        TypeEdgeWindowsHeap::item_type *pHeapItem;
+        EdgeWindow theWindow;
 
-            // setting an index also assigns appropriate pointer to the corresponding pointer field
-        void SetEdgeIdx(TypeEdgeList &EdgeList, const uint32_t index)
+        WindowListElement(const TypeEdgeWindowsHeap::item_type *heapItem, const EdgeWindow &win)
         {
-            this->dwEdgeIdx = index;
-            this->pEdge = &(EdgeList[index]);
+            this->pHeapItem = const_cast<TypeEdgeWindowsHeap::item_type *>(heapItem);
+            this->theWindow = win;
         }
-        void SetPseuSrcVertexIdx(TypeVertexList &VertexList, const uint32_t index)
+        WindowListElement() : pHeapItem(nullptr) {}
+    };
+
+    // Objects allocated in blocks owned by the pool. Free() keeps an object for
+    // the next Allocate(), and Reset() frees all the objects at once without
+    // releasing the blocks. The objects keep their address until the pool is
+    // destroyed, and hold the values they were freed with.
+    template <class T>
+    class CObjectPool
+    {
+    public:
+        CObjectPool() noexcept : m_dwBlock(0), m_dwBlockUsed(0) {}
+
+        CObjectPool(CObjectPool const &) = delete;
+        CObjectPool &operator=(CObjectPool const &) = delete;
+
+        // throws std::bad_alloc
+        T *Allocate()
         {
-            this->dwPseuSrcVertexIdx = index;
-            this->pPseuSrcVertex = (index < VertexList.size()) ? &(VertexList[index]) : nullptr;
+            if (!m_FreeObjects.empty())
+            {
+                T *pObject = m_FreeObjects.back();
+                m_FreeObjects.pop_back();
+                return pObject;
+            }
+
+            if (m_dwBlock < m_Blocks.size() && m_dwBlockUsed == BLOCK_SIZE)
+            {
+                ++m_dwBlock;
+                m_dwBlockUsed = 0;
+            }
+            if (m_dwBlock == m_Blocks.size())
+            {
+                m_Blocks.emplace_back(new T[BLOCK_SIZE]);
+                m_dwBlockUsed = 0;
+            }
+            return &m_Blocks[m_dwBlock][m_dwBlockUsed++];
         }
-        void SetMarkFromEdgeVertexIdx(TypeVertexList &VertexList, const uint32_t index)
+
+        // throws std::bad_alloc
+        void Free(T *pObject)
         {
-            this->dwMarkFromEdgeVertexIdx = index;
-            this->pMarkFromEdgeVertex = &(VertexList[index]);
+            m_FreeObjects.push_back(pObject);
         }
-        void SetFaceIdxPropagatedFrom(TypeFaceList &FaceList, const uint32_t index)
+
+        void Reset() noexcept
         {
-            this->dwFaceIdxPropagatedFrom = index;
-            this->pFacePropagatedFrom = &(FaceList[index]);
+            m_FreeObjects.clear();
+            m_dwBlock = 0;
+            m_dwBlockUsed = 0;
         }
+
+    private:
+        static constexpr size_t BLOCK_SIZE = 1024;
+
+        std::vector<std::unique_ptr<T[]>> m_Blocks;
+        size_t m_dwBlock;     // the block objects are taken from
+        size_t m_dwBlockUsed; // objects of that block already taken
+        std::vector<T *> m_FreeObjects;
+    };
+
+    // Contiguous storage of the windows lists of all the edges of an engine.
+    // Each list is a segment whose capacity is a power of two, carved from
+    // blocks owned by the arena. A segment outgrown by its list is kept for
+    // the next list of that capacity, and Reset() gives all the segments back
+    // at once without releasing the blocks, so the windows of one source reuse
+    // the memory of the previous ones.
+    class CWindowListArena
+    {
+    public:
+        CWindowListArena() noexcept : m_dwBlock(0), m_dwBlockUsed(0) {}
+
+        CWindowListArena(CWindowListArena const &) = delete;
+        CWindowListArena &operator=(CWindowListArena const &) = delete;
+
+        // returns a segment of (1 << dwCapacityLog2) elements, throws std::bad_alloc
+        WindowListElement *AllocateSegment(uint32_t dwCapacityLog2)
+        {
+            if (dwCapacityLog2 >= m_FreeSegments.size())
+            {
+                m_FreeSegments.resize(dwCapacityLog2 + 1);
+            }
+            std::vector<WindowListElement *> &freeSegments = m_FreeSegments[dwCapacityLog2];
+            if (!freeSegments.empty())
+            {
+                WindowListElement *pSegment = freeSegments.back();
+                freeSegments.pop_back();
+                return pSegment;
+            }
+
+            // the end of a block too short for the segment is left unused
+            const size_t dwCapacity = size_t(1) << dwCapacityLog2;
+            while (m_dwBlock < m_Blocks.size() && m_BlockSizes[m_dwBlock] - m_dwBlockUsed < dwCapacity)
+            {
+                ++m_dwBlock;
+                m_dwBlockUsed = 0;
+            }
+            if (m_dwBlock == m_Blocks.size())
+            {
+                const size_t dwBlockSize = std::max(BLOCK_SIZE, dwCapacity);
+                m_BlockSizes.reserve(m_Blocks.size() + 1);
+                m_Blocks.emplace_back(new WindowListElement[dwBlockSize]);
+                m_BlockSizes.push_back(dwBlockSize);
+                m_dwBlockUsed = 0;
+            }
+
+            WindowListElement *pSegment = &m_Blocks[m_dwBlock][m_dwBlockUsed];
+            m_dwBlockUsed += dwCapacity;
+            return pSegment;
+        }
+
+        // throws std::bad_alloc
+        void FreeSegment(WindowListElement *pSegment, uint32_t dwCapacityLog2)
+        {
+            m_FreeSegments[dwCapacityLog2].push_back(pSegment);
+        }
+
+        void Reset() noexcept
+        {
+            for (auto &freeSegments : m_FreeSegments)
+            {
+                freeSegments.clear();
+            }
+            m_dwBlock = 0;
+            m_dwBlockUsed = 0;
+        }
+
+    private:
+        static constexpr size_t BLOCK_SIZE = 1024;
+
+        std::vector<std::unique_ptr<WindowListElement[]>> m_Blocks;
+        std::vector<size_t> m_BlockSizes;
+        size_t m_dwBlock;     // the block segments are carved from
+        size_t m_dwBlockUsed; // elements of that block already carved
+        std::vector<std::vector<WindowListElement *>> m_FreeSegments; // by log2 of the capacity
+    };
+
+    // The windows list of an edge, stored in a CWindowListArena. The arena is
+    // passed to the operations which may grow the list.
+    class CWindowList
+    {
+    public:
+        CWindowList() noexcept : m_pElements(nullptr), m_dwSize(0), m_dwCapacityLog2(0) {}
+
+        size_t size() const noexcept { return m_dwSize; }
+        bool empty() const noexcept { return m_dwSize == 0; }
+
+        WindowListElement &operator[](size_t i) noexcept
+        {
+            assert(i < m_dwSize);
+            return m_pElements[i];
+        }
+        const WindowListElement &operator[](size_t i) const noexcept
+        {
+            assert(i < m_dwSize);
+            return m_pElements[i];
+        }
+
+        // throws std::bad_alloc
+        void push_back(CWindowListArena &arena, const WindowListElement &element)
+        {
+            if (!m_pElements)
+            {
+                m_pElements = arena.AllocateSegment(0);
+                m_dwCapacityLog2 = 0;
+            }
+            else if (m_dwSize == (size_t(1) << m_dwCapacityLog2))
+            {
+                WindowListElement *pElements = arena.AllocateSegment(m_dwCapacityLog2 + 1);
+                std::copy(m_pElements, m_pElements + m_dwSize, pElements);
+                arena.FreeSegment(m_pElements, m_dwCapacityLog2);
+                m_pElements = pElements;
+                ++m_dwCapacityLog2;
+            }
+            m_pElements[m_dwSize++] = element;
+        }
+
+        // removes the element i, keeping the order of the others
+        void erase(size_t i) noexcept
+        {
+            assert(i < m_dwSize);
+            std::move(m_pElements + i + 1, m_pElements + m_dwSize, m_pElements + i);
+            --m_dwSize;
+        }
+
+        // forgets the segment, which is given back by CWindowListArena::Reset()
+        void clear() noexcept
+        {
+            m_pElements = nullptr;
+            m_dwSize = 0;
+            m_dwCapacityLog2 = 0;
+        }
+
+    private:
+        WindowListElement *m_pElements;
+        size_t m_dwSize;
+        uint32_t m_dwCapacityLog2;
     };
 
     struct Edge
@@ -299,22 +462,9 @@ namespace GeodesicDist
             return ((!pAdjFace0) || (!pAdjFace1));
         }
 
-        struct WindowListElement
-        {
-            TypeEdgeWindowsHeap::item_type *pHeapItem;
-            EdgeWindow theWindow;
-
-            WindowListElement(const TypeEdgeWindowsHeap::item_type *heapItem, const EdgeWindow &win)
-            {
-                this->pHeapItem = const_cast<TypeEdgeWindowsHeap::item_type *>(heapItem);
-                this->theWindow = win;
-            }
-            WindowListElement() : pHeapItem(nullptr) {}
-        };
-
         // on the edge, there is a windows list, which stores windows that has propagated onto this edge
         // in addition, it also stores a reference to the same window in the windows heap, so we can modify the one stored in the heap (modification during window intersection)
-        std::vector<WindowListElement> WindowsList;
+        CWindowList WindowsList;
     };
 
     struct Face
@@ -525,9 +675,6 @@ namespace GeodesicDist
 
         bool bShadowBoundary;
 
-        std::vector<Face *> facesAdj; // faces that use this vertex
-        std::vector<Edge *> edgesAdj; // edges that have this vertex
-
         Vertex() : bBoundary(false),
             dAngle(0.0),
             dLengthOfWindowEdgeToThisVertex(DBL_MAX),
@@ -35,9 +35,12 @@
 #include <wsl/winadapter.h>
 #endif
 
+#include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <vector>
 
 #include <DirectXMath.h>
@@ -84,6 +87,18 @@ namespace DirectX
     // UVATLAS_DEFAULT - Meshes with more than 25k faces go through fast, meshes with fewer than 25k faces go through quality
     // UVATLAS_GEODESIC_FAST - Uses approximations to improve charting speed at the cost of added stretch or more charts.
     // UVATLAS_GEODESIC_QUALITY - Provides better quality charts, but requires more time and memory than fast.
+    // UVATLAS_DETERMINISTIC - The same input and options give the same output whatever the thread count.
+    // UVATLAS_GEODESIC_ADAPTIVE - Chooses between fast and quality for each chart, from its face count, its number
+    //                             of landmarks and whether an IMT is given, instead of from the face count of the mesh.
+    // UVATLAS_GEODESIC_HEAT - Uses the heat method on large charts, which is much faster than quality on them but
+    //                         approximate, and quality on small charts. The charts usually match the ones of
+    //                         quality, but can have more stretch or be more. Meshes with an IMT go through fast.
+    // UVATLAS_GEODESIC_COARSE - Uses quality on a simplified level of the charts with more than 25k faces, then
+    //                           corrects the distances on the full chart, and quality on smaller charts. Meshes
+    //                           with an IMT go through fast.
+    // UVATLAS_CG_UNPRECONDITIONED, UVATLAS_CG_JACOBI, UVATLAS_CG_IC0, UVATLAS_CG_SSOR - Selects the preconditioner of
+    //     the conjugate gradient solves of the barycentric and LSCM parameterizations: none, the diagonal, the
+    //     incomplete Cholesky factorization or symmetric SOR. Without any of them, IC0 is used.
     enum UVATLAS : uint32_t
     {
         UVATLAS_DEFAULT = 0x00,
@@ -91,14 +106,117 @@ namespace DirectX
         UVATLAS_GEODESIC_QUALITY = 0x02,
         UVATLAS_LIMIT_MERGE_STRETCH = 0x04,
         UVATLAS_LIMIT_FACE_STRETCH = 0x08,
+        UVATLAS_DETERMINISTIC = 0x10,
+        UVATLAS_GEODESIC_ADAPTIVE = 0x20,
+        UVATLAS_GEODESIC_HEAT = 0x40,
+        UVATLAS_GEODESIC_COARSE = 0x80,
+        UVATLAS_CG_UNPRECONDITIONED = 0x100,
+        UVATLAS_CG_JACOBI = 0x200,
+        UVATLAS_CG_IC0 = 0x400,
+        UVATLAS_CG_SSOR = 0x800,
     };
 
     constexpr float UVATLAS_DEFAULT_CALLBACK_FREQUENCY = 0.0001f;
 
+    // Controls the threads used by a call to the UVAtlas apis. A nullptr executor
+    // uses the default settings.
+    //  maxThreadCount - The maximum number of threads working on the call,
+    //                   including the calling thread. If this is 0, the OpenMP
+    //                   default is used, or the number of hardware threads in
+    //                   builds without OpenMP. 1 runs everything on the calling
+    //                   thread.
+    //  submit - If set, this is called to run work on the caller's job system
+    //           instead of on threads created by the library. Each submitted
+    //           function must be called once, possibly inline. The calling
+    //           thread works on the same tasks meanwhile, so it does not
+    //           deadlock when the job system is busy: a submitted function
+    //           started after the work is done returns immediately.
+    struct UVAtlasExecutor
+    {
+        size_t maxThreadCount;
+        std::function<void __cdecl(std::function<void __cdecl()> work)> submit;
+    };
+
+    // Stops a call to UVAtlasCreate, UVAtlasPartition or UVAtlasPack before it
+    // completes. The members are checked inside the long running loops, so the
+    // call returns shortly after the request.
+    //  cancel - Set to true from any thread to abort the call with E_ABORT.
+    //  deadline - The call fails with HRESULT_FROM_WIN32(ERROR_TIMEOUT) when
+    //             it is still running at this time. The default value means
+    //             no deadline.
+    //  bestEffort - Instead of failing at the deadline, the partition stops
+    //               refining the charts, the charts left to parameterize use
+    //               the fast geodesic distances, and the charts found so far
+    //               are packed without merging. The packing always completes,
+    //               so the call still finishes somewhat after the deadline,
+    //               and the maximum number of charts is not enforced.
+    struct UVAtlasCancellation
+    {
+        std::atomic<bool> cancel{ false };
+        std::chrono::steady_clock::time_point deadline{};
+        bool bestEffort = false;
+    };
+
+    // Statistics of a call to UVAtlasCreate, UVAtlasPartition or UVAtlasPack,
+    // to find where the time goes for a given mesh. Times are wall clock, in
+    // milliseconds. Members which don't apply to the call are 0.
+    //  initTime - Computing the base mesh information.
+    //  rootChartTime - Building the initial charts from the mesh.
+    //  partitionTime - Partitioning the charts until the stretch or chart
+    //                  count is reached.
+    //  optimizeStretchTime - Optimizing the stretch of the final charts.
+    //  mergeTime - Merging small charts.
+    //  boundaryTime - Optimizing the chart boundaries. This is part of
+    //                 partitionTime, and is summed over the threads working
+    //                 on the call, so it can exceed the wall time.
+    //  packTime - Packing the charts into the atlas.
+    //  repackTimes - Each iteration of the packing, which restarts with a
+    //                smaller chart scale until all charts fit.
+    //  geodesicKS98Runs, geodesicExactRuns, geodesicHeatRuns, geodesicCoarseRuns,
+    //  geodesicDijkstraRuns - Geodesic distances computed from one source vertex,
+    //      by backend.
+    //  cgSolveCount, cgIterations - Conjugate gradient solves, and their total
+    //                               iterations.
+    //  cgIterationLimitCount - Conjugate gradient solves stopped by their
+    //                          iteration limit, so the parameterization failed.
+    //  graphCutCount - Graph cuts run to optimize the chart boundaries.
+    //  mergeAttempts, mergeRejections - Chart pairs tried for merging, and the
+    //                                   ones which could not be merged.
+    //  peakChartCount - Largest number of charts during the partition.
+    struct UVAtlasStats
+    {
+        double initTime;
+        double rootChartTime;
+        double partitionTime;
+        double optimizeStretchTime;
+        double mergeTime;
+        double boundaryTime;
+        double packTime;
+        std::vector<double> repackTimes;
+
+        size_t geodesicKS98Runs;
+        size_t geodesicExactRuns;
+        size_t geodesicHeatRuns;
+        size_t geodesicCoarseRuns;
+        size_t geodesicDijkstraRuns;
+        size_t cgSolveCount;
+        size_t cgIterations;
+        size_t cgIterationLimitCount;
+        size_t graphCutCount;
+        size_t mergeAttempts;
+        size_t mergeRejections;
+        size_t peakChartCount;
+    };
+
     //============================================================================
     //
     // UVAtlas apis
     //
+    // The apis are reentrant: all the state of a call is owned by that call, so
+    // several threads may process different meshes at the same time. The
+    // callbacks are invoked from the calling thread only, except signalCallback
+    // of UVAtlasComputeIMTFromSignal when an executor is given.
+    //
     //============================================================================
 
     // This function creates atlases for meshes. There are two modes of operation,
@@ -160,6 +278,11 @@ namespace DirectX
     //  numChartsOut - A location to store the number of charts created, or if the
     //                 maximum number of charts was too low, this gives the minimum
     //                 number of charts needed to create an atlas.
+    //  executor - Optional thread control, see UVAtlasExecutor.
+    //  stats - Optional location receiving the time spent in each stage, and
+    //          other counters, see UVAtlasStats.
+    //  cancellation - Optional cancellation token and deadline, see
+    //                 UVAtlasCancellation.
 
     UVATLAS_API HRESULT __cdecl UVAtlasCreate(
         _In_reads_(nVerts) const XMFLOAT3 *positions,
@@ -184,7 +307,10 @@ namespace DirectX
         _Inout_opt_ std::vector<uint32_t> *pvFacePartitioning = nullptr,
         _Inout_opt_ std::vector<uint32_t> *pvVertexRemapArray = nullptr,
         _Out_opt_ float *maxStretchOut = nullptr,
-        _Out_opt_ size_t *numChartsOut = nullptr);
+        _Out_opt_ size_t *numChartsOut = nullptr,
+        _In_opt_ const UVAtlasExecutor *executor = nullptr,
+        _Out_opt_ UVAtlasStats *stats = nullptr,
+        _In_opt_ const UVAtlasCancellation *cancellation = nullptr);
 
     // This has the same exact arguments as Create, except that it does not perform the
     // final packing step. This method allows one to get a partitioning out, and possibly
@@ -231,7 +357,10 @@ namespace DirectX
         _Inout_opt_ std::vector<uint32_t> *pvVertexRemapArray,
         _Inout_ std::vector<uint32_t> &vPartitionResultAdjacency,
         _Out_opt_ float *maxStretchOut = nullptr,
-        _Out_opt_ size_t *numChartsOut = nullptr);
+        _Out_opt_ size_t *numChartsOut = nullptr,
+        _In_opt_ const UVAtlasExecutor *executor = nullptr,
+        _Out_opt_ UVAtlasStats *stats = nullptr,
+        _In_opt_ const UVAtlasCancellation *cancellation = nullptr);
 
     // This takes the face partitioning result from Partition and packs it into an
     // atlas of the given size. pPartitionResultAdjacency should be derived from
@@ -245,7 +374,116 @@ namespace DirectX
         _In_ float gutter,
         _In_ const std::vector<uint32_t> &vPartitionResultAdjacency,
         _In_ std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
-        _In_ float callbackFrequency);
+        _In_ float callbackFrequency,
+        _In_opt_ const UVAtlasExecutor *executor = nullptr,
+        _Out_opt_ UVAtlasStats *stats = nullptr,
+        _In_opt_ const UVAtlasCancellation *cancellation = nullptr);
+
+    // Describes one mesh of UVAtlasCreateBatch. The members have the meaning of
+    // the UVAtlasCreate parameters of the same name.
+    struct UVAtlasBatchMesh
+    {
+        const XMFLOAT3 *positions;
+        size_t nVerts;
+        const void *indices;
+        DXGI_FORMAT indexFormat;
+        size_t nFaces;
+        size_t maxChartNumber;
+        float maxStretch;
+        size_t width;
+        size_t height;
+        float gutter;
+        const uint32_t *adjacency;
+        const uint32_t *falseEdgeAdjacency;
+        const float *pIMTArray;
+        UVATLAS options;
+    };
+
+    // Result of one mesh of UVAtlasCreateBatch. hr is the result of the mesh,
+    // the other members are the matching UVAtlasCreate outputs, and are only
+    // valid when hr succeeded.
+    struct UVAtlasBatchResult
+    {
+        HRESULT hr;
+        std::vector<UVAtlasVertex> vMeshOutVertexBuffer;
+        std::vector<uint8_t> vMeshOutIndexBuffer;
+        std::vector<uint32_t> vFacePartitioning;
+        std::vector<uint32_t> vVertexRemapArray;
+        float maxStretchOut;
+        size_t numChartsOut;
+    };
+
+    // This function creates the atlases of many meshes at once, which keeps the
+    // threads busy when the meshes are too small to be worth splitting. The
+    // meshes are created largest first, one per thread. A mesh holding more than
+    // its share of the faces is instead created alone, with all the threads.
+    //
+    //  meshes - The nMeshes meshes to create atlases for.
+    //  statusCallback - Called with the progress of the whole batch, measured in
+    //                   faces, from the calling thread only.
+    //  results - Resized to nMeshes, results[i] receives the atlas of meshes[i].
+    //            A mesh not processed because the batch was aborted by the
+    //            callback gets E_ABORT.
+    //  executor - Optional thread control, see UVAtlasExecutor.
+    //  cancellation - Optional cancellation token and deadline, shared by all
+    //                 the meshes, see UVAtlasCancellation. A mesh not started
+    //                 before the call was stopped gets the error of the stop.
+    //
+    // Returns E_ABORT if the callback aborted the batch, otherwise the first
+    // failure found in results, or S_OK when every mesh succeeded.
+
+    UVATLAS_API HRESULT __cdecl UVAtlasCreateBatch(
+        _In_reads_(nMeshes) const UVAtlasBatchMesh *meshes,
+        _In_ size_t nMeshes,
+        _In_ std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
+        _In_ float callbackFrequency,
+        _Inout_ std::vector<UVAtlasBatchResult> &results,
+        _In_opt_ const UVAtlasExecutor *executor = nullptr,
+        _In_opt_ const UVAtlasCancellation *cancellation = nullptr);
+
+    // An atlas creation running in the background, see UVAtlasCreateAsync.
+    struct UVAtlasJob;
+
+    // This function starts UVAtlasCreate on one mesh and returns at once, so the
+    // caller does not have to wrap the blocking api in its own thread.
+    //
+    //  mesh - The mesh to create the atlas for. The arrays it points to must
+    //         stay valid until the job is done.
+    //  completion - Optional, called with the result when the job is done, from
+    //               the thread which ran the job, before UVAtlasJobWait returns.
+    //  job - Receives the handle of the job. Releasing it does not stop the
+    //        job, use UVAtlasJobCancel. The job holds a reference to itself
+    //        until it is done, so the handle can be released at any time,
+    //        including from the completion.
+    //  executor - Optional thread control, see UVAtlasExecutor. The job itself
+    //             is submitted to the job system when submit is set. Otherwise
+    //             it runs on a thread created by the library for this job,
+    //             owned by the job and joined when the job is released after
+    //             it is done. Several jobs can then overlap with the caller's
+    //             other work.
+    //
+    // Returns an error if the job could not be started, in which case the
+    // completion is not called.
+
+    UVATLAS_API HRESULT __cdecl UVAtlasCreateAsync(
+        _In_ const UVAtlasBatchMesh &mesh,
+        _In_ std::function<void __cdecl(const UVAtlasBatchResult &result)> completion,
+        _In_ float callbackFrequency,
+        _Out_ std::shared_ptr<UVAtlasJob> &job,
+        _In_opt_ const UVAtlasExecutor *executor = nullptr);
+
+    // Stops the job, which then completes with E_ABORT shortly after. Does
+    // nothing when the job is already done.
+    UVATLAS_API void __cdecl UVAtlasJobCancel(_Inout_ UVAtlasJob &job);
+
+    // Returns the progress of the job, from 0 to 1.
+    UVATLAS_API float __cdecl UVAtlasJobGetProgress(_In_ const UVAtlasJob &job);
+
+    // Returns true when the job is done, UVAtlasJobWait then returns at once.
+    UVATLAS_API bool __cdecl UVAtlasJobIsDone(_In_ const UVAtlasJob &job);
+
+    // Waits for the job and returns its result, which lives as long as the job.
+    UVATLAS_API const UVAtlasBatchResult &__cdecl UVAtlasJobWait(_Inout_ UVAtlasJob &job);
 
     //============================================================================
     //
@@ -286,7 +524,8 @@ namespace DirectX
         _In_ size_t signalDimension,
         _In_ size_t signalStride,
         _In_ std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
-        _Out_writes_(nFaces * 3) float *pIMTArray);
+        _Out_writes_(nFaces * 3) float *pIMTArray,
+        _In_opt_ const UVAtlasExecutor *executor = nullptr);
 
     // This function is used to calculate the IMT from data that varies over the
     // surface of the mesh (generally at a higher frequency than vertex data).
@@ -305,6 +544,10 @@ namespace DirectX
     //                   signalOut - A pointer to where to store the signal data.
     // userData        - A pointer that will be passed in to the callback.
     // pIMTArray        - An array of 3 * nFaces floats for the result
+    // executor         - Optional thread control. signalCallback is only called
+    //                    from several threads at the same time when an executor
+    //                    is given, otherwise the faces are processed on the
+    //                    calling thread.
     UVATLAS_API HRESULT __cdecl UVAtlasComputeIMTFromSignal(
         _In_reads_(nVerts) const XMFLOAT3 *positions,
         _In_reads_(nVerts) const XMFLOAT2 *texcoords,
@@ -319,7 +562,8 @@ namespace DirectX
         signalCallback,
         _In_opt_ void *userData,
         _In_ std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
-        _Out_writes_(nFaces * 3) float *pIMTArray);
+        _Out_writes_(nFaces * 3) float *pIMTArray,
+        _In_opt_ const UVAtlasExecutor *executor = nullptr);
 
     // This function is used to calculate the IMT from texture data. Given a texture
     // that maps over the surface of the mesh, the algorithm computes the IMT for
@@ -343,7 +587,8 @@ namespace DirectX
         _In_ size_t height,
         _In_ UVATLAS_IMT options,
         _In_ std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
-        _Out_writes_(nFaces * 3) float *pIMTArray);
+        _Out_writes_(nFaces * 3) float *pIMTArray,
+        _In_opt_ const UVAtlasExecutor *executor = nullptr);
 
     // This function is very similar to UVAtlasComputeIMTFromTexture, but it can
     // calculate higher dimensional values than 4.
@@ -370,7 +615,8 @@ namespace DirectX
         _In_ size_t nComponents,
         _In_ UVATLAS_IMT options,
         _In_ std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
-        _Out_writes_(nFaces * 3) float *pIMTArray);
+        _Out_writes_(nFaces * 3) float *pIMTArray,
+        _In_opt_ const UVAtlasExecutor *executor = nullptr);
 
     // This function is for applying the a vertex remap array from UVAtlasCreate/UVAtlasPartition to a vertex buffer
     //
@@ -112,9 +112,35 @@ namespace Isochart
 #pragma clang diagnostic ignored "-Wdouble-promotion"
 #endif
 
+    // Matrices of at least LANCZOS_MIN_DIMENSION rows, of which at most one
+    // eigenpair per LANCZOS_MIN_DIMENSION_RATIO rows is wanted, are solved by
+    // block Lanczos. The full decomposition is O(n^3) for the n*n matrix,
+    // Lanczos is O(n^2) per step.
+    constexpr size_t LANCZOS_MIN_DIMENSION = 128;
+    constexpr size_t LANCZOS_MIN_DIMENSION_RATIO = 8;
+
+    // Lanczos gives up after LANCZOS_STEPS_PER_EIGEN steps per wanted
+    // eigenpair plus LANCZOS_EXTRA_STEPS, and the full decomposition is used.
+    constexpr size_t LANCZOS_STEPS_PER_EIGEN = 6;
+    constexpr size_t LANCZOS_EXTRA_STEPS = 30;
+
+    // A Ritz pair is converged when the norm of its residual is at most
+    // LANCZOS_TOLERANCE times the largest absolute value of the wanted Ritz
+    // values.
+    constexpr double LANCZOS_TOLERANCE = 1.0e-8;
+
+    // The Krylov space is taken as invariant when less than LANCZOS_BREAKDOWN
+    // of a new vector remains after orthogonalization.
+    constexpr double LANCZOS_BREAKDOWN = 1.0e-10;
+
+    // Epsilon of the QL iteration on the projected matrix.
+    constexpr double LANCZOS_QL_EPSILON = 1.0e-12;
+
     template <class TYPE>
     class CSymmetricMatrix
     {
+        template <class> friend class CSymmetricMatrix;
+
     public:
         using value_type = TYPE;
 
@@ -160,6 +186,85 @@ namespace Isochart
             memcpy(dest, src, dwDimension * sizeof(value_type));
         }
 
+        static inline double DoubleDot(
+            const double v1[],
+            const double v2[],
+            size_t dwDimension)
+        {
+            double result = 0;
+            for (size_t ii = 0; ii < dwDimension; ii++)
+            {
+                result += v1[ii] * v2[ii];
+            }
+
+            return result;
+        }
+
+        // Removes from v its components along the dwBasisSize orthonormal
+        // vectors stored in the rows of pBasis. Gram-Schmidt is applied twice
+        // to keep the basis orthogonal in floating point. The removed
+        // components are returned in pCoordinate if it isn't nullptr.
+        static void OrthogonalizeToBasis(
+            size_t dwDimension,
+            const double *pBasis,
+            size_t dwBasisSize,
+            double v[],
+            double *pCoordinate)
+        {
+            if (pCoordinate)
+            {
+                memset(pCoordinate, 0, dwBasisSize * sizeof(double));
+            }
+
+            for (size_t ii = 0; ii < 2; ii++)
+            {
+                for (size_t i = 0; i < dwBasisSize; i++)
+                {
+                    const double *pQ = pBasis + i * dwDimension;
+                    double c = DoubleDot(pQ, v, dwDimension);
+                    for (size_t j = 0; j < dwDimension; j++)
+                    {
+                        v[j] -= c * pQ[j];
+                    }
+                    if (pCoordinate)
+                    {
+                        pCoordinate[i] += c;
+                    }
+                }
+            }
+        }
+
+        // Appends a random vector, orthogonalized to the basis, as the row
+        // dwBasisSize of pBasis.
+        static bool AppendRandomBasisVector(
+            size_t dwDimension,
+            double *pBasis,
+            size_t &dwBasisSize,
+            std::mt19937_64 &randomEngine)
+        {
+            double *pQ = pBasis + dwBasisSize * dwDimension;
+            for (size_t i = 0; i < dwDimension; i++)
+            {
+                pQ[i] = double(randomEngine() >> 11) / double(uint64_t(1) << 53) - 0.5;
+            }
+
+            double fNorm = IsochartSqrt(DoubleDot(pQ, pQ, dwDimension));
+            OrthogonalizeToBasis(dwDimension, pBasis, dwBasisSize, pQ, nullptr);
+
+            double fRemainder = IsochartSqrt(DoubleDot(pQ, pQ, dwDimension));
+            if (fRemainder <= LANCZOS_BREAKDOWN * fNorm)
+            {
+                return false;
+            }
+
+            for (size_t i = 0; i < dwDimension; i++)
+            {
+                pQ[i] /= fRemainder;
+            }
+            dwBasisSize++;
+            return true;
+        }
+
     public:
         _Success_(return) static bool GetEigen(
             size_t dwDimension,
@@ -178,6 +283,206 @@ namespace Isochart
                 return false;
             }
 
+            // 2. If only a few of the largest eigenpairs are wanted, try Lanczos
+            // first, otherwise (or if it doesn't converge) decompose the whole
+            // matrix.
+            if (dwDimension >= LANCZOS_MIN_DIMENSION
+                && dwMaxRange * LANCZOS_MIN_DIMENSION_RATIO <= dwDimension
+                && GetLargestEigenByLanczos(
+                    dwDimension, pMatrix, pEigenValue, pEigenVector, dwMaxRange))
+            {
+                return true;
+            }
+
+            return GetEigenByHouseholderQL(
+                dwDimension, pMatrix, pEigenValue, pEigenVector, dwMaxRange, epsilon);
+        }
+
+    private:
+        // Block Lanczos with full reorthogonalization, for the dwMaxRange
+        // largest eigenpairs. The Krylov space is started from dwMaxRange
+        // random vectors, so that eigenvalues of multiplicity up to dwMaxRange
+        // are found, and each step appends the product of the matrix and the
+        // oldest basis vector not multiplied yet. The Ritz pairs are computed
+        // by the full decomposition of the projected matrix, in double.
+        // Returns false if they don't converge in the allowed steps.
+        _Success_(return) static bool GetLargestEigenByLanczos(
+            size_t dwDimension,
+            _In_reads_(dwDimension *dwDimension) const value_type *pMatrix,
+            _Out_writes_(dwMaxRange) value_type *pEigenValue,
+            _Out_writes_(dwDimension *dwMaxRange) value_type *pEigenVector,
+            size_t dwMaxRange)
+        {
+            const size_t dwBlockSize = dwMaxRange;
+            const size_t dwMaxSteps = std::min(
+                dwDimension - dwBlockSize,
+                LANCZOS_STEPS_PER_EIGEN * dwMaxRange + LANCZOS_EXTRA_STEPS);
+            const size_t dwMaxBasis = dwMaxSteps + dwBlockSize;
+
+            // 1. allocate memory resouce
+            std::unique_ptr<double[]> tmp(new (std::nothrow) double[
+                (dwMaxBasis * dwDimension) + (dwMaxSteps * dwMaxBasis) + (dwMaxSteps * dwMaxSteps) + (dwMaxRange * dwMaxSteps) + dwMaxRange + dwDimension]);
+            if (!tmp)
+                return false;
+
+            double *pBasis = tmp.get();                                 // dwMaxBasis * dwDimension
+            double *pCoordinate = pBasis + (dwMaxBasis * dwDimension);   // dwMaxSteps * dwMaxBasis
+            double *pProjected = pCoordinate + (dwMaxSteps * dwMaxBasis); // dwMaxSteps * dwMaxSteps
+            double *pRitzVector = pProjected + (dwMaxSteps * dwMaxSteps); // dwMaxRange * dwMaxSteps
+            double *pRitzValue = pRitzVector + (dwMaxRange * dwMaxSteps); // dwMaxRange
+            double *pW = pRitzValue + dwMaxRange;                         // dwDimension
+
+            // 2. Start from a block of random vectors. The engine is seeded
+            // with its default, so that results are reproducible.
+            std::mt19937_64 randomEngine;
+            size_t dwBasisSize = 0;
+            for (size_t i = 0; i < dwBlockSize; i++)
+            {
+                if (!AppendRandomBasisVector(dwDimension, pBasis, dwBasisSize, randomEngine))
+                {
+                    return false;
+                }
+            }
+
+            for (size_t dwSteps = 0; dwSteps < dwMaxSteps;)
+            {
+                // 3. w = A * q(dwSteps). Its coordinates along the basis are
+                // kept in row dwSteps of pCoordinate, the rest of w is the next
+                // basis vector q(dwSteps + dwBlockSize).
+                const double *pQ = pBasis + dwSteps * dwDimension;
+                double *pWCoordinate = pCoordinate + dwSteps * dwMaxBasis;
+
+                for (size_t i = 0; i < dwDimension; i++)
+                {
+                    const value_type *pRow = pMatrix + i * dwDimension;
+                    double w = 0;
+                    for (size_t j = 0; j < dwDimension; j++)
+                    {
+                        w += double(pRow[j]) * pQ[j];
+                    }
+                    pW[i] = w;
+                }
+
+                double fNorm = IsochartSqrt(DoubleDot(pW, pW, dwDimension));
+                OrthogonalizeToBasis(dwDimension, pBasis, dwBasisSize, pW, pWCoordinate);
+                double fRemainder = IsochartSqrt(DoubleDot(pW, pW, dwDimension));
+                dwSteps++;
+
+                if (fRemainder > LANCZOS_BREAKDOWN * fNorm)
+                {
+                    pWCoordinate[dwBasisSize] = fRemainder;
+                    double *pNewQ = pBasis + dwBasisSize * dwDimension;
+                    for (size_t i = 0; i < dwDimension; i++)
+                    {
+                        pNewQ[i] = pW[i] / fRemainder;
+                    }
+                    dwBasisSize++;
+                }
+                else
+                {
+                    // The Krylov space is invariant, go on with a random vector.
+                    pWCoordinate[dwBasisSize] = 0;
+                    if (!AppendRandomBasisVector(dwDimension, pBasis, dwBasisSize, randomEngine))
+                    {
+                        return false;
+                    }
+                }
+
+                // Check the convergence once per block.
+                if (dwSteps < dwMaxRange || (dwSteps % dwBlockSize != 0 && dwSteps < dwMaxSteps))
+                {
+                    continue;
+                }
+
+                // 4. Rayleigh-Ritz on the first dwSteps basis vectors. The
+                // projected element (i, j), i <= j, is the coordinate of
+                // A * q(j) along q(i).
+                for (size_t i = 0; i < dwSteps; i++)
+                {
+                    for (size_t j = i; j < dwSteps; j++)
+                    {
+                        pProjected[i * dwSteps + j] = pCoordinate[j * dwMaxBasis + i];
+                        pProjected[j * dwSteps + i] = pCoordinate[j * dwMaxBasis + i];
+                    }
+                }
+
+                if (!CSymmetricMatrix<double>::GetEigenByHouseholderQL(
+                    dwSteps, pProjected, pRitzValue, pRitzVector, dwMaxRange, LANCZOS_QL_EPSILON))
+                {
+                    return false;
+                }
+
+                // 5. The residual of the Ritz pair (t, Q * s) is the part of
+                // A * Q * s along the basis vectors not multiplied yet. A * q(j)
+                // has no coordinate along q(i) if i > j + dwBlockSize.
+                const double fTolerance = LANCZOS_TOLERANCE * std::max(
+                    fabs(pRitzValue[0]), fabs(pRitzValue[dwMaxRange - 1]));
+
+                bool bConverged = true;
+                for (size_t k = 0; k < dwMaxRange && bConverged; k++)
+                {
+                    const double *pS = pRitzVector + k * dwSteps;
+                    double fResidual = 0;
+                    for (size_t i = dwSteps; i < dwBasisSize; i++)
+                    {
+                        double r = 0;
+                        for (size_t j = i - dwBlockSize; j < dwSteps; j++)
+                        {
+                            r += pCoordinate[j * dwMaxBasis + i] * pS[j];
+                        }
+                        fResidual += r * r;
+                    }
+                    bConverged = IsochartSqrt(fResidual) <= fTolerance;
+                }
+
+                if (!bConverged)
+                {
+                    continue;
+                }
+
+                // 6. Export the Ritz pairs.
+                for (size_t k = 0; k < dwMaxRange; k++)
+                {
+                    const double *pS = pRitzVector + k * dwSteps;
+                    value_type *pVector = pEigenVector + k * dwDimension;
+
+                    pEigenValue[k] = value_type(pRitzValue[k]);
+                    for (size_t i = 0; i < dwDimension; i++)
+                    {
+                        double v = 0;
+                        for (size_t j = 0; j < dwSteps; j++)
+                        {
+                            v += pS[j] * pBasis[j * dwDimension + i];
+                        }
+                        pVector[i] = value_type(v);
+                    }
+                }
+
+                return true;
+            }
+
+            return false;
+        }
+
+        // Householder reduction to tridiagonal form, followed by the QL
+        // iteration, for all eigenpairs.
+        _Success_(return) static bool GetEigenByHouseholderQL(
+            size_t dwDimension,
+            _In_reads_(dwDimension *dwDimension) const value_type *pMatrix,
+            _Out_writes_(dwMaxRange) value_type *pEigenValue,
+            _Out_writes_(dwDimension *dwMaxRange) value_type *pEigenVector,
+            size_t dwMaxRange,
+            value_type epsilon)
+        {
+            // 1. check argument
+            if (!pMatrix || !pEigenValue || !pEigenVector)
+                return false;
+
+            if (dwDimension < dwMaxRange || dwMaxRange == 0 || dwDimension == 0)
+            {
+                return false;
+            }
+
             // 2. allocate memory resouce
             std::unique_ptr<value_type[]> tmp(new (std::nothrow) value_type[(dwDimension * dwDimension) + (4 * dwDimension)]);
             if (!tmp)
@@ -10,7 +10,9 @@
 #include "pch.h"
 #include "UVAtlas.h"
 #include "isochart.h"
+#include "isochartcancel.h"
 #include "UVAtlasRepacker.h"
+#include "taskscheduler.h"
 
 #include <cstdarg>
 
@@ -272,6 +274,9 @@ namespace
         _Inout_ std::vector<uint32_t> &vPartitionResultAdjacency,
         _Out_opt_ float *maxStretchOut,
         _Out_opt_ size_t *numChartsOut,
+        _In_opt_ const UVAtlasExecutor *executor,
+        _Inout_opt_ UVAtlasStats *stats,
+        _In_opt_ const UVAtlasCancellation *cancellation,
         _In_ unsigned int uStageInfo)
     {
         if (!positions || !nVerts || !indices || !nFaces)
@@ -363,7 +368,10 @@ namespace
             statusCallBack,
             callbackFrequency,
             falseEdgeAdjacency,
-            options);
+            options,
+            executor,
+            stats,
+            cancellation);
         if (FAILED(hr))
             return hr;
 
@@ -472,6 +480,9 @@ namespace
         _In_ const std::vector<uint32_t> &vPartitionResultAdjacency,
         _In_ LPISOCHARTCALLBACK &statusCallback,
         float callbackFrequency,
+        _In_opt_ const UVAtlasExecutor *executor,
+        _Inout_opt_ UVAtlasStats *stats,
+        _In_opt_ const UVAtlasCancellation *cancellation,
         _In_ unsigned int uStageInfo)
     {
         if (!width || !height)
@@ -554,7 +565,10 @@ namespace
             gutter,
             uStageInfo,
             statusCallback,
-            callbackFrequency);
+            callbackFrequency,
+            executor,
+            stats,
+            cancellation);
         if (FAILED(hr))
             return hr;
 
@@ -595,8 +609,16 @@ HRESULT __cdecl DirectX::UVAtlasPartition(
     std::vector<uint32_t> *pvVertexRemapArray,
     std::vector<uint32_t> &vPartitionResultAdjacency,
     float *maxStretchOut,
-    size_t *numChartsOut)
+    size_t *numChartsOut,
+    const UVAtlasExecutor *executor,
+    UVAtlasStats *stats,
+    const UVAtlasCancellation *cancellation)
 {
+    if (stats)
+    {
+        *stats = UVAtlasStats{};
+    }
+
     return UVAtlasPartitionInt(positions,
         nVerts,
         indices,
@@ -617,6 +639,9 @@ HRESULT __cdecl DirectX::UVAtlasPartition(
         vPartitionResultAdjacency,
         maxStretchOut,
         numChartsOut,
+        executor,
+        stats,
+        cancellation,
         (maxChartNumber == 0) ? MAKE_STAGE(2U, 0U, 2U) : MAKE_STAGE(3U, 0U, 3U));
 }
 
@@ -631,8 +656,16 @@ HRESULT __cdecl DirectX::UVAtlasPack(
     float gutter,
     const std::vector<uint32_t> &vPartitionResultAdjacency,
     std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
-    float callbackFrequency)
+    float callbackFrequency,
+    const UVAtlasExecutor *executor,
+    UVAtlasStats *stats,
+    const UVAtlasCancellation *cancellation)
 {
+    if (stats)
+    {
+        *stats = UVAtlasStats{};
+    }
+
     return UVAtlasPackInt(vMeshVertexBuffer,
         vMeshIndexBuffer,
         indexFormat,
@@ -642,6 +675,9 @@ HRESULT __cdecl DirectX::UVAtlasPack(
         vPartitionResultAdjacency,
         statusCallBack,
         callbackFrequency,
+        executor,
+        stats,
+        cancellation,
         MAKE_STAGE(1, 0, 1));
 }
 
@@ -669,8 +705,16 @@ HRESULT __cdecl DirectX::UVAtlasCreate(
     std::vector<uint32_t> *pvFacePartitioning,
     std::vector<uint32_t> *pvVertexRemapArray,
     float *maxStretchOut,
-    size_t *numChartsOut)
+    size_t *numChartsOut,
+    const UVAtlasExecutor *executor,
+    UVAtlasStats *stats,
+    const UVAtlasCancellation *cancellation)
 {
+    if (stats)
+    {
+        *stats = UVAtlasStats{};
+    }
+
     std::vector<uint32_t> vFacePartitioning;
     std::vector<uint32_t> vAdjacencyOut;
 
@@ -694,6 +738,9 @@ HRESULT __cdecl DirectX::UVAtlasCreate(
         vAdjacencyOut,
         maxStretchOut,
         numChartsOut,
+        executor,
+        stats,
+        cancellation,
         (maxChartNumber == 0) ? MAKE_STAGE(3U, 0U, 2U) : MAKE_STAGE(4U, 0U, 3U));
     if (FAILED(hr))
         return hr;
@@ -707,6 +754,9 @@ HRESULT __cdecl DirectX::UVAtlasCreate(
         vAdjacencyOut,
         statusCallBack,
         callbackFrequency,
+        executor,
+        stats,
+        cancellation,
         (maxChartNumber == 0) ? MAKE_STAGE(3U, 2U, 1U) : MAKE_STAGE(4U, 3U, 1U));
     if (FAILED(hr))
         return hr;
@@ -719,6 +769,423 @@ HRESULT __cdecl DirectX::UVAtlasCreate(
     return S_OK;
 }
 
+//-------------------------------------------------------------------------------------
+namespace
+{
+    HRESULT CreateBatchMesh(
+        const UVAtlasBatchMesh &mesh,
+        const std::function<HRESULT __cdecl(float percentComplete)> &statusCallBack,
+        float callbackFrequency,
+        const UVAtlasExecutor *executor,
+        const UVAtlasCancellation *cancellation,
+        UVAtlasBatchResult &result)
+    {
+        // A mesh not started before the batch was stopped keeps the error of
+        // the stop.
+        result.hr = CIsochartCancel(cancellation).Check();
+        if (FAILED(result.hr))
+        {
+            return result.hr;
+        }
+
+        try
+        {
+            result.hr = UVAtlasCreate(mesh.positions,
+                mesh.nVerts,
+                mesh.indices,
+                mesh.indexFormat,
+                mesh.nFaces,
+                mesh.maxChartNumber,
+                mesh.maxStretch,
+                mesh.width,
+                mesh.height,
+                mesh.gutter,
+                mesh.adjacency,
+                mesh.falseEdgeAdjacency,
+                mesh.pIMTArray,
+                statusCallBack,
+                callbackFrequency,
+                mesh.options,
+                result.vMeshOutVertexBuffer,
+                result.vMeshOutIndexBuffer,
+                &result.vFacePartitioning,
+                &result.vVertexRemapArray,
+                &result.maxStretchOut,
+                &result.numChartsOut,
+                executor,
+                nullptr,
+                cancellation);
+        }
+        catch (std::bad_alloc &)
+        {
+            result.hr = E_OUTOFMEMORY;
+        }
+        return result.hr;
+    }
+}
+
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT __cdecl DirectX::UVAtlasCreateBatch(
+    const UVAtlasBatchMesh *meshes,
+    size_t nMeshes,
+    std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
+    float callbackFrequency,
+    std::vector<UVAtlasBatchResult> &results,
+    const UVAtlasExecutor *executor,
+    const UVAtlasCancellation *cancellation)
+{
+    if (!meshes && nMeshes > 0)
+        return E_INVALIDARG;
+
+    std::vector<size_t> order;
+    try
+    {
+        results.clear();
+        results.resize(nMeshes);
+        order.resize(nMeshes);
+    }
+    catch (std::bad_alloc &)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    size_t totalFaces = 0;
+    for (size_t i = 0; i < nMeshes; i++)
+    {
+        results[i].hr = E_ABORT;
+        order[i] = i;
+        totalFaces += meshes[i].nFaces;
+    }
+
+    // Largest meshes first, so the small ones fill the gaps at the end.
+    std::sort(order.begin(), order.end(), [meshes](size_t a, size_t b)
+        {
+            return (meshes[a].nFaces != meshes[b].nFaces) ? (meshes[a].nFaces > meshes[b].nFaces) : (a < b);
+        });
+
+    CTaskScheduler scheduler(executor);
+    const size_t dwWorkerCount = scheduler.GetWorkerCount();
+
+    // Progress is counted in faces, and only reported from the calling thread.
+    std::atomic<size_t> facesDone(0);
+    float fLastPct = 0.f;
+    bool bAborted = false;
+    auto reportProgress = [&](size_t dwFaces) -> HRESULT
+        {
+            if (!statusCallBack || !totalFaces)
+                return S_OK;
+
+            float fPct = std::min(float(dwFaces) / float(totalFaces), 1.f);
+            if (fPct < 1.f && fPct - fLastPct < callbackFrequency)
+                return S_OK;
+
+            fLastPct = fPct;
+            if (FAILED(statusCallBack(fPct)))
+            {
+                bAborted = true;
+                return E_ABORT;
+            }
+            return S_OK;
+        };
+
+    // A mesh holding more than its share of the faces would keep one thread
+    // busy long after the others ran out of meshes, so these are created one
+    // after the other, each with all the threads.
+    size_t dwLargeCount = 0;
+    if (dwWorkerCount > 1)
+    {
+        while (dwLargeCount < nMeshes && meshes[order[dwLargeCount]].nFaces * dwWorkerCount > totalFaces)
+            dwLargeCount++;
+    }
+
+    for (size_t i = 0; i < dwLargeCount; i++)
+    {
+        const UVAtlasBatchMesh &mesh = meshes[order[i]];
+        const size_t dwBase = facesDone;
+
+        std::function<HRESULT __cdecl(float percentComplete)> meshCallBack;
+        if (statusCallBack)
+        {
+            try
+            {
+                meshCallBack = [&reportProgress, &mesh, dwBase](float fPct) -> HRESULT
+                    {
+                        return reportProgress(dwBase + size_t(fPct * float(mesh.nFaces)));
+                    };
+            }
+            catch (std::bad_alloc &)
+            {
+                return E_OUTOFMEMORY;
+            }
+        }
+
+        CreateBatchMesh(mesh, meshCallBack, callbackFrequency, executor, cancellation, results[order[i]]);
+        if (bAborted)
+            return E_ABORT;
+
+        facesDone += mesh.nFaces;
+    }
+
+    // The other meshes are created one per thread, each thread taking the
+    // largest mesh left.
+    const UVAtlasExecutor serialExecutor = { 1, nullptr };
+    std::atomic<size_t> dwNext(dwLargeCount);
+    HRESULT hr = scheduler.ParallelFor(dwWorkerCount, 1,
+        [&](size_t, size_t, size_t dwWorker) -> HRESULT
+        {
+            for (size_t i = dwNext++; i < nMeshes && !scheduler.IsFailed(); i = dwNext++)
+            {
+                const UVAtlasBatchMesh &mesh = meshes[order[i]];
+                CreateBatchMesh(mesh, nullptr, callbackFrequency, &serialExecutor, cancellation, results[order[i]]);
+                facesDone += mesh.nFaces;
+
+                if (dwWorker == 0)
+                {
+                    HRESULT hrProgress = reportProgress(facesDone);
+                    if (FAILED(hrProgress))
+                        return hrProgress;
+                }
+            }
+            return S_OK;
+        });
+    if (FAILED(hr))
+        return hr;
+
+    hr = reportProgress(totalFaces);
+    if (FAILED(hr))
+        return hr;
+
+    for (size_t i = 0; i < nMeshes; i++)
+    {
+        if (FAILED(results[i].hr))
+            return results[i].hr;
+    }
+
+    return S_OK;
+}
+
+//-------------------------------------------------------------------------------------
+struct DirectX::UVAtlasJob
+{
+    UVAtlasBatchMesh mesh;
+    std::function<void __cdecl(const UVAtlasBatchResult &result)> completion;
+    float callbackFrequency;
+    UVAtlasExecutor executor;
+
+    UVAtlasCancellation cancellation;
+    std::atomic<float> progress;
+
+    mutable std::mutex lock;
+    std::condition_variable signal;
+    bool bDone;
+    UVAtlasBatchResult result;
+
+    // Runs the job when the executor has no submit
+    std::thread worker;
+
+    UVAtlasJob() : mesh{}, callbackFrequency(0.f), executor{ 0, nullptr }, progress(0.f), bDone(false), result{ E_ABORT } {}
+
+    UVAtlasJob(const UVAtlasJob &) = delete;
+    UVAtlasJob &operator=(const UVAtlasJob &) = delete;
+
+    // The worker holds a reference until Run returns, so the job is only
+    // released on it when it held the last one. It then detaches itself, as
+    // it has nothing left to run. Otherwise Run has returned and the join is
+    // short.
+    ~UVAtlasJob()
+    {
+        if (worker.joinable())
+        {
+            if (worker.get_id() == std::this_thread::get_id())
+            {
+                worker.detach();
+            }
+            else
+            {
+                worker.join();
+            }
+        }
+    }
+
+    void Run() noexcept
+    {
+        auto statusCallBack = [this](float percentComplete) -> HRESULT
+            {
+                progress.store(percentComplete, std::memory_order_relaxed);
+                return S_OK;
+            };
+        CreateBatchMesh(mesh, statusCallBack, callbackFrequency, &executor, &cancellation, result);
+        if (SUCCEEDED(result.hr))
+        {
+            progress = 1.f;
+        }
+
+        if (completion)
+        {
+            completion(result);
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            bDone = true;
+        }
+        signal.notify_all();
+    }
+};
+
+_Use_decl_annotations_
+HRESULT __cdecl DirectX::UVAtlasCreateAsync(
+    const UVAtlasBatchMesh &mesh,
+    std::function<void __cdecl(const UVAtlasBatchResult &result)> completion,
+    float callbackFrequency,
+    std::shared_ptr<UVAtlasJob> &job,
+    const UVAtlasExecutor *executor)
+{
+    job.reset();
+
+    std::shared_ptr<UVAtlasJob> newJob;
+    try
+    {
+        newJob = std::make_shared<UVAtlasJob>();
+        newJob->mesh = mesh;
+        newJob->completion = std::move(completion);
+        newJob->callbackFrequency = callbackFrequency;
+        if (executor)
+        {
+            newJob->executor = *executor;
+        }
+    }
+    catch (std::bad_alloc &)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    // The job keeps itself alive until it is done, even when the caller or
+    // the completion releases its handle.
+    try
+    {
+        if (newJob->executor.submit)
+        {
+            newJob->executor.submit([newJob]()
+                {
+                    newJob->Run();
+                });
+        }
+        else
+        {
+            newJob->worker = std::thread([pJob = newJob]() mutable
+                {
+                    pJob->Run();
+                    pJob.reset();
+                });
+        }
+    }
+    catch (std::bad_alloc &)
+    {
+        return E_OUTOFMEMORY;
+    }
+    catch (std::system_error &)
+    {
+        return E_FAIL;
+    }
+
+    job = std::move(newJob);
+    return S_OK;
+}
+
+_Use_decl_annotations_
+void __cdecl DirectX::UVAtlasJobCancel(UVAtlasJob &job)
+{
+    job.cancellation.cancel = true;
+}
+
+_Use_decl_annotations_
+float __cdecl DirectX::UVAtlasJobGetProgress(const UVAtlasJob &job)
+{
+    return job.progress.load(std::memory_order_relaxed);
+}
+
+_Use_decl_annotations_
+bool __cdecl DirectX::UVAtlasJobIsDone(const UVAtlasJob &job)
+{
+    std::lock_guard<std::mutex> guard(job.lock);
+    return job.bDone;
+}
+
+_Use_decl_annotations_
+const UVAtlasBatchResult &__cdecl DirectX::UVAtlasJobWait(UVAtlasJob &job)
+{
+    std::unique_lock<std::mutex> guard(job.lock);
+    job.signal.wait(guard, [&job]()
+        {
+            return job.bDone;
+        });
+    return job.result;
+}
+
+//-------------------------------------------------------------------------------------
+namespace
+{
+    constexpr size_t IMT_FACE_GRAIN = 256;
+
+    typedef std::function<HRESULT(size_t face, float *pfScratch)> IMTFACETASK;
+
+    // Runs faceTask on every face with the executor's threads. Each range of
+    // faces gets its own dwScratchSize floats of scratch memory. Only the
+    // calling thread reports progress.
+    HRESULT ComputeIMTOnFaces(
+        size_t nFaces,
+        size_t dwScratchSize,
+        const IMTFACETASK &faceTask,
+        const std::function<HRESULT __cdecl(float percentComplete)> &statusCallBack,
+        const UVAtlasExecutor *executor)
+    {
+        std::atomic<size_t> facesDone(0);
+
+        CTaskScheduler scheduler(executor);
+        HRESULT hr = scheduler.ParallelFor(nFaces, IMT_FACE_GRAIN,
+            [&](size_t dwBegin, size_t dwEnd, size_t dwWorker) -> HRESULT
+            {
+                std::unique_ptr<float[]> scratch;
+                if (dwScratchSize > 0)
+                {
+                    scratch.reset(new (std::nothrow) float[dwScratchSize]);
+                    if (!scratch)
+                        return E_OUTOFMEMORY;
+                }
+
+                for (size_t i = dwBegin; i < dwEnd; i++)
+                {
+                    if (statusCallBack && (dwWorker == 0) && ((i % 64) == 0))
+                    {
+                        float fPct = float(facesDone + i - dwBegin) / float(nFaces);
+                        if (FAILED(statusCallBack(fPct)))
+                            return E_ABORT;
+                    }
+
+                    HRESULT hrFace = faceTask(i, scratch.get());
+                    if (FAILED(hrFace))
+                        return hrFace;
+                }
+
+                facesDone += dwEnd - dwBegin;
+                return S_OK;
+            });
+        if (FAILED(hr))
+            return hr;
+
+        if (statusCallBack)
+        {
+            hr = statusCallBack(1.0f);
+            if (FAILED(hr))
+                return E_ABORT;
+        }
+
+        return S_OK;
+    }
+}
+
 //-------------------------------------------------------------------------------------
 _Use_decl_annotations_
 HRESULT __cdecl DirectX::UVAtlasComputeIMTFromPerVertexSignal(
@@ -731,7 +1198,8 @@ HRESULT __cdecl DirectX::UVAtlasComputeIMTFromPerVertexSignal(
     size_t signalDimension,
     size_t signalStride,
     std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
-    float *pIMTArray)
+    float *pIMTArray,
+    const UVAtlasExecutor *executor)
 {
     if (!positions || !nVerts || !indices || !nFaces || !pVertexSignal || !pIMTArray)
         return E_INVALIDARG;
@@ -767,75 +1235,56 @@ HRESULT __cdecl DirectX::UVAtlasComputeIMTFromPerVertexSignal(
     if ((uint64_t(signalDimension) * 3) >= UINT32_MAX)
         return HRESULT_E_ARITHMETIC_OVERFLOW;
 
-    std::unique_ptr<float[]> signalData(new (std::nothrow) float[3 * signalDimension]);
-    if (!signalData)
-        return E_OUTOFMEMORY;
-
-    float *pfSignalData = signalData.get();
-
     auto pdwIndexData = reinterpret_cast<const uint32_t *>(indices);
     auto pwIndexData = reinterpret_cast<const uint16_t *>(indices);
 
     float *pfIMTData = pIMTArray;
 
-    HRESULT hr;
-
-    for (size_t i = 0; i < nFaces; i++)
-    {
-        if (statusCallBack && ((i % 64) == 0))
+    return ComputeIMTOnFaces(nFaces,
+        3 * signalDimension,
+        [&](size_t i, float *pfSignalData) -> HRESULT
         {
-            float fPct = float(i) / float(nFaces);
-            hr = statusCallBack(fPct);
-            if (FAILED(hr))
-                return E_ABORT;
-        }
-
-        XMFLOAT3 pos[3] = {};
-        for (size_t j = 0; j < 3; j++)
-        {
-            uint32_t dwId;
-            if (indexFormat == DXGI_FORMAT_R16_UINT)
-            {
-                dwId = pwIndexData[3 * i + j];
-            }
-            else
+            XMFLOAT3 pos[3] = {};
+            for (size_t j = 0; j < 3; j++)
             {
-                dwId = pdwIndexData[3 * i + j];
-            }
+                uint32_t dwId;
+                if (indexFormat == DXGI_FORMAT_R16_UINT)
+                {
+                    dwId = pwIndexData[3 * i + j];
+                }
+                else
+                {
+                    dwId = pdwIndexData[3 * i + j];
+                }
 
-            if (dwId >= nVerts)
-            {
-                DPF(0, "UVAtlasComputeIMT: Vertex ID out of range.");
-                return E_FAIL;
-            }
+                if (dwId >= nVerts)
+                {
+                    DPF(0, "UVAtlasComputeIMT: Vertex ID out of range.");
+                    return E_FAIL;
+                }
 
-            pos[j] = positions[dwId];
+                pos[j] = positions[dwId];
 
-            for (size_t k = 0; k < signalDimension; k++)
-            {
-                pfSignalData[j * signalDimension + k] = pVertexSignal[dwId * (signalStride / sizeof(float)) + k];
+                for (size_t k = 0; k < signalDimension; k++)
+                {
+                    pfSignalData[j * signalDimension + k] = pVertexSignal[dwId * (signalStride / sizeof(float)) + k];
+                }
             }
-        }
 
-        hr = IMTFromPerVertexSignal(pos,
-            pfSignalData,
-            signalDimension,
-            reinterpret_cast<FLOAT3 *>(pfIMTData + 3 * i));
-        if (FAILED(hr))
-        {
-            DPF(0, "UVAtlasComputeIMT: IMT data calculation failed.");
-            return hr;
-        }
-    }
-
-    if (statusCallBack)
-    {
-        hr = statusCallBack(1.0f);
-        if (FAILED(hr))
-            return E_ABORT;
-    }
+            HRESULT hr = IMTFromPerVertexSignal(pos,
+                pfSignalData,
+                signalDimension,
+                reinterpret_cast<FLOAT3 *>(pfIMTData + 3 * i));
+            if (FAILED(hr))
+            {
+                DPF(0, "UVAtlasComputeIMT: IMT data calculation failed.");
+                return hr;
+            }
 
-    return S_OK;
+            return S_OK;
+        },
+        statusCallBack,
+        executor);
 }
 
 //-------------------------------------------------------------------------------------
@@ -852,7 +1301,8 @@ HRESULT __cdecl DirectX::UVAtlasComputeIMTFromSignal(
     std::function<HRESULT __cdecl(const DirectX::XMFLOAT2 *uv, size_t primitiveID, size_t signalDimension, void *userData, float *signalOut)> signalCallback,
     void *userData,
     std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
-    float *pIMTArray)
+    float *pIMTArray,
+    const UVAtlasExecutor *executor)
 {
     if (!positions || !texcoords || !nVerts || !indices || !nFaces || !pIMTArray)
         return E_INVALIDARG;
@@ -890,65 +1340,55 @@ HRESULT __cdecl DirectX::UVAtlasComputeIMTFromSignal(
 
     float *pfIMTData = pIMTArray;
 
-    HRESULT hr;
+    // The user's signal callback is only called concurrently when asked for.
+    const UVAtlasExecutor serialExecutor = { 1, nullptr };
 
-    for (size_t i = 0; i < nFaces; i++)
-    {
-        if (statusCallBack && ((i % 64) == 0))
+    return ComputeIMTOnFaces(nFaces,
+        0,
+        [&](size_t i, float *) -> HRESULT
         {
-            float fPct = float(i) / float(nFaces);
-            hr = statusCallBack(fPct);
-            if (FAILED(hr))
-                return E_ABORT;
-        }
-
-        XMFLOAT3 pos[3] = {};
-        XMFLOAT2 uv[3] = {};
-        for (size_t j = 0; j < 3; j++)
-        {
-            uint32_t dwId;
-            if (indexFormat == DXGI_FORMAT_R16_UINT)
-            {
-                dwId = pwIndexData[3 * i + j];
-            }
-            else
+            XMFLOAT3 pos[3] = {};
+            XMFLOAT2 uv[3] = {};
+            for (size_t j = 0; j < 3; j++)
             {
-                dwId = pdwIndexData[3 * i + j];
+                uint32_t dwId;
+                if (indexFormat == DXGI_FORMAT_R16_UINT)
+                {
+                    dwId = pwIndexData[3 * i + j];
+                }
+                else
+                {
+                    dwId = pdwIndexData[3 * i + j];
+                }
+
+                if (dwId >= nVerts)
+                {
+                    DPF(0, "UVAtlasComputeIMT: Vertex ID out of range.");
+                    return E_FAIL;
+                }
+
+                pos[j] = positions[dwId];
+                uv[j] = texcoords[dwId];
             }
 
-            if (dwId >= nVerts)
+            HRESULT hr = IMTFromTextureMap(pos, uv,
+                8, // max 64k subtesselations
+                maxUVDistance,
+                i,
+                signalDimension,
+                signalCallback,
+                userData,
+                reinterpret_cast<FLOAT3 *>(pfIMTData + 3 * i));
+            if (FAILED(hr))
             {
-                DPF(0, "UVAtlasComputeIMT: Vertex ID out of range.");
-                return E_FAIL;
+                DPF(0, "UVAtlasComputeIMT: IMT data calculation failed.");
+                return hr;
             }
 
-            pos[j] = positions[dwId];
-            uv[j] = texcoords[dwId];
-        }
-
-        hr = IMTFromTextureMap(pos, uv,
-            8, // max 64k subtesselations
-            maxUVDistance,
-            i,
-            signalDimension,
-            signalCallback,
-            userData,
-            reinterpret_cast<FLOAT3 *>(pfIMTData + 3 * i));
-        if (FAILED(hr))
-        {
-            DPF(0, "UVAtlasComputeIMT: IMT data calculation failed.");
-            return hr;
-        }
-    }
-
-    if (statusCallBack)
-    {
-        hr = statusCallBack(1.0f);
-        if (FAILED(hr))
-            return E_ABORT;
-    }
-
-    return S_OK;
+            return S_OK;
+        },
+        statusCallBack,
+        executor ? executor : &serialExecutor);
 }
 
 //-------------------------------------------------------------------------------------
@@ -1245,7 +1685,8 @@ HRESULT __cdecl DirectX::UVAtlasComputeIMTFromTexture(
     size_t height,
     UVATLAS_IMT options,
     std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
-    float *pIMTArray)
+    float *pIMTArray,
+    const UVAtlasExecutor *executor)
 {
     if (!positions || !texcoords || !nVerts || !indices || !nFaces || !pTexture || !pIMTArray)
         return E_INVALIDARG;
@@ -1303,64 +1744,51 @@ HRESULT __cdecl DirectX::UVAtlasComputeIMTFromTexture(
 
     float *pfIMTData = pIMTArray;
 
-    HRESULT hr;
-
-    for (size_t i = 0; i < nFaces; i++)
-    {
-        if (statusCallBack && ((i % 64) == 0))
+    return ComputeIMTOnFaces(nFaces,
+        0,
+        [&](size_t i, float *) -> HRESULT
         {
-            float fPct = float(i) / float(nFaces);
-            hr = statusCallBack(fPct);
-            if (FAILED(hr))
-                return E_ABORT;
-        }
-
-        XMFLOAT3 pos[3] = {};
-        XMFLOAT2 uv[3] = {};
-        for (size_t j = 0; j < 3; j++)
-        {
-            uint32_t dwId;
-            if (indexFormat == DXGI_FORMAT_R16_UINT)
-            {
-                dwId = pwIndexData[3 * i + j];
-            }
-            else
+            XMFLOAT3 pos[3] = {};
+            XMFLOAT2 uv[3] = {};
+            for (size_t j = 0; j < 3; j++)
             {
-                dwId = pdwIndexData[3 * i + j];
+                uint32_t dwId;
+                if (indexFormat == DXGI_FORMAT_R16_UINT)
+                {
+                    dwId = pwIndexData[3 * i + j];
+                }
+                else
+                {
+                    dwId = pdwIndexData[3 * i + j];
+                }
+
+                if (dwId >= nVerts)
+                {
+                    DPF(0, "UVAtlasComputeIMT: Vertex ID out of range.");
+                    return E_FAIL;
+                }
+
+                pos[j] = positions[dwId];
+                uv[j] = texcoords[dwId];
             }
 
-            if (dwId >= nVerts)
+            HRESULT hr = IMTFromTextureMapEx(pos,
+                uv,
+                i,
+                4, // dimension 4, rgba, can be zeroes if less than 4
+                pSignalCallback,
+                &TextureDesc,
+                reinterpret_cast<FLOAT3 *>(pfIMTData + 3 * i));
+            if (FAILED(hr))
             {
-                DPF(0, "UVAtlasComputeIMT: Vertex ID out of range.");
-                return E_FAIL;
+                DPF(0, "UVAtlasComputeIMT: IMT data calculation failed.");
+                return hr;
             }
 
-            pos[j] = positions[dwId];
-            uv[j] = texcoords[dwId];
-        }
-
-        hr = IMTFromTextureMapEx(pos,
-            uv,
-            i,
-            4, // dimension 4, rgba, can be zeroes if less than 4
-            pSignalCallback,
-            &TextureDesc,
-            reinterpret_cast<FLOAT3 *>(pfIMTData + 3 * i));
-        if (FAILED(hr))
-        {
-            DPF(0, "UVAtlasComputeIMT: IMT data calculation failed.");
-            return hr;
-        }
-    }
-
-    if (statusCallBack)
-    {
-        hr = statusCallBack(1.0f);
-        if (FAILED(hr))
-            return E_ABORT;
-    }
-
-    return S_OK;
+            return S_OK;
+        },
+        statusCallBack,
+        executor);
 }
 
 //-------------------------------------------------------------------------------------
@@ -1651,7 +2079,8 @@ HRESULT __cdecl DirectX::UVAtlasComputeIMTFromPerTexelSignal(
     size_t nComponents,
     UVATLAS_IMT options,
     std::function<HRESULT __cdecl(float percentComplete)> statusCallBack,
-    float *pIMTArray)
+    float *pIMTArray,
+    const UVAtlasExecutor *executor)
 {
     if (!positions || !texcoords || !nVerts || !indices || !nFaces || !pTexelSignal || !pIMTArray)
         return E_INVALIDARG;
@@ -1718,64 +2147,51 @@ HRESULT __cdecl DirectX::UVAtlasComputeIMTFromPerTexelSignal(
 
     float *pfIMTData = pIMTArray;
 
-    HRESULT hr;
-
-    for (size_t i = 0; i < nFaces; i++)
-    {
-        if (statusCallBack && ((i % 64) == 0))
-        {
-            float fPct = float(i) / float(nFaces);
-            hr = statusCallBack(fPct);
-            if (FAILED(hr))
-                return E_ABORT;
-        }
-
-        XMFLOAT3 pos[3] = {};
-        XMFLOAT2 uv[3] = {};
-        for (size_t j = 0; j < 3; j++)
+    return ComputeIMTOnFaces(nFaces,
+        0,
+        [&](size_t i, float *) -> HRESULT
         {
-            uint32_t dwId;
-            if (indexFormat == DXGI_FORMAT_R16_UINT)
-            {
-                dwId = pwIndexData[3 * i + j];
-            }
-            else
+            XMFLOAT3 pos[3] = {};
+            XMFLOAT2 uv[3] = {};
+            for (size_t j = 0; j < 3; j++)
             {
-                dwId = pdwIndexData[3 * i + j];
+                uint32_t dwId;
+                if (indexFormat == DXGI_FORMAT_R16_UINT)
+                {
+                    dwId = pwIndexData[3 * i + j];
+                }
+                else
+                {
+                    dwId = pdwIndexData[3 * i + j];
+                }
+
+                if (dwId >= nVerts)
+                {
+                    DPF(0, "UVAtlasComputeIMT: Vertex ID out of range.");
+                    return E_FAIL;
+                }
+
+                pos[j] = positions[dwId];
+                uv[j] = texcoords[dwId];
             }
 
-            if (dwId >= nVerts)
+            HRESULT hr = IMTFromTextureMapEx(pos,
+                uv,
+                i,
+                signalDimension,
+                pSignalCallback,
+                &FloatArrayDesc,
+                reinterpret_cast<FLOAT3 *>(pfIMTData + 3 * i));
+            if (FAILED(hr))
             {
-                DPF(0, "UVAtlasComputeIMT: Vertex ID out of range.");
-                return E_FAIL;
+                DPF(0, "UVAtlasComputeIMT: IMT data calculation failed.");
+                return hr;
             }
 
-            pos[j] = positions[dwId];
-            uv[j] = texcoords[dwId];
-        }
-
-        hr = IMTFromTextureMapEx(pos,
-            uv,
-            i,
-            signalDimension,
-            pSignalCallback,
-            &FloatArrayDesc,
-            reinterpret_cast<FLOAT3 *>(pfIMTData + 3 * i));
-        if (FAILED(hr))
-        {
-            DPF(0, "UVAtlasComputeIMT: IMT data calculation failed.");
-            return hr;
-        }
-    }
-
-    if (statusCallBack)
-    {
-        hr = statusCallBack(1.0f);
-        if (FAILED(hr))
-            return E_ABORT;
-    }
-
-    return S_OK;
+            return S_OK;
+        },
+        statusCallBack,
+        executor);
 }
 
 //-------------------------------------------------------------------------------------
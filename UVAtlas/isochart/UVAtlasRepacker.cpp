@@ -11,6 +11,8 @@
 
 #include "UVAtlasRepacker.h"
 #include "UVAtlas.h"
+#include "isochartstats.h"
+#include "taskscheduler.h"
 
 using namespace DirectX;
 using namespace Isochart;
@@ -30,6 +32,9 @@ IsochartRepacker::isochartpack2(
     unsigned int Stage,
     LPISOCHARTCALLBACK pCallback,
     float Frequency,
+    const UVAtlasExecutor *pExecutor,
+    UVAtlasStats *pStats,
+    const UVAtlasCancellation *pCancellation,
     size_t iNumRotate)
 {
     HRESULT hr = S_OK;
@@ -45,13 +50,23 @@ IsochartRepacker::isochartpack2(
     if (!repacker.SetCallback(pCallback, Frequency))
         return E_INVALIDARG;
 
+    repacker.SetExecutor(pExecutor);
+    repacker.SetStats(pStats);
+    repacker.SetCancellation(pCancellation);
+
     unsigned int dwTotalStage = STAGE_TOTAL(Stage);
     unsigned int dwDoneStage = STAGE_DONE(Stage);
 
     if (!repacker.SetStage(dwTotalStage, dwDoneStage))
         return E_INVALIDARG;
 
-    if (FAILED(hr = repacker.Repack()))
+    auto start = std::chrono::steady_clock::now();
+    hr = repacker.Repack();
+    if (pStats)
+    {
+        pStats->packTime += CStatsTimer::ToMilliseconds(CStatsTimer::ElapsedNanoseconds(start));
+    }
+    if (FAILED(hr))
         return hr;
 
     return S_OK;
@@ -126,10 +141,13 @@ CUVAtlasRepacker::CUVAtlasRepacker(
     m_pFinalWidth(pFinalWidth),
     m_pFinalHeight(pFinalHeight),
     m_pOurChartNumber(pChartNumber),
-    m_pOurIterationTimes(pIterationTimes)
+    m_pOurIterationTimes(pIterationTimes),
+    m_pExecutor(nullptr),
+    m_pStats(nullptr)
 {
-    std::random_device randomDevice;
-    m_randomEngine.seed(randomDevice());
+    // Only breaks the ties between the sides to put a chart on, a fixed seed
+    // keeps the atlas reproducible.
+    m_randomEngine.seed(REPACKER_RANDOM_SEED);
 }
 
 /***************************************************************************\
@@ -169,11 +187,27 @@ HRESULT CUVAtlasRepacker::Repack()
         if (m_iIterationTimes <= 9)
             m_callbackSchemer.InitCallBackAdapt(m_iNumCharts, 0.090f, float(m_iIterationTimes * 0.090 + 0.05));
 
+        if (FAILED(hr = m_cancel.Check()))
+            return hr;
+
         m_OutOfRange = false;
+        auto start = std::chrono::steady_clock::now();
         if (FAILED(hr = CreateUVAtlas()))
             return hr;
         DPF(3, "Estimated Space Percent = %.3f%%", double(m_EstimatedSpacePercent * 100.f));
 
+        if (m_pStats)
+        {
+            try
+            {
+                m_pStats->repackTimes.push_back(CStatsTimer::ToMilliseconds(CStatsTimer::ElapsedNanoseconds(start)));
+            }
+            catch (std::bad_alloc &)
+            {
+                return E_OUTOFMEMORY;
+            }
+        }
+
         if (m_iIterationTimes <= 9)
         {
             if (FAILED(hr = m_callbackSchemer.FinishWorkAdapt()))
@@ -282,6 +316,21 @@ bool CUVAtlasRepacker::SetStage(unsigned int TotalStageCount, unsigned int DoneS
     return true;
 }
 
+void CUVAtlasRepacker::SetExecutor(const UVAtlasExecutor *pExecutor)
+{
+    m_pExecutor = pExecutor;
+}
+
+void CUVAtlasRepacker::SetStats(UVAtlasStats *pStats)
+{
+    m_pStats = pStats;
+}
+
+void CUVAtlasRepacker::SetCancellation(const UVAtlasCancellation *pCancellation)
+{
+    m_cancel = CIsochartCancel(pCancellation);
+}
+
 //-------------------------------------------------------------------------
 //	private functions
 //-------------------------------------------------------------------------
@@ -304,6 +353,9 @@ HRESULT CUVAtlasRepacker::CreateUVAtlas()
     m_packedCharts = 1;
     for (size_t i = 1; i < m_iNumCharts; i++)
     {
+        if (FAILED(hr = m_cancel.Check()))
+            return hr;
+
         PutChart(m_SortedChartIndex[i]);
         if (!m_OutOfRange)
         {
@@ -1042,157 +1094,178 @@ void CUVAtlasRepacker::ComputeBoundingBox(
 \***************************************************************************/
 HRESULT CUVAtlasRepacker::PrepareChartsInfo()
 {
-    XMMATRIX bestMatrix = XMMatrixIdentity();
-    float RotateAngle = 5.0f;
-
-    std::vector<XMFLOAT2> OutVec;
+    // The charts are independent, each one only rotates its own vertices.
+    CTaskScheduler scheduler(m_pExecutor);
+    HRESULT hr = scheduler.ParallelFor(m_iNumCharts, 1,
+        [this](size_t dwBegin, size_t dwEnd, size_t) -> HRESULT
+        {
+            std::vector<XMFLOAT2> OutVec;
+            for (size_t i = dwBegin; i < dwEnd; i++)
+            {
+                HRESULT hrChart = PrepareChartInfo(static_cast<uint32_t>(i), OutVec);
+                if (FAILED(hrChart))
+                    return hrChart;
+            }
+            return S_OK;
+        });
+    if (FAILED(hr))
+        return hr;
 
-    // iterate each chart to tessellate it
+    // Sum in chart order, so the total does not depend on the thread count.
     for (uint32_t i = 0; i < m_iNumCharts; i++)
     {
-        // find best angle to rotate the chart to the best position
-        try
-        {
-            OutVec.resize(m_AttrTable[i].VertexCount);
-        }
-        catch (std::bad_alloc &)
-        {
-            return E_OUTOFMEMORY;
-        }
-
-        float minArea = 1e10;
+        if (m_ChartsInfo[i].valid)
+            m_fChartsTotalArea += m_ChartsInfo[i].area;
+    }
 
-        for (size_t j = 1; float(j) <= (float(90) / RotateAngle); j++)
-        {
-            float angle = float(j) * RotateAngle / 180.0f * XM_PI;
-            if (angle > XM_PI / 2.0f)
-                angle = XM_PI / 2.0f;
-            XMMATRIX rotateMatrix = XMMatrixRotationZ(angle);
+    return S_OK;
+}
 
-            XMVector2TransformCoordStream(
-                &OutVec[0],
-                sizeof(XMFLOAT2),
-                &m_VertexBuffer[m_AttrTable[i].VertexStart].uv,
-                VertexSize,
-                m_AttrTable[i].VertexCount,
-                rotateMatrix);
+HRESULT CUVAtlasRepacker::PrepareChartInfo(uint32_t i, std::vector<XMFLOAT2> &OutVec)
+{
+    XMMATRIX bestMatrix = XMMatrixIdentity();
+    float RotateAngle = 5.0f;
 
-            XMFLOAT2 minV(1e10f, 1e10f);
-            XMFLOAT2 maxV(-1e10f, -1e10f);
-            ComputeBoundingBox(OutVec, &minV, &maxV);
+    // find best angle to rotate the chart to the best position
+    try
+    {
+        OutVec.resize(m_AttrTable[i].VertexCount);
+    }
+    catch (std::bad_alloc &)
+    {
+        return E_OUTOFMEMORY;
+    }
 
-            // check if the chart has only one point
-            // we ignore it in our packing process
-            if ((maxV.x == minV.x) && (maxV.y == minV.y))
-            {
-                m_ChartsInfo[i].valid = false;
-                goto NEXT;
-            }
+    float minArea = 1e10;
 
-            // find the smallest bounding box
-            if ((maxV.x - minV.x) * (maxV.y - minV.y) < minArea)
-            {
-                minArea = (maxV.x - minV.x) * (maxV.y - minV.y);
-                bestMatrix = rotateMatrix;
-            }
-        }
+    for (size_t j = 1; float(j) <= (float(90) / RotateAngle); j++)
+    {
+        float angle = float(j) * RotateAngle / 180.0f * XM_PI;
+        if (angle > XM_PI / 2.0f)
+            angle = XM_PI / 2.0f;
+        XMMATRIX rotateMatrix = XMMatrixRotationZ(angle);
 
-        // copy the rotated vertex buffer back into the original one
         XMVector2TransformCoordStream(
-            &m_VertexBuffer[m_AttrTable[i].VertexStart].uv,
-            VertexSize,
+            &OutVec[0],
+            sizeof(XMFLOAT2),
             &m_VertexBuffer[m_AttrTable[i].VertexStart].uv,
             VertexSize,
             m_AttrTable[i].VertexCount,
-            bestMatrix);
+            rotateMatrix);
 
-        m_ChartsInfo[i].valid = true;
-        m_ChartsInfo[i].area = GetChartArea(i);
-        m_fChartsTotalArea += m_ChartsInfo[i].area;
+        XMFLOAT2 minV(1e10f, 1e10f);
+        XMFLOAT2 maxV(-1e10f, -1e10f);
+        ComputeBoundingBox(OutVec, &minV, &maxV);
 
-        // rotate the chart to different position and store the
-        // edges and other useful information
-        for (size_t j = 0; j < m_iRotateNum; j++)
+        // check if the chart has only one point
+        // we ignore it in our packing process
+        if ((maxV.x == minV.x) && (maxV.y == minV.y))
         {
-            float angle = float(j) * XM_PI / float(m_iRotateNum) / 2.0f;
-            XMMATRIX rotateMatrix = XMMatrixRotationZ(angle);
+            m_ChartsInfo[i].valid = false;
+            return S_OK;
+        }
 
-            XMVector2TransformCoordStream(
-                &OutVec[0],
-                sizeof(XMFLOAT2),
-                &m_VertexBuffer[m_AttrTable[i].VertexStart].uv,
-                VertexSize,
-                m_AttrTable[i].VertexCount,
-                rotateMatrix);
+        // find the smallest bounding box
+        if ((maxV.x - minV.x) * (maxV.y - minV.y) < minArea)
+        {
+            minArea = (maxV.x - minV.x) * (maxV.y - minV.y);
+            bestMatrix = rotateMatrix;
+        }
+    }
 
-            XMFLOAT2 minV(1e10f, 1e10f);
-            XMFLOAT2 maxV(-1e10f, -1e10f);
-            ComputeBoundingBox(OutVec, &minV, &maxV);
+    // copy the rotated vertex buffer back into the original one
+    XMVector2TransformCoordStream(
+        &m_VertexBuffer[m_AttrTable[i].VertexStart].uv,
+        VertexSize,
+        &m_VertexBuffer[m_AttrTable[i].VertexStart].uv,
+        VertexSize,
+        m_AttrTable[i].VertexCount,
+        bestMatrix);
+
+    m_ChartsInfo[i].valid = true;
+    m_ChartsInfo[i].area = GetChartArea(i);
+
+    // rotate the chart to different position and store the
+    // edges and other useful information
+    for (size_t j = 0; j < m_iRotateNum; j++)
+    {
+        float angle = float(j) * XM_PI / float(m_iRotateNum) / 2.0f;
+        XMMATRIX rotateMatrix = XMMatrixRotationZ(angle);
 
-            m_ChartsInfo[i].PosInfo[j].angle = angle;
-            m_ChartsInfo[i].PosInfo[j].maxPoint = maxV;
-            m_ChartsInfo[i].PosInfo[j].minPoint = minV;
-            if (j == 0)
-                m_ChartsInfo[i].maxLength = std::max(maxV.x - minV.x, maxV.y - minV.y);
+        XMVector2TransformCoordStream(
+            &OutVec[0],
+            sizeof(XMFLOAT2),
+            &m_VertexBuffer[m_AttrTable[i].VertexStart].uv,
+            VertexSize,
+            m_AttrTable[i].VertexCount,
+            rotateMatrix);
 
-            // find the outer edges of every chart for later tessellation
-            for (uint32_t k = 0; k < m_AttrTable[i].FaceCount; k++)
-            {
-                uint32_t Base = (k + m_AttrTable[i].FaceStart) * 3;
+        XMFLOAT2 minV(1e10f, 1e10f);
+        XMFLOAT2 maxV(-1e10f, -1e10f);
+        ComputeBoundingBox(OutVec, &minV, &maxV);
 
-                uint32_t a = m_IndexPartition[m_IndexBuffer[Base]];
-                uint32_t b = m_IndexPartition[m_IndexBuffer[Base + 1u]];
-                uint32_t c = m_IndexPartition[m_IndexBuffer[Base + 2u]];
+        m_ChartsInfo[i].PosInfo[j].angle = angle;
+        m_ChartsInfo[i].PosInfo[j].maxPoint = maxV;
+        m_ChartsInfo[i].PosInfo[j].minPoint = minV;
+        if (j == 0)
+            m_ChartsInfo[i].maxLength = std::max(maxV.x - minV.x, maxV.y - minV.y);
 
-                uint32_t indexbase = m_AttrTable[i].VertexStart;
+        // find the outer edges of every chart for later tessellation
+        for (uint32_t k = 0; k < m_AttrTable[i].FaceCount; k++)
+        {
+            uint32_t Base = (k + m_AttrTable[i].FaceStart) * 3;
+
+            uint32_t a = m_IndexPartition[m_IndexBuffer[Base]];
+            uint32_t b = m_IndexPartition[m_IndexBuffer[Base + 1u]];
+            uint32_t c = m_IndexPartition[m_IndexBuffer[Base + 2u]];
+
+            uint32_t indexbase = m_AttrTable[i].VertexStart;
 
-                XMFLOAT2 &Vertex1 = *reinterpret_cast<XMFLOAT2 *>(&OutVec[a - indexbase]);
-                XMFLOAT2 &Vertex2 = *reinterpret_cast<XMFLOAT2 *>(&OutVec[b - indexbase]);
-                XMFLOAT2 &Vertex3 = *reinterpret_cast<XMFLOAT2 *>(&OutVec[c - indexbase]);
+            XMFLOAT2 &Vertex1 = *reinterpret_cast<XMFLOAT2 *>(&OutVec[a - indexbase]);
+            XMFLOAT2 &Vertex2 = *reinterpret_cast<XMFLOAT2 *>(&OutVec[b - indexbase]);
+            XMFLOAT2 &Vertex3 = *reinterpret_cast<XMFLOAT2 *>(&OutVec[c - indexbase]);
 
-                // handle the situation when the triangle have two uniform vertices
-                // bases on our experiment we just recognize every line segment as one edge
-                if (((Vertex1.x == Vertex2.x) && (Vertex1.y == Vertex2.y)) ||
-                    ((Vertex1.x == Vertex3.x) && (Vertex1.y == Vertex3.y)) ||
-                    ((Vertex3.x == Vertex2.x) && (Vertex3.y == Vertex2.y)))
+            // handle the situation when the triangle have two uniform vertices
+            // bases on our experiment we just recognize every line segment as one edge
+            if (((Vertex1.x == Vertex2.x) && (Vertex1.y == Vertex2.y)) ||
+                ((Vertex1.x == Vertex3.x) && (Vertex1.y == Vertex3.y)) ||
+                ((Vertex3.x == Vertex2.x) && (Vertex3.y == Vertex2.y)))
+            {
+                m_ChartsInfo[i].PosInfo[j].edges.clear();
+                for (uint32_t t = 0; t < m_AttrTable[i].FaceCount; t++)
                 {
-                    m_ChartsInfo[i].PosInfo[j].edges.clear();
-                    for (uint32_t t = 0; t < m_AttrTable[i].FaceCount; t++)
-                    {
-                        uint32_t Base0 = (t + m_AttrTable[i].FaceStart) * 3;
+                    uint32_t Base0 = (t + m_AttrTable[i].FaceStart) * 3;
 
-                        uint32_t a0 = m_IndexPartition[m_IndexBuffer[Base0]];
-                        uint32_t b0 = m_IndexPartition[m_IndexBuffer[Base0 + 1]];
-                        uint32_t c0 = m_IndexPartition[m_IndexBuffer[Base0 + 2]];
+                    uint32_t a0 = m_IndexPartition[m_IndexBuffer[Base0]];
+                    uint32_t b0 = m_IndexPartition[m_IndexBuffer[Base0 + 1]];
+                    uint32_t c0 = m_IndexPartition[m_IndexBuffer[Base0 + 2]];
 
-                        uint32_t indexbase0 = m_AttrTable[i].VertexStart;
+                    uint32_t indexbase0 = m_AttrTable[i].VertexStart;
 
-                        if (a0 >= indexbase0 && b0 >= indexbase0 && c0 >= indexbase0)
-                        {
-                            XMFLOAT2 &vert1 = *reinterpret_cast<XMFLOAT2 *>(&OutVec[a0 - indexbase0]);
-                            XMFLOAT2 &vert2 = *reinterpret_cast<XMFLOAT2 *>(&OutVec[b0 - indexbase0]);
-                            XMFLOAT2 &vert3 = *reinterpret_cast<XMFLOAT2 *>(&OutVec[c0 - indexbase0]);
-                            m_ChartsInfo[i].PosInfo[j].edges.push_back(EDGE(vert1, vert2));
-                            m_ChartsInfo[i].PosInfo[j].edges.push_back(EDGE(vert2, vert3));
-                            m_ChartsInfo[i].PosInfo[j].edges.push_back(EDGE(vert3, vert1));
-                        }
-                        else
-                            return E_FAIL;
+                    if (a0 >= indexbase0 && b0 >= indexbase0 && c0 >= indexbase0)
+                    {
+                        XMFLOAT2 &vert1 = *reinterpret_cast<XMFLOAT2 *>(&OutVec[a0 - indexbase0]);
+                        XMFLOAT2 &vert2 = *reinterpret_cast<XMFLOAT2 *>(&OutVec[b0 - indexbase0]);
+                        XMFLOAT2 &vert3 = *reinterpret_cast<XMFLOAT2 *>(&OutVec[c0 - indexbase0]);
+                        m_ChartsInfo[i].PosInfo[j].edges.push_back(EDGE(vert1, vert2));
+                        m_ChartsInfo[i].PosInfo[j].edges.push_back(EDGE(vert2, vert3));
+                        m_ChartsInfo[i].PosInfo[j].edges.push_back(EDGE(vert3, vert1));
                     }
-                    break;
+                    else
+                        return E_FAIL;
                 }
-
-                // if the triangle has a edge without adjacent triangle
-                // the edge is one outer edge
-                if (m_NewAdjacentInfo[Base] == uint32_t(-1))
-                    m_ChartsInfo[i].PosInfo[j].edges.push_back(EDGE(Vertex1, Vertex2));
-                if (m_NewAdjacentInfo[Base + 1] == uint32_t(-1))
-                    m_ChartsInfo[i].PosInfo[j].edges.push_back(EDGE(Vertex2, Vertex3));
-                if (m_NewAdjacentInfo[Base + 2] == uint32_t(-1))
-                    m_ChartsInfo[i].PosInfo[j].edges.push_back(EDGE(Vertex3, Vertex1));
+                break;
             }
+
+            // if the triangle has a edge without adjacent triangle
+            // the edge is one outer edge
+            if (m_NewAdjacentInfo[Base] == uint32_t(-1))
+                m_ChartsInfo[i].PosInfo[j].edges.push_back(EDGE(Vertex1, Vertex2));
+            if (m_NewAdjacentInfo[Base + 1] == uint32_t(-1))
+                m_ChartsInfo[i].PosInfo[j].edges.push_back(EDGE(Vertex2, Vertex3));
+            if (m_NewAdjacentInfo[Base + 2] == uint32_t(-1))
+                m_ChartsInfo[i].PosInfo[j].edges.push_back(EDGE(Vertex3, Vertex1));
         }
-    NEXT:;
     }
 
     return S_OK;
@@ -11,6 +11,7 @@
 
 #include "callbackschemer.h"
 #include "isochart.h"
+#include "isochartcancel.h"
 
 namespace IsochartRepacker
 {
@@ -31,6 +32,9 @@ namespace IsochartRepacker
     // than the user defined atlas
     constexpr int INITIAL_SIZE_FACTOR = 2;
 
+    // seed of the random choice between two equally good sides
+    constexpr uint64_t REPACKER_RANDOM_SEED = 0x2545f4914f6cdd1dull;
+
     // convert the index buffer into this structure for convenience
     // use template to handle 16-bit index and 32-bit index
     template <class T>
@@ -122,6 +126,12 @@ namespace IsochartRepacker
             [in]	Frequency		-	Specify how often the function will call the
                                         callback; a reasonable default value
                                         is 0.0001f.
+            [in]	pExecutor		-	Optional thread control, see
+                                        DirectX::UVAtlasExecutor.
+            [in]	pCancellation	-	Optional cancellation token and
+                                        deadline, checked before each chart
+                                        is put into the atlas. A best effort
+                                        deadline does not stop the packing.
             [in]	iNumRotate		-	The tentative times of rotation on one
                                         chart between 0 and 90 degrees when put
                                         the	chart into atlas. The default value
@@ -145,6 +155,9 @@ namespace IsochartRepacker
         _In_ unsigned int Stage,
         _In_ Isochart::LPISOCHARTCALLBACK pCallback = nullptr,
         _In_ float Frequency = 0.01f,
+        _In_opt_ const DirectX::UVAtlasExecutor *pExecutor = nullptr,
+        _Inout_opt_ DirectX::UVAtlasStats *pStats = nullptr,
+        _In_opt_ const DirectX::UVAtlasCancellation *pCancellation = nullptr,
         _In_ size_t iNumRotate = 5);
 
     class CUVAtlasRepacker
@@ -170,6 +183,9 @@ namespace IsochartRepacker
 
         bool SetCallback(Isochart::LPISOCHARTCALLBACK pCallback, float Frequency);
         bool SetStage(unsigned int TotalStageCount, unsigned int DoneStageCount);
+        void SetExecutor(const DirectX::UVAtlasExecutor *pExecutor);
+        void SetStats(DirectX::UVAtlasStats *pStats);
+        void SetCancellation(const DirectX::UVAtlasCancellation *pCancellation);
         HRESULT Repack();
 
     private:
@@ -182,6 +198,7 @@ namespace IsochartRepacker
         HRESULT GenerateAdjacentInfo();
 
         HRESULT PrepareChartsInfo();
+        HRESULT PrepareChartInfo(uint32_t i, std::vector<DirectX::XMFLOAT2> &OutVec);
 
         template <class T>
         HRESULT GenerateNewBuffers();
@@ -317,6 +334,9 @@ namespace IsochartRepacker
         size_t *m_pOurIterationTimes;
 
         Isochart::CCallbackSchemer m_callbackSchemer;
+        const DirectX::UVAtlasExecutor *m_pExecutor;
+        DirectX::UVAtlasStats *m_pStats;
+        Isochart::CIsochartCancel m_cancel;
 
         std::mt19937_64 m_randomEngine;
     };
@@ -12,8 +12,6 @@
 
 using namespace Isochart;
 
-size_t CMaxFlow::Node::m_expect_degree = 3;
-
 // reserve the memory for nodes and edges
 // for better memory performance
 void CMaxFlow::ReserveMemory(size_t nNodes, size_t nEdges, size_t nDegree)
@@ -21,7 +19,6 @@ void CMaxFlow::ReserveMemory(size_t nNodes, size_t nEdges, size_t nDegree)
     nodes.clear();
     edges.clear();
 
-    Node::m_expect_degree = nDegree;
     if (nEdges == 0)
     {
         nEdges = nNodes * nDegree;
@@ -36,7 +33,6 @@ bool CMaxFlow::InitGraphCut(size_t nNodes, size_t nEdges, size_t nDegree)
     nodes.clear();
     edges.clear();
 
-    Node::m_expect_degree = nDegree;
     if (nEdges == 0)
     {
         nEdges = nNodes * nDegree;
@@ -45,6 +41,10 @@ bool CMaxFlow::InitGraphCut(size_t nNodes, size_t nEdges, size_t nDegree)
     try
     {
         nodes.resize(nNodes);
+        for (auto &node : nodes)
+        {
+            node.edges.reserve(nDegree);
+        }
         edges.reserve(nEdges * 2); // bi-directional edges, hence *2
     }
     catch (std::bad_alloc &)
@@ -162,7 +162,6 @@ namespace Isochart
             Node()
                 : capacity(0), resident(0), parent_node(no_parent), parent_edge(no_parent), m_iFlag(0), depth(0)
             {
-                edges.reserve(m_expect_degree);
             }
 
             cap_type capacity;
@@ -217,8 +216,6 @@ namespace Isochart
 
             int get_depth() const { return depth; }
 
-            static size_t m_expect_degree;
-
         protected:
             node_id parent_node; // parent node on the tree
             edge_id parent_edge; // the edge to parent node. always s->t
@@ -163,7 +163,7 @@ HRESULT CIsochartMesh::GenerateBoundaryCoord(
 }
 
 HRESULT CIsochartMesh::InitializeBarycentricEquation(
-    CSparseMatrix<double> &A,
+    CCompressedSparseMatrix<double> &A,
     CVector<double> &BU,
     CVector<double> &BV,
     const std::vector<double> &boundTable,
@@ -172,6 +172,7 @@ HRESULT CIsochartMesh::InitializeBarycentricEquation(
     HRESULT hr = S_OK;
 
     CSparseMatrix<double> orgA;
+    CCompressedSparseMatrix<double> compressedA;
     CVector<double> orgBU, orgBV;
 
     // 1. Allocate memory
@@ -218,20 +219,25 @@ HRESULT CIsochartMesh::InitializeBarycentricEquation(
         orgBV[vertMap[ii]] = bv;
     }
 
+    if (!compressedA.compress(orgA))
+    {
+        return E_OUTOFMEMORY;
+    }
+
     // 3. get Symmetric matrix
     // A' = A^T * A
-    if (!CSparseMatrix<double>::Mat_Trans_MUL_Mat(A, orgA))
+    if (!CCompressedSparseMatrix<double>::Mat_Trans_MUL_Mat(A, compressedA))
     {
         return E_OUTOFMEMORY;
     }
 
     // B' = A^T * b
-    if (!CSparseMatrix<double>::Mat_Trans_Mul_Vec(BU, orgA, orgBU))
+    if (!CCompressedSparseMatrix<double>::Mat_Trans_Mul_Vec(BU, compressedA, orgBU))
     {
         return E_OUTOFMEMORY;
     }
 
-    if (!CSparseMatrix<double>::Mat_Trans_Mul_Vec(BV, orgA, orgBV))
+    if (!CCompressedSparseMatrix<double>::Mat_Trans_Mul_Vec(BV, compressedA, orgBV))
     {
         return E_OUTOFMEMORY;
     }
@@ -276,11 +282,13 @@ HRESULT CIsochartMesh::BarycentricParameterization(
     size_t dwBoundaryCount = 0;
     size_t dwInternalCount = 0;
     std::vector<double> boundTable;
-    CSparseMatrix<double> A;
+    CCompressedSparseMatrix<double> A;
+    CCGPreconditioner<double> preconditioner;
     CVector<double> BU;
     CVector<double> BV;
     CVector<double> U;
     size_t nIterCount = 0;
+    bool bSolved = false;
     CVector<double> V;
 
     FAILURE_GOTO_END(
@@ -312,35 +320,50 @@ HRESULT CIsochartMesh::BarycentricParameterization(
             boundTable,
             vertMap));
 
-    // 4. Solve the linear equation set
     FAILURE_GOTO_END(
-        (false != CSparseMatrix<double>::ConjugateGradient(
-            U,
+        InitializeCGPreconditioner(
             A,
-            BU,
-            BC_MAX_ITERATION,
-            1e-8,
-            nIterCount)
-            ? S_OK
-            : E_FAIL));
+            preconditioner));
+
+    // 4. Solve the linear equation set, both with the same preconditioner
+    bSolved = CCompressedSparseMatrix<double>::ConjugateGradient(
+        U,
+        A,
+        BU,
+        preconditioner.type() != CG_PRECONDITIONER_NONE ? &preconditioner : nullptr,
+        BC_MAX_ITERATION,
+        1e-8,
+        nIterCount,
+        m_IsochartEngine.m_cancel.GetStopCheck(),
+        &m_IsochartEngine.m_executor);
+    m_IsochartEngine.m_stats.dwCGSolves++;
+    m_IsochartEngine.m_stats.dwCGIterations += nIterCount;
+    FAILURE_GOTO_END(m_IsochartEngine.m_cancel.Check());
+    FAILURE_GOTO_END(bSolved ? S_OK : E_FAIL);
     if (nIterCount >= BC_MAX_ITERATION)
     {
+        m_IsochartEngine.m_stats.dwCGIterationLimits++;
         goto LEnd;
     }
 
     nIterCount = 0;
-    FAILURE_GOTO_END(
-        (false != CSparseMatrix<double>::ConjugateGradient(
-            V,
-            A,
-            BV,
-            BC_MAX_ITERATION,
-            1e-8,
-            nIterCount)
-            ? S_OK
-            : E_FAIL));
+    bSolved = CCompressedSparseMatrix<double>::ConjugateGradient(
+        V,
+        A,
+        BV,
+        preconditioner.type() != CG_PRECONDITIONER_NONE ? &preconditioner : nullptr,
+        BC_MAX_ITERATION,
+        1e-8,
+        nIterCount,
+        m_IsochartEngine.m_cancel.GetStopCheck(),
+        &m_IsochartEngine.m_executor);
+    m_IsochartEngine.m_stats.dwCGSolves++;
+    m_IsochartEngine.m_stats.dwCGIterations += nIterCount;
+    FAILURE_GOTO_END(m_IsochartEngine.m_cancel.Check());
+    FAILURE_GOTO_END(bSolved ? S_OK : E_FAIL);
     if (nIterCount >= BC_MAX_ITERATION)
     {
+        m_IsochartEngine.m_stats.dwCGIterationLimits++;
         goto LEnd;
     }
 
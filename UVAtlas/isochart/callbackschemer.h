@@ -38,6 +38,14 @@ namespace Isochart
     //	Only check if caller want to report.
     // -FinishWorkAdapt()
     //	Finish a sub-task.
+    // -BeginParallelWork()
+    //  Start a stage run by several threads, from the calling thread. Until
+    //  EndParallelWork(), the workers count their steps with AddParallelWork()
+    //  and may call CheckPointAdapt() and PollParallelWork(). The callback is
+    //  then only called from the calling thread, at most once per
+    //  PARALLEL_CALLBACK_INTERVAL, and its failure is returned to all threads.
+    // -EndParallelWork()
+    //  Finish the parallel stage, from the calling thread.
     //
     // Example:
     // 	-A main task A has 2 sub-tasks: B, C
@@ -51,6 +59,9 @@ namespace Isochart
     //  2.2 UpdateCallbackAdapt(1)...UpdateCallbackAdapt(1)... // Perform task C
     //  2.3 FinishWorkAdapt() //Finish task C
 
+    // Shortest wall time between two calls of the callback in a parallel stage.
+    constexpr std::chrono::milliseconds PARALLEL_CALLBACK_INTERVAL(50);
+
     class CCallbackSchemer
     {
     public:
@@ -67,9 +78,16 @@ namespace Isochart
             m_fBase(0.f),
             m_dwTotalStage(0),
             m_dwDoneStage(0),
-            m_fPercentOfAllTasks(0.f)
+            m_fPercentOfAllTasks(0.f),
+            m_bParallel(false),
+            m_dwWorkerCount(0),
+            m_dwParallelDone(0),
+            m_hrParallel(S_OK)
         {}
 
+        CCallbackSchemer(CCallbackSchemer const &) = delete;
+        CCallbackSchemer &operator=(CCallbackSchemer const &) = delete;
+
         void SetCallback(
             LPISOCHARTCALLBACK pCallback,
             float Frequency);
@@ -93,7 +111,21 @@ namespace Isochart
 
         float PercentInAllStage();
 
+        HRESULT BeginParallelWork(size_t dwWorkerCount);
+        void AddParallelWork(size_t dwWorker, size_t dwDone);
+        HRESULT PollParallelWork();
+        HRESULT EndParallelWork();
+        bool IsParallelWork() const { return m_bParallel; }
+
     private:
+        void CollectParallelWork();
+
+        // Steps done by one worker, on its own cache line.
+        struct alignas(64) WORKERPROGRESS
+        {
+            std::atomic<size_t> dwDone;
+        };
+
         LPISOCHARTCALLBACK m_pCallback; // Callback function
         float m_fCallbackFrequency;     // The frequency to call callback function.
 
@@ -117,6 +149,14 @@ namespace Isochart
         unsigned int m_dwDoneStage;
 
         float m_fPercentOfAllTasks;
+
+        bool m_bParallel;                   // In a parallel stage.
+        std::unique_ptr<WORKERPROGRESS[]> m_pWorkerProgress;
+        size_t m_dwWorkerCount;
+        size_t m_dwParallelDone;            // Worker steps already in m_dwWorkDone.
+        std::thread::id m_callingThread;    // The only thread calling the callback.
+        std::chrono::steady_clock::time_point m_lastCallback;
+        std::atomic<HRESULT> m_hrParallel;  // First failure of the callback.
     };
 
     inline void CCallbackSchemer::SetCallback(
@@ -259,6 +299,11 @@ namespace Isochart
             return S_OK;
         }
 
+        if (m_bParallel)
+        {
+            return PollParallelWork();
+        }
+
         // Not update progress, only check if caller want to abort.
         return m_pCallback(PercentInAllStage());
     }
@@ -275,4 +320,117 @@ namespace Isochart
             PercentInAllStage());
     }
 
+    inline HRESULT CCallbackSchemer::BeginParallelWork(size_t dwWorkerCount)
+    {
+        assert(!m_bParallel);
+
+        if (!m_pCallback)
+        {
+            return S_OK;
+        }
+
+        if (dwWorkerCount > m_dwWorkerCount)
+        {
+            m_pWorkerProgress.reset(new (std::nothrow) WORKERPROGRESS[dwWorkerCount]);
+            if (!m_pWorkerProgress)
+            {
+                m_dwWorkerCount = 0;
+                return E_OUTOFMEMORY;
+            }
+            m_dwWorkerCount = dwWorkerCount;
+        }
+
+        for (size_t i = 0; i < m_dwWorkerCount; i++)
+        {
+            m_pWorkerProgress[i].dwDone = 0;
+        }
+        m_dwParallelDone = 0;
+        m_hrParallel = S_OK;
+        m_callingThread = std::this_thread::get_id();
+        m_lastCallback = std::chrono::steady_clock::now();
+        m_bParallel = true;
+        return S_OK;
+    }
+
+    // Any thread of the parallel stage.
+    inline void CCallbackSchemer::AddParallelWork(size_t dwWorker, size_t dwDone)
+    {
+        if (!m_bParallel)
+        {
+            return;
+        }
+
+        assert(dwWorker < m_dwWorkerCount);
+        m_pWorkerProgress[dwWorker].dwDone.fetch_add(dwDone, std::memory_order_relaxed);
+    }
+
+    // Any thread of the parallel stage. Only the calling thread updates the
+    // progress and calls the callback, the others get its last failure.
+    inline HRESULT CCallbackSchemer::PollParallelWork()
+    {
+        if (!m_bParallel)
+        {
+            return S_OK;
+        }
+
+        HRESULT hr = m_hrParallel;
+        if (FAILED(hr) || std::this_thread::get_id() != m_callingThread)
+        {
+            return hr;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - m_lastCallback < PARALLEL_CALLBACK_INTERVAL)
+        {
+            return S_OK;
+        }
+        m_lastCallback = now;
+
+        CollectParallelWork();
+
+        hr = m_pCallback(PercentInAllStage());
+        if (FAILED(hr))
+        {
+            m_hrParallel = hr;
+        }
+        return hr;
+    }
+
+    inline HRESULT CCallbackSchemer::EndParallelWork()
+    {
+        if (!m_bParallel)
+        {
+            return S_OK;
+        }
+
+        CollectParallelWork();
+        m_bParallel = false;
+        return m_hrParallel;
+    }
+
+    // Adds the worker steps done since the last call to the progress. As
+    // UpdateCallbackAdapt(), the progress stops at the wait point.
+    inline void CCallbackSchemer::CollectParallelWork()
+    {
+        size_t dwTotal = 0;
+        for (size_t i = 0; i < m_dwWorkerCount; i++)
+        {
+            dwTotal += m_pWorkerProgress[i].dwDone.load(std::memory_order_relaxed);
+        }
+
+        size_t dwNew = dwTotal - m_dwParallelDone;
+        m_dwParallelDone = dwTotal;
+        if (m_bIsWaitToFinish || 0 == dwNew)
+        {
+            return;
+        }
+
+        m_dwWorkDone += dwNew;
+        if (m_dwWorkDone >= m_dwWaitPoint)
+        {
+            m_dwWorkDone = m_dwWaitPoint;
+            m_bIsWaitToFinish = true;
+            m_dwWaitCount = 0;
+        }
+    }
 }
@@ -173,7 +173,10 @@ HRESULT Isochart::isochart(
     float *pMaxStretchOut,
     LPISOCHARTCALLBACK pCallback,
     float Frequency,
-    unsigned int dwOptions)
+    unsigned int dwOptions,
+    const UVAtlasExecutor *pExecutor,
+    UVAtlasStats *pStats,
+    const UVAtlasCancellation *pCancellation)
 {
     // 1. Check input parameter
     if (!CheckIsochartInput(
@@ -225,6 +228,22 @@ HRESULT Isochart::isochart(
         }
     }
 
+    if (pExecutor)
+    {
+        if (FAILED(hr = pEngine->SetExecutor(pExecutor)))
+        {
+            goto LEnd;
+        }
+    }
+
+    if (pCancellation)
+    {
+        if (FAILED(hr = pEngine->SetCancellation(pCancellation)))
+        {
+            goto LEnd;
+        }
+    }
+
     // 4. Initialize isochart engine
     if (FAILED(hr = pEngine->Initialize(
         pVertexArray,
@@ -269,6 +288,11 @@ HRESULT Isochart::isochart(
 
 LEnd:
 
+    if (pStats)
+    {
+        pEngine->ExportStats(pStats);
+    }
+
     // 7. Free resources of isochart engine
     pEngine->Free();
 
@@ -310,7 +334,10 @@ Isochart::isochartpartition(
     LPISOCHARTCALLBACK pCallback,
     float Frequency,
     const uint32_t *pSplitHint,
-    unsigned int dwOptions)
+    unsigned int dwOptions,
+    const UVAtlasExecutor *pExecutor,
+    UVAtlasStats *pStats,
+    const UVAtlasCancellation *pCancellation)
 {
     unsigned int dwTotalStage = STAGE_TOTAL(Stage);
     unsigned int dwDoneStage = STAGE_DONE(Stage);
@@ -341,6 +368,20 @@ Isochart::isochartpartition(
             goto LEnd;
         }
     }
+    if (pExecutor)
+    {
+        if (FAILED(hr = pEngine->SetExecutor(pExecutor)))
+        {
+            goto LEnd;
+        }
+    }
+    if (pCancellation)
+    {
+        if (FAILED(hr = pEngine->SetCancellation(pCancellation)))
+        {
+            goto LEnd;
+        }
+    }
     pEngine->SetStage(dwTotalStage, dwDoneStage);
 
     // 4. Initialize isochart engine
@@ -382,6 +423,11 @@ Isochart::isochartpartition(
     pEngine->SetStage(dwTotalStage, dwDoneStage + 1);
 LEnd:
 
+    if (pStats)
+    {
+        pEngine->ExportStats(pStats);
+    }
+
     // 7. Free resources of isochart engine
     pEngine->Free();
 
@@ -46,8 +46,28 @@ namespace Isochart
 
         // all internal geodesic distance computation tries to use the new approach implemented in geodesicdist.lib (except IMT is specified), this is precise but slower
         constexpr unsigned int GEODESIC_QUALITY = 0x02;
+
+        // each chart selects its geodesic distance algorithm from the estimated cost of the new approach on that chart,
+        // so the small charts of a large mesh still use it
+        constexpr unsigned int GEODESIC_ADAPTIVE = 0x20;
+
+        // large charts use the heat method [CWW13], factoring each chart once for all its landmarks (except IMT is specified),
+        // this is much faster than the new approach on large charts, but approximate. Small charts use the new approach
+        constexpr unsigned int GEODESIC_HEAT = 0x40;
+
+        // charts of at least _LIMIT_FACENUM_USENEWGEODIST faces use the new approach on a simplified level of the chart,
+        // then correct the distances on the chart with [KS98] (except IMT is specified). Small charts use the new approach
+        constexpr unsigned int GEODESIC_COARSE = 0x80;
+
+        // preconditioner of the conjugate gradient solves of the barycentric and LSCM parameterizations,
+        // without any of them the default one of lscmparam.cpp is used
+        constexpr unsigned int CG_UNPRECONDITIONED = 0x100;
+        constexpr unsigned int CG_JACOBI = 0x200;
+        constexpr unsigned int CG_IC0 = 0x400;
+        constexpr unsigned int CG_SSOR = 0x800;
     };
-    constexpr unsigned int OPTIONMASK_ISOCHART_GEODESIC = ISOCHARTOPTION::GEODESIC_FAST | ISOCHARTOPTION::GEODESIC_QUALITY;
+    constexpr unsigned int OPTIONMASK_ISOCHART_GEODESIC = ISOCHARTOPTION::GEODESIC_FAST | ISOCHARTOPTION::GEODESIC_QUALITY | ISOCHARTOPTION::GEODESIC_ADAPTIVE | ISOCHARTOPTION::GEODESIC_HEAT | ISOCHARTOPTION::GEODESIC_COARSE;
+    constexpr unsigned int OPTIONMASK_ISOCHART_CG_PRECONDITIONER = ISOCHARTOPTION::CG_UNPRECONDITIONED | ISOCHARTOPTION::CG_JACOBI | ISOCHARTOPTION::CG_IC0 | ISOCHARTOPTION::CG_SSOR;
 
     HRESULT
         isochart(
@@ -72,7 +92,10 @@ namespace Isochart
             // Callback parameters
             LPISOCHARTCALLBACK pCallback = nullptr,
             float Frequency = 0.01f, // Call callback function each time completed 1% work of all task
-            unsigned int dwOptions = ISOCHARTOPTION::DEFAULT);
+            unsigned int dwOptions = ISOCHARTOPTION::DEFAULT,
+            const DirectX::UVAtlasExecutor *pExecutor = nullptr,
+            DirectX::UVAtlasStats *pStats = nullptr,
+            const DirectX::UVAtlasCancellation *pCancellation = nullptr);
 
     HRESULT
         isochartpartition(
@@ -102,7 +125,10 @@ namespace Isochart
                                                             // CAN be splitted, set the that ajacency to -1.
                                                             // Usually, it's easier for user to specified the edge that CAN NOT be
                                                             // splitted, make sure to validate the input
-            _In_ unsigned int dwOptions = ISOCHARTOPTION::DEFAULT);
+            _In_ unsigned int dwOptions = ISOCHARTOPTION::DEFAULT,
+            _In_opt_ const DirectX::UVAtlasExecutor *pExecutor = nullptr,
+            _Inout_opt_ DirectX::UVAtlasStats *pStats = nullptr,
+            _In_opt_ const DirectX::UVAtlasCancellation *pCancellation = nullptr);
 
         // Class IIsochartEngine for the advanced usage
         // Use CreateIsochartEngine() & ReleaseIsochartEngine to create/release
@@ -154,6 +180,18 @@ namespace Isochart
             unsigned int TotalStageCount,
             unsigned int DoneStageCount) noexcept = 0;
 
+        virtual HRESULT SetExecutor(
+            const DirectX::UVAtlasExecutor *pExecutor) noexcept = 0;
+
+        // The engine keeps pCancellation, which must outlive the calls made to
+        // the engine.
+        virtual HRESULT SetCancellation(
+            const DirectX::UVAtlasCancellation *pCancellation) noexcept = 0;
+
+        // Adds the stage times and counters of the engine to pStatsOut.
+        virtual HRESULT ExportStats(
+            DirectX::UVAtlasStats *pStatsOut) noexcept = 0;
+
         virtual HRESULT ExportPartitionResult(
             std::vector<DirectX::UVAtlasVertex> *pvVertexArrayOut,
             std::vector<uint8_t> *pvFaceIndexArrayOut,
@@ -0,0 +1,86 @@
+//-------------------------------------------------------------------------------------
+// UVAtlas - isochartcancel.h
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "UVAtlas.h"
+
+namespace Isochart
+{
+    // CIsochartCancel checks the UVAtlasCancellation of a call. It only keeps a
+    // pointer to the caller's token, so it is cheap to copy, and Check() may be
+    // called from any thread.
+    class CIsochartCancel
+    {
+    public:
+        CIsochartCancel() noexcept : m_pCancellation(nullptr) {}
+
+        explicit CIsochartCancel(const DirectX::UVAtlasCancellation *pCancellation) noexcept :
+            m_pCancellation(pCancellation)
+        {}
+
+        // Returns E_ABORT when the call was cancelled, and HRESULT_E_TIMEOUT
+        // when the deadline passed. In best effort mode the deadline does not
+        // stop the call, see IsOutOfTime().
+        HRESULT Check() const noexcept;
+
+        bool IsStopped() const noexcept
+        {
+            return FAILED(Check());
+        }
+
+        // Returns a function for the loops which only take a stop predicate.
+        // It refers to this object, which must outlive it.
+        std::function<bool()> GetStopCheck() const
+        {
+            return [this]() { return IsStopped(); };
+        }
+
+        // Returns true when the deadline of a best effort call passed. The
+        // partition then stops refining the charts and takes its fast paths.
+        bool IsOutOfTime() const noexcept;
+
+    private:
+        bool IsDeadlinePassed() const noexcept;
+
+        const DirectX::UVAtlasCancellation *m_pCancellation;
+    };
+
+    inline bool CIsochartCancel::IsDeadlinePassed() const noexcept
+    {
+        return m_pCancellation->deadline != std::chrono::steady_clock::time_point{}
+            && std::chrono::steady_clock::now() >= m_pCancellation->deadline;
+    }
+
+    inline HRESULT CIsochartCancel::Check() const noexcept
+    {
+        if (!m_pCancellation)
+        {
+            return S_OK;
+        }
+
+        if (m_pCancellation->cancel.load(std::memory_order_relaxed))
+        {
+            return E_ABORT;
+        }
+
+        if (!m_pCancellation->bestEffort && IsDeadlinePassed())
+        {
+            return HRESULT_E_TIMEOUT;
+        }
+        return S_OK;
+    }
+
+    inline bool CIsochartCancel::IsOutOfTime() const noexcept
+    {
+        return m_pCancellation
+            && m_pCancellation->bestEffort
+            && IsDeadlinePassed();
+    }
+}
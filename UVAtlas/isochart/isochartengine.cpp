@@ -11,10 +11,17 @@
 #include "isochartengine.h"
 #include "isochart.h"
 #include "isochartmesh.h"
+#include "taskscheduler.h"
 
 using namespace DirectX;
 using namespace Isochart;
 
+namespace
+{
+    // Base seed of the charts' random engines with UVATLAS_DETERMINISTIC.
+    constexpr uint64_t DETERMINISTIC_RANDOM_SEED = 0x5bd1e9955bd1e995ull;
+}
+
 // Create instance of the class which implements the IIsochartEngine interface
 IIsochartEngine *IIsochartEngine::CreateIsochartEngine()
 {
@@ -40,10 +47,11 @@ m_state(ISOCHART_ST_UNINITILAIZED),
 #ifdef _WIN32
 m_hMutex(nullptr),
 #endif
-m_dwOptions(ISOCHARTOPTION::DEFAULT)
+m_dwOptions(ISOCHARTOPTION::DEFAULT),
+m_executor{ 0, nullptr }
 {
     std::random_device randomDevice;
-    m_randomEngine.seed(randomDevice());
+    m_randomSeed = (uint64_t(randomDevice()) << 32) | randomDevice();
 }
 
 CIsochartEngine::~CIsochartEngine()
@@ -117,6 +125,10 @@ HRESULT CIsochartEngine::Initialize(
     }
 
     m_dwOptions = dwOptions;
+    if (m_dwOptions & UVATLAS_DETERMINISTIC)
+    {
+        m_randomSeed = DETERMINISTIC_RANDOM_SEED;
+    }
 
     HRESULT hr = S_OK;
 
@@ -133,28 +145,37 @@ HRESULT CIsochartEngine::Initialize(
     }
 
     // 3. If engine is already initialized, return error code
+    m_stats.Reset();
 
     // 4. Prepare global basic information table.
-    if (FAILED(hr = InitializeBaseInfo(
-        pVertexArray,
-        VertexCount,
-        VertexStride,
-        IndexFormat,
-        pFaceIndexArray,
-        FaceCount,
-        pIMTArray,
-        pOriginalAjacency,
-        pSplitHint)))
+    {
+        CStatsTimer timer(m_stats.initTime);
+        hr = InitializeBaseInfo(
+            pVertexArray,
+            VertexCount,
+            VertexStride,
+            IndexFormat,
+            pFaceIndexArray,
+            FaceCount,
+            pIMTArray,
+            pOriginalAjacency,
+            pSplitHint);
+    }
+    if (FAILED(hr))
     {
         goto LEnd;
     }
 
     // 5. Internal initialization. Prepare the initial charts to be partitioned.
-    if (FAILED(hr = ApplyInitEngine(
-        m_baseInfo,
-        IndexFormat,
-        pFaceIndexArray,
-        true)))
+    {
+        CStatsTimer timer(m_stats.rootChartTime);
+        hr = ApplyInitEngine(
+            m_baseInfo,
+            IndexFormat,
+            pFaceIndexArray,
+            true);
+    }
+    if (FAILED(hr))
     {
         goto LEnd;
     }
@@ -281,92 +302,73 @@ HRESULT CIsochartEngine::InitializeCurrentChartHeap()
     return S_OK;
 }
 
-#ifdef _OPENMP
-#ifdef _MSC_VER
-#pragma warning(disable : 6993)
-#endif
-HRESULT CIsochartEngine::ParameterizeChartsInHeapParallelized(
+HRESULT CIsochartEngine::ParameterizeChartsInHeap(
     bool bFirstTime,
     size_t MaxChartNumber)
 {
     // 3.1 If Any charts needed to be partitioned
 
     /// Parallelization:
-    /// 1st Move heap to vector `parent`
-    /// 2nd run through parent in parallel, add children to `children`
-    /// 3rd children = parent, goto 2nd
-    std::vector<CIsochartMesh *> parent;
-    while (!m_currentChartHeap.empty())
-        parent.emplace_back(m_currentChartHeap.cutTopData());
-
-    HRESULT hrOut = S_OK;
-    while (!parent.empty() && !FAILED(hrOut))
+    /// Each chart is a task of the work-stealing scheduler. Partitioning a
+    /// chart spawns its children as new tasks on the same worker, so a large
+    /// sub-tree keeps all workers busy without waiting for the other charts of
+    /// the same level to finish.
+    CTaskScheduler scheduler(&m_executor);
+    std::mutex chartLock;
+
+    // The tasks call the callback schemer from all workers, it only reports
+    // from this thread.
+    HRESULT hr = m_callbackSchemer.BeginParallelWork(scheduler.GetWorkerCount());
+    if (FAILED(hr))
+        return hr;
+    if (m_callbackSchemer.IsParallelWork())
     {
-        std::vector<CIsochartMesh *> children;
-    #pragma omp parallel
-        {
-
-            std::vector<CIsochartMesh *> children_thrd;
-        #pragma omp for
-            for (int n = 0; n < static_cast<int>(parent.size()); ++n)
+        scheduler.SetIdlePoll([this](size_t)
             {
-                if (FAILED(hrOut)) // for the other threads
-                    continue;
-
-                auto pChart = parent[static_cast<size_t>(n)];
-                assert(pChart != nullptr);
-                _Analysis_assume_(pChart != nullptr);
-
-                // Process current chart, if it's needed to be partitioned again,
-                // Just partition it.
-                HRESULT hr = pChart->Partition(); /// Adds children to pChart->m_children						// hotspot
-                if (FAILED(hr))
-                {
-                    hrOut = hr; // doesn't need pragma atomic as all changes to hrOut are to set it to FAILED
-                    continue;
-                }
-
-                // If current chart has been partitoned, just children add to heap to be
-                // processed later.
-                if (pChart->HasChildren())
-                {
-                    /// Add children to children vector to be ran in the following parallelization run
-                    for (size_t i = 0; i < pChart->GetChildrenCount(); i++)
-                    {
-                        CIsochartMesh *pChild = pChart->GetChild(i);
-                        assert(pChild != nullptr);
+                return m_callbackSchemer.PollParallelWork();
+            }, PARALLEL_CALLBACK_INTERVAL);
+    }
 
-                        if (pChild->GetVertexNumber() == 4 && (pChild->GetVertexBuffer()[0]).dwIDInRootMesh == 228)
-                        {
-                            DPF(3, "hello...");
-                        }
+    while (!m_currentChartHeap.empty())
+    {
+        CIsochartMesh *pChart = m_currentChartHeap.cutTopData();
+        assert(pChart != nullptr);
+        _Analysis_assume_(pChart != nullptr);
 
-                        children_thrd.emplace_back(pChild);
-                    }
-                    pChart->UnlinkAllChildren();
-                    if (!pChart->IsInitChart())
-                        delete pChart;
-                }
-                else // A right parameterization (with acceptable face overturn) has been gotten, add current chart to final Chart List
-                {
-                    try
-                    {
-                    #pragma omp critical
-                        m_finalChartList.push_back(pChart);
-                    }
-                    catch (std::bad_alloc &)
-                    {
-                        hrOut = E_OUTOFMEMORY;
-                    }
-                }
-            }
-        #pragma omp critical
+        hr = scheduler.Spawn(0, [this, &scheduler, &chartLock, pChart, bFirstTime](size_t dwWorker)
             {
-                children.insert(children.end(), children_thrd.begin(), children_thrd.end());
-                // std::move(children_thrd.begin(), children_thrd.end(), std::back_inserter(children)); // Might be faster if the objects in vector have move constructor. Needs testing
+                return ParameterizeChartTask(scheduler, chartLock, pChart, bFirstTime, dwWorker);
+            });
+        if (FAILED(hr))
+        {
+            std::lock_guard<std::mutex> lock(chartLock);
+            if (!m_currentChartHeap.insertData(pChart, 0) && !pChart->IsInitChart())
+            {
+                delete pChart;
             }
+            break;
         }
-        parent = children;
+    }
+
+    // Tasks already spawned must run, even after a failure, to release their
+    // charts.
+    HRESULT hrRun = scheduler.Run();
+    HRESULT hrCallback = m_callbackSchemer.EndParallelWork();
+    if (FAILED(hr))
+        return hr;
+    if (FAILED(hrRun))
+        return hrRun;
+    if (FAILED(hrCallback))
+        return hrCallback;
+
+    // The charts were added in the order the tasks finished. The next steps
+    // depend on this order, so sort them by chart ID to get the same result
+    // with any thread count.
+    if (m_dwOptions & UVATLAS_DETERMINISTIC)
+    {
+        hr = SortFinalCharts();
+        if (FAILED(hr))
+            return hr;
     }
 
     // 3.2 Update status
@@ -394,93 +396,140 @@ HRESULT CIsochartEngine::ParameterizeChartsInHeapParallelized(
     return S_OK;
 }
 
-#else
+HRESULT CIsochartEngine::SortFinalCharts()
+{
+    std::vector<std::pair<uint32_t, CIsochartMesh *>> sortedCharts;
+    try
+    {
+        sortedCharts.reserve(m_finalChartList.size());
+    }
+    catch (std::bad_alloc &)
+    {
+        return E_OUTOFMEMORY;
+    }
 
-HRESULT CIsochartEngine::ParameterizeChartsInHeap(
+    for (CIsochartMesh *pChart : m_finalChartList)
+    {
+        sortedCharts.emplace_back(pChart->GetChartID(), pChart);
+    }
+    std::sort(sortedCharts.begin(), sortedCharts.end(),
+        [](const std::pair<uint32_t, CIsochartMesh *> &a, const std::pair<uint32_t, CIsochartMesh *> &b)
+        {
+            return a.first < b.first;
+        });
+
+    for (size_t i = 0; i < sortedCharts.size(); i++)
+    {
+        m_finalChartList[i] = sortedCharts[i].second;
+    }
+    return S_OK;
+}
+
+// Mixes the chart ID into the base seed with the SplitMix64 finalizer, so close
+// IDs give unrelated streams.
+uint64_t CIsochartEngine::GetChartRandomSeed(uint32_t dwChartID) const
+{
+    uint64_t z = m_randomSeed + (uint64_t(dwChartID) + 1) * 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+HRESULT CIsochartEngine::ParameterizeChartTask(
+    CTaskScheduler &scheduler,
+    std::mutex &chartLock,
+    CIsochartMesh *pChart,
     bool bFirstTime,
-    size_t MaxChartNumber)
+    size_t dwWorker)
 {
-    // 3.1 If Any charts needed to be partitioned
-    while (!m_currentChartHeap.empty())
-    {
-        DPF(1, "Processed charts number is : %zu", m_finalChartList.size() + m_currentChartHeap.size());
-        auto pChart = m_currentChartHeap.cutTopData();
-        assert(pChart != nullptr);
-        _Analysis_assume_(pChart != nullptr);
+    assert(pChart != nullptr);
 
+    // Another task failed, give the chart back to the heap to be released
+    // with the others.
+    HRESULT hr = S_OK;
+    if (!scheduler.IsFailed())
+    {
         // Process current chart, if it's needed to be partitioned again,
         // Just partition it.
-        HRESULT hr = pChart->Partition();
-        if (FAILED(hr))
+        hr = m_cancel.Check();
+        if (SUCCEEDED(hr))
         {
-            return hr;
+            hr = pChart->Partition();
         }
-
-        // If current chart has been partitoned, just children add to heap to be
-        // processed later.
-        if (pChart->HasChildren())
+    }
+    if (scheduler.IsFailed() || FAILED(hr))
+    {
+        std::lock_guard<std::mutex> lock(chartLock);
+        if (!m_currentChartHeap.insertData(pChart, 0))
         {
-            if (FAILED(hr = AddChildrenToCurrentChartHeap(pChart)))
+            if (!pChart->IsInitChart())
             {
                 delete pChart;
-                return hr;
             }
-            else
+            return E_OUTOFMEMORY;
+        }
+        return hr;
+    }
+
+    // If current chart has been partitoned, spawn a task for each child.
+    if (pChart->HasChildren())
+    {
+        for (size_t i = 0; i < pChart->GetChildrenCount(); i++)
+        {
+            CIsochartMesh *pChild = pChart->GetChild(i);
+            assert(pChild != nullptr);
+
+            hr = scheduler.Spawn(dwWorker, [this, &scheduler, &chartLock, pChild, bFirstTime](size_t dwChildWorker)
+                {
+                    return ParameterizeChartTask(scheduler, chartLock, pChild, bFirstTime, dwChildWorker);
+                });
+            if (FAILED(hr))
             {
+                // Children not spawned yet are released with the parent.
+                for (size_t j = 0; j < i; j++)
+                {
+                    pChart->UnlinkChild(j);
+                }
                 if (!pChart->IsInitChart())
                 {
                     delete pChart;
                 }
+                return hr;
             }
         }
-
-        // If A right parameterization (with acceptable face overturn)
-        // has been gotten, add current chart to final Chart List.
-        else
+        pChart->UnlinkAllChildren();
+        if (!pChart->IsInitChart())
         {
-            try
-            {
-                m_finalChartList.push_back(pChart);
-            }
-            catch (std::bad_alloc &)
-            {
-                delete pChart;
-                return E_OUTOFMEMORY;
-            }
-
-            if (bFirstTime)
-            {
-                if (FAILED(hr = m_callbackSchemer.UpdateCallbackAdapt(pChart->GetFaceNumber())))
-                    return hr;
-            }
+            delete pChart;
         }
     }
 
-    // 3.2 Update status
-    if (bFirstTime)
+    // If A right parameterization (with acceptable face overturn)
+    // has been gotten, add current chart to final Chart List.
+    else
     {
-        HRESULT hr = m_callbackSchemer.FinishWorkAdapt();
-        if (FAILED(hr))
-            return hr;
-
-        if (dwExpectChartCount > 0)
+        std::lock_guard<std::mutex> lock(chartLock);
+        try
         {
-            size_t dwStep = 0;
-            if (MaxChartNumber > m_currentChartHeap.size())
+            m_finalChartList.push_back(pChart);
+        }
+        catch (std::bad_alloc &)
+        {
+            if (!m_currentChartHeap.insertData(pChart, 0) && !pChart->IsInitChart())
             {
-                dwStep = MaxChartNumber - m_currentChartHeap.size();
+                delete pChart;
             }
-            m_callbackSchemer.InitCallBackAdapt(dwStep, 0.70f, 0.40f);
+            return E_OUTOFMEMORY;
         }
-        else
+
+        if (bFirstTime)
         {
-            m_callbackSchemer.InitCallBackAdapt(1, 0.40f, 0.40f);
+            m_callbackSchemer.AddParallelWork(dwWorker, pChart->GetFaceNumber());
         }
     }
-
-    return S_OK;
+    return m_callbackSchemer.PollParallelWork();
 }
-#endif
+
 
 HRESULT CIsochartEngine::GenerateNewChartsToParameterize()
 {
@@ -554,7 +603,8 @@ HRESULT CIsochartEngine::OptimizeParameterizedCharts(
         FAILURE_RETURN(
             CIsochartMesh::OptimizeAllL2SquaredStretch(
                 m_finalChartList,
-                true));
+                true,
+                &m_executor));
 
         // computer geometric stretch after optimize signal stretch
         CIsochartMesh::ComputeGeoAvgL2Stretch(
@@ -666,24 +716,28 @@ HRESULT CIsochartEngine::PartitionByGlobalAvgL2Stretch(
     do
     {
         // 3.1. Generate initial parameterization for charts in current chart heap
-    #ifdef _OPENMP
-        hr = ParameterizeChartsInHeapParallelized(bCountParition, MaxChartNumber);
-    #else
-        hr = ParameterizeChartsInHeap(bCountParition, MaxChartNumber);
-    #endif
+        {
+            CStatsTimer timer(m_stats.partitionTime);
+            hr = ParameterizeChartsInHeap(bCountParition, MaxChartNumber);
+        }
         if (FAILED(hr))
             return hr;
 
         bCountParition = false;
+        m_stats.UpdatePeakChartCount(m_finalChartList.size());
 
         DPF(1, "Current charts number is : %zu", m_finalChartList.size());
 
         // 3.2 Optimize all charts with right parameterization
         // chart 2d area will be compted in this function
-        FAILURE_RETURN(
-            CIsochartMesh::OptimizeAllL2SquaredStretch(
+        {
+            CStatsTimer timer(m_stats.optimizeStretchTime);
+            hr = CIsochartMesh::OptimizeAllL2SquaredStretch(
                 m_finalChartList,
-                false));
+                false,
+                &m_executor);
+        }
+        FAILURE_RETURN(hr);
 
         // 3.3
         // For geometric case, get current optical average L^2 Squared Stretch
@@ -712,18 +766,28 @@ HRESULT CIsochartEngine::PartitionByGlobalAvgL2Stretch(
             bHasSatisfiedNumber = true;
         }
 
-        // 3.6 If we don't reach the expected stretch criteria,
+        // 3.6 Every chart has a parameterization here. In best effort mode,
+        // stop refining them once the deadline passed.
+        FAILURE_RETURN(m_cancel.Check());
+        if (m_cancel.IsOutOfTime())
+        {
+            DPF(0, "Deadline passed, keep %zu charts", m_finalChartList.size());
+            break;
+        }
+
+        // 3.7 If we don't reach the expected stretch criteria,
         // Selete a canidate to parition and parameterize the children.
         if (!CIsochartMesh::IsReachExpectedTotalAvgL2SqrStretch(
             fCurrAvgL2SquaredStretch,
             fExpectAvgL2SquaredStretch) ||
             m_finalChartList.size() < dwExpectChartCount)
         {
+            CStatsTimer timer(m_stats.partitionTime);
             FAILURE_RETURN(
                 GenerateNewChartsToParameterize());
         }
 
-        // 3.7 Update status
+        // 3.8 Update status
         if (dwExpectChartCount > 0)
         {
             size_t dwCurrentChartNumber(m_finalChartList.size() + m_currentChartHeap.size());
@@ -742,19 +806,22 @@ HRESULT CIsochartEngine::PartitionByGlobalAvgL2Stretch(
     if (FAILED(hr))
         return hr;
 
-    // 4. MergeChart
-    if (m_finalChartList.size() > dwExpectChartCount)
+    // 4. MergeChart, unless the deadline of a best effort call passed.
+    if (m_finalChartList.size() > dwExpectChartCount && !m_cancel.IsOutOfTime())
     {
         DPF(0, "Charts before merge %zu", m_finalChartList.size());
         dwLastChartNumber = m_finalChartList.size();
         m_callbackSchemer.InitCallBackAdapt((2 + m_finalChartList.size()), 0.20f, 0.80f);
 
-        if (FAILED(
+        {
+            CStatsTimer timer(m_stats.mergeTime);
             hr = CIsochartMesh::MergeSmallCharts(
                 m_finalChartList,
                 dwExpectChartCount,
                 m_baseInfo,
-                m_callbackSchemer)))
+                m_callbackSchemer);
+        }
+        if (FAILED(hr))
         {
             return hr;
         }
@@ -766,8 +833,11 @@ HRESULT CIsochartEngine::PartitionByGlobalAvgL2Stretch(
     }
 
     // 5. Optimize parameterized charts.
-    FAILURE_RETURN(
-        OptimizeParameterizedCharts(Stretch, fCurrAvgL2SquaredStretch));
+    {
+        CStatsTimer timer(m_stats.optimizeStretchTime);
+        hr = OptimizeParameterizedCharts(Stretch, fCurrAvgL2SquaredStretch);
+    }
+    FAILURE_RETURN(hr);
 
     // 6. Export current partition result by set the attribute id of each face
     // in original mesh
@@ -1018,6 +1088,68 @@ HRESULT CIsochartEngine::SetStage(
     return hr;
 }
 
+HRESULT CIsochartEngine::SetExecutor(
+    const DirectX::UVAtlasExecutor *pExecutor) noexcept
+{
+    HRESULT hr = S_OK;
+
+    // 1. Try to enter exclusive section
+    if (FAILED(hr = TryEnterExclusiveSection()))
+    {
+        return hr;
+    }
+
+    try
+    {
+        if (pExecutor)
+        {
+            m_executor = *pExecutor;
+        }
+        else
+        {
+            m_executor = UVAtlasExecutor{ 0, nullptr };
+        }
+    }
+    catch (std::bad_alloc &)
+    {
+        hr = E_OUTOFMEMORY;
+    }
+
+    LeaveExclusiveSection();
+
+    return hr;
+}
+
+HRESULT CIsochartEngine::SetCancellation(
+    const DirectX::UVAtlasCancellation *pCancellation) noexcept
+{
+    HRESULT hr = S_OK;
+
+    // 1. Try to enter exclusive section
+    if (FAILED(hr = TryEnterExclusiveSection()))
+    {
+        return hr;
+    }
+
+    m_cancel = CIsochartCancel(pCancellation);
+
+    LeaveExclusiveSection();
+
+    return hr;
+}
+
+HRESULT CIsochartEngine::ExportStats(
+    DirectX::UVAtlasStats *pStatsOut) noexcept
+{
+    if (!pStatsOut)
+    {
+        return E_INVALIDARG;
+    }
+
+    m_stats.Export(*pStatsOut);
+    return S_OK;
+}
+
 HRESULT CIsochartEngine::ExportPartitionResult(
     std::vector<UVAtlasVertex> *pvVertexArrayOut,
     std::vector<uint8_t> *pvFaceIndexArrayOut,
@@ -1257,6 +1389,11 @@ HRESULT CIsochartEngine::ApplyInitEngine(
     size_t dwTestFaceCount = 0;
     while (!m_currentChartHeap.empty())
     {
+        if (FAILED(hr = m_cancel.Check()))
+        {
+            return hr;
+        }
+
         CIsochartMesh *pChart = m_currentChartHeap.cutTopData();
         assert(pChart != nullptr);
         _Analysis_assume_(pChart != nullptr);
@@ -1827,7 +1964,14 @@ bool Isochart::CheckInitializeParameters(
     UNREFERENCED_PARAMETER(FaceCount);
     UNREFERENCED_PARAMETER(pIMTArray);
 
-    if ((dwOptions & ISOCHARTOPTION::GEODESIC_FAST) && (dwOptions & ISOCHARTOPTION::GEODESIC_QUALITY))
+    // At most one geodesic algorithm selection
+    const unsigned int dwGeodesicOptions = dwOptions & OPTIONMASK_ISOCHART_GEODESIC;
+    if (dwGeodesicOptions & (dwGeodesicOptions - 1))
+        return false;
+
+    // At most one preconditioner selection
+    const unsigned int dwPreconditionerOptions = dwOptions & OPTIONMASK_ISOCHART_CG_PRECONDITIONER;
+    if (dwPreconditionerOptions & (dwPreconditionerOptions - 1))
         return false;
 
     // 1. Vertex buffer
@@ -11,12 +11,15 @@
 
 #include "basemeshinfo.h"
 #include "callbackschemer.h"
+#include "isochartcancel.h"
+#include "isochartstats.h"
 #include "maxheap.hpp"
 
 namespace Isochart
 {
     class CCallbackSchemer;
     class CIsochartMesh;
+    class CTaskScheduler;
 
     class CIsochartEngine : public IIsochartEngine
     {
@@ -64,6 +67,15 @@ namespace Isochart
             unsigned int TotalStageCount,
             unsigned int DoneStageCount) noexcept override;
 
+        HRESULT SetExecutor(
+            const DirectX::UVAtlasExecutor *pExecutor) noexcept override;
+
+        HRESULT SetCancellation(
+            const DirectX::UVAtlasCancellation *pCancellation) noexcept override;
+
+        HRESULT ExportStats(
+            DirectX::UVAtlasStats *pStatsOut) noexcept override;
+
         HRESULT ExportPartitionResult(
             std::vector<DirectX::UVAtlasVertex> *pvVertexArrayOut,
             std::vector<uint8_t> *pvFaceIndexArrayOut,
@@ -80,11 +92,10 @@ namespace Isochart
 
         HRESULT CreateEngineMutex();
 
-        float UniformRand(float maxValue) const
-        {
-            std::uniform_real_distribution<float> dis(0.f, maxValue);
-            return dis(m_randomEngine);
-        }
+        // Charts are optimized concurrently, each one draws from its own
+        // random engine, seeded by the chart ID. So the draws of a chart don't
+        // depend on the other charts.
+        uint64_t GetChartRandomSeed(uint32_t dwChartID) const;
 
     private:
         enum EngineState
@@ -127,15 +138,16 @@ namespace Isochart
             size_t &ChartNumberOut,
             float &MaxChartStretchOut,
             uint32_t *pFaceAttributeIDOut);
-    #ifdef _OPENMP
-        HRESULT ParameterizeChartsInHeapParallelized(
-            bool bFirstTime,
-            size_t MaxChartNumber);
-    #else
         HRESULT ParameterizeChartsInHeap(
             bool bFirstTime,
             size_t MaxChartNumber);
-    #endif
+        HRESULT ParameterizeChartTask(
+            CTaskScheduler &scheduler,
+            std::mutex &chartLock,
+            CIsochartMesh *pChart,
+            bool bFirstTime,
+            size_t dwWorker);
+        HRESULT SortFinalCharts();
         HRESULT GenerateNewChartsToParameterize();
 
         HRESULT OptimizeParameterizedCharts(
@@ -253,7 +265,18 @@ namespace Isochart
 
         unsigned int m_dwOptions;
 
-        mutable std::mt19937_64 m_randomEngine;
+        // Threads used by the parallel stages.
+        DirectX::UVAtlasExecutor m_executor;
+
+        // Mixed with the chart IDs to seed the charts' random engines. It is
+        // fixed with UVATLAS_DETERMINISTIC.
+        uint64_t m_randomSeed;
+
+        // Stage times and counters, updated by the charts.
+        mutable CIsochartStats m_stats;
+
+        // Cancellation token and deadline of the call, checked by the charts.
+        CIsochartCancel m_cancel;
 
         friend CIsochartMesh;
     };
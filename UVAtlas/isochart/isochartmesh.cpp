@@ -101,10 +101,14 @@ CIsochartMesh::CIsochartMesh(
     m_dwEdgeNumber(0),
     m_pFather(nullptr),
     m_fBoxDiagLen(0),
+    m_bIsLandmarkSignalScaled(false),
+    m_fLandmarkSignalRatio(0),
     m_fParamStretchL2(0),
     m_fParamStretchLn(0),
     m_fBaseL2Stretch(0),
     m_fGeoL2Stretch(0),
+    m_bHeatGeodesicsFailed(false),
+    m_bCoarseGeodesicsFailed(false),
     m_bVertImportanceDone(false),
     m_bIsSubChart(false),
     m_bIsInitChart(false),
@@ -138,6 +142,7 @@ void CIsochartMesh::Free()
 
         DestroyPakingInfoBuffer();
     DeleteChildren();
+    ReleaseGeodesicCache();
 }
 
 /////////////////////////////////////////////////////////////
@@ -157,6 +162,16 @@ bool CIsochartMesh::HasBoundaryVertex() const
     return false;
 }
 
+uint32_t CIsochartMesh::GetChartID() const
+{
+    uint32_t dwChartID = UINT32_MAX;
+    for (size_t i = 0; i < m_dwFaceNumber; ++i)
+    {
+        dwChartID = std::min(dwChartID, m_pFaces[i].dwIDInRootMesh);
+    }
+    return dwChartID;
+}
+
 // Convert external stretch to the internal stretches
 // See more details in [SSGH01] page 2-3:
 void CIsochartMesh::ConvertToInternalCriterion(
@@ -820,6 +835,9 @@ HRESULT CIsochartMesh::Partition()
         pfVertMappingCoord);
 LEnd:
     m_isoMap.Clear();
+    ReleaseGeodesicCache();
+    m_pfLandmarkDistance.reset();
+    m_pfLandmarkCombineDistance.reset();
 
     if (!IsIMTSpecified())
     {
@@ -1012,6 +1030,7 @@ HRESULT CIsochartMesh::Bipartition3D()
 
     // assert(m_children.size() == 2);
 LEnd:
+    ReleaseGeodesicCache();
     if (!IsIMTSpecified())
     {
         assert(pfVertCombineDistance == pfVertGeoDistance);
@@ -1204,6 +1223,7 @@ HRESULT CIsochartMesh::IsomapParameterlization(
     float *pfVertMappingCoord = nullptr;
     size_t dwLandmarkNumber = 0;
     size_t dwCalculatedDimension = 0;
+    size_t dwBlockSize = 0;
 
     // 1. Calculate the landmark vertices
     if (FAILED(hr = CalculateLandmarkVertices(
@@ -1214,43 +1234,95 @@ HRESULT CIsochartMesh::IsomapParameterlization(
     }
 
     // 2. Calculate the geodesic distance matrix of landmark vertices
-    pfVertGeodesicDistance = new (std::nothrow) float[dwLandmarkNumber * m_dwVertNumber];
-
-    if (bIsSignalSpecialized)
-    {
-        pfVertCombinedDistance = new (std::nothrow) float[dwLandmarkNumber * m_dwVertNumber];
-    }
-    else
-    {
-        pfVertCombinedDistance = pfVertGeodesicDistance;
-    }
+    // When the distances from the landmarks to all vertices are too large to
+    // be kept, only the matrix is kept and the distances are returned as
+    // nullptr. The users then read the distances between landmarks from
+    // m_pfLandmarkDistance and compute the other ones again.
+    m_pfLandmarkDistance.reset();
+    m_pfLandmarkCombineDistance.reset();
+    dwBlockSize = GetLandmarkDistanceBlockSize(dwLandmarkNumber);
     pfGeodesicMatrix = new (std::nothrow) float[dwLandmarkNumber * dwLandmarkNumber];
-    if (!pfVertGeodesicDistance || !pfGeodesicMatrix || !pfVertCombinedDistance)
+    if (!pfGeodesicMatrix)
     {
         hr = E_OUTOFMEMORY;
         goto LEnd;
     }
 
-    if (FAILED(hr = CalculateGeodesicDistance(
-        m_landmarkVerts,
-        pfVertCombinedDistance,
-        pfVertGeodesicDistance)))
+    if (dwBlockSize < dwLandmarkNumber)
     {
-        goto LEnd;
+#if USING_COMBINED_DISTANCE_TO_PARAMETERIZE
+#error "The landmark distances are only streamed for the geodesic distance"
+#endif
+        m_pfLandmarkDistance.reset(new (std::nothrow) float[dwLandmarkNumber * dwLandmarkNumber]);
+        if (!m_pfLandmarkDistance)
+        {
+            hr = E_OUTOFMEMORY;
+            goto LEnd;
+        }
+
+        if (bIsSignalSpecialized)
+        {
+            m_pfLandmarkCombineDistance.reset(new (std::nothrow) float[dwLandmarkNumber * dwLandmarkNumber]);
+            if (!m_pfLandmarkCombineDistance)
+            {
+                hr = E_OUTOFMEMORY;
+                goto LEnd;
+            }
+        }
+
+        if (FAILED(hr = CalculateStreamedGeodesicMatrix(
+            dwBlockSize,
+            pfGeodesicMatrix,
+            m_pfLandmarkCombineDistance.get())))
+        {
+            goto LEnd;
+        }
+
+        // m_isoMap.Init takes over pfGeodesicMatrix
+        memcpy(
+            m_pfLandmarkDistance.get(),
+            pfGeodesicMatrix,
+            dwLandmarkNumber * dwLandmarkNumber * sizeof(float));
     }
+    else
+    {
+        pfVertGeodesicDistance = new (std::nothrow) float[dwLandmarkNumber * m_dwVertNumber];
 
-#if USING_COMBINED_DISTANCE_TO_PARAMETERIZE
-    CalculateGeodesicMatrix(
-        m_landmarkVerts,
-        pfVertCombinedDistance,
-        pfGeodesicMatrix);
+        if (bIsSignalSpecialized)
+        {
+            pfVertCombinedDistance = new (std::nothrow) float[dwLandmarkNumber * m_dwVertNumber];
+        }
+        else
+        {
+            pfVertCombinedDistance = pfVertGeodesicDistance;
+        }
+        if (!pfVertGeodesicDistance || !pfVertCombinedDistance)
+        {
+            hr = E_OUTOFMEMORY;
+            goto LEnd;
+        }
 
-#else
-    CalculateGeodesicMatrix(
-        m_landmarkVerts,
-        pfVertGeodesicDistance,
-        pfGeodesicMatrix);
-#endif
+        if (FAILED(hr = CalculateGeodesicDistance(
+            m_landmarkVerts,
+            pfVertCombinedDistance,
+            pfVertGeodesicDistance)))
+        {
+            goto LEnd;
+        }
+
+    #if USING_COMBINED_DISTANCE_TO_PARAMETERIZE
+        CalculateGeodesicMatrix(
+            m_landmarkVerts,
+            pfVertCombinedDistance,
+            pfGeodesicMatrix);
+
+    #else
+        CalculateGeodesicMatrix(
+            m_landmarkVerts,
+            pfVertGeodesicDistance,
+            pfGeodesicMatrix);
+    #endif
+    }
 
     // 4. Perform Isomap to do surface spectral analysis
     if (m_bIsSubChart)
@@ -1263,7 +1335,8 @@ HRESULT CIsochartMesh::IsomapParameterlization(
     }
     if (FAILED(hr = m_isoMap.Init(
         dwLandmarkNumber,
-        pfGeodesicMatrix)))
+        pfGeodesicMatrix,
+        &m_IsochartEngine.m_executor)))
     {
         goto LEnd;
     }
@@ -1346,6 +1419,8 @@ LEnd:
     SAFE_DELETE_ARRAY(pfGeodesicMatrix)
         if (FAILED(hr))
         {
+            m_pfLandmarkDistance.reset();
+            m_pfLandmarkCombineDistance.reset();
             SAFE_DELETE_ARRAY(pfVertGeodesicDistance)
                 if (bIsSignalSpecialized)
                 {
@@ -1377,8 +1452,9 @@ HRESULT CIsochartMesh::BuildFullConnection(bool &bIsManifold)
     assert(m_pVerts != nullptr);
     assert(m_pFaces != nullptr);
 
-    // 1. Clear old adjacence of each vertex.
+    // 1. Clear old adjacence of each vertex, and the operators built on it.
     ClearVerticesAdjacence();
+    ReleaseGeodesicCache();
 
     // 2. Find all edges, add vertex's adjacent faces and edges
     // if more than 2 faces share one edge, it's not a valid toplogy
@@ -3311,121 +3387,106 @@ CIsochartMesh *CIsochartMesh::SplitVertices(
 
 // Calculate the geodesic distance from all other vertices to the source vertice,
 // using dijkstra algorithm. using heap algorithm to get the min-distance at each
-// step.
+// step. With pBound, only the vertices within the bound are settled.
 HRESULT CIsochartMesh::CalculateDijkstraPathToVertex(
     uint32_t dwSourceVertID,
-    uint32_t *pdwFarestPeerVertID) const
+    uint32_t *pdwFarestPeerVertID,
+    const GEODESICQUERYBOUND *pBound) const
 {
-    uint32_t dwFarestPeerVertID = INVALID_VERT_ID;
+    m_IsochartEngine.m_stats.dwDijkstraRuns++;
 
-    std::unique_ptr<bool[]> vertProcessed(new (std::nothrow) bool[m_dwVertNumber]);
-    std::unique_ptr<CMaxHeapItem<float, uint32_t>[]> heapItem(new (std::nothrow) CMaxHeapItem<float, uint32_t>[m_dwVertNumber]);
-    if (!vertProcessed || !heapItem)
+    // The flat adjacency is kept with the geodesic caches of the chart, until
+    // its connectivity is rebuilt.
+    HRESULT hr = PrepareShortestPathTopology();
+    if (FAILED(hr))
     {
-        return E_OUTOFMEMORY;
+        return hr;
     }
 
-    bool *pbVertProcessed = vertProcessed.get();
-    memset(pbVertProcessed, 0, sizeof(bool) * m_dwVertNumber);
+    const uint32_t *pdwRowStart = m_pShortestPathTopology->rowStart.data();
+    const SHORTESTPATHNEIGHBOR *pNeighbors = m_pShortestPathTopology->neighbors.data();
 
-    auto pHeapItem = heapItem.get();
+    uint32_t dwFarestPeerVertID = INVALID_VERT_ID;
 
-    CMaxHeap<float, uint32_t> heap;
-    if (!heap.resize(m_dwVertNumber))
+    CGeodesicQueryTracker tracker;
+    if (FAILED(hr = tracker.Init(pBound, m_dwVertNumber)))
+    {
+        return hr;
+    }
+
+    std::unique_ptr<bool[]> vertProcessed(new (std::nothrow) bool[m_dwVertNumber]);
+    CMaxIndexHeap<float> heap;
+    if (!vertProcessed || !heap.resize(m_dwVertNumber))
     {
         return E_OUTOFMEMORY;
     }
 
+    bool *pbVertProcessed = vertProcessed.get();
+    memset(pbVertProcessed, 0, sizeof(bool) * m_dwVertNumber);
+
     // 1. Init the distance to souce of each vertice
-    ISOCHARTVERTEX *pCurrentVertex = m_pVerts;
     for (size_t i = 0; i < m_dwVertNumber; i++)
     {
-        pCurrentVertex->fGeodesicDistance = FLT_MAX;
-        pCurrentVertex->dwNextVertIDOnPath = INVALID_VERT_ID;
-        pCurrentVertex++;
+        m_pVerts[i].fGeodesicDistance = FLT_MAX;
+        m_pVerts[i].dwNextVertIDOnPath = INVALID_VERT_ID;
     }
 
     // 2. Init the source vertice
-    pCurrentVertex = m_pVerts + dwSourceVertID;
     pbVertProcessed[dwSourceVertID] = true;
-    pCurrentVertex->fGeodesicDistance = 0;
-
-    pHeapItem[dwSourceVertID].m_weight = -pCurrentVertex->fGeodesicDistance;
-    pHeapItem[dwSourceVertID].m_data = dwSourceVertID;
-    if (!heap.insert(pHeapItem + dwSourceVertID))
-    {
-        return E_OUTOFMEMORY;
-    }
+    m_pVerts[dwSourceVertID].fGeodesicDistance = 0;
+    heap.insert(dwSourceVertID, 0);
 
     // 3.  iteration of computing distance, from the one ring neighorhood to the outside
-
-    for (size_t i = 0; i < m_dwVertNumber; i++)
+    uint32_t dwCurrentID = 0;
+    while (heap.cutTop(dwCurrentID))
     {
-        CMaxHeapItem<float, uint32_t> *pTop = heap.cutTop();
-        if (!pTop)
+        ISOCHARTVERTEX *pCurrentVertex = m_pVerts + dwCurrentID;
+        if (tracker.IsBeyond(pCurrentVertex->fGeodesicDistance))
         {
             break;
         }
 
         // 3.1 Get vertices having min-distance to source
-        pCurrentVertex = m_pVerts + pTop->m_data;
-        assert(pCurrentVertex->dwID == pTop->m_data);
-        pbVertProcessed[pCurrentVertex->dwID] = true;
-        dwFarestPeerVertID = pCurrentVertex->dwID;
+        pbVertProcessed[dwCurrentID] = true;
+        dwFarestPeerVertID = dwCurrentID;
+        tracker.Settle(dwCurrentID, pCurrentVertex->fGeodesicDistance);
+
+        const SHORTESTPATHNEIGHBOR *pRowBegin = pNeighbors + pdwRowStart[dwCurrentID];
+        const SHORTESTPATHNEIGHBOR *pRowEnd = pNeighbors + pdwRowStart[dwCurrentID + 1];
 
         // 3.2 Computing the distance of the vertices adjacent to current vertices
-        for (size_t j = 0; j < pCurrentVertex->edgeAdjacent.size(); j++)
+        for (const SHORTESTPATHNEIGHBOR *pNeighbor = pRowBegin; pNeighbor < pRowEnd; pNeighbor++)
         {
-            uint32_t dwAdjacentVertID;
-
-            const ISOCHARTEDGE &edge = m_edges[pCurrentVertex->edgeAdjacent[j]];
-            if (edge.dwVertexID[0] == pCurrentVertex->dwID)
-            {
-                dwAdjacentVertID = edge.dwVertexID[1];
-            }
-            else
-            {
-                dwAdjacentVertID = edge.dwVertexID[0];
-            }
-
-            if (pbVertProcessed[dwAdjacentVertID])
+            if (pbVertProcessed[pNeighbor->dwVertID])
             {
                 continue;
             }
 
-            ISOCHARTVERTEX *pAdjacentVertex = m_pVerts + dwAdjacentVertID;
-            if (pAdjacentVertex->fGeodesicDistance > pCurrentVertex->fGeodesicDistance + edge.fLength)
+            ISOCHARTVERTEX *pAdjacentVertex = m_pVerts + pNeighbor->dwVertID;
+            if (pAdjacentVertex->fGeodesicDistance > pCurrentVertex->fGeodesicDistance + pNeighbor->fLength)
             {
-                pAdjacentVertex->fGeodesicDistance = pCurrentVertex->fGeodesicDistance + edge.fLength;
+                pAdjacentVertex->fGeodesicDistance = pCurrentVertex->fGeodesicDistance + pNeighbor->fLength;
 
-                pAdjacentVertex->dwNextVertIDOnPath = pCurrentVertex->dwID;
+                pAdjacentVertex->dwNextVertIDOnPath = dwCurrentID;
             }
         }
 
         // 3.3 prepare for next iteration
-        for (size_t j = 0; j < pCurrentVertex->vertAdjacent.size(); j++)
+        for (const SHORTESTPATHNEIGHBOR *pNeighbor = pRowBegin; pNeighbor < pRowEnd; pNeighbor++)
         {
-            uint32_t dwAdjacentVertID = pCurrentVertex->vertAdjacent[j];
+            uint32_t dwAdjacentVertID = pNeighbor->dwVertID;
             if (pbVertProcessed[dwAdjacentVertID])
             {
                 continue;
             }
 
-            ISOCHARTVERTEX *pAdjacentVertex = m_pVerts + dwAdjacentVertID;
-
-            if (pHeapItem[dwAdjacentVertID].isItemInHeap())
+            if (heap.isItemInHeap(dwAdjacentVertID))
             {
-                heap.update(pHeapItem + dwAdjacentVertID,
-                    -pAdjacentVertex->fGeodesicDistance);
+                heap.update(dwAdjacentVertID, -m_pVerts[dwAdjacentVertID].fGeodesicDistance);
             }
             else
             {
-                pHeapItem[dwAdjacentVertID].m_data = dwAdjacentVertID;
-                pHeapItem[dwAdjacentVertID].m_weight = -pAdjacentVertex->fGeodesicDistance;
-                if (!heap.insert(pHeapItem + dwAdjacentVertID))
-                {
-                    return E_OUTOFMEMORY;
-                }
+                heap.insert(dwAdjacentVertID, -m_pVerts[dwAdjacentVertID].fGeodesicDistance);
             }
         }
     }
@@ -19,6 +19,7 @@
 
 #include "ExactOneToAll.h"
 #include "ApproximateOneToAll.h"
+#include "HeatGeodesics.h"
 
 namespace Isochart
 {
@@ -81,7 +82,6 @@ namespace Isochart
         int nImportanceOrder;    // Important order of this vertex
         float fGeodesicDistance; // Using in Computing distance from this vertex to specified sourc
         float fDijikstraDistance;
-        float fSignalDistance; // Signal distance
 
         std::vector<uint32_t> vertAdjacent; // ID of vertices having edge between this vertex
         std::vector<uint32_t> faceAdjacent; // ID of faces using this vertex
@@ -116,6 +116,102 @@ namespace Isochart
     };
     typedef std::vector<ISOCHARTEDGE *> EDGE_ARRAY;
 
+    // define the macro to use the exact algorithm, otherwise the fast approximate algorithm is employed
+#ifdef _USE_EXACT_ALGORITHM
+    typedef GeodesicDist::CExactOneToAll ONETOALLENGINE;
+#else
+    typedef GeodesicDist::CApproximateOneToAll ONETOALLENGINE;
+#endif
+
+    // Algorithm computing the geodesic distances from one source vertex, chosen
+    // once per chart and query by CIsochartMesh::SelectGeodesicBackend().
+    enum GEODESICBACKEND
+    {
+        GEODESIC_BACKEND_KS98,  // [KS98] fast marching, supports signal distances
+        GEODESIC_BACKEND_EXACT, // Window propagation of ONETOALLENGINE
+        GEODESIC_BACKEND_HEAT,  // [CWW13] heat method, on the factorization cached by the chart
+        GEODESIC_BACKEND_COARSE // ONETOALLENGINE on the simplified chart cached by the chart, corrected by [KS98]
+    };
+
+    // Simplified level of a chart for GEODESIC_BACKEND_COARSE. Its vertices are
+    // a subset of the chart vertices, at the same positions.
+    struct COARSEGEODESICLEVEL
+    {
+        std::vector<uint32_t> coarseVerts;  // the chart vertex of each coarse vertex
+        std::vector<uint32_t> fineToCoarse; // the coarse vertex of each chart vertex, INVALID_VERT_ID if collapsed
+        GeodesicDist::MeshTopology topology;
+    };
+
+    // One neighbor of a vertex in SHORTESTPATHTOPOLOGY, with the edge fields
+    // the shortest path queries read.
+    struct SHORTESTPATHNEIGHBOR
+    {
+        uint32_t dwVertID;
+        float fLength;
+        uint32_t dwOppositVertID[2]; // of the edge, the second one is INVALID_VERT_ID on boundaries
+        uint32_t dwEdgeID;
+    };
+
+    // Adjacency of the chart vertices in flat arrays for the [KS98] and
+    // Dijkstra queries. The neighbors of vertex i are
+    // neighbors[rowStart[i]] .. neighbors[rowStart[i + 1] - 1], in the order
+    // of its vertAdjacent list, see PrepareShortestPathTopology.
+    struct SHORTESTPATHTOPOLOGY
+    {
+        std::vector<uint32_t> rowStart;
+        std::vector<SHORTESTPATHNEIGHBOR> neighbors;
+    };
+
+    // Scratch of one worker computing geodesic distances to landmarks.
+    struct GEODESICWORKSPACE
+    {
+        std::unique_ptr<ONETOALLENGINE> pOneToAllEngine;    // Built on first use
+        std::unique_ptr<ONETOALLENGINE> pCoarseEngine;      // On the coarse level, built on first use
+        std::unique_ptr<float[]> pfSignalDistance;       // Signal distances which are not kept
+        GeodesicDist::CHeatGeodesics::Workspace heat;
+    };
+
+    // Bound of a geodesic query which only needs the distances near its source
+    // or at some vertices. The vertices are settled by increasing distance, and
+    // the query stops before the first one farther than fMaxDistance, or than
+    // the dwTargetCount-th of the targets settled. The distances of the
+    // vertices left are incomplete. The heat method always solves the whole
+    // chart.
+    struct GEODESICQUERYBOUND
+    {
+        float fMaxDistance;             // FLT_MAX for no limit
+        const uint32_t *pdwTargetVerts; // the targets, nullptr when there are none
+        size_t dwTargetVertNumber;
+        size_t dwTargetCount;           // 0 to ignore the targets
+    };
+
+    // Applies a GEODESICQUERYBOUND to a Dijkstra-like query, no bound when
+    // Init() is given nullptr
+    class CGeodesicQueryTracker
+    {
+    public:
+        CGeodesicQueryTracker() noexcept : m_fMaxDistance(FLT_MAX), m_dwTargetsLeft(0) {}
+
+        HRESULT Init(const GEODESICQUERYBOUND *pBound, size_t dwVertNumber);
+
+        // whether a vertex at fDistance needs not be settled
+        bool IsBeyond(float fDistance) const noexcept { return fDistance > m_fMaxDistance; }
+
+        // once the targets are settled, the query stops past their distance
+        void Settle(uint32_t dwVertID, float fDistance) noexcept
+        {
+            if (m_dwTargetsLeft > 0 && m_isTarget[dwVertID] && --m_dwTargetsLeft == 0)
+            {
+                m_fMaxDistance = std::min(m_fMaxDistance, fDistance);
+            }
+        }
+
+    private:
+        float m_fMaxDistance;
+        size_t m_dwTargetsLeft;
+        std::unique_ptr<bool[]> m_isTarget;
+    };
+
     class CCallbackSchemer;
     class CIsoMap;
 
@@ -169,7 +265,8 @@ namespace Isochart
 
         static HRESULT OptimizeAllL2SquaredStretch(
             ISOCHARTMESH_ARRAY &chartList,
-            bool bOptimizeSignal);
+            bool bOptimizeSignal,
+            const DirectX::UVAtlasExecutor *pExecutor);
 
         static HRESULT OptimalScaleChart(
             ISOCHARTMESH_ARRAY &chartList,
@@ -239,19 +336,24 @@ namespace Isochart
         bool IsIMTSpecified() const { return m_baseInfo.pfIMTArray != nullptr; }
         bool HasBoundaryVertex() const;
 
+        // The smallest root ID of the chart faces. The charts of a partition
+        // don't share faces, so their IDs are different.
+        uint32_t GetChartID() const;
+
         /////////////////////////////////////////////////////////////
         //////////////Basic Data Member Access Methods///////////////
         /////////////////////////////////////////////////////////////
-        size_t GetVertexNumber() { return m_dwVertNumber; }
+        size_t GetVertexNumber() const { return m_dwVertNumber; }
         ISOCHARTVERTEX *GetVertexBuffer() const { return m_pVerts; }
 
-        size_t GetFaceNumber() { return m_dwFaceNumber; }
+        size_t GetFaceNumber() const { return m_dwFaceNumber; }
         ISOCHARTFACE *GetFaceBuffer() const { return m_pFaces; }
 
-        size_t GetEdgeNumber() { return m_dwEdgeNumber; }
+        size_t GetEdgeNumber() const { return m_dwEdgeNumber; }
         std::vector<ISOCHARTEDGE> &GetEdgesList() { return m_edges; }
+        const std::vector<ISOCHARTEDGE> &GetEdgesList() const { return m_edges; }
 
-        float GetBoxDiagLen() { return m_fBoxDiagLen; }
+        float GetBoxDiagLen() const { return m_fBoxDiagLen; }
         std::vector<uint32_t> &GetAdjacentChartList() { return m_adjacentChart; }
 
         void SetInitChart() { m_bIsInitChart = true; }
@@ -473,7 +575,8 @@ namespace Isochart
 
         HRESULT CalculateDijkstraPathToVertex(
             uint32_t dwSourceVertID,
-            uint32_t *pdwFarestPeerVertID = nullptr) const;
+            uint32_t *pdwFarestPeerVertID = nullptr,
+            const GEODESICQUERYBOUND *pBound = nullptr) const;
 
         HRESULT CalMinPathBetweenBoundaries(
             VERTEX_ARRAY &allBoundaryList,
@@ -517,6 +620,34 @@ namespace Isochart
             size_t dwPrimaryEigenDimension,
             float *pfVertMappingCoord);
 
+        size_t GetLandmarkDistanceBlockSize(size_t dwLandmarkNumber) const;
+
+        HRESULT CalculateStreamedGeodesicMatrix(
+            size_t dwBlockSize,
+            float *pfGeodesicMatrix,
+            float *pfCombineMatrix);
+
+        HRESULT CalculateLandmarkRows(
+            const std::vector<uint32_t> &landmarkIdx,
+            float *pfDistance) const;
+
+        HRESULT CalculateStreamedVertMappingCoord(
+            size_t dwBlockSize,
+            size_t dwPrimaryEigenDimension,
+            float *pfVertMappingCoord);
+
+        HRESULT AddLandmarkMapping(
+            const float *pfDistance,
+            size_t dwLandmarkBegin,
+            size_t dwLandmarkEnd,
+            size_t dwPrimaryEigenDimension,
+            float *pfVertMappingCoord);
+
+        float GetLandmarkPairDistance(
+            const float *pfVertGeodesicDistance,
+            size_t dwLandmarkIdx1,
+            size_t dwLandmarkIdx2) const;
+
         HRESULT CalculateLandmarkVertices(
             size_t dwMinLandmarkNumber,
             size_t &dwLardmarkNumber);
@@ -526,38 +657,86 @@ namespace Isochart
             const float *pfVertGeodesicDistance,
             float *pfGeodesicMatrix) const;
 
-        HRESULT InitOneToAllEngine();
+        HRESULT PrepareOneToAllTopology() const;
+        HRESULT InitOneToAllEngine(
+            ONETOALLENGINE &oneToAllEngine,
+            const GeodesicDist::MeshTopology &topology) const;
+
+        HRESULT PrepareHeatGeodesics(bool &bIsAvailable) const;
+        HRESULT PrepareCoarseGeodesics(bool &bIsAvailable) const;
+        void ReleaseGeodesicCache() const noexcept;
+
+        GEODESICBACKEND SelectGeodesicBackend(
+            size_t dwSourceCount,
+            bool bIsSignalDistance) const;
 
         HRESULT CalculateGeodesicDistance(
             std::vector<uint32_t> &vertList,
             float *pfVertCombineDistance,
-            float *pfVertGeodesicDistance) const;
+            float *pfVertGeodesicDistance,
+            const GEODESICQUERYBOUND *pBound = nullptr,
+            bool bRawDistance = false) const;
 
         void UpdateAdjacentVertexGeodistance(
-            ISOCHARTVERTEX *pCurrentVertex,
-            ISOCHARTVERTEX *pAdjacentVertex,
-            const ISOCHARTEDGE &edgeBetweenVertex,
-            bool *pbVertProcessed,
-            bool bIsSignalDistance) const;
+            uint32_t dwCurrentID,
+            const SHORTESTPATHNEIGHBOR &neighbor,
+            const bool *pbVertProcessed,
+            float *pfGeodesicDistance,
+            float *pfSignalDistance) const;
 
         HRESULT CalculateGeodesicDistanceToVertex(
             uint32_t dwSourceVertID,
+            GEODESICBACKEND backend,
             bool bIsSignalDistance,
-            uint32_t *pdwFarestPeerVertID = nullptr) const;
+            GEODESICWORKSPACE &workspace,
+            float *pfGeodesicDistance,
+            float *pfSignalDistance,
+            uint32_t *pdwFarestPeerVertID = nullptr,
+            const GEODESICQUERYBOUND *pBound = nullptr) const;
 
         HRESULT CalculateGeodesicDistanceToVertexKS98(
             uint32_t dwSourceVertID,
-            bool bIsSignalDistance,
+            float *pfGeodesicDistance,
+            float *pfSignalDistance,
+            uint32_t *pdwFarestPeerVertID = nullptr,
+            const GEODESICQUERYBOUND *pBound = nullptr) const;
+
+        HRESULT CalculateGeodesicDistanceToVertexHeat(
+            uint32_t dwSourceVertID,
+            GeodesicDist::CHeatGeodesics::Workspace &workspace,
+            float *pfGeodesicDistance,
             uint32_t *pdwFarestPeerVertID = nullptr) const;
 
         HRESULT CalculateGeodesicDistanceToVertexNewGeoDist(
             uint32_t dwSourceVertID,
-            uint32_t *pdwFarestPeerVertID = nullptr);
+            ONETOALLENGINE &oneToAllEngine,
+            float *pfGeodesicDistance,
+            uint32_t *pdwFarestPeerVertID = nullptr,
+            const GEODESICQUERYBOUND *pBound = nullptr) const;
+
+        HRESULT CalculateGeodesicDistanceToVertexCoarse(
+            uint32_t dwSourceVertID,
+            GEODESICWORKSPACE &workspace,
+            float *pfGeodesicDistance,
+            uint32_t *pdwFarestPeerVertID = nullptr,
+            const GEODESICQUERYBOUND *pBound = nullptr) const;
+
+        HRESULT PropagateGeodesicDistance(
+            uint32_t dwSourceVertID,
+            const uint32_t *pdwSeedVerts,
+            size_t dwSeedVertNumber,
+            float *pfGeodesicDistance,
+            float *pfSignalDistance,
+            uint32_t *pdwFarestPeerVertID,
+            const GEODESICQUERYBOUND *pBound) const;
+
+        HRESULT PrepareShortestPathTopology() const;
 
         void CalculateGeodesicDistanceABC(
             ISOCHARTVERTEX *pVertexA,
             ISOCHARTVERTEX *pVertexB,
-            ISOCHARTVERTEX *pVertexC) const;
+            ISOCHARTVERTEX *pVertexC,
+            float *pfGeodesicDistance) const;
 
         void CombineGeodesicAndSignalDistance(
             float *pfSignalDistance,
@@ -733,6 +912,10 @@ namespace Isochart
             const float *pfVertParitionDistance,
             std::vector<uint32_t> &representativeVertsIdx);
 
+        HRESULT ClusterFacesByRepresentiveDistance(
+            uint32_t *pdwFaceChartID,
+            const std::vector<uint32_t> &representativeVertsIdx);
+
         HRESULT PartitionGeneralShape(
             const float *pfVertGeodesicDistance,
             const float *pfVertCombineDistance,
@@ -977,7 +1160,8 @@ namespace Isochart
         HRESULT CalParamDistanceToAllLandmarks(
             const float *pfOldGeodesicDistance,
             float *pfNewGeodesicDistance,
-            std::vector<uint32_t> &allLandmark);
+            std::vector<uint32_t> &allLandmark,
+            const bool *pbIsFuzzyFatherFace);
 
         HRESULT CalSubchartsLandmarkUV(
             float *pfNewGeodesicDistance,
@@ -1219,7 +1403,7 @@ namespace Isochart
             uint32_t dwBaseVertId2);
 
         HRESULT InitializeLSCMEquation(
-            CSparseMatrix<double> &A,
+            CCompressedSparseMatrix<double> &A,
             CVector<double> &B,
             CVector<double> &U,
             uint32_t dwBaseVertId1,
@@ -1235,6 +1419,10 @@ namespace Isochart
 
         HRESULT CheckLinearEquationParamResult(
             bool &bIsOverLap);
+
+        HRESULT InitializeCGPreconditioner(
+            const CCompressedSparseMatrix<double> &A,
+            CCGPreconditioner<double> &preconditioner);
         /////////////////////////////////////////////////////////////
         //////////////////Barycentric Parameterization///////////////////
         /////////////////////////////////////////////////////////////
@@ -1252,7 +1440,7 @@ namespace Isochart
             const std::vector<uint32_t> &vertMap);
 
         HRESULT InitializeBarycentricEquation(
-            CSparseMatrix<double> &A,
+            CCompressedSparseMatrix<double> &A,
             CVector<double> &BU,
             CVector<double> &BV,
             const std::vector<double> &boundTable,
@@ -1291,6 +1479,42 @@ namespace Isochart
         CIsoMap m_isoMap;
         std::vector<uint32_t> m_landmarkVerts;
 
+        // Distances between the landmarks, kept by IsomapParameterlization
+        // when the rows from the landmarks to all vertices are too large to
+        // be stored. Read through GetLandmarkPairDistance. With IMT, the
+        // combined distances between the landmarks and the scale of the
+        // signal distance over all landmark rows are kept too, so that
+        // CalculateLandmarkRows returns the rows which would have been stored.
+        std::unique_ptr<float[]> m_pfLandmarkDistance;
+        std::unique_ptr<float[]> m_pfLandmarkCombineDistance;
+        bool m_bIsLandmarkSignalScaled;
+        float m_fLandmarkSignalRatio;
+
+        // Factored operators of the heat method, built by the first heat
+        // geodesic query on the chart and shared by the following ones, until
+        // the chart is done with. m_bHeatGeodesicsFailed records a chart the
+        // heat method can't handle.
+        mutable std::unique_ptr<GeodesicDist::CHeatGeodesics> m_pHeatGeodesics;
+        mutable bool m_bHeatGeodesicsFailed;
+
+        // Topology of the chart for the one-to-all engines, and the engines
+        // built on it by earlier queries, kept for the following ones until
+        // the chart is done with. Released with the operators of the heat
+        // method by ReleaseGeodesicCache().
+        mutable std::unique_ptr<GeodesicDist::MeshTopology> m_pOneToAllTopology;
+        mutable std::vector<std::unique_ptr<ONETOALLENGINE>> m_oneToAllEngines;
+
+        // Simplified level of the chart for GEODESIC_BACKEND_COARSE, built and
+        // released like the operators of the heat method.
+        // m_bCoarseGeodesicsFailed records a chart which can't be simplified
+        // into a manifold level.
+        mutable std::unique_ptr<COARSEGEODESICLEVEL> m_pCoarseGeodesics;
+        mutable bool m_bCoarseGeodesicsFailed;
+
+        // Flat adjacency of the shortest path queries, built by the first
+        // query on the chart and released with the other geodesic caches.
+        mutable std::unique_ptr<SHORTESTPATHTOPOLOGY> m_pShortestPathTopology;
+
         // m_fParamStretchL2 and m_fParamStretchLn bound the distortion of
         // parameterization.See more detail in :
         // Kun Zhou, John Synder, Baining Guo, Heung-Yeung Shum:
@@ -1318,12 +1542,6 @@ namespace Isochart
         bool m_bOrderedLandmark;
 
         bool m_bNeedToClean;
-
-    #ifdef _USE_EXACT_ALGORITHM
-        GeodesicDist::CExactOneToAll m_ExactOneToAllEngine;
-    #else
-        GeodesicDist::CApproximateOneToAll m_ApproximateOneToAllEngine;
-    #endif
     };
 
 }
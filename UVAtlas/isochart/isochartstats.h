@@ -0,0 +1,142 @@
+//-------------------------------------------------------------------------------------
+// UVAtlas - isochartstats.h
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "UVAtlas.h"
+
+namespace Isochart
+{
+    // CIsochartStats collects the stage times and counters of an engine, which
+    // are returned to the caller in a UVAtlasStats. Charts are processed by
+    // several threads at once, so every member is atomic. Times are kept in
+    // nanoseconds of wall clock.
+    class CIsochartStats
+    {
+    public:
+        CIsochartStats() noexcept { Reset(); }
+
+        CIsochartStats(CIsochartStats const &) = delete;
+        CIsochartStats &operator=(CIsochartStats const &) = delete;
+
+        void Reset() noexcept;
+
+        void UpdatePeakChartCount(size_t dwChartCount) noexcept;
+
+        // Adds the collected values to stats.
+        void Export(DirectX::UVAtlasStats &stats) const noexcept;
+
+        std::atomic<uint64_t> initTime;
+        std::atomic<uint64_t> rootChartTime;
+        std::atomic<uint64_t> partitionTime;
+        std::atomic<uint64_t> optimizeStretchTime;
+        std::atomic<uint64_t> mergeTime;
+        std::atomic<uint64_t> boundaryTime;
+
+        std::atomic<size_t> dwKS98Runs;
+        std::atomic<size_t> dwExactRuns;
+        std::atomic<size_t> dwHeatRuns;
+        std::atomic<size_t> dwCoarseRuns;
+        std::atomic<size_t> dwDijkstraRuns;
+        std::atomic<size_t> dwCGSolves;
+        std::atomic<size_t> dwCGIterations;
+        std::atomic<size_t> dwCGIterationLimits;
+        std::atomic<size_t> dwGraphCuts;
+        std::atomic<size_t> dwMergeAttempts;
+        std::atomic<size_t> dwMergeRejections;
+        std::atomic<size_t> dwPeakChartCount;
+    };
+
+    // CStatsTimer adds the wall time of its scope to a time of CIsochartStats.
+    class CStatsTimer
+    {
+    public:
+        explicit CStatsTimer(std::atomic<uint64_t> &time) noexcept :
+            m_time(time),
+            m_start(std::chrono::steady_clock::now())
+        {}
+
+        CStatsTimer(CStatsTimer const &) = delete;
+        CStatsTimer &operator=(CStatsTimer const &) = delete;
+
+        ~CStatsTimer()
+        {
+            m_time += ElapsedNanoseconds(m_start);
+        }
+
+        static uint64_t ElapsedNanoseconds(std::chrono::steady_clock::time_point start) noexcept
+        {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count());
+        }
+
+        static double ToMilliseconds(uint64_t time) noexcept
+        {
+            return double(time) * 1e-6;
+        }
+
+    private:
+        std::atomic<uint64_t> &m_time;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    inline void CIsochartStats::Reset() noexcept
+    {
+        initTime = 0;
+        rootChartTime = 0;
+        partitionTime = 0;
+        optimizeStretchTime = 0;
+        mergeTime = 0;
+        boundaryTime = 0;
+
+        dwKS98Runs = 0;
+        dwExactRuns = 0;
+        dwHeatRuns = 0;
+        dwCoarseRuns = 0;
+        dwDijkstraRuns = 0;
+        dwCGSolves = 0;
+        dwCGIterations = 0;
+        dwCGIterationLimits = 0;
+        dwGraphCuts = 0;
+        dwMergeAttempts = 0;
+        dwMergeRejections = 0;
+        dwPeakChartCount = 0;
+    }
+
+    inline void CIsochartStats::UpdatePeakChartCount(size_t dwChartCount) noexcept
+    {
+        size_t dwPeak = dwPeakChartCount;
+        while (dwPeak < dwChartCount && !dwPeakChartCount.compare_exchange_weak(dwPeak, dwChartCount))
+        {
+        }
+    }
+
+    inline void CIsochartStats::Export(DirectX::UVAtlasStats &stats) const noexcept
+    {
+        stats.initTime += CStatsTimer::ToMilliseconds(initTime);
+        stats.rootChartTime += CStatsTimer::ToMilliseconds(rootChartTime);
+        stats.partitionTime += CStatsTimer::ToMilliseconds(partitionTime);
+        stats.optimizeStretchTime += CStatsTimer::ToMilliseconds(optimizeStretchTime);
+        stats.mergeTime += CStatsTimer::ToMilliseconds(mergeTime);
+        stats.boundaryTime += CStatsTimer::ToMilliseconds(boundaryTime);
+
+        stats.geodesicKS98Runs += dwKS98Runs;
+        stats.geodesicExactRuns += dwExactRuns;
+        stats.geodesicHeatRuns += dwHeatRuns;
+        stats.geodesicCoarseRuns += dwCoarseRuns;
+        stats.geodesicDijkstraRuns += dwDijkstraRuns;
+        stats.cgSolveCount += dwCGSolves;
+        stats.cgIterations += dwCGIterations;
+        stats.cgIterationLimitCount += dwCGIterationLimits;
+        stats.graphCutCount += dwGraphCuts;
+        stats.mergeAttempts += dwMergeAttempts;
+        stats.mergeRejections += dwMergeRejections;
+        stats.peakChartCount = std::max<size_t>(stats.peakChartCount, dwPeakChartCount);
+    }
+}
@@ -10,9 +10,23 @@
 #include "pch.h"
 #include "isomap.h"
 #include "isochartutil.h"
+#include "taskscheduler.h"
 
 using namespace Isochart;
 
+namespace
+{
+    // Landmark matrices of at least this many elements are double centered by
+    // the workers of the executor.
+    constexpr size_t PARALLEL_CENTERING_MIN_ELEMENTS = 0x100000;
+
+    // Columns are squared and summed in blocks of CENTERING_COLUMN_BLOCK, so
+    // that the sums of a block stay in cache while a worker walks down the
+    // rows. Rows are centered CENTERING_ROW_GRAIN at a time.
+    constexpr size_t CENTERING_COLUMN_BLOCK = 256;
+    constexpr size_t CENTERING_ROW_GRAIN = 16;
+}
+
 #include "SymmetricMatrix.hpp"
 
 CIsoMap::CIsoMap()
@@ -31,7 +45,10 @@ CIsoMap::~CIsoMap()
     Clear();
 }
 
-HRESULT CIsoMap::Init(size_t dwDimension, float *pGeodesicMatrix)
+HRESULT CIsoMap::Init(
+    size_t dwDimension,
+    float *pGeodesicMatrix,
+    const DirectX::UVAtlasExecutor *pExecutor)
 {
     Clear();
     assert(pGeodesicMatrix != nullptr);
@@ -43,18 +60,9 @@ HRESULT CIsoMap::Init(size_t dwDimension, float *pGeodesicMatrix)
     m_pfMatrixB = pGeodesicMatrix;
     m_dwMatrixDimension = dwDimension;
 
-    float *pRow = m_pfMatrixB;
-    for (size_t i = 0; i < m_dwMatrixDimension; i++)
-    {
-        for (size_t j = 0; j < m_dwMatrixDimension; j++)
-        {
-            pRow[j] *= pRow[j];
-        }
-
-        pRow += m_dwMatrixDimension;
-    }
+    const size_t dwDim = m_dwMatrixDimension;
 
-    std::unique_ptr<float[]> average(new (std::nothrow) float[m_dwMatrixDimension]);
+    std::unique_ptr<float[]> average(new (std::nothrow) float[dwDim]);
     if (!average)
     {
         return E_OUTOFMEMORY;
@@ -62,65 +70,97 @@ HRESULT CIsoMap::Init(size_t dwDimension, float *pGeodesicMatrix)
 
     float *pfAverage = average.get();
 
-    m_pfAvgSquaredDstColumn = new (std::nothrow) float[m_dwMatrixDimension];
+    m_pfAvgSquaredDstColumn = new (std::nothrow) float[dwDim];
     if (!m_pfAvgSquaredDstColumn)
     {
         return E_OUTOFMEMORY;
     }
 
-    for (size_t i = 0; i < m_dwMatrixDimension; i++)
-    {
-        pfAverage[i] = 0;
-        for (size_t j = 0; j < m_dwMatrixDimension; j++)
-        {
-            pfAverage[i] += m_pfMatrixB[j * m_dwMatrixDimension + i];
-        }
-        pfAverage[i] /= float(m_dwMatrixDimension);
-    }
-    memcpy(m_pfAvgSquaredDstColumn, pfAverage, m_dwMatrixDimension * sizeof(float));
+    // B = -0.5 * J * D^2 * J, J = I - 1 * 1' / n, in two passes over the
+    // matrix. The rounding of every element is the same as squaring, removing
+    // the column averages, removing the row averages and scaling in separate
+    // passes.
 
-    pRow = m_pfMatrixB;
-    for (size_t i = 0; i < m_dwMatrixDimension; i++)
-    {
-        for (size_t j = 0; j < m_dwMatrixDimension; j++)
+    // 1. Square the elements and sum the columns. Each block of columns is
+    // summed down the rows, so the sums of a block stay in cache.
+    auto squareColumns = [&](size_t dwBegin, size_t dwEnd, size_t) -> HRESULT
         {
-            pRow[j] -= pfAverage[j];
-        }
-        pRow += m_dwMatrixDimension;
-    }
-
-    pRow = m_pfMatrixB;
-    for (size_t i = 0; i < m_dwMatrixDimension; i++)
+            size_t dwFirst = dwBegin * CENTERING_COLUMN_BLOCK;
+            size_t dwLast = std::min(dwEnd * CENTERING_COLUMN_BLOCK, dwDim);
+
+            for (size_t j = dwFirst; j < dwLast; j++)
+            {
+                pfAverage[j] = 0;
+            }
+
+            for (size_t i = 0; i < dwDim; i++)
+            {
+                float *pRow = m_pfMatrixB + i * dwDim;
+                for (size_t j = dwFirst; j < dwLast; j++)
+                {
+                    pRow[j] *= pRow[j];
+                    pfAverage[j] += pRow[j];
+                }
+            }
+
+            for (size_t j = dwFirst; j < dwLast; j++)
+            {
+                pfAverage[j] /= float(dwDim);
+            }
+            return S_OK;
+        };
+
+    // 2. Remove the column averages, then the row average, and scale each row
+    // while it is in cache. The row average is added serially in float on
+    // purpose: splitting it between SIMD lanes would reorder the additions
+    // and change the rounding, and the output is kept bit-identical to the
+    // separate passes (Tests/benchmark.cpp compares them). The other loops
+    // are element-wise and left to the compiler's vectorizer.
+    auto centerRows = [&](size_t dwBegin, size_t dwEnd, size_t) -> HRESULT
+        {
+            for (size_t i = dwBegin; i < dwEnd; i++)
+            {
+                float *pRow = m_pfMatrixB + i * dwDim;
+                float fRowAverage = 0;
+                for (size_t j = 0; j < dwDim; j++)
+                {
+                    pRow[j] -= pfAverage[j];
+                    fRowAverage += pRow[j];
+                }
+                fRowAverage /= float(dwDim);
+
+                for (size_t j = 0; j < dwDim; j++)
+                {
+                    pRow[j] = (pRow[j] - fRowAverage) * -0.5f;
+                }
+            }
+            return S_OK;
+        };
+
+    const size_t dwColumnBlocks = (dwDim + CENTERING_COLUMN_BLOCK - 1) / CENTERING_COLUMN_BLOCK;
+
+    HRESULT hr = S_OK;
+    if (dwDim * dwDim >= PARALLEL_CENTERING_MIN_ELEMENTS)
     {
-        pfAverage[i] = 0;
-        for (size_t j = 0; j < m_dwMatrixDimension; j++)
+        if (FAILED(hr = CTaskScheduler::NestedParallelFor(dwColumnBlocks, 1, squareColumns, pExecutor)))
         {
-            pfAverage[i] += pRow[j];
+            return hr;
         }
 
-        pfAverage[i] /= float(m_dwMatrixDimension);
-        pRow += m_dwMatrixDimension;
-    }
+        memcpy(m_pfAvgSquaredDstColumn, pfAverage, dwDim * sizeof(float));
 
-    pRow = m_pfMatrixB;
-    for (size_t i = 0; i < m_dwMatrixDimension; i++)
-    {
-        for (size_t j = 0; j < m_dwMatrixDimension; j++)
+        if (FAILED(hr = CTaskScheduler::NestedParallelFor(dwDim, CENTERING_ROW_GRAIN, centerRows, pExecutor)))
         {
-            pRow[j] -= pfAverage[i];
+            return hr;
         }
-        pRow += m_dwMatrixDimension;
     }
-
-    pRow = m_pfMatrixB;
-    for (size_t i = 0; i < m_dwMatrixDimension; i++)
+    else
     {
-        for (size_t j = 0; j < m_dwMatrixDimension; j++)
-        {
-            pRow[j] *= -0.5f;
-        }
-        pRow += m_dwMatrixDimension;
+        squareColumns(0, dwColumnBlocks, 0);
+        memcpy(m_pfAvgSquaredDstColumn, pfAverage, dwDim * sizeof(float));
+        centerRows(0, dwDim, 0);
     }
+
     return S_OK;
 }
 
@@ -135,13 +175,8 @@ HRESULT CIsoMap::ComputeLargestEigen(
     assert(dwSelectedDimension <= m_dwMatrixDimension);
     _Analysis_assume_(dwSelectedDimension <= m_dwMatrixDimension);
 
-    std::unique_ptr<float[]> pfEigenValue(new (std::nothrow) float[m_dwMatrixDimension]);
-    std::unique_ptr<float[]> pfEigenVector(new (std::nothrow) float[m_dwMatrixDimension * m_dwMatrixDimension]);
-    if (!pfEigenValue || !pfEigenVector)
-    {
-        return E_OUTOFMEMORY;
-    }
-
+    // GetEigen only exports the selected eigenpairs, so they're written to the
+    // members directly.
     m_pfEigenValue = new (std::nothrow) float[dwSelectedDimension];
     m_pfEigenVector = new (std::nothrow) float[m_dwMatrixDimension * dwSelectedDimension];
 
@@ -152,18 +187,12 @@ HRESULT CIsoMap::ComputeLargestEigen(
 
     if (!CSymmetricMatrix<float>::GetEigen(
         m_dwMatrixDimension, m_pfMatrixB,
-        pfEigenValue.get(), pfEigenVector.get(),
+        m_pfEigenValue, m_pfEigenVector,
         dwSelectedDimension))
     {
         return E_OUTOFMEMORY;
     }
 
-    memcpy(m_pfEigenValue, pfEigenValue.get(), dwSelectedDimension * sizeof(float));
-    memcpy(
-        m_pfEigenVector,
-        pfEigenVector.get(),
-        m_dwMatrixDimension * dwSelectedDimension * sizeof(float));
-
     m_fSumOfEigenValue = 0;
     dwCalculatedDimension = 0;
     for (size_t i = 0; i < dwSelectedDimension; i++)
@@ -17,9 +17,12 @@ namespace Isochart
         CIsoMap();
         ~CIsoMap();
 
+        // Double centers pfGeodesicMatrix in place and takes it over. Large
+        // matrices are split between the workers of pExecutor.
         HRESULT Init(
             size_t dwDimension,
-            float *pfGeodesicMatrix);
+            float *pfGeodesicMatrix,
+            const DirectX::UVAtlasExecutor *pExecutor = nullptr);
 
         void Clear();
 
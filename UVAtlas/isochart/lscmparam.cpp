@@ -20,6 +20,11 @@ using namespace DirectX;
 namespace
 {
     constexpr size_t LSCM_MAX_ITERATION = 10000;
+
+    // Preconditioner of the conjugate gradient solves when the options don't
+    // select one.
+    constexpr CGPRECONDITIONER DEFAULT_CG_PRECONDITIONER = CG_PRECONDITIONER_IC0;
+
     enum EQUATION_POSITION
     {
         IN_COEFFICIENT,
@@ -231,7 +236,7 @@ HRESULT CIsochartMesh::AssignLSCMResult(
 
 //-------------------------------------------------------------------------------------
 HRESULT CIsochartMesh::InitializeLSCMEquation(
-    CSparseMatrix<double> &A,
+    CCompressedSparseMatrix<double> &A,
     CVector<double> &B,
     CVector<double> &U,
     uint32_t dwBaseVertId1,
@@ -239,6 +244,7 @@ HRESULT CIsochartMesh::InitializeLSCMEquation(
 {
     HRESULT hr = S_OK;
     CSparseMatrix<double> orgA;
+    CCompressedSparseMatrix<double> compressedA;
     CSparseMatrix<double> M;
     CVector<double> orgB;
 
@@ -265,14 +271,19 @@ HRESULT CIsochartMesh::InitializeLSCMEquation(
     assert(orgB.size() == 2 * m_dwFaceNumber);
     CVector<double>::scale(orgB, orgB, -1.0);
 
+    if (!compressedA.compress(orgA))
+    {
+        return E_OUTOFMEMORY;
+    }
+
     // A' = A^T * A
-    if (!CSparseMatrix<double>::Mat_Trans_MUL_Mat(A, orgA))
+    if (!CCompressedSparseMatrix<double>::Mat_Trans_MUL_Mat(A, compressedA))
     {
         return E_OUTOFMEMORY;
     }
 
     // B' = A^T * b
-    if (!CSparseMatrix<double>::Mat_Trans_Mul_Vec(B, orgA, orgB))
+    if (!CCompressedSparseMatrix<double>::Mat_Trans_Mul_Vec(B, compressedA, orgB))
     {
         return E_OUTOFMEMORY;
     }
@@ -311,6 +322,37 @@ HRESULT CIsochartMesh::CheckLinearEquationParamResult(
     return hr;
 }
 
+//-------------------------------------------------------------------------------------
+HRESULT CIsochartMesh::InitializeCGPreconditioner(
+    const CCompressedSparseMatrix<double> &A,
+    CCGPreconditioner<double> &preconditioner)
+{
+    CGPRECONDITIONER type = DEFAULT_CG_PRECONDITIONER;
+    switch (m_IsochartEngine.m_dwOptions & OPTIONMASK_ISOCHART_CG_PRECONDITIONER)
+    {
+    case ISOCHARTOPTION::CG_UNPRECONDITIONED:
+        type = CG_PRECONDITIONER_NONE;
+        break;
+    case ISOCHARTOPTION::CG_JACOBI:
+        type = CG_PRECONDITIONER_JACOBI;
+        break;
+    case ISOCHARTOPTION::CG_IC0:
+        type = CG_PRECONDITIONER_IC0;
+        break;
+    case ISOCHARTOPTION::CG_SSOR:
+        type = CG_PRECONDITIONER_SSOR;
+        break;
+    default:
+        break;
+    }
+
+    if (!preconditioner.init(A, type))
+    {
+        return E_OUTOFMEMORY;
+    }
+    return S_OK;
+}
+
 //-------------------------------------------------------------------------------------
 HRESULT CIsochartMesh::LSCMParameterization(
     bool &bIsOverLap)
@@ -322,9 +364,11 @@ HRESULT CIsochartMesh::LSCMParameterization(
     // 1. Find 2 farest boundary vertices as the reference vertices
     uint32_t dwBaseVertId1, dwBaseVertId2;
     CVector<double> U, X;
-    CSparseMatrix<double> A;
+    CCompressedSparseMatrix<double> A;
+    CCGPreconditioner<double> preconditioner;
     CVector<double> B;
     size_t nIterCount = 0;
+    bool bSolved = false;
 
     FAILURE_GOTO_END(
         FindTwoFarestBoundaryVertices(
@@ -346,19 +390,29 @@ HRESULT CIsochartMesh::LSCMParameterization(
             dwBaseVertId1,
             dwBaseVertId2));
 
-    // 3. Solve the linear equation set
     FAILURE_GOTO_END(
-        (false != CSparseMatrix<double>::ConjugateGradient(
-            X,
+        InitializeCGPreconditioner(
             A,
-            B,
-            LSCM_MAX_ITERATION,
-            1e-8,
-            nIterCount)
-            ? S_OK
-            : E_FAIL));
+            preconditioner));
+
+    // 3. Solve the linear equation set
+    bSolved = CCompressedSparseMatrix<double>::ConjugateGradient(
+        X,
+        A,
+        B,
+        preconditioner.type() != CG_PRECONDITIONER_NONE ? &preconditioner : nullptr,
+        LSCM_MAX_ITERATION,
+        1e-8,
+        nIterCount,
+        m_IsochartEngine.m_cancel.GetStopCheck(),
+        &m_IsochartEngine.m_executor);
+    m_IsochartEngine.m_stats.dwCGSolves++;
+    m_IsochartEngine.m_stats.dwCGIterations += nIterCount;
+    FAILURE_GOTO_END(m_IsochartEngine.m_cancel.Check());
+    FAILURE_GOTO_END(bSolved ? S_OK : E_FAIL);
     if (nIterCount >= LSCM_MAX_ITERATION)
     {
+        m_IsochartEngine.m_stats.dwCGIterationLimits++;
         goto LEnd;
     }
 
@@ -383,10 +383,12 @@ HRESULT CIsochartMesh::MergeAdjacentChart(
         }
 
         // 2.3.  try to merge.
+        pMainChart->m_IsochartEngine.m_stats.dwMergeAttempts++;
         FAILURE_RETURN(
             TryMergeChart(children, pMainChart, pAddjacentChart, &pMergedChart));
         if (!pMergedChart)
         {
+            pMainChart->m_IsochartEngine.m_stats.dwMergeRejections++;
             continue;
         }
 
@@ -400,6 +402,7 @@ HRESULT CIsochartMesh::MergeAdjacentChart(
         }
         if (!bParameterSucceed)
         {
+            pMainChart->m_IsochartEngine.m_stats.dwMergeRejections++;
             delete pMergedChart;
             pMergedChart = nullptr;
             continue;
@@ -414,6 +417,7 @@ HRESULT CIsochartMesh::MergeAdjacentChart(
             pMergedChart,
             bCanMerge)))
         {
+            pMainChart->m_IsochartEngine.m_stats.dwMergeRejections++;
             delete pMergedChart;
             pMergedChart = nullptr;
             continue;
@@ -425,6 +429,7 @@ HRESULT CIsochartMesh::MergeAdjacentChart(
         }
         else
         {
+            pMainChart->m_IsochartEngine.m_stats.dwMergeRejections++;
             delete pMergedChart;
             pMergedChart = nullptr;
         }
@@ -588,7 +593,7 @@ HRESULT CIsochartMesh::CalculateIsoParameterization()
         m_landmarkVerts, pfVertGeodesicDistance, pfGeodesicMatrix);
 
     // 3. Perform Isomap to decrease dimension
-    if (FAILED(hr = m_isoMap.Init(dwLandmarkNumber, pfGeodesicMatrix)))
+    if (FAILED(hr = m_isoMap.Init(dwLandmarkNumber, pfGeodesicMatrix, &m_IsochartEngine.m_executor)))
     {
         goto LEnd;
     }
@@ -610,6 +615,7 @@ HRESULT CIsochartMesh::CalculateIsoParameterization()
 LEnd:
     m_landmarkVerts.clear();
     m_isoMap.Clear();
+    ReleaseGeodesicCache();
 
     return hr;
 }
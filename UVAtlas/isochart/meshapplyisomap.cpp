@@ -12,24 +12,59 @@
 
 #include "ExactOneToAll.h"
 #include "ApproximateOneToAll.h"
+#include "HeatGeodesics.h"
 #include "mathutils.h"
+#include "progressivemesh.h"
+#include "taskscheduler.h"
 
 using namespace Isochart;
 using namespace GeodesicDist;
 using namespace DirectX;
 
-// define the macro to use the exact algorithm, otherwise the fast approximate algorithm is employed
-#ifdef _USE_EXACT_ALGORITHM
-#define ONE_TO_ALL_ENGINE m_ExactOneToAllEngine
-#else
-#define ONE_TO_ALL_ENGINE m_ApproximateOneToAllEngine
-#endif
-
 namespace
 {
     // face number limit, below this limit, new geodesic algorithm is used, otherwise the old KS98 is used
     constexpr size_t LIMIT_FACENUM_USENEWGEODIST = _LIMIT_FACENUM_USENEWGEODIST;
 
+    // With GEODESIC_ADAPTIVE, a chart uses the new geodesic algorithm while
+    // the estimated cost of its sources stays below this budget. One source
+    // costs about faces^1.5 in the window propagation, against
+    // vertices * log(vertices) for [KS98], which is negligible next to it.
+    // The budget is a chart of LIMIT_FACENUM_USENEWGEODIST faces with 256
+    // sources.
+    constexpr double ADAPTIVE_NEWGEODIST_COST_BUDGET = 256.0 * 3.95e6;
+
+    // With GEODESIC_HEAT, charts with at least this many vertices use the heat
+    // method, whose factorization is paid once per chart. Smaller charts use
+    // the new geodesic algorithm, which is precise and still cheap on them.
+    constexpr size_t HEAT_MIN_VERTICES = 4096;
+
+    // With GEODESIC_COARSE, the charts using the coarse level are simplified
+    // down to this many vertices, a chart the new geodesic algorithm handles
+    // quickly.
+    constexpr size_t COARSE_GEODESIC_VERT_NUMBER = 4096;
+
+    // Landmarks times vertices below which the geodesic distances are not
+    // worth splitting between threads.
+    constexpr size_t PARALLEL_GEODESIC_MIN_WORK = 0x10000;
+
+    // Size in bytes above which the distances from the landmarks to all
+    // vertices of a chart are not stored by IsomapParameterlization. They are
+    // computed in blocks of rows instead, LANDMARK_DISTANCE_BLOCK_MEMORY
+    // bytes at a time, once for the landmark distance matrix and once more
+    // for the embedding of the other vertices.
+    constexpr size_t LANDMARK_DISTANCE_MEMORY_LIMIT = 256 << 20;
+    constexpr size_t LANDMARK_DISTANCE_BLOCK_MEMORY = 32 << 20;
+
+    // The vertices which are not landmarks are mapped MAPPING_VERTEX_BLOCK at
+    // a time, by the product of their columns of the landmark distance rows
+    // with the eigenvectors. Above PARALLEL_MAPPING_MIN_WORK vertices times
+    // landmarks, the blocks are split between threads, MAPPING_BLOCK_GRAIN
+    // blocks at a time.
+    constexpr size_t MAPPING_VERTEX_BLOCK = 64;
+    constexpr size_t MAPPING_BLOCK_GRAIN = 16;
+    constexpr size_t PARALLEL_MAPPING_MIN_WORK = 0x100000;
+
     // Used to combine geodesic and signal distance. See [Kun04], 6 section.
     constexpr float SIGNAL_DISTANCE_WEIGHT = 0.30f;
 }
@@ -131,82 +166,58 @@ HRESULT CIsochartMesh::CalculateLandmarkVertices(
     return S_OK;
 }
 
-// init structures used in CExactOneToAll or CApproximateOneToAll
-HRESULT CIsochartMesh::InitOneToAllEngine()
+// Builds the topology the one-to-all engines of this chart run on, if it is
+// not built yet. Not thread safe, called before the landmarks are split
+// between workers, which only read it.
+HRESULT CIsochartMesh::PrepareOneToAllTopology() const
 {
-    ONE_TO_ALL_ENGINE.m_VertexList.clear();
-    ONE_TO_ALL_ENGINE.m_EdgeList.clear();
-    ONE_TO_ALL_ENGINE.m_FaceList.clear();
+    if (m_pOneToAllTopology)
+    {
+        return S_OK;
+    }
 
     try
     {
-        ONE_TO_ALL_ENGINE.m_VertexList.resize(m_dwVertNumber);
-        ONE_TO_ALL_ENGINE.m_EdgeList.resize(m_dwEdgeNumber);
-        ONE_TO_ALL_ENGINE.m_FaceList.resize(m_dwFaceNumber);
+        std::unique_ptr<MeshTopology> pTopology(new (std::nothrow) MeshTopology);
+        if (!pTopology)
+        {
+            return E_OUTOFMEMORY;
+        }
 
-        // init vertex list in ONE_TO_ALL_ENGINE
+        pTopology->vertexPositions.resize(m_dwVertNumber);
+        pTopology->vertexBoundary.resize(m_dwVertNumber);
         for (size_t i = 0; i < m_dwVertNumber; ++i)
         {
-            Vertex &thisVertex = ONE_TO_ALL_ENGINE.m_VertexList[i];
-
-            thisVertex.x = double(m_baseInfo.pVertPosition[m_pVerts[i].dwIDInRootMesh].x);
-            thisVertex.y = double(m_baseInfo.pVertPosition[m_pVerts[i].dwIDInRootMesh].y);
-            thisVertex.z = double(m_baseInfo.pVertPosition[m_pVerts[i].dwIDInRootMesh].z);
-            thisVertex.bBoundary = m_pVerts[i].bIsBoundary;
+            const XMFLOAT3 &position = m_baseInfo.pVertPosition[m_pVerts[i].dwIDInRootMesh];
+            pTopology->vertexPositions[i].x = double(position.x);
+            pTopology->vertexPositions[i].y = double(position.y);
+            pTopology->vertexPositions[i].z = double(position.z);
+            pTopology->vertexBoundary[i] = m_pVerts[i].bIsBoundary ? 1 : 0;
         }
 
-        // init edge list in ONE_TO_ALL_ENGINE
+        pTopology->edgeVertices.resize(2 * m_dwEdgeNumber);
+        pTopology->edgeFaces.resize(2 * m_dwEdgeNumber);
         for (size_t i = 0; i < m_dwEdgeNumber; ++i)
         {
-            Edge &thisEdge = ONE_TO_ALL_ENGINE.m_EdgeList[i];
-
-            thisEdge.dwVertexIdx0 = m_edges[i].dwVertexID[0];
-            thisEdge.pVertex0 = &ONE_TO_ALL_ENGINE.m_VertexList[thisEdge.dwVertexIdx0];
-            thisEdge.dwVertexIdx1 = m_edges[i].dwVertexID[1];
-            thisEdge.pVertex1 = &ONE_TO_ALL_ENGINE.m_VertexList[thisEdge.dwVertexIdx1];
-
-            thisEdge.dwAdjFaceIdx0 = m_edges[i].dwFaceID[0];
-            thisEdge.pAdjFace0 = &ONE_TO_ALL_ENGINE.m_FaceList[thisEdge.dwAdjFaceIdx0];
-            thisEdge.dwAdjFaceIdx1 = m_edges[i].dwFaceID[1] == INVALID_FACE_ID ? FLAG_INVALIDDWORD : m_edges[i].dwFaceID[1];
-            thisEdge.pAdjFace1 = m_edges[i].dwFaceID[1] == INVALID_FACE_ID ? nullptr : &ONE_TO_ALL_ENGINE.m_FaceList[thisEdge.dwAdjFaceIdx1];
-
-            thisEdge.dEdgeLength = sqrt(SquredD3Dist(*thisEdge.pVertex0, *thisEdge.pVertex1));
-
-            thisEdge.pVertex0->edgesAdj.push_back(&thisEdge);
-            thisEdge.pVertex1->edgesAdj.push_back(&thisEdge);
+            pTopology->edgeVertices[2 * i] = m_edges[i].dwVertexID[0];
+            pTopology->edgeVertices[2 * i + 1] = m_edges[i].dwVertexID[1];
+            pTopology->edgeFaces[2 * i] = m_edges[i].dwFaceID[0];
+            pTopology->edgeFaces[2 * i + 1] = m_edges[i].dwFaceID[1] == INVALID_FACE_ID ? FLAG_INVALIDDWORD : m_edges[i].dwFaceID[1];
         }
 
-        // init face list in ONE_TO_ALL_ENGINE
+        pTopology->faceEdges.resize(3 * m_dwFaceNumber);
+        pTopology->faceVertices.resize(3 * m_dwFaceNumber);
         for (size_t i = 0; i < m_dwFaceNumber; ++i)
         {
-            Face &thisFace = ONE_TO_ALL_ENGINE.m_FaceList[i];
-
-            thisFace.dwEdgeIdx0 = m_pFaces[i].dwEdgeID[0];
-            thisFace.pEdge0 = &ONE_TO_ALL_ENGINE.m_EdgeList[thisFace.dwEdgeIdx0];
-            thisFace.dwEdgeIdx1 = m_pFaces[i].dwEdgeID[1];
-            thisFace.pEdge1 = &ONE_TO_ALL_ENGINE.m_EdgeList[thisFace.dwEdgeIdx1];
-            thisFace.dwEdgeIdx2 = m_pFaces[i].dwEdgeID[2];
-            thisFace.pEdge2 = &ONE_TO_ALL_ENGINE.m_EdgeList[thisFace.dwEdgeIdx2];
-
-            thisFace.dwVertexIdx0 = m_pFaces[i].dwVertexID[0];
-            thisFace.pVertex0 = &ONE_TO_ALL_ENGINE.m_VertexList[thisFace.dwVertexIdx0];
-            thisFace.dwVertexIdx1 = m_pFaces[i].dwVertexID[1];
-            thisFace.pVertex1 = &ONE_TO_ALL_ENGINE.m_VertexList[thisFace.dwVertexIdx1];
-            thisFace.dwVertexIdx2 = m_pFaces[i].dwVertexID[2];
-            thisFace.pVertex2 = &ONE_TO_ALL_ENGINE.m_VertexList[thisFace.dwVertexIdx2];
-
-            thisFace.pVertex2->dAngle += ComputeAngleBetween2Lines(*thisFace.pVertex2, *thisFace.pVertex0, *thisFace.pVertex1);
-            thisFace.pVertex1->dAngle += ComputeAngleBetween2Lines(*thisFace.pVertex1, *thisFace.pVertex0, *thisFace.pVertex2);
-            thisFace.pVertex0->dAngle += ComputeAngleBetween2Lines(*thisFace.pVertex0, *thisFace.pVertex1, *thisFace.pVertex2);
-
-            thisFace.pVertex0->bUsed = true;
-            thisFace.pVertex1->bUsed = true;
-            thisFace.pVertex2->bUsed = true;
-
-            thisFace.pVertex0->facesAdj.push_back(&thisFace);
-            thisFace.pVertex1->facesAdj.push_back(&thisFace);
-            thisFace.pVertex2->facesAdj.push_back(&thisFace);
+            for (size_t j = 0; j < 3; ++j)
+            {
+                pTopology->faceEdges[3 * i + j] = m_pFaces[i].dwEdgeID[j];
+                pTopology->faceVertices[3 * i + j] = m_pFaces[i].dwVertexID[j];
+            }
         }
+
+        pTopology->Build();
+        m_pOneToAllTopology = std::move(pTopology);
     }
     catch (std::bad_alloc &)
     {
@@ -216,418 +227,1285 @@ HRESULT CIsochartMesh::InitOneToAllEngine()
     return S_OK;
 }
 
-// For each vertex in landmark list, compute geodesic distance from
-// this vertex to all other vertices in the same chart.
-HRESULT CIsochartMesh::CalculateGeodesicDistance(
-    std::vector<uint32_t> &vertList,
-    float *pfVertCombineDistance,
-    float *pfVertGeodesicDistance) const
+// Flattens the adjacency of the vertices, with the fields of the matching
+// edges, for the shortest path queries. The neighbors of a vertex follow its
+// vertAdjacent list, the order in which the queries update the heap. A vertex
+// whose vertAdjacent and edgeAdjacent lists do not pair one-to-one, which only
+// happens on degenerate charts, gets one neighbor for each of its edges in
+// edgeAdjacent order instead.
+HRESULT CIsochartMesh::PrepareShortestPathTopology() const
 {
-    if (vertList.empty())
+    if (m_pShortestPathTopology)
     {
         return S_OK;
     }
-    assert(!(!pfVertGeodesicDistance && !pfVertCombineDistance));
-
-    HRESULT hr = S_OK;
-    size_t dwVertLandNumber = static_cast<size_t>(vertList.size());
-    bool bIsSignalDistance = IsIMTSpecified();
-
-    if (
-        (
-            // if the geodesic algorithm selection field of the isochart option is DEFAULT, check whether suitable to apply the new algorithm
-            (
-                (
-                    (m_IsochartEngine.m_dwOptions & OPTIONMASK_ISOCHART_GEODESIC) ==
-                    (ISOCHARTOPTION::DEFAULT & OPTIONMASK_ISOCHART_GEODESIC)) &&
-                (m_baseInfo.dwFaceCount < LIMIT_FACENUM_USENEWGEODIST)) ||
-
-            // or the user forces to use the new algorithm
-            (
-                m_IsochartEngine.m_dwOptions & ISOCHARTOPTION::GEODESIC_QUALITY)) &&
-
-        // anyway, if IMT is specified, use the old geodesic distance algorithm, because currently the new geodesic distance algorithm does not support IMT
-        (
-            !bIsSignalDistance &&
-            m_dwVertNumber > 0 &&
-            m_dwFaceNumber > 0))
-    {
-        const_cast<CIsochartMesh *>(this)->InitOneToAllEngine();
-    }
 
-    float *pfTempGeodesicDistance = nullptr;
-    if (!pfVertGeodesicDistance)
+    try
     {
-        pfTempGeodesicDistance = new (std::nothrow) float[dwVertLandNumber * m_dwVertNumber];
-        if (!pfTempGeodesicDistance)
+        std::unique_ptr<SHORTESTPATHTOPOLOGY> pTopology(new (std::nothrow) SHORTESTPATHTOPOLOGY);
+        if (!pTopology)
         {
             return E_OUTOFMEMORY;
         }
-    }
-    else
-    {
-        pfTempGeodesicDistance = pfVertGeodesicDistance;
-    }
-
-    float *pCombineDistanceToOneLandmark = pfVertCombineDistance;
-    float *pGeodesicDstanceToOneLandmark = pfTempGeodesicDistance;
-    for (size_t i = 0; i < dwVertLandNumber; i++)
-    {
-        if (FAILED(hr = CalculateGeodesicDistanceToVertex(
-            vertList[i],
-            bIsSignalDistance)))
-        {
-            if (pfVertGeodesicDistance != pfTempGeodesicDistance)
-            {
-                delete[] pfTempGeodesicDistance;
-            }
-            return hr;
-        }
 
-        if (pfVertCombineDistance && bIsSignalDistance)
+        size_t dwNeighborNumber = 0;
+        for (size_t i = 0; i < m_dwVertNumber; i++)
         {
-            for (size_t j = 0; j < m_dwVertNumber; j++)
-            {
-                pCombineDistanceToOneLandmark[j] = m_pVerts[j].fSignalDistance;
-                pGeodesicDstanceToOneLandmark[j] = m_pVerts[j].fGeodesicDistance;
-            }
-            pCombineDistanceToOneLandmark += m_dwVertNumber;
-            pGeodesicDstanceToOneLandmark += m_dwVertNumber;
+            dwNeighborNumber += m_pVerts[i].edgeAdjacent.size();
         }
-        else
+        if (dwNeighborNumber >= UINT32_MAX)
         {
-            for (size_t j = 0; j < m_dwVertNumber; j++)
-            {
-                pGeodesicDstanceToOneLandmark[j] = m_pVerts[j].fGeodesicDistance;
-            }
-            pGeodesicDstanceToOneLandmark += m_dwVertNumber;
+            return HRESULT_E_ARITHMETIC_OVERFLOW;
         }
-    }
 
-    if (pfVertCombineDistance && bIsSignalDistance)
-    {
-        CombineGeodesicAndSignalDistance(
-            pfVertCombineDistance,
-            pfTempGeodesicDistance,
-            dwVertLandNumber);
-    }
+        pTopology->rowStart.resize(m_dwVertNumber + 1);
+        pTopology->neighbors.reserve(dwNeighborNumber);
+        std::vector<SHORTESTPATHNEIGHBOR> &neighbors = pTopology->neighbors;
 
-    for (size_t i = 0; i < dwVertLandNumber; i++)
-    {
-        for (size_t j = i; j < dwVertLandNumber; j++)
+        auto addNeighbor = [&](uint32_t dwAdjacentID, uint32_t dwEdgeID)
+            {
+                const ISOCHARTEDGE &edge = m_edges[dwEdgeID];
+                SHORTESTPATHNEIGHBOR neighbor;
+                neighbor.dwVertID = dwAdjacentID;
+                neighbor.fLength = edge.fLength;
+                neighbor.dwOppositVertID[0] = edge.dwOppositVertID[0];
+                neighbor.dwOppositVertID[1] = edge.dwOppositVertID[1];
+                neighbor.dwEdgeID = dwEdgeID;
+                neighbors.push_back(neighbor);
+            };
+
+        for (uint32_t i = 0; i < m_dwVertNumber; i++)
         {
-            uint32_t dwIndex1 = static_cast<uint32_t>(i * m_dwVertNumber + vertList[j]);
-            uint32_t dwIndex2 = static_cast<uint32_t>(j * m_dwVertNumber + vertList[i]);
-
-            if (pfVertCombineDistance && bIsSignalDistance)
+            const ISOCHARTVERTEX &vertex = m_pVerts[i];
+            size_t dwRowStart = neighbors.size();
+            pTopology->rowStart[i] = static_cast<uint32_t>(dwRowStart);
+
+            // Each vertAdjacent vertex must be reached by exactly one edge,
+            // and each edge must be used once.
+            bool bIsPaired = (vertex.edgeAdjacent.size() == vertex.vertAdjacent.size());
+            for (size_t j = 0; bIsPaired && j < vertex.vertAdjacent.size(); j++)
             {
-                pfVertCombineDistance[dwIndex1] = pfVertCombineDistance[dwIndex2] = std::min<float>(
-                    pfVertCombineDistance[dwIndex1],
-                    pfVertCombineDistance[dwIndex2]);
+                uint32_t dwAdjacentID = vertex.vertAdjacent[j];
+                uint32_t dwEdgeID = INVALID_INDEX;
+                for (size_t k = 0; k < vertex.edgeAdjacent.size(); k++)
+                {
+                    const ISOCHARTEDGE &edge = m_edges[vertex.edgeAdjacent[k]];
+                    uint32_t dwOtherID = (edge.dwVertexID[0] == i) ? edge.dwVertexID[1] : edge.dwVertexID[0];
+                    if (dwOtherID == dwAdjacentID)
+                    {
+                        bIsPaired = bIsPaired && (dwEdgeID == INVALID_INDEX);
+                        dwEdgeID = vertex.edgeAdjacent[k];
+                    }
+                }
+
+                bIsPaired = bIsPaired && (dwEdgeID != INVALID_INDEX);
+                for (size_t k = dwRowStart; bIsPaired && k < neighbors.size(); k++)
+                {
+                    bIsPaired = (neighbors[k].dwEdgeID != dwEdgeID);
+                }
+
+                if (bIsPaired)
+                {
+                    addNeighbor(dwAdjacentID, dwEdgeID);
+                }
             }
 
-            if (pfVertGeodesicDistance)
+            if (!bIsPaired)
             {
-                pfVertGeodesicDistance[dwIndex1] = pfVertGeodesicDistance[dwIndex2] = std::min<float>(
-                    pfVertGeodesicDistance[dwIndex1],
-                    pfVertGeodesicDistance[dwIndex2]);
+                neighbors.resize(dwRowStart);
+                for (size_t k = 0; k < vertex.edgeAdjacent.size(); k++)
+                {
+                    const ISOCHARTEDGE &edge = m_edges[vertex.edgeAdjacent[k]];
+                    uint32_t dwOtherID = (edge.dwVertexID[0] == i) ? edge.dwVertexID[1] : edge.dwVertexID[0];
+                    addNeighbor(dwOtherID, vertex.edgeAdjacent[k]);
+                }
             }
         }
-    }
+        pTopology->rowStart[m_dwVertNumber] = static_cast<uint32_t>(neighbors.size());
 
-    if (pfVertGeodesicDistance != pfTempGeodesicDistance)
+        m_pShortestPathTopology = std::move(pTopology);
+    }
+    catch (std::bad_alloc &)
     {
-        delete[] pfTempGeodesicDistance;
+        return E_OUTOFMEMORY;
     }
 
     return S_OK;
 }
 
-void CIsochartMesh::CombineGeodesicAndSignalDistance(
-    float *pfSignalDistance,
-    const float *pfGeodesicDistance,
-    size_t dwVertLandNumber) const
+// init structures used in CExactOneToAll or CApproximateOneToAll, from the
+// topology prepared by PrepareOneToAllTopology() or PrepareCoarseGeodesics()
+HRESULT CIsochartMesh::InitOneToAllEngine(
+    ONETOALLENGINE &oneToAllEngine,
+    const MeshTopology &topology) const
 {
-    assert(pfSignalDistance != nullptr);
-    assert(pfGeodesicDistance != nullptr);
-
-    float fAverageSignalDifference = 0;
-    float fAverageGeodesicDifference = 0;
-
-    size_t dwDistanceCount = dwVertLandNumber * m_dwVertNumber;
+    try
+    {
+        // In best effort mode, a run still going at the deadline is cut short,
+        // the KS98 distances stand in for the vertices it did not reach.
+        const CIsochartCancel &cancel = m_IsochartEngine.m_cancel;
+        oneToAllEngine.SetStopCheck([&cancel]() { return cancel.IsStopped() || cancel.IsOutOfTime(); });
 
-    for (size_t ii = 0; ii < dwDistanceCount; ii++)
+        oneToAllEngine.Init(topology);
+    }
+    catch (std::bad_alloc &)
     {
-        fAverageSignalDifference += pfSignalDistance[ii];
-        fAverageGeodesicDifference += pfGeodesicDistance[ii];
+        return E_OUTOFMEMORY;
     }
 
-    float fSignalWeight = SIGNAL_DISTANCE_WEIGHT;
+    return S_OK;
+}
 
-    fAverageSignalDifference /= float(dwDistanceCount);
-    fAverageGeodesicDifference /= float(dwDistanceCount);
+// Builds the factored operators of the heat method for this chart, if they are
+// not built yet. bIsAvailable is false when the chart is degenerate for the
+// heat method, other backends must be used then. Not thread safe, called
+// before the landmarks are split between workers, which only read them.
+HRESULT CIsochartMesh::PrepareHeatGeodesics(bool &bIsAvailable) const
+{
+    bIsAvailable = false;
+    if (m_bHeatGeodesicsFailed)
+    {
+        return S_OK;
+    }
+    if (m_pHeatGeodesics)
+    {
+        bIsAvailable = true;
+        return S_OK;
+    }
 
-    if (fAverageSignalDifference > ISOCHART_ZERO_EPS)
+    try
     {
-        float fRatio = fAverageGeodesicDifference / fAverageSignalDifference;
+        std::vector<DVector3> vertices(m_dwVertNumber);
+        for (size_t i = 0; i < m_dwVertNumber; ++i)
+        {
+            const XMFLOAT3 &position = m_baseInfo.pVertPosition[m_pVerts[i].dwIDInRootMesh];
+            vertices[i].x = double(position.x);
+            vertices[i].y = double(position.y);
+            vertices[i].z = double(position.z);
+        }
 
-        for (size_t ii = 0; ii < dwDistanceCount; ii++)
+        std::vector<uint32_t> indices(3 * m_dwFaceNumber);
+        for (size_t i = 0; i < m_dwFaceNumber; ++i)
+        {
+            indices[3 * i] = m_pFaces[i].dwVertexID[0];
+            indices[3 * i + 1] = m_pFaces[i].dwVertexID[1];
+            indices[3 * i + 2] = m_pFaces[i].dwVertexID[2];
+        }
+
+        std::unique_ptr<CHeatGeodesics> pHeatGeodesics(new (std::nothrow) CHeatGeodesics);
+        if (!pHeatGeodesics)
+        {
+            return E_OUTOFMEMORY;
+        }
+        if (!pHeatGeodesics->Init(vertices, indices.data(), m_dwFaceNumber))
         {
-            pfSignalDistance[ii] =
-                pfGeodesicDistance[ii] * (1 - fSignalWeight) + fRatio * pfSignalDistance[ii] * fSignalWeight;
+            m_bHeatGeodesicsFailed = true;
+            return S_OK;
         }
+        m_pHeatGeodesics = std::move(pHeatGeodesics);
     }
-    else
+    catch (std::bad_alloc &)
     {
-        memcpy(pfSignalDistance, pfGeodesicDistance, sizeof(float) * dwDistanceCount);
+        return E_OUTOFMEMORY;
     }
+
+    bIsAvailable = true;
+    return S_OK;
 }
 
-void CIsochartMesh::UpdateAdjacentVertexGeodistance(
-    ISOCHARTVERTEX *pCurrentVertex,
-    ISOCHARTVERTEX *pAdjacentVertex,
-    const ISOCHARTEDGE &edgeBetweenVertex,
-    bool *pbVertProcessed,
-    bool bIsSignalDistance) const
+// Builds the simplified level of this chart for GEODESIC_BACKEND_COARSE, if it
+// is not built yet. The chart is simplified by CProgressiveMesh, as for the
+// importance of its vertices, down to COARSE_GEODESIC_VERT_NUMBER vertices.
+// bIsAvailable is false when the level is not a manifold the one-to-all
+// engines can run on, other backends must be used then. Not thread safe,
+// called before the landmarks are split between workers, which only read it.
+HRESULT CIsochartMesh::PrepareCoarseGeodesics(bool &bIsAvailable) const
 {
-    assert(pCurrentVertex != nullptr);
-    assert(pAdjacentVertex != nullptr);
-    assert(pbVertProcessed != nullptr);
+    bIsAvailable = false;
+    if (m_bCoarseGeodesicsFailed)
+    {
+        return S_OK;
+    }
+    if (m_pCoarseGeodesics)
+    {
+        bIsAvailable = true;
+        return S_OK;
+    }
+
+    std::unique_ptr<COARSEGEODESICLEVEL> pCoarse(new (std::nothrow) COARSEGEODESICLEVEL);
+    if (!pCoarse)
+    {
+        return E_OUTOFMEMORY;
+    }
 
-    if (pAdjacentVertex->fGeodesicDistance > (pCurrentVertex->fGeodesicDistance + edgeBetweenVertex.fLength))
+    // 1. Simplify the chart, without reporting progress, this may run on a
+    // worker of the partition.
+    std::vector<uint32_t> faceVerts;
     {
-        pAdjacentVertex->fGeodesicDistance =
-            (pCurrentVertex->fGeodesicDistance + edgeBetweenVertex.fLength);
+        CProgressiveMesh progressiveMesh(m_baseInfo, m_callbackSchemer);
 
-        if (bIsSignalDistance)
+        HRESULT hr = progressiveMesh.Initialize(*this, false);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+        hr = progressiveMesh.Simplify(COARSE_GEODESIC_VERT_NUMBER);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+        hr = progressiveMesh.ExportSimplifiedMesh(pCoarse->coarseVerts, faceVerts);
+        if (FAILED(hr))
         {
-            pAdjacentVertex->fSignalDistance =
-                pCurrentVertex->fSignalDistance + edgeBetweenVertex.fSignalLength;
+            return hr;
         }
     }
 
-    for (size_t k = 0; k < 2; k++)
+    try
     {
-        if (edgeBetweenVertex.dwOppositVertID[k] == INVALID_VERT_ID)
+        const size_t dwCoarseVertNumber = pCoarse->coarseVerts.size();
+        const size_t dwCoarseFaceNumber = faceVerts.size() / 3;
+        MeshTopology &topology = pCoarse->topology;
+
+        // 2. The coarse vertices keep the positions of the chart vertices
+        pCoarse->fineToCoarse.assign(m_dwVertNumber, INVALID_VERT_ID);
+        topology.vertexPositions.resize(dwCoarseVertNumber);
+        topology.vertexBoundary.assign(dwCoarseVertNumber, 0);
+        for (size_t i = 0; i < dwCoarseVertNumber; ++i)
         {
-            assert(k == 1);
-            break;
-        }
+            const uint32_t dwVertID = pCoarse->coarseVerts[i];
+            pCoarse->fineToCoarse[dwVertID] = static_cast<uint32_t>(i);
 
-        assert(!(k == 1 && edgeBetweenVertex.bIsBoundary));
+            const XMFLOAT3 &position = m_baseInfo.pVertPosition[m_pVerts[dwVertID].dwIDInRootMesh];
+            topology.vertexPositions[i].x = double(position.x);
+            topology.vertexPositions[i].y = double(position.y);
+            topology.vertexPositions[i].z = double(position.z);
+        }
 
-        ISOCHARTVERTEX *pOppositeVertex = m_pVerts + edgeBetweenVertex.dwOppositVertID[k];
+        // 3. Find the edges of the coarse faces by sorting their sides by
+        // vertices. A side shared by more than 2 faces, or a degenerated face,
+        // makes a level the engines can't run on.
+        std::vector<std::pair<uint64_t, uint32_t>> sides(3 * dwCoarseFaceNumber);
+        for (size_t i = 0; i < dwCoarseFaceNumber; ++i)
+        {
+            for (size_t j = 0; j < 3; ++j)
+            {
+                uint32_t v1 = faceVerts[3 * i + j];
+                uint32_t v2 = faceVerts[3 * i + (j + 1) % 3];
+                if (v1 == v2)
+                {
+                    m_bCoarseGeodesicsFailed = true;
+                    return S_OK;
+                }
+                if (v1 > v2)
+                {
+                    std::swap(v1, v2);
+                }
+                sides[3 * i + j] = std::make_pair((uint64_t(v1) << 32) | v2, static_cast<uint32_t>(3 * i + j));
+            }
+        }
+        std::sort(sides.begin(), sides.end());
 
-        if (pbVertProcessed[pOppositeVertex->dwID])
+        topology.faceVertices.swap(faceVerts);
+        topology.faceEdges.resize(3 * dwCoarseFaceNumber);
+        topology.edgeVertices.clear();
+        topology.edgeFaces.clear();
+        for (size_t i = 0; i < sides.size();)
         {
-            if (pOppositeVertex->fGeodesicDistance >
-                pCurrentVertex->fGeodesicDistance)
+            size_t dwSideCount = 1;
+            while (i + dwSideCount < sides.size() && sides[i + dwSideCount].first == sides[i].first)
             {
-                CalculateGeodesicDistanceABC(
-                    pCurrentVertex,
-                    pOppositeVertex,
-                    pAdjacentVertex);
+                dwSideCount++;
             }
-            else
+            if (dwSideCount > 2)
             {
-                CalculateGeodesicDistanceABC(
-                    pOppositeVertex,
-                    pCurrentVertex,
-                    pAdjacentVertex);
+                m_bCoarseGeodesicsFailed = true;
+                return S_OK;
             }
-        }
-    }
-}
-
-HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertex(
-    uint32_t dwSourceVertID,
-    bool bIsSignalDistance,
-    uint32_t *pdwFarestPeerVertID) const
-{
-    HRESULT hr =
-        CalculateGeodesicDistanceToVertexKS98(dwSourceVertID, bIsSignalDistance, pdwFarestPeerVertID);
-    if (FAILED(hr))
-        return hr;
 
-    if (
-        (
-            // if the geodesic algorithm selection field of the isochart option is DEFAULT, check whether suitable to apply the new algorithm
-            (
-                (
-                    (m_IsochartEngine.m_dwOptions & OPTIONMASK_ISOCHART_GEODESIC) ==
-                    (ISOCHARTOPTION::DEFAULT & OPTIONMASK_ISOCHART_GEODESIC)) &&
-                (m_baseInfo.dwFaceCount < LIMIT_FACENUM_USENEWGEODIST)) ||
+            const uint32_t dwEdgeID = static_cast<uint32_t>(topology.edgeVertices.size() / 2);
+            const uint32_t v1 = static_cast<uint32_t>(sides[i].first >> 32);
+            const uint32_t v2 = static_cast<uint32_t>(sides[i].first & 0xffffffff);
+            topology.edgeVertices.push_back(v1);
+            topology.edgeVertices.push_back(v2);
+            topology.edgeFaces.push_back(sides[i].second / 3);
+            if (dwSideCount == 2)
+            {
+                topology.edgeFaces.push_back(sides[i + 1].second / 3);
+            }
+            else
+            {
+                topology.edgeFaces.push_back(FLAG_INVALIDDWORD);
+                topology.vertexBoundary[v1] = 1;
+                topology.vertexBoundary[v2] = 1;
+            }
 
-            // or the user forces to use the new algorithm
-            (
-                m_IsochartEngine.m_dwOptions & ISOCHARTOPTION::GEODESIC_QUALITY)) &&
+            for (size_t k = 0; k < dwSideCount; ++k)
+            {
+                topology.faceEdges[sides[i + k].second] = dwEdgeID;
+            }
+            i += dwSideCount;
+        }
 
-        // anyway, if IMT is specified, use the old geodesic distance algorithm, because currently the new geodesic distance algorithm does not support IMT
-        (
-            !bIsSignalDistance &&
-            m_dwVertNumber > 0 &&
-            m_dwFaceNumber > 0))
+        topology.Build();
+    }
+    catch (std::bad_alloc &)
     {
-        hr = const_cast<CIsochartMesh *>(this)->CalculateGeodesicDistanceToVertexNewGeoDist(dwSourceVertID, pdwFarestPeerVertID);
+        return E_OUTOFMEMORY;
     }
 
-    return hr;
+    m_pCoarseGeodesics = std::move(pCoarse);
+    bIsAvailable = true;
+    return S_OK;
 }
 
-HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertexNewGeoDist(
-    uint32_t dwSourceVertID,
-    uint32_t *pdwFarestPeerVertID)
+void CIsochartMesh::ReleaseGeodesicCache() const noexcept
 {
-    try
-    {
-        ONE_TO_ALL_ENGINE.SetSrcVertexIdx(dwSourceVertID);
-        ONE_TO_ALL_ENGINE.Run();
-    }
-    catch (std::bad_alloc &)
+    m_pHeatGeodesics.reset();
+    m_bHeatGeodesicsFailed = false;
+    m_oneToAllEngines.clear();
+    m_pOneToAllTopology.reset();
+    m_pCoarseGeodesics.reset();
+    m_bCoarseGeodesicsFailed = false;
+    m_pShortestPathTopology.reset();
+}
+
+HRESULT CGeodesicQueryTracker::Init(const GEODESICQUERYBOUND *pBound, size_t dwVertNumber)
+{
+    m_fMaxDistance = FLT_MAX;
+    m_dwTargetsLeft = 0;
+    if (!pBound)
     {
-        return E_OUTOFMEMORY;
+        return S_OK;
     }
 
-    uint32_t dwFarestVertID = 0;
-    double dGeoFarest = 0.0;
-    for (uint32_t i = 0; i < m_dwVertNumber; ++i)
+    m_fMaxDistance = pBound->fMaxDistance;
+    if (pBound->dwTargetCount > 0)
     {
-        m_pVerts[i].fGeodesicDistance = m_pVerts[i].fSignalDistance =
-            std::min(m_pVerts[i].fGeodesicDistance,
-                float(ONE_TO_ALL_ENGINE.m_VertexList[i].dGeoDistanceToSrc));
-
-        if (double(m_pVerts[i].fGeodesicDistance) > dGeoFarest)
+        m_isTarget.reset(new (std::nothrow) bool[dwVertNumber]);
+        if (!m_isTarget)
         {
-            dGeoFarest = double(m_pVerts[i].fGeodesicDistance);
-            dwFarestVertID = i;
+            return E_OUTOFMEMORY;
         }
-    }
+        memset(m_isTarget.get(), 0, sizeof(bool) * dwVertNumber);
 
-    if (pdwFarestPeerVertID)
-    {
-        *pdwFarestPeerVertID = dwFarestVertID;
+        for (size_t i = 0; i < pBound->dwTargetVertNumber; i++)
+        {
+            m_isTarget[pBound->pdwTargetVerts[i]] = true;
+        }
+        m_dwTargetsLeft = pBound->dwTargetCount;
     }
 
     return S_OK;
 }
 
-// See more detail in [KS98]
-HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertexKS98(
-    uint32_t dwSourceVertID,
-    bool bIsSignalDistance,
-    uint32_t *pdwFarestPeerVertID) const
+// Selects the algorithm computing the geodesic distances from dwSourceCount
+// sources of this chart.
+GEODESICBACKEND CIsochartMesh::SelectGeodesicBackend(
+    size_t dwSourceCount,
+    bool bIsSignalDistance) const
 {
-    uint32_t dwFarestVertID = 0;
-
-    std::unique_ptr<bool[]> pbVertProcessed(new (std::nothrow) bool[m_dwVertNumber]);
-    std::unique_ptr<CMaxHeapItem<float, uint32_t>[]> heapItem(new (std::nothrow) CMaxHeapItem<float, uint32_t>[m_dwVertNumber]);
-    if (!pbVertProcessed || !heapItem)
+    // if IMT is specified, use the old geodesic distance algorithm, because currently the new geodesic distance algorithm does not support IMT
+    if (bIsSignalDistance || m_dwVertNumber == 0 || m_dwFaceNumber == 0)
     {
-        return E_OUTOFMEMORY;
+        return GEODESIC_BACKEND_KS98;
     }
-    memset(pbVertProcessed.get(), 0, sizeof(bool) * m_dwVertNumber);
 
-    CMaxHeap<float, uint32_t> heap;
-    if (!heap.resize(m_dwVertNumber))
+    switch (m_IsochartEngine.m_dwOptions & OPTIONMASK_ISOCHART_GEODESIC)
     {
-        return E_OUTOFMEMORY;
-    }
-
-    auto pHeapItem = heapItem.get();
+    case ISOCHARTOPTION::GEODESIC_QUALITY:
+        return GEODESIC_BACKEND_EXACT;
 
-    // 1. Init the distance to source of each vertex
-    ISOCHARTVERTEX *pCurrentVertex = m_pVerts;
-    for (size_t i = 0; i < m_dwVertNumber; i++)
+    case ISOCHARTOPTION::GEODESIC_ADAPTIVE:
     {
-        pCurrentVertex->fGeodesicDistance = FLT_MAX;
-        pCurrentVertex->fSignalDistance = FLT_MAX;
-        pCurrentVertex++;
+        const double dFaceCount = double(m_dwFaceNumber);
+        const double dCost = double(dwSourceCount) * dFaceCount * sqrt(dFaceCount);
+        return (dCost <= ADAPTIVE_NEWGEODIST_COST_BUDGET) ? GEODESIC_BACKEND_EXACT : GEODESIC_BACKEND_KS98;
     }
 
-    // 2. Init the source vertices
-    pCurrentVertex = m_pVerts + dwSourceVertID;
-    pbVertProcessed[dwSourceVertID] = true;
-    pCurrentVertex->fGeodesicDistance = 0;
-    pCurrentVertex->fSignalDistance = 0;
+    case ISOCHARTOPTION::GEODESIC_HEAT:
+        return (m_dwVertNumber >= HEAT_MIN_VERTICES) ? GEODESIC_BACKEND_HEAT : GEODESIC_BACKEND_EXACT;
 
-    // 3. Init heap to prepare process of iteration.
-    pHeapItem[dwSourceVertID].m_data = dwSourceVertID;
-    pHeapItem[dwSourceVertID].m_weight = 0;
+    case ISOCHARTOPTION::GEODESIC_COARSE:
+        return (m_dwFaceNumber < LIMIT_FACENUM_USENEWGEODIST || m_dwVertNumber <= COARSE_GEODESIC_VERT_NUMBER) ? GEODESIC_BACKEND_EXACT : GEODESIC_BACKEND_COARSE;
 
-    if (!heap.insert(pHeapItem + dwSourceVertID))
-    {
-        return E_OUTOFMEMORY;
-    }
+    case ISOCHARTOPTION::DEFAULT:
+        return (m_baseInfo.dwFaceCount < LIMIT_FACENUM_USENEWGEODIST) ? GEODESIC_BACKEND_EXACT : GEODESIC_BACKEND_KS98;
 
-    dwFarestVertID = dwSourceVertID;
+    default:
+        return GEODESIC_BACKEND_KS98;
+    }
+}
 
-    // 4. Dijkstra algorithm to compute geodesic distance from source
-    // to other vertices.
-    for (size_t i = 0; i < m_dwVertNumber; i++)
+// For each vertex in landmark list, compute geodesic distance from
+// this vertex to all other vertices in the same chart.
+//
+// The landmarks are independent: each one writes its own row of the results,
+// so they are computed concurrently, on the workers of the partition when
+// called from a chart task. Each worker has its own one-to-all engine.
+// pBound limits the distances needed from each landmark.
+// With bRawDistance, the rows are returned as computed: the signal distance
+// is not combined with the geodesic one, and the distances between the
+// landmarks are not made symmetric.
+HRESULT CIsochartMesh::CalculateGeodesicDistance(
+    std::vector<uint32_t> &vertList,
+    float *pfVertCombineDistance,
+    float *pfVertGeodesicDistance,
+    const GEODESICQUERYBOUND *pBound,
+    bool bRawDistance) const
+{
+    if (vertList.empty())
     {
-        CMaxHeapItem<float, uint32_t> *pTop;
-        pTop = heap.cutTop();
-        if (!pTop)
+        return S_OK;
+    }
+    assert(!(!pfVertGeodesicDistance && !pfVertCombineDistance));
+
+    HRESULT hr = S_OK;
+    size_t dwVertLandNumber = static_cast<size_t>(vertList.size());
+    bool bIsSignalDistance = IsIMTSpecified();
+    GEODESICBACKEND backend = SelectGeodesicBackend(dwVertLandNumber, bIsSignalDistance);
+
+    if (backend == GEODESIC_BACKEND_HEAT)
+    {
+        bool bIsAvailable = false;
+        HRESULT hrHeat = PrepareHeatGeodesics(bIsAvailable);
+        if (FAILED(hrHeat))
+        {
+            return hrHeat;
+        }
+        if (!bIsAvailable)
+        {
+            backend = GEODESIC_BACKEND_KS98;
+        }
+    }
+    else if (backend == GEODESIC_BACKEND_COARSE)
+    {
+        bool bIsAvailable = false;
+        hr = PrepareCoarseGeodesics(bIsAvailable);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+        if (!bIsAvailable)
+        {
+            backend = GEODESIC_BACKEND_KS98;
+        }
+    }
+    else if (backend == GEODESIC_BACKEND_EXACT)
+    {
+        hr = PrepareOneToAllTopology();
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+    }
+
+    // [KS98] also corrects the other backends but the heat method, build its
+    // adjacency before the workers share it.
+    if (backend != GEODESIC_BACKEND_HEAT)
+    {
+        hr = PrepareShortestPathTopology();
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+    }
+
+    float *pfTempGeodesicDistance = nullptr;
+    if (!pfVertGeodesicDistance)
+    {
+        pfTempGeodesicDistance = new (std::nothrow) float[dwVertLandNumber * m_dwVertNumber];
+        if (!pfTempGeodesicDistance)
+        {
+            return E_OUTOFMEMORY;
+        }
+    }
+    else
+    {
+        pfTempGeodesicDistance = pfVertGeodesicDistance;
+    }
+
+    const DirectX::UVAtlasExecutor *pExecutor = &m_IsochartEngine.m_executor;
+    size_t dwWorkerCount = 1;
+    size_t dwGrain = dwVertLandNumber;
+    if (dwVertLandNumber > 1 && dwVertLandNumber * m_dwVertNumber >= PARALLEL_GEODESIC_MIN_WORK)
+    {
+        dwWorkerCount = CTaskScheduler::GetNestedWorkerCount(pExecutor);
+        dwGrain = 1;
+    }
+
+    std::unique_ptr<GEODESICWORKSPACE[]> workspaces(new (std::nothrow) GEODESICWORKSPACE[dwWorkerCount]);
+    if (!workspaces)
+    {
+        if (pfVertGeodesicDistance != pfTempGeodesicDistance)
+        {
+            delete[] pfTempGeodesicDistance;
+        }
+        return E_OUTOFMEMORY;
+    }
+
+    // The engines built by earlier calls on the chart only need their
+    // per-source state reset
+    for (size_t i = 0; i < dwWorkerCount && !m_oneToAllEngines.empty(); i++)
+    {
+        workspaces[i].pOneToAllEngine = std::move(m_oneToAllEngines.back());
+        m_oneToAllEngines.pop_back();
+    }
+
+    auto calculateLandmarks = [&](size_t dwBegin, size_t dwEnd, size_t dwWorker) -> HRESULT
+        {
+            GEODESICWORKSPACE &workspace = workspaces[dwWorker];
+            for (size_t i = dwBegin; i < dwEnd; i++)
+            {
+                float *pfSignalDistance = nullptr;
+                if (bIsSignalDistance)
+                {
+                    if (pfVertCombineDistance)
+                    {
+                        pfSignalDistance = pfVertCombineDistance + i * m_dwVertNumber;
+                    }
+                    else
+                    {
+                        if (!workspace.pfSignalDistance)
+                        {
+                            workspace.pfSignalDistance.reset(new (std::nothrow) float[m_dwVertNumber]);
+                            if (!workspace.pfSignalDistance)
+                            {
+                                return E_OUTOFMEMORY;
+                            }
+                        }
+                        pfSignalDistance = workspace.pfSignalDistance.get();
+                    }
+                }
+
+                HRESULT hrLandmark = CalculateGeodesicDistanceToVertex(
+                    vertList[i],
+                    backend,
+                    bIsSignalDistance,
+                    workspace,
+                    pfTempGeodesicDistance + i * m_dwVertNumber,
+                    pfSignalDistance,
+                    nullptr,
+                    pBound);
+                if (FAILED(hrLandmark))
+                {
+                    return hrLandmark;
+                }
+            }
+            return S_OK;
+        };
+
+    if (dwWorkerCount > 1)
+    {
+        hr = CTaskScheduler::NestedParallelFor(dwVertLandNumber, dwGrain, calculateLandmarks, pExecutor);
+    }
+    else
+    {
+        hr = calculateLandmarks(0, dwVertLandNumber, 0);
+    }
+
+    try
+    {
+        for (size_t i = 0; i < dwWorkerCount; i++)
+        {
+            if (workspaces[i].pOneToAllEngine)
+            {
+                m_oneToAllEngines.push_back(std::move(workspaces[i].pOneToAllEngine));
+            }
+        }
+    }
+    catch (std::bad_alloc &)
+    {
+        // the engines are only rebuilt by the next call
+    }
+
+    if (FAILED(hr))
+    {
+        if (pfVertGeodesicDistance != pfTempGeodesicDistance)
+        {
+            delete[] pfTempGeodesicDistance;
+        }
+        return hr;
+    }
+
+    if (bRawDistance)
+    {
+        assert(pfVertGeodesicDistance == pfTempGeodesicDistance);
+        return S_OK;
+    }
+
+    if (pfVertCombineDistance && bIsSignalDistance)
+    {
+        CombineGeodesicAndSignalDistance(
+            pfVertCombineDistance,
+            pfTempGeodesicDistance,
+            dwVertLandNumber);
+    }
+
+    for (size_t i = 0; i < dwVertLandNumber; i++)
+    {
+        for (size_t j = i; j < dwVertLandNumber; j++)
+        {
+            uint32_t dwIndex1 = static_cast<uint32_t>(i * m_dwVertNumber + vertList[j]);
+            uint32_t dwIndex2 = static_cast<uint32_t>(j * m_dwVertNumber + vertList[i]);
+
+            if (pfVertCombineDistance && bIsSignalDistance)
+            {
+                pfVertCombineDistance[dwIndex1] = pfVertCombineDistance[dwIndex2] = std::min<float>(
+                    pfVertCombineDistance[dwIndex1],
+                    pfVertCombineDistance[dwIndex2]);
+            }
+
+            if (pfVertGeodesicDistance)
+            {
+                pfVertGeodesicDistance[dwIndex1] = pfVertGeodesicDistance[dwIndex2] = std::min<float>(
+                    pfVertGeodesicDistance[dwIndex1],
+                    pfVertGeodesicDistance[dwIndex2]);
+            }
+        }
+    }
+
+    if (pfVertGeodesicDistance != pfTempGeodesicDistance)
+    {
+        delete[] pfTempGeodesicDistance;
+    }
+
+    return S_OK;
+}
+
+namespace
+{
+    // Adds dwDistanceCount signal and geodesic distances to the sums averaged
+    // to scale the signal distance. The sums are kept in float and added in
+    // order, so rows added in several calls give the same sums as in one.
+    void AddSignalScaleSums(
+        const float *pfSignalDistance,
+        const float *pfGeodesicDistance,
+        size_t dwDistanceCount,
+        float &fSignalSum,
+        float &fGeodesicSum)
+    {
+        for (size_t ii = 0; ii < dwDistanceCount; ii++)
+        {
+            fSignalSum += pfSignalDistance[ii];
+            fGeodesicSum += pfGeodesicDistance[ii];
+        }
+    }
+
+    // The ratio of the average geodesic distance to the average signal
+    // distance. Returns false when the signal distance is too small to be
+    // scaled, the combined distance is then the geodesic one.
+    bool GetSignalScaleRatio(
+        float fSignalSum,
+        float fGeodesicSum,
+        size_t dwDistanceCount,
+        float &fRatio)
+    {
+        float fAverageSignalDifference = fSignalSum / float(dwDistanceCount);
+        float fAverageGeodesicDifference = fGeodesicSum / float(dwDistanceCount);
+
+        fRatio = 0;
+        if (fAverageSignalDifference > ISOCHART_ZERO_EPS)
+        {
+            fRatio = fAverageGeodesicDifference / fAverageSignalDifference;
+            return true;
+        }
+        return false;
+    }
+
+    // Replaces the signal distances by their combination with the geodesic
+    // ones, see [Kun04], 6 section.
+    void ApplySignalScale(
+        float *pfSignalDistance,
+        const float *pfGeodesicDistance,
+        size_t dwDistanceCount,
+        bool bIsScaled,
+        float fRatio)
+    {
+        float fSignalWeight = SIGNAL_DISTANCE_WEIGHT;
+
+        if (bIsScaled)
+        {
+            for (size_t ii = 0; ii < dwDistanceCount; ii++)
+            {
+                pfSignalDistance[ii] =
+                    pfGeodesicDistance[ii] * (1 - fSignalWeight) + fRatio * pfSignalDistance[ii] * fSignalWeight;
+            }
+        }
+        else
+        {
+            memcpy(pfSignalDistance, pfGeodesicDistance, sizeof(float) * dwDistanceCount);
+        }
+    }
+}
+
+void CIsochartMesh::CombineGeodesicAndSignalDistance(
+    float *pfSignalDistance,
+    const float *pfGeodesicDistance,
+    size_t dwVertLandNumber) const
+{
+    assert(pfSignalDistance != nullptr);
+    assert(pfGeodesicDistance != nullptr);
+
+    size_t dwDistanceCount = dwVertLandNumber * m_dwVertNumber;
+
+    float fSignalSum = 0;
+    float fGeodesicSum = 0;
+    AddSignalScaleSums(pfSignalDistance, pfGeodesicDistance, dwDistanceCount, fSignalSum, fGeodesicSum);
+
+    float fRatio = 0;
+    bool bIsScaled = GetSignalScaleRatio(fSignalSum, fGeodesicSum, dwDistanceCount, fRatio);
+
+    ApplySignalScale(pfSignalDistance, pfGeodesicDistance, dwDistanceCount, bIsScaled, fRatio);
+}
+
+// Relaxes the distance of the neighbor of dwCurrentID through their edge, then
+// through the triangles of the edge whose opposite vertex is processed, see
+// CalculateGeodesicDistanceABC.
+void CIsochartMesh::UpdateAdjacentVertexGeodistance(
+    uint32_t dwCurrentID,
+    const SHORTESTPATHNEIGHBOR &neighbor,
+    const bool *pbVertProcessed,
+    float *pfGeodesicDistance,
+    float *pfSignalDistance) const
+{
+    uint32_t dwAdjacentID = neighbor.dwVertID;
+    if (pfGeodesicDistance[dwAdjacentID] > (pfGeodesicDistance[dwCurrentID] + neighbor.fLength))
+    {
+        pfGeodesicDistance[dwAdjacentID] =
+            (pfGeodesicDistance[dwCurrentID] + neighbor.fLength);
+
+        if (pfSignalDistance)
+        {
+            pfSignalDistance[dwAdjacentID] =
+                pfSignalDistance[dwCurrentID] + m_edges[neighbor.dwEdgeID].fSignalLength;
+        }
+    }
+
+    for (size_t k = 0; k < 2; k++)
+    {
+        uint32_t dwOppositeID = neighbor.dwOppositVertID[k];
+        if (dwOppositeID == INVALID_VERT_ID)
+        {
+            assert(k == 1);
+            break;
+        }
+
+        if (pbVertProcessed[dwOppositeID])
+        {
+            if (pfGeodesicDistance[dwOppositeID] >
+                pfGeodesicDistance[dwCurrentID])
+            {
+                CalculateGeodesicDistanceABC(
+                    m_pVerts + dwCurrentID,
+                    m_pVerts + dwOppositeID,
+                    m_pVerts + dwAdjacentID,
+                    pfGeodesicDistance);
+            }
+            else
+            {
+                CalculateGeodesicDistanceABC(
+                    m_pVerts + dwOppositeID,
+                    m_pVerts + dwCurrentID,
+                    m_pVerts + dwAdjacentID,
+                    pfGeodesicDistance);
+            }
+        }
+    }
+}
+
+// Computes the distances from one source into the given rows, which must hold
+// m_dwVertNumber values, running only the selected backend. pfSignalDistance
+// is only written for signal distances, which need GEODESIC_BACKEND_KS98.
+// The workspace belongs to the calling worker.
+HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertex(
+    uint32_t dwSourceVertID,
+    GEODESICBACKEND backend,
+    bool bIsSignalDistance,
+    GEODESICWORKSPACE &workspace,
+    float *pfGeodesicDistance,
+    float *pfSignalDistance,
+    uint32_t *pdwFarestPeerVertID,
+    const GEODESICQUERYBOUND *pBound) const
+{
+    assert(pfGeodesicDistance != nullptr);
+    assert(!bIsSignalDistance || pfSignalDistance != nullptr);
+    assert(!bIsSignalDistance || backend == GEODESIC_BACKEND_KS98);
+
+    HRESULT hr = m_IsochartEngine.m_cancel.Check();
+    if (FAILED(hr))
+        return hr;
+
+    // Each source is long on large charts, report between them in the
+    // parallel partition.
+    hr = m_callbackSchemer.PollParallelWork();
+    if (FAILED(hr))
+        return hr;
+
+    // a best effort call out of time falls back to the fast algorithm
+    if (backend == GEODESIC_BACKEND_EXACT && !m_IsochartEngine.m_cancel.IsOutOfTime())
+    {
+        if (!workspace.pOneToAllEngine)
+        {
+            workspace.pOneToAllEngine.reset(new (std::nothrow) ONETOALLENGINE);
+            if (!workspace.pOneToAllEngine)
+            {
+                return E_OUTOFMEMORY;
+            }
+            hr = InitOneToAllEngine(*workspace.pOneToAllEngine, *m_pOneToAllTopology);
+            if (FAILED(hr))
+            {
+                workspace.pOneToAllEngine.reset();
+                return hr;
+            }
+        }
+
+        hr = CalculateGeodesicDistanceToVertexNewGeoDist(
+            dwSourceVertID,
+            *workspace.pOneToAllEngine,
+            pfGeodesicDistance,
+            pdwFarestPeerVertID,
+            pBound);
+    }
+    else if (backend == GEODESIC_BACKEND_HEAT)
+    {
+        hr = CalculateGeodesicDistanceToVertexHeat(
+            dwSourceVertID,
+            workspace.heat,
+            pfGeodesicDistance,
+            pdwFarestPeerVertID);
+    }
+    else if (backend == GEODESIC_BACKEND_COARSE)
+    {
+        hr = CalculateGeodesicDistanceToVertexCoarse(
+            dwSourceVertID,
+            workspace,
+            pfGeodesicDistance,
+            pdwFarestPeerVertID,
+            pBound);
+    }
+    else
+    {
+        hr = CalculateGeodesicDistanceToVertexKS98(
+            dwSourceVertID,
+            pfGeodesicDistance,
+            bIsSignalDistance ? pfSignalDistance : nullptr,
+            pdwFarestPeerVertID,
+            pBound);
+    }
+
+    return hr;
+}
+
+// See more detail in [CWW13]. The operators are prepared by
+// CalculateGeodesicDistance().
+HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertexHeat(
+    uint32_t dwSourceVertID,
+    CHeatGeodesics::Workspace &workspace,
+    float *pfGeodesicDistance,
+    uint32_t *pdwFarestPeerVertID) const
+{
+    assert(m_pHeatGeodesics != nullptr);
+    assert(m_pHeatGeodesics->GetVertexNumber() == m_dwVertNumber);
+
+    m_IsochartEngine.m_stats.dwHeatRuns++;
+
+    try
+    {
+        m_pHeatGeodesics->Run(dwSourceVertID, workspace);
+    }
+    catch (std::bad_alloc &)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    uint32_t dwFarestVertID = 0;
+    float fGeoFarest = 0.0f;
+    for (uint32_t i = 0; i < m_dwVertNumber; ++i)
+    {
+        pfGeodesicDistance[i] = float(workspace.vdDistance[i]);
+        if (pfGeodesicDistance[i] > fGeoFarest)
+        {
+            fGeoFarest = pfGeodesicDistance[i];
+            dwFarestVertID = i;
+        }
+    }
+
+    if (pdwFarestPeerVertID)
+    {
+        *pdwFarestPeerVertID = dwFarestVertID;
+    }
+
+    return S_OK;
+}
+
+HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertexNewGeoDist(
+    uint32_t dwSourceVertID,
+    ONETOALLENGINE &oneToAllEngine,
+    float *pfGeodesicDistance,
+    uint32_t *pdwFarestPeerVertID,
+    const GEODESICQUERYBOUND *pBound) const
+{
+    m_IsochartEngine.m_stats.dwExactRuns++;
+
+    if (pBound)
+    {
+        oneToAllEngine.SetBound(
+            pBound->fMaxDistance == FLT_MAX ? DBL_MAX : double(pBound->fMaxDistance),
+            pBound->pdwTargetVerts,
+            pBound->dwTargetVertNumber,
+            pBound->dwTargetCount);
+    }
+    else
+    {
+        oneToAllEngine.SetBound(DBL_MAX, nullptr, 0, 0);
+    }
+
+    try
+    {
+        oneToAllEngine.SetSrcVertexIdx(dwSourceVertID);
+        oneToAllEngine.Run();
+    }
+    catch (std::bad_alloc &)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    // The run stops early when the call is cancelled, its distances are not
+    // complete.
+    HRESULT hr = m_IsochartEngine.m_cancel.Check();
+    if (FAILED(hr))
+        return hr;
+
+    // A run cut short at the deadline of a best effort call leaves vertices
+    // unreached, the [KS98] distances stand in for them. A bounded run leaves
+    // vertices unreached anyway.
+    bool bAllReached = true;
+    if (pBound)
+    {
+        bAllReached = !m_IsochartEngine.m_cancel.IsOutOfTime();
+    }
+    else
+    {
+        for (uint32_t i = 0; i < m_dwVertNumber; ++i)
+        {
+            if (oneToAllEngine.m_VertexList[i].dGeoDistanceToSrc == DBL_MAX)
+            {
+                bAllReached = false;
+                break;
+            }
+        }
+    }
+
+    if (bAllReached)
+    {
+        for (uint32_t i = 0; i < m_dwVertNumber; ++i)
+        {
+            const double dDistance = oneToAllEngine.m_VertexList[i].dGeoDistanceToSrc;
+            pfGeodesicDistance[i] = dDistance == DBL_MAX ? FLT_MAX : float(dDistance);
+        }
+    }
+    else
+    {
+        hr = CalculateGeodesicDistanceToVertexKS98(
+            dwSourceVertID,
+            pfGeodesicDistance,
+            nullptr,
+            nullptr,
+            pBound);
+        if (FAILED(hr))
+            return hr;
+
+        for (uint32_t i = 0; i < m_dwVertNumber; ++i)
+        {
+            pfGeodesicDistance[i] =
+                std::min(pfGeodesicDistance[i],
+                    float(oneToAllEngine.m_VertexList[i].dGeoDistanceToSrc));
+        }
+    }
+
+    uint32_t dwFarestVertID = 0;
+    double dGeoFarest = 0.0;
+    for (uint32_t i = 0; i < m_dwVertNumber; ++i)
+    {
+        if (double(pfGeodesicDistance[i]) > dGeoFarest)
+        {
+            dGeoFarest = double(pfGeodesicDistance[i]);
+            dwFarestVertID = i;
+        }
+    }
+
+    if (pdwFarestPeerVertID)
+    {
+        *pdwFarestPeerVertID = dwFarestVertID;
+    }
+
+    return S_OK;
+}
+
+// Computes the distances from one source on the coarse level prepared by
+// PrepareCoarseGeodesics(), then prolongs them to the chart: the coarse
+// vertices are seeds at their coarse distances, and a [KS98] propagation from
+// the source and the seeds corrects the distances of all the chart vertices.
+// A source collapsed by the simplification starts the coarse run from its
+// nearest coarse vertex, offset by the distance to it. pBound only applies to
+// the correction.
+HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertexCoarse(
+    uint32_t dwSourceVertID,
+    GEODESICWORKSPACE &workspace,
+    float *pfGeodesicDistance,
+    uint32_t *pdwFarestPeerVertID,
+    const GEODESICQUERYBOUND *pBound) const
+{
+    assert(m_pCoarseGeodesics != nullptr);
+
+    m_IsochartEngine.m_stats.dwCoarseRuns++;
+
+    const COARSEGEODESICLEVEL &coarse = *m_pCoarseGeodesics;
+    const size_t dwCoarseVertNumber = coarse.coarseVerts.size();
+    HRESULT hr = S_OK;
+
+    if (!workspace.pCoarseEngine)
+    {
+        workspace.pCoarseEngine.reset(new (std::nothrow) ONETOALLENGINE);
+        if (!workspace.pCoarseEngine)
+        {
+            return E_OUTOFMEMORY;
+        }
+        hr = InitOneToAllEngine(*workspace.pCoarseEngine, coarse.topology);
+        if (FAILED(hr))
+        {
+            workspace.pCoarseEngine.reset();
+            return hr;
+        }
+    }
+
+    // 1. Find the coarse vertex the coarse run starts from
+    uint32_t dwCoarseSourceID = coarse.fineToCoarse[dwSourceVertID];
+    float fSourceOffset = 0;
+    if (dwCoarseSourceID == INVALID_VERT_ID)
+    {
+        GEODESICQUERYBOUND nearestBound = { FLT_MAX, coarse.coarseVerts.data(), dwCoarseVertNumber, 1 };
+
+        for (size_t i = 0; i < m_dwVertNumber; i++)
+        {
+            pfGeodesicDistance[i] = FLT_MAX;
+        }
+        hr = PropagateGeodesicDistance(
+            dwSourceVertID,
+            nullptr,
+            0,
+            pfGeodesicDistance,
+            nullptr,
+            nullptr,
+            &nearestBound);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        fSourceOffset = FLT_MAX;
+        for (size_t i = 0; i < dwCoarseVertNumber; i++)
+        {
+            if (pfGeodesicDistance[coarse.coarseVerts[i]] < fSourceOffset)
+            {
+                fSourceOffset = pfGeodesicDistance[coarse.coarseVerts[i]];
+                dwCoarseSourceID = static_cast<uint32_t>(i);
+            }
+        }
+    }
+
+    // 2. Geodesic distances on the coarse level
+    ONETOALLENGINE &coarseEngine = *workspace.pCoarseEngine;
+    if (dwCoarseSourceID != INVALID_VERT_ID)
+    {
+        coarseEngine.SetBound(DBL_MAX, nullptr, 0, 0);
+
+        try
+        {
+            coarseEngine.SetSrcVertexIdx(dwCoarseSourceID);
+            coarseEngine.Run();
+        }
+        catch (std::bad_alloc &)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        // The run stops early when the call is cancelled. At the deadline of a
+        // best effort call, the coarse vertices it did not reach are left to
+        // the correction.
+        hr = m_IsochartEngine.m_cancel.Check();
+        if (FAILED(hr))
+            return hr;
+    }
+
+    // 3. Prolong the coarse distances to the chart and correct them
+    for (size_t i = 0; i < m_dwVertNumber; i++)
+    {
+        pfGeodesicDistance[i] = FLT_MAX;
+    }
+    if (dwCoarseSourceID != INVALID_VERT_ID)
+    {
+        for (size_t i = 0; i < dwCoarseVertNumber; i++)
+        {
+            const double dDistance = coarseEngine.m_VertexList[i].dGeoDistanceToSrc;
+            if (dDistance != DBL_MAX)
+            {
+                pfGeodesicDistance[coarse.coarseVerts[i]] = fSourceOffset + float(dDistance);
+            }
+        }
+    }
+
+    return PropagateGeodesicDistance(
+        dwSourceVertID,
+        coarse.coarseVerts.data(),
+        dwCoarseVertNumber,
+        pfGeodesicDistance,
+        nullptr,
+        pdwFarestPeerVertID,
+        pBound);
+}
+
+// See more detail in [KS98]
+HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertexKS98(
+    uint32_t dwSourceVertID,
+    float *pfGeodesicDistance,
+    float *pfSignalDistance,
+    uint32_t *pdwFarestPeerVertID,
+    const GEODESICQUERYBOUND *pBound) const
+{
+    m_IsochartEngine.m_stats.dwKS98Runs++;
+
+    // 1. Init the distance to source of each vertex
+    for (size_t i = 0; i < m_dwVertNumber; i++)
+    {
+        pfGeodesicDistance[i] = FLT_MAX;
+    }
+    if (pfSignalDistance)
+    {
+        for (size_t i = 0; i < m_dwVertNumber; i++)
+        {
+            pfSignalDistance[i] = FLT_MAX;
+        }
+    }
+
+    return PropagateGeodesicDistance(
+        dwSourceVertID,
+        nullptr,
+        0,
+        pfGeodesicDistance,
+        pfSignalDistance,
+        pdwFarestPeerVertID,
+        pBound);
+}
+
+// Propagates the distances from dwSourceVertID, and from the seed vertices at
+// the distances pfGeodesicDistance already holds for them, to the other
+// vertices, whose distances must be FLT_MAX. The propagation can only lower
+// the distances of the seeds. Signal distances are only propagated from the
+// source, without seeds. Runs on SHORTESTPATHTOPOLOGY, which
+// CalculateGeodesicDistance builds before the workers share it.
+HRESULT CIsochartMesh::PropagateGeodesicDistance(
+    uint32_t dwSourceVertID,
+    const uint32_t *pdwSeedVerts,
+    size_t dwSeedVertNumber,
+    float *pfGeodesicDistance,
+    float *pfSignalDistance,
+    uint32_t *pdwFarestPeerVertID,
+    const GEODESICQUERYBOUND *pBound) const
+{
+    assert(!pfSignalDistance || dwSeedVertNumber == 0);
+    assert(m_pShortestPathTopology != nullptr);
+
+    const uint32_t *pdwRowStart = m_pShortestPathTopology->rowStart.data();
+    const SHORTESTPATHNEIGHBOR *pNeighbors = m_pShortestPathTopology->neighbors.data();
+
+    CGeodesicQueryTracker tracker;
+    HRESULT hr = tracker.Init(pBound, m_dwVertNumber);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    std::unique_ptr<bool[]> vertProcessed(new (std::nothrow) bool[m_dwVertNumber]);
+    CMaxIndexHeap<float> heap;
+    if (!vertProcessed || !heap.resize(m_dwVertNumber))
+    {
+        return E_OUTOFMEMORY;
+    }
+    bool *pbVertProcessed = vertProcessed.get();
+    memset(pbVertProcessed, 0, sizeof(bool) * m_dwVertNumber);
+
+    // 1. Init the source vertex
+    pbVertProcessed[dwSourceVertID] = true;
+    pfGeodesicDistance[dwSourceVertID] = 0;
+    if (pfSignalDistance)
+    {
+        pfSignalDistance[dwSourceVertID] = 0;
+    }
+
+    // 2. Init heap with the source and the seeds.
+    heap.insert(dwSourceVertID, 0);
+    for (size_t i = 0; i < dwSeedVertNumber; i++)
+    {
+        uint32_t dwSeedVertID = pdwSeedVerts[i];
+        if (dwSeedVertID == dwSourceVertID || pfGeodesicDistance[dwSeedVertID] == FLT_MAX)
         {
-            break;
+            continue;
         }
+        heap.insert(dwSeedVertID, -pfGeodesicDistance[dwSeedVertID]);
+    }
 
-        pCurrentVertex = m_pVerts + pTop->m_data;
-        pbVertProcessed[pCurrentVertex->dwID] = true;
-        dwFarestVertID = pCurrentVertex->dwID;
+    uint32_t dwFarestVertID = dwSourceVertID;
 
-        // 4.1 For each vertex adjacent to current vertex, Compute geodesic
-        //     distance to source vertex.
-        for (size_t j = 0; j < pCurrentVertex->edgeAdjacent.size(); j++)
+    // 3. Dijkstra algorithm to compute geodesic distance from source
+    // to other vertices.
+    uint32_t dwCurrentID = 0;
+    while (heap.cutTop(dwCurrentID))
+    {
+        if (tracker.IsBeyond(pfGeodesicDistance[dwCurrentID]))
         {
-            uint32_t dwAdjacentVertID;
-            const ISOCHARTEDGE &edge = m_edges[pCurrentVertex->edgeAdjacent[j]];
+            break;
+        }
 
-            if (edge.dwVertexID[0] == pCurrentVertex->dwID)
-            {
-                dwAdjacentVertID = edge.dwVertexID[1];
-            }
-            else
-            {
-                dwAdjacentVertID = edge.dwVertexID[0];
-            }
+        pbVertProcessed[dwCurrentID] = true;
+        dwFarestVertID = dwCurrentID;
+        tracker.Settle(dwCurrentID, pfGeodesicDistance[dwCurrentID]);
+
+        const SHORTESTPATHNEIGHBOR *pRowBegin = pNeighbors + pdwRowStart[dwCurrentID];
+        const SHORTESTPATHNEIGHBOR *pRowEnd = pNeighbors + pdwRowStart[dwCurrentID + 1];
 
-            if (pbVertProcessed[dwAdjacentVertID])
+        // 3.1 For each vertex adjacent to current vertex, Compute geodesic
+        //     distance to source vertex.
+        for (const SHORTESTPATHNEIGHBOR *pNeighbor = pRowBegin; pNeighbor < pRowEnd; pNeighbor++)
+        {
+            if (!pbVertProcessed[pNeighbor->dwVertID])
             {
-                continue;
+                UpdateAdjacentVertexGeodistance(
+                    dwCurrentID,
+                    *pNeighbor,
+                    pbVertProcessed,
+                    pfGeodesicDistance,
+                    pfSignalDistance);
             }
-
-            ISOCHARTVERTEX *pAdjacentVertex = m_pVerts + dwAdjacentVertID;
-
-            UpdateAdjacentVertexGeodistance(
-                pCurrentVertex, pAdjacentVertex,
-                edge, pbVertProcessed.get(), bIsSignalDistance);
         }
 
-        // 4.2 Update heap according to 4.1 step.
-        for (size_t j = 0; j < pCurrentVertex->vertAdjacent.size(); j++)
+        // 3.2 Update heap according to 3.1 step.
+        for (const SHORTESTPATHNEIGHBOR *pNeighbor = pRowBegin; pNeighbor < pRowEnd; pNeighbor++)
         {
-            uint32_t dwAdjacentID = pCurrentVertex->vertAdjacent[j];
+            uint32_t dwAdjacentID = pNeighbor->dwVertID;
             if (pbVertProcessed[dwAdjacentID])
             {
                 continue;
             }
 
-            ISOCHARTVERTEX *pAdjacentVertex = m_pVerts + dwAdjacentID;
-            if (pHeapItem[dwAdjacentID].isItemInHeap())
+            if (heap.isItemInHeap(dwAdjacentID))
             {
-                heap.update(pHeapItem + dwAdjacentID,
-                    -pAdjacentVertex->fGeodesicDistance);
+                heap.update(dwAdjacentID, -pfGeodesicDistance[dwAdjacentID]);
             }
             else
             {
-                pHeapItem[dwAdjacentID].m_data = dwAdjacentID;
-                pHeapItem[dwAdjacentID].m_weight =
-                    -pAdjacentVertex->fGeodesicDistance;
-                if (!heap.insert(pHeapItem + dwAdjacentID))
-                {
-                    return E_OUTOFMEMORY;
-                }
+                heap.insert(dwAdjacentID, -pfGeodesicDistance[dwAdjacentID]);
             }
         }
     }
@@ -643,10 +1521,11 @@ HRESULT CIsochartMesh::CalculateGeodesicDistanceToVertexKS98(
 void CIsochartMesh::CalculateGeodesicDistanceABC(
     ISOCHARTVERTEX *pVertexA,
     ISOCHARTVERTEX *pVertexB,
-    ISOCHARTVERTEX *pVertexC) const
+    ISOCHARTVERTEX *pVertexC,
+    float *pfGeodesicDistance) const
 {
     XMVECTOR v[3];
-    float u = pVertexB->fGeodesicDistance - pVertexA->fGeodesicDistance;
+    float u = pfGeodesicDistance[pVertexB->dwID] - pfGeodesicDistance[pVertexA->dwID];
     v[0] = XMVectorSubtract(XMLoadFloat3(m_baseInfo.pVertPosition + pVertexB->dwIDInRootMesh),
         XMLoadFloat3(m_baseInfo.pVertPosition + pVertexC->dwIDInRootMesh));
 
@@ -696,9 +1575,9 @@ void CIsochartMesh::CalculateGeodesicDistanceABC(
         return;
     }
 
-    if (pVertexC->fGeodesicDistance > pVertexA->fGeodesicDistance + t)
+    if (pfGeodesicDistance[pVertexC->dwID] > pfGeodesicDistance[pVertexA->dwID] + t)
     {
-        pVertexC->fGeodesicDistance = pVertexA->fGeodesicDistance + t;
+        pfGeodesicDistance[pVertexC->dwID] = pfGeodesicDistance[pVertexA->dwID] + t;
     }
 }
 
@@ -738,6 +1617,440 @@ void CIsochartMesh::CalculateGeodesicMatrix(
     return;
 }
 
+// Number of landmarks whose distance rows are computed together. This is all
+// the landmarks while their rows fit in LANDMARK_DISTANCE_MEMORY_LIMIT.
+size_t CIsochartMesh::GetLandmarkDistanceBlockSize(size_t dwLandmarkNumber) const
+{
+    size_t dwRowSize = m_dwVertNumber * sizeof(float);
+    size_t dwStoredRowSize = IsIMTSpecified() ? 2 * dwRowSize : dwRowSize;
+    if (dwRowSize == 0 || dwLandmarkNumber <= LANDMARK_DISTANCE_MEMORY_LIMIT / dwStoredRowSize)
+    {
+        return dwLandmarkNumber;
+    }
+
+    // Keep a landmark for each worker in a block
+    size_t dwBlockSize = std::max(
+        LANDMARK_DISTANCE_BLOCK_MEMORY / dwStoredRowSize,
+        CTaskScheduler::GetNestedWorkerCount(&m_IsochartEngine.m_executor));
+    return std::max<size_t>(1, std::min(dwBlockSize, dwLandmarkNumber));
+}
+
+// Calculate the geodesic matrix of the landmarks without keeping their rows:
+// the rows are computed dwBlockSize landmarks at a time and only the distances
+// between landmarks are kept, made symmetric as CalculateGeodesicDistance does.
+// With IMT, the combined distances between the landmarks are kept in
+// pfCombineMatrix, with the signal scaled by the averages of all landmark rows
+// as CombineGeodesicAndSignalDistance does. The scale is kept for
+// CalculateLandmarkRows.
+HRESULT CIsochartMesh::CalculateStreamedGeodesicMatrix(
+    size_t dwBlockSize,
+    float *pfGeodesicMatrix,
+    float *pfCombineMatrix)
+{
+    assert(pfGeodesicMatrix != nullptr);
+    assert(dwBlockSize > 0);
+    assert(IsIMTSpecified() == (pfCombineMatrix != nullptr));
+
+    size_t dwLandmarkNumber = m_landmarkVerts.size();
+    std::unique_ptr<float[]> blockDistance(new (std::nothrow) float[dwBlockSize * m_dwVertNumber]);
+    std::unique_ptr<float[]> blockSignalDistance;
+    if (pfCombineMatrix)
+    {
+        blockSignalDistance.reset(new (std::nothrow) float[dwBlockSize * m_dwVertNumber]);
+    }
+    if (!blockDistance || (pfCombineMatrix && !blockSignalDistance))
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    float fSignalSum = 0;
+    float fGeodesicSum = 0;
+
+    std::vector<uint32_t> blockVerts;
+    for (size_t dwBegin = 0; dwBegin < dwLandmarkNumber; dwBegin += dwBlockSize)
+    {
+        size_t dwEnd = std::min(dwBegin + dwBlockSize, dwLandmarkNumber);
+        try
+        {
+            blockVerts.assign(m_landmarkVerts.begin() + ptrdiff_t(dwBegin), m_landmarkVerts.begin() + ptrdiff_t(dwEnd));
+        }
+        catch (std::bad_alloc &)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        HRESULT hr = CalculateGeodesicDistance(
+            blockVerts,
+            blockSignalDistance.get(),
+            blockDistance.get(),
+            nullptr,
+            true);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        if (pfCombineMatrix)
+        {
+            AddSignalScaleSums(
+                blockSignalDistance.get(),
+                blockDistance.get(),
+                (dwEnd - dwBegin) * m_dwVertNumber,
+                fSignalSum,
+                fGeodesicSum);
+        }
+
+        for (size_t i = dwBegin; i < dwEnd; i++)
+        {
+            const float *pDistanceToOneLandmark = blockDistance.get() + (i - dwBegin) * m_dwVertNumber;
+            float *pfGeodesicColumn = pfGeodesicMatrix + i * dwLandmarkNumber;
+            for (size_t j = 0; j < dwLandmarkNumber; j++)
+            {
+                pfGeodesicColumn[j] = pDistanceToOneLandmark[m_landmarkVerts[j]];
+            }
+
+            if (pfCombineMatrix)
+            {
+                const float *pSignalToOneLandmark = blockSignalDistance.get() + (i - dwBegin) * m_dwVertNumber;
+                float *pfCombineColumn = pfCombineMatrix + i * dwLandmarkNumber;
+                for (size_t j = 0; j < dwLandmarkNumber; j++)
+                {
+                    pfCombineColumn[j] = pSignalToOneLandmark[m_landmarkVerts[j]];
+                }
+            }
+        }
+    }
+
+    if (pfCombineMatrix)
+    {
+        m_bIsLandmarkSignalScaled = GetSignalScaleRatio(
+            fSignalSum,
+            fGeodesicSum,
+            dwLandmarkNumber * m_dwVertNumber,
+            m_fLandmarkSignalRatio);
+
+        ApplySignalScale(
+            pfCombineMatrix,
+            pfGeodesicMatrix,
+            dwLandmarkNumber * dwLandmarkNumber,
+            m_bIsLandmarkSignalScaled,
+            m_fLandmarkSignalRatio);
+    }
+
+    for (size_t i = 0; i < dwLandmarkNumber; i++)
+    {
+        for (size_t j = i + 1; j < dwLandmarkNumber; j++)
+        {
+            pfGeodesicMatrix[i * dwLandmarkNumber + j] = pfGeodesicMatrix[j * dwLandmarkNumber + i] = std::min(
+                pfGeodesicMatrix[i * dwLandmarkNumber + j],
+                pfGeodesicMatrix[j * dwLandmarkNumber + i]);
+
+            if (pfCombineMatrix)
+            {
+                pfCombineMatrix[i * dwLandmarkNumber + j] = pfCombineMatrix[j * dwLandmarkNumber + i] = std::min(
+                    pfCombineMatrix[i * dwLandmarkNumber + j],
+                    pfCombineMatrix[j * dwLandmarkNumber + i]);
+            }
+        }
+    }
+
+    return S_OK;
+}
+
+// Calculate the rows of the landmarks landmarkIdx, as IsomapParameterlization
+// stores them when the rows of all landmarks fit: with IMT, the rows are the
+// combined distances, with the signal scaled by the averages of all landmark
+// rows, and the distances to the landmarks are made symmetric with all
+// landmarks. Only used when the rows of all landmarks were not stored.
+HRESULT CIsochartMesh::CalculateLandmarkRows(
+    const std::vector<uint32_t> &landmarkIdx,
+    float *pfDistance) const
+{
+    assert(pfDistance != nullptr);
+    assert(m_pfLandmarkDistance);
+
+    bool bIsSignalSpecialized = IsIMTSpecified();
+    size_t dwLandmarkNumber = m_landmarkVerts.size();
+    size_t dwRowNumber = landmarkIdx.size();
+
+    std::vector<uint32_t> rowVerts;
+    try
+    {
+        rowVerts.resize(dwRowNumber);
+    }
+    catch (std::bad_alloc &)
+    {
+        return E_OUTOFMEMORY;
+    }
+    for (size_t i = 0; i < dwRowNumber; i++)
+    {
+        rowVerts[i] = m_landmarkVerts[landmarkIdx[i]];
+    }
+
+    std::unique_ptr<float[]> geodesicDistance;
+    if (bIsSignalSpecialized)
+    {
+        assert(m_pfLandmarkCombineDistance);
+        geodesicDistance.reset(new (std::nothrow) float[dwRowNumber * m_dwVertNumber]);
+        if (!geodesicDistance)
+        {
+            return E_OUTOFMEMORY;
+        }
+    }
+
+    HRESULT hr = CalculateGeodesicDistance(
+        rowVerts,
+        bIsSignalSpecialized ? pfDistance : nullptr,
+        bIsSignalSpecialized ? geodesicDistance.get() : pfDistance,
+        nullptr,
+        true);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    const float *pfLandmarkDistance = m_pfLandmarkDistance.get();
+    if (bIsSignalSpecialized)
+    {
+        ApplySignalScale(
+            pfDistance,
+            geodesicDistance.get(),
+            dwRowNumber * m_dwVertNumber,
+            m_bIsLandmarkSignalScaled,
+            m_fLandmarkSignalRatio);
+        pfLandmarkDistance = m_pfLandmarkCombineDistance.get();
+    }
+
+    for (size_t i = 0; i < dwRowNumber; i++)
+    {
+        float *pfRow = pfDistance + i * m_dwVertNumber;
+        const float *pfLandmarkRow = pfLandmarkDistance + landmarkIdx[i] * dwLandmarkNumber;
+        for (size_t j = 0; j < dwLandmarkNumber; j++)
+        {
+            pfRow[m_landmarkVerts[j]] = pfLandmarkRow[j];
+        }
+    }
+
+    return S_OK;
+}
+
+// Compute the embeddings of the vertices which are not landmark like
+// CalculateVertMappingCoord, computing the landmark rows again dwBlockSize at
+// a time. The terms of the landmarks are summed in the same order, so the
+// embeddings don't depend on the block size.
+HRESULT CIsochartMesh::CalculateStreamedVertMappingCoord(
+    size_t dwBlockSize,
+    size_t dwPrimaryEigenDimension,
+    float *pfVertMappingCoord)
+{
+    assert(pfVertMappingCoord != nullptr);
+    assert(dwBlockSize > 0);
+
+    size_t dwLandmarkNumber = m_landmarkVerts.size();
+    std::unique_ptr<float[]> blockDistance(new (std::nothrow) float[dwBlockSize * m_dwVertNumber]);
+    if (!blockDistance)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    std::vector<uint32_t> blockVerts;
+    for (size_t dwBegin = 0; dwBegin < dwLandmarkNumber; dwBegin += dwBlockSize)
+    {
+        size_t dwEnd = std::min(dwBegin + dwBlockSize, dwLandmarkNumber);
+        try
+        {
+            blockVerts.assign(m_landmarkVerts.begin() + ptrdiff_t(dwBegin), m_landmarkVerts.begin() + ptrdiff_t(dwEnd));
+        }
+        catch (std::bad_alloc &)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        HRESULT hr = CalculateGeodesicDistance(blockVerts, nullptr, blockDistance.get());
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        if (FAILED(hr = AddLandmarkMapping(
+            blockDistance.get(),
+            dwBegin,
+            dwEnd,
+            dwPrimaryEigenDimension,
+            pfVertMappingCoord)))
+        {
+            return hr;
+        }
+    }
+
+    return S_OK;
+}
+
+namespace
+{
+    // Adds to pfCoord[k * dwVertCount + v] the terms of the landmarks
+    // [dwLandmarkBegin, dwLandmarkEnd) in the k-th coordinate of vertex v,
+    // see section 4 of [Kun04]. The distance of vertex v to the landmark j
+    // is pfDistance[(j - dwLandmarkBegin) * dwRowStride + v].
+    // The landmarks are added in order, so every coordinate is rounded as
+    // when the vertices are mapped one at a time.
+    void AddLandmarkTerms(
+        const CIsoMap &isoMap,
+        size_t dwLandmarkNumber,
+        size_t dwLandmarkBegin,
+        size_t dwLandmarkEnd,
+        const float *pfDistance,
+        size_t dwRowStride,
+        size_t dwVertCount,
+        size_t dwPrimaryEigenDimension,
+        float *pfCoord)
+    {
+        assert(dwVertCount <= MAPPING_VERTEX_BLOCK);
+
+        const float *pfAverage = isoMap.GetAverageColumn();
+        const float *pfEigenVector = isoMap.GetEigenVector();
+        float fVectorWeight[MAPPING_VERTEX_BLOCK];
+
+        for (size_t j = dwLandmarkBegin; j < dwLandmarkEnd; j++)
+        {
+            const float fAverage = pfAverage[j];
+            for (size_t v = 0; v < dwVertCount; v++)
+            {
+                fVectorWeight[v] = fAverage - pfDistance[v] * pfDistance[v];
+            }
+
+            for (size_t k = 0; k < dwPrimaryEigenDimension; k++)
+            {
+                const float fEigen = pfEigenVector[k * dwLandmarkNumber + j];
+                float *pfDimensionCoord = pfCoord + k * dwVertCount;
+                for (size_t v = 0; v < dwVertCount; v++)
+                {
+                    pfDimensionCoord[v] += fVectorWeight[v] * fEigen;
+                }
+            }
+
+            pfDistance += dwRowStride;
+        }
+    }
+}
+
+// Adds the terms of the landmarks [dwLandmarkBegin, dwLandmarkEnd) to the
+// embedding of the vertices which are not landmarks, as a product of the
+// distance rows of these landmarks, pfDistance, with the eigenvectors.
+// The sums are kept in pfVertMappingCoord between calls. The first call
+// starts them from 0, the last one scales them by the eigenvalues and sets
+// the UV of the vertices. pfVertMappingCoord may be nullptr if a single call
+// covers all landmarks.
+HRESULT CIsochartMesh::AddLandmarkMapping(
+    const float *pfDistance,
+    size_t dwLandmarkBegin,
+    size_t dwLandmarkEnd,
+    size_t dwPrimaryEigenDimension,
+    float *pfVertMappingCoord)
+{
+    const size_t dwLandmarkNumber = m_landmarkVerts.size();
+    const bool bFirst = (dwLandmarkBegin == 0);
+    const bool bLast = (dwLandmarkEnd == dwLandmarkNumber);
+    assert(pfVertMappingCoord != nullptr || (bFirst && bLast));
+
+    const float *pfEigenValue = m_isoMap.GetEigenValue();
+    const size_t dwBlockNumber = (m_dwVertNumber + MAPPING_VERTEX_BLOCK - 1) / MAPPING_VERTEX_BLOCK;
+
+    auto mapBlocks = [&](size_t dwBegin, size_t dwEnd, size_t) -> HRESULT
+        {
+            std::unique_ptr<float[]> coord(new (std::nothrow) float[MAPPING_VERTEX_BLOCK * dwPrimaryEigenDimension]);
+            if (!coord)
+            {
+                return E_OUTOFMEMORY;
+            }
+            float *pfCoord = coord.get();
+
+            for (size_t dwBlock = dwBegin; dwBlock < dwEnd; dwBlock++)
+            {
+                const size_t dwFirstVert = dwBlock * MAPPING_VERTEX_BLOCK;
+                const size_t dwVertCount = std::min(MAPPING_VERTEX_BLOCK, m_dwVertNumber - dwFirstVert);
+
+                // The coordinates of the block are transposed, so that the
+                // vertices are contiguous for each dimension.
+                for (size_t v = 0; v < dwVertCount; v++)
+                {
+                    for (size_t k = 0; k < dwPrimaryEigenDimension; k++)
+                    {
+                        pfCoord[k * dwVertCount + v] = bFirst ? 0 : pfVertMappingCoord[(dwFirstVert + v) * dwPrimaryEigenDimension + k];
+                    }
+                }
+
+                AddLandmarkTerms(
+                    m_isoMap,
+                    dwLandmarkNumber,
+                    dwLandmarkBegin,
+                    dwLandmarkEnd,
+                    pfDistance + dwFirstVert,
+                    m_dwVertNumber,
+                    dwVertCount,
+                    dwPrimaryEigenDimension,
+                    pfCoord);
+
+                for (size_t v = 0; v < dwVertCount; v++)
+                {
+                    ISOCHARTVERTEX *pVertex = m_pVerts + dwFirstVert + v;
+                    if (pVertex->bIsLandmark)
+                    {
+                        continue;
+                    }
+
+                    if (bLast)
+                    {
+                        for (size_t k = 0; k < dwPrimaryEigenDimension; k++)
+                        {
+                            pfCoord[k * dwVertCount + v] /= IsochartSqrtf(pfEigenValue[k]) * 2;
+                        }
+
+                        pVertex->uv.x = pfCoord[v];
+                        pVertex->uv.y = pfCoord[dwVertCount + v];
+                    }
+
+                    if (pfVertMappingCoord)
+                    {
+                        for (size_t k = 0; k < dwPrimaryEigenDimension; k++)
+                        {
+                            pfVertMappingCoord[(dwFirstVert + v) * dwPrimaryEigenDimension + k] = pfCoord[k * dwVertCount + v];
+                        }
+                    }
+                }
+            }
+            return S_OK;
+        };
+
+    if (m_dwVertNumber * (dwLandmarkEnd - dwLandmarkBegin) >= PARALLEL_MAPPING_MIN_WORK)
+    {
+        return CTaskScheduler::NestedParallelFor(
+            dwBlockNumber,
+            MAPPING_BLOCK_GRAIN,
+            mapBlocks,
+            &m_IsochartEngine.m_executor);
+    }
+
+    return mapBlocks(0, dwBlockNumber, 0);
+}
+
+// Distance between the dwLandmarkIdx1-th and dwLandmarkIdx2-th landmarks,
+// read from the landmark rows or, when they were not kept, from the landmark
+// distance matrix.
+float CIsochartMesh::GetLandmarkPairDistance(
+    const float *pfVertGeodesicDistance,
+    size_t dwLandmarkIdx1,
+    size_t dwLandmarkIdx2) const
+{
+    if (pfVertGeodesicDistance)
+    {
+        return pfVertGeodesicDistance[dwLandmarkIdx1 * m_dwVertNumber + m_landmarkVerts[dwLandmarkIdx2]];
+    }
+
+    assert(m_pfLandmarkDistance);
+    return m_pfLandmarkDistance[dwLandmarkIdx1 * m_landmarkVerts.size() + dwLandmarkIdx2];
+}
+
 // Compute n-dimension embeddings of all vertices which are not landmark, using
 // algorithm in section 4 of [Kun04]
 HRESULT CIsochartMesh::CalculateVertMappingCoord(
@@ -748,20 +2061,13 @@ HRESULT CIsochartMesh::CalculateVertMappingCoord(
                                 // coordinates of each vertex in it.Not Only
                                 // store UV coordinate in vertex
 {
-    assert(pfVertGeodesicDistance != nullptr);
+    assert(pfVertGeodesicDistance != nullptr || pfVertMappingCoord != nullptr);
     assert(dwPrimaryEigenDimension >= 2);
     _Analysis_assume_(dwPrimaryEigenDimension >= 2);
 
-    std::unique_ptr<float[]> landmarkCoords;
-    if (dwLandmarkNumber * dwPrimaryEigenDimension >
-        dwLandmarkNumber + dwPrimaryEigenDimension)
-    {
-        landmarkCoords.reset(new (std::nothrow) float[dwLandmarkNumber * dwPrimaryEigenDimension]);
-    }
-    else
-    {
-        landmarkCoords.reset(new (std::nothrow) float[dwLandmarkNumber + dwPrimaryEigenDimension]);
-    }
+    assert(dwLandmarkNumber == m_landmarkVerts.size());
+
+    std::unique_ptr<float[]> landmarkCoords(new (std::nothrow) float[dwLandmarkNumber * dwPrimaryEigenDimension]);
     if (!landmarkCoords)
     {
         return E_OUTOFMEMORY;
@@ -793,52 +2099,30 @@ HRESULT CIsochartMesh::CalculateVertMappingCoord(
         pfCoord += dwPrimaryEigenDimension;
     }
 
-    const float *pfAverage = m_isoMap.GetAverageColumn();
-
-    pVertex = m_pVerts;
-
-    // Beacause pfLandmarkCoords is no longer used. Here reuse the buffer for
-    // other work. Just reduce additional memory allocation.
-    float *fVectorWeight = pfLandmarkCoords;
-
-    pfCoord = pfLandmarkCoords + dwLandmarkNumber;
-    for (size_t i = 0; i < m_dwVertNumber; i++)
+    if (!pfVertGeodesicDistance)
     {
-        if (pVertex->bIsLandmark)
-        {
-            pVertex++;
-            continue;
-        }
-
-        const float *pfDistance = pfVertGeodesicDistance;
-
-        for (size_t j = 0; j < dwLandmarkNumber; j++)
-        {
-            fVectorWeight[j] = pfAverage[j] - pfDistance[i] * pfDistance[i];
-            pfDistance += m_dwVertNumber;
-        }
-
-        if (pfVertMappingCoord)
+        // The distance rows were not kept, compute them again.
+        HRESULT hr = CalculateStreamedVertMappingCoord(
+            GetLandmarkDistanceBlockSize(dwLandmarkNumber),
+            dwPrimaryEigenDimension,
+            pfVertMappingCoord);
+        if (FAILED(hr))
         {
-            pfCoord = pfVertMappingCoord + i * dwPrimaryEigenDimension;
+            return hr;
         }
-
-        for (size_t k = 0; k < dwPrimaryEigenDimension; k++)
+    }
+    else
+    {
+        HRESULT hr = AddLandmarkMapping(
+            pfVertGeodesicDistance,
+            0,
+            dwLandmarkNumber,
+            dwPrimaryEigenDimension,
+            pfVertMappingCoord);
+        if (FAILED(hr))
         {
-            pfCoord[k] = 0;
-            const float *fEigenVector = m_isoMap.GetEigenVector() + k * dwLandmarkNumber;
-
-            for (size_t j = 0; j < dwLandmarkNumber; j++)
-            {
-                pfCoord[k] += fVectorWeight[j] * fEigenVector[j];
-            }
-            pfCoord[k] /= IsochartSqrtf(m_isoMap.GetEigenValue()[k]) * 2;
+            return hr;
         }
-
-        pVertex->uv.x = pfCoord[0];
-        pVertex->uv.y = pfCoord[1];
-
-        pVertex++;
     }
 
     // Make the parameterization on the right plane
@@ -61,6 +61,8 @@ HRESULT CIsochartMesh::OptimizeBoundaryByAngle(
         return S_OK;
     }
 
+    CStatsTimer timer(m_IsochartEngine.m_stats.boundaryTime);
+
     // 1. Calculate dihedral angle for each edge using formula in
     // [Kun04], section 4
     std::unique_ptr<uint32_t[]> pdwFaceChartIDBackup(new (std::nothrow) uint32_t[m_dwFaceNumber]);
@@ -528,6 +530,7 @@ HRESULT CIsochartMesh::OptimizeOneBoundaryByAngle(
     }
 
     float fMaxFlow = 0;
+    m_IsochartEngine.m_stats.dwGraphCuts++;
     if (FAILED(hr = graphCut.CutGraph(fMaxFlow)))
     {
         return hr;
@@ -567,6 +570,8 @@ HRESULT CIsochartMesh::OptimizeBoundaryByStretch(
         return S_OK;
     }
 
+    CStatsTimer timer(m_IsochartEngine.m_stats.boundaryTime);
+
     std::vector<uint32_t> allLandmark;
     std::vector<uint32_t> oldLandmark;
     std::vector<uint32_t> newLandmark;
@@ -622,7 +627,8 @@ HRESULT CIsochartMesh::OptimizeBoundaryByStretch(
     hr = CalParamDistanceToAllLandmarks(
         pfOldGeodesicDistance,
         pfNewGeodesicDistance.get(),
-        allLandmark);
+        allLandmark,
+        pbIsFuzzyFatherFace.get());
     if (FAILED(hr))
     {
         return hr;
@@ -919,22 +925,28 @@ HRESULT CIsochartMesh::DecreaseLocalLandmark()
     return S_OK;
 }
 
+// The distances from the new landmarks are only read at the landmarks and at
+// the vertices of the fuzzy faces, the other ones are left incomplete.
+// Without pfOldGeodesicDistance, when the rows of the chart landmarks were not
+// kept, all landmarks are computed as new ones.
 HRESULT CIsochartMesh::CalParamDistanceToAllLandmarks(
     const float *pfOldGeodesicDistance,
     float *pfNewGeodesicDistance,
-    std::vector<uint32_t> &allLandmark)
+    std::vector<uint32_t> &allLandmark,
+    const bool *pbIsFuzzyFatherFace)
 {
     HRESULT hr = S_OK;
 
     std::vector<uint32_t> oldLandmark;
     std::vector<uint32_t> newLandmark;
+    std::vector<uint32_t> targetVerts;
 
     try
     {
         for (size_t i = 0; i < allLandmark.size(); i++)
         {
             ISOCHARTVERTEX *pVertex = m_pVerts + allLandmark[i];
-            if (pVertex->bIsLandmark)
+            if (pVertex->bIsLandmark && pfOldGeodesicDistance)
             {
                 for (size_t j = 0; j < m_landmarkVerts.size(); j++)
                 {
@@ -957,6 +969,38 @@ HRESULT CIsochartMesh::CalParamDistanceToAllLandmarks(
                 newLandmark.push_back(pVertex->dwID);
             }
         }
+
+        if (!newLandmark.empty())
+        {
+            std::unique_ptr<bool[]> isTarget(new (std::nothrow) bool[m_dwVertNumber]);
+            if (!isTarget)
+            {
+                return E_OUTOFMEMORY;
+            }
+            memset(isTarget.get(), 0, sizeof(bool) * m_dwVertNumber);
+
+            for (size_t i = 0; i < allLandmark.size(); i++)
+            {
+                isTarget[allLandmark[i]] = true;
+            }
+            for (size_t i = 0; i < m_dwFaceNumber; i++)
+            {
+                if (pbIsFuzzyFatherFace[i])
+                {
+                    for (size_t j = 0; j < 3; j++)
+                    {
+                        isTarget[m_pFaces[i].dwVertexID[j]] = true;
+                    }
+                }
+            }
+            for (uint32_t i = 0; i < m_dwVertNumber; i++)
+            {
+                if (isTarget[i])
+                {
+                    targetVerts.push_back(i);
+                }
+            }
+        }
     }
     catch (std::bad_alloc &)
     {
@@ -966,11 +1010,14 @@ HRESULT CIsochartMesh::CalParamDistanceToAllLandmarks(
     // 3.2 compute geodesic distance from each local landmark to other vertices.
     if (!newLandmark.empty())
     {
+        GEODESICQUERYBOUND bound = { FLT_MAX, targetVerts.data(), targetVerts.size(), targetVerts.size() };
+
         FAILURE_RETURN(
             CalculateGeodesicDistance(
                 newLandmark,
                 nullptr,
-                pfNewGeodesicDistance + oldLandmark.size() * m_dwVertNumber));
+                pfNewGeodesicDistance + oldLandmark.size() * m_dwVertNumber,
+                &bound));
     }
 
     assert(allLandmark.size() ==
@@ -1385,6 +1432,7 @@ OptimizeOneBoundaryByAngle(
 
     // Perform graph cut
     float fMaxFlow = 0;
+    m_IsochartEngine.m_stats.dwGraphCuts++;
     if (FAILED(hr = graphCut.CutGraph(fMaxFlow)))
     {
         return hr;
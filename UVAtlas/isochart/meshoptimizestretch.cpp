@@ -42,6 +42,7 @@
 #include "isochartmesh.h"
 #include "UVAtlas.h"
 #include "maxheap.hpp"
+#include "taskscheduler.h"
 
 using namespace Isochart;
 using namespace DirectX;
@@ -77,6 +78,9 @@ namespace Isochart
         XMFLOAT2 minBound;
         XMFLOAT2 maxBound;
 
+        // Random moves of the vertices, seeded by the chart ID.
+        std::mt19937_64 randomEngine;
+
         // Only for Ln stretch
         float fPreveMaxFaceStretch;
         float fInfiniteStretch;
@@ -239,16 +243,25 @@ uint32_t CIsochartMesh::GetBestPartitionCanidate(
     return dwMaxIdx;
 }
 
+// Charts are optimized independently on the executor's threads. Each chart
+// only updates its own stretch and area, the totals are summed afterward by
+// the callers in chart order, so they don't depend on the thread count.
 HRESULT CIsochartMesh::OptimizeAllL2SquaredStretch(
     ISOCHARTMESH_ARRAY &chartList,
-    bool bOptimizeSignal)
+    bool bOptimizeSignal,
+    const DirectX::UVAtlasExecutor *pExecutor)
 {
-    HRESULT hr = S_OK;
-    for (size_t ii = 0; ii < chartList.size(); ii++)
-    {
-        FAILURE_RETURN(chartList[ii]->OptimizeChartL2Stretch(bOptimizeSignal));
-    }
-    return S_OK;
+    CTaskScheduler scheduler(pExecutor);
+    return scheduler.ParallelFor(chartList.size(), 1,
+        [&chartList, bOptimizeSignal](size_t dwBegin, size_t dwEnd, size_t) -> HRESULT
+        {
+            HRESULT hr = S_OK;
+            for (size_t ii = dwBegin; ii < dwEnd; ii++)
+            {
+                FAILURE_RETURN(chartList[ii]->OptimizeChartL2Stretch(bOptimizeSignal));
+            }
+            return S_OK;
+        });
 }
 
 float CIsochartMesh::ComputeGeoAvgL2Stretch(
@@ -515,6 +528,7 @@ HRESULT CIsochartMesh::InitOptimizeInfo(
         optimizeInfo.pfFaceStretch = new (std::nothrow) float[m_dwFaceNumber];
         optimizeInfo.pfVertStretch = new (std::nothrow) float[m_dwVertNumber];
         optimizeInfo.pHeapItems = new (std::nothrow) CMaxHeapItem<float, uint32_t>[m_dwVertNumber];
+        optimizeInfo.randomEngine.seed(m_IsochartEngine.GetChartRandomSeed(GetChartID()));
     }
 
     if (!optimizeInfo.pfFaceStretch || !optimizeInfo.pfVertStretch || !optimizeInfo.pHeapItems)
@@ -1794,14 +1808,13 @@ bool CIsochartMesh::OptimizeVertexStretchAroundCenter(
     float fTempStretch = 0;
     XMFLOAT2 middle;
     // As the decription in [SSGH01], randomly moving vertex will have more
-    // chance to find the optimal position. To make consistent results, srand
-    // with a specified value 2
-    srand(2);
+    // chance to find the optimal position.
+    std::uniform_real_distribution<float> dis(0.f, 2.f * XM_PI);
     size_t iteration = 0;
     while (iteration < optimizeInfo.dwRandOptOneVertTimes)
     {
         // 1. Get a new random position in the optimizing circle range
-        float fAngle = m_IsochartEngine.UniformRand(2.f * XM_PI);
+        float fAngle = dis(optimizeInfo.randomEngine);
         vertInfo.end.x =
             vertInfo.center.x + vertInfo.fRadius * cosf(fAngle);
         vertInfo.end.y =
@@ -1610,7 +1610,7 @@ HRESULT CIsochartMesh::ProcessSpecialShape(
 #endif
 
     assert(
-        (IsIMTSpecified() && pfVertGeodesicDistance != pfVertCombineDistance) || (!IsIMTSpecified() && pfVertGeodesicDistance == pfVertCombineDistance));
+        (IsIMTSpecified() && pfVertGeodesicDistance != pfVertCombineDistance) || (!IsIMTSpecified() && pfVertGeodesicDistance == pfVertCombineDistance) || (!pfVertGeodesicDistance && !pfVertCombineDistance));
 
     // 1. Detect special shape
     uint32_t dwLonghornExtremeVexID = 0;
@@ -1814,8 +1814,27 @@ CaculateDistanceToExtremeVertex(
     float &fMinDistance,
     float &fMaxDistance) const
 {
+    // Only the distances to the boundary are needed
+    std::vector<uint32_t> boundaryVerts;
+    try
+    {
+        for (uint32_t i = 0; i < m_dwVertNumber; i++)
+        {
+            if (m_pVerts[i].bIsBoundary)
+            {
+                boundaryVerts.push_back(i);
+            }
+        }
+    }
+    catch (std::bad_alloc &)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    GEODESICQUERYBOUND bound = { FLT_MAX, boundaryVerts.data(), boundaryVerts.size(), boundaryVerts.size() };
+
     HRESULT hr = S_OK;
-    if (FAILED(hr = CalculateDijkstraPathToVertex(dwVertexID)))
+    if (FAILED(hr = CalculateDijkstraPathToVertex(dwVertexID, nullptr, &bound)))
     {
         return hr;
     }
@@ -2087,7 +2106,7 @@ HRESULT CIsochartMesh::ProcessGeneralShape(
     assert(m_children.empty());
 
     assert(
-        (IsIMTSpecified() && pfVertGeodesicDistance != pfVertCombineDistance) || (!IsIMTSpecified() && pfVertGeodesicDistance == pfVertCombineDistance));
+        (IsIMTSpecified() && pfVertGeodesicDistance != pfVertCombineDistance) || (!IsIMTSpecified() && pfVertGeodesicDistance == pfVertCombineDistance) || (!pfVertGeodesicDistance && !pfVertCombineDistance));
 
     // 1. If dwPrimaryEigenDimension is small enough, The algorithm of
     // stretch optimization can work well. So, optimize the Initial
@@ -2324,12 +2343,14 @@ HRESULT CIsochartMesh::RemoveCloseRepresentiveVertices(
             float fMinDist = FLT_MAX;
             for (size_t k = 0; k < i; k++)
             {
-                uint32_t index = static_cast<uint32_t>(
-                    representativeVertsIdx[k] * m_dwVertNumber + m_landmarkVerts[representativeVertsIdx[j]]);
+                float fDistance = GetLandmarkPairDistance(
+                    pfVertGeodesicDistance,
+                    representativeVertsIdx[k],
+                    representativeVertsIdx[j]);
 
-                if (pfVertGeodesicDistance[index] < fMinDist)
+                if (fDistance < fMinDist)
                 {
-                    fMinDist = pfVertGeodesicDistance[index];
+                    fMinDist = fDistance;
                 }
             }
 
@@ -2367,7 +2388,6 @@ HRESULT CIsochartMesh::GetMainRepresentive(
     size_t dwNumber,
     const float *pfVertGeodesicDistance)
 {
-    assert(pfVertGeodesicDistance != nullptr);
     assert(dwNumber >= 2);
     assert(representativeVertsIdx.size() >= 2);
 
@@ -2385,12 +2405,10 @@ HRESULT CIsochartMesh::GetMainRepresentive(
             float fTotalDistance = 0;
             for (size_t k = 0; k < i; k++)
             {
-                uint32_t dwIdx = static_cast<uint32_t>(
-                    representativeVertsIdx[k] * m_dwVertNumber +
-                    m_landmarkVerts[representativeVertsIdx[j]]);
-
-                fTotalDistance +=
-                    pfVertGeodesicDistance[dwIdx];
+                fTotalDistance += GetLandmarkPairDistance(
+                    pfVertGeodesicDistance,
+                    representativeVertsIdx[k],
+                    representativeVertsIdx[j]);
             }
             if (fTotalDistance > fMaxTotalDistance)
             {
@@ -2438,10 +2456,25 @@ HRESULT CIsochartMesh::PartitionGeneralShape(
 
     // 1. Partition the chart into representativeVertsIdx.size()
     // parts by growing charts simultaneously around the representatives
-    ClusterFacesByParameterDistance(
-        pdwFaceChartID.get(),
-        pfVertCombineDistance,
-        representativeVertsIdx);
+    if (pfVertCombineDistance)
+    {
+        ClusterFacesByParameterDistance(
+            pdwFaceChartID.get(),
+            pfVertCombineDistance,
+            representativeVertsIdx);
+    }
+    else
+    {
+        // The landmark rows were not kept, compute the ones of the
+        // representatives again.
+        HRESULT hrRows = ClusterFacesByRepresentiveDistance(
+            pdwFaceChartID.get(),
+            representativeVertsIdx);
+        if (FAILED(hrRows))
+        {
+            return hrRows;
+        }
+    }
 
     // 2.Smooth parititon result
     size_t dwMaxSubchartCount = representativeVertsIdx.size();
@@ -2529,6 +2562,51 @@ void CIsochartMesh::ClusterFacesByParameterDistance(
     }
 }
 
+// ClusterFacesByParameterDistance with the distances from the representatives
+// computed on demand.
+HRESULT CIsochartMesh::ClusterFacesByRepresentiveDistance(
+    uint32_t *pdwFaceChartID,
+    const std::vector<uint32_t> &representativeVertsIdx)
+{
+    size_t dwRepresentiveNumber = representativeVertsIdx.size();
+
+    std::vector<uint32_t> representativeRows;
+    try
+    {
+        representativeRows.resize(dwRepresentiveNumber);
+    }
+    catch (std::bad_alloc &)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    for (size_t i = 0; i < dwRepresentiveNumber; i++)
+    {
+        representativeRows[i] = static_cast<uint32_t>(i);
+    }
+
+    // The rows are the ones IsomapParameterlization would have stored, the
+    // partition does not depend on whether the landmark rows were kept.
+    std::unique_ptr<float[]> partitionDistance(new (std::nothrow) float[dwRepresentiveNumber * m_dwVertNumber]);
+    if (!partitionDistance)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    HRESULT hr = CalculateLandmarkRows(representativeVertsIdx, partitionDistance.get());
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    ClusterFacesByParameterDistance(
+        pdwFaceChartID,
+        partitionDistance.get(),
+        representativeRows);
+
+    return S_OK;
+}
+
 // For each face, creat a sub-chart.
 HRESULT CIsochartMesh::PartitionEachFace()
 {
@@ -2960,7 +3038,6 @@ HRESULT CIsochartMesh::GrowPartitionFromCutPath(
 HRESULT CIsochartMesh::ReserveFarestTwoLandmarks(
     const float *pfVertGeodesicDistance)
 {
-    assert(pfVertGeodesicDistance != nullptr);
     HRESULT hr = S_OK;
     m_bOrderedLandmark = true;
     if (m_landmarkVerts.size() < 3)
@@ -2975,13 +3052,13 @@ HRESULT CIsochartMesh::ReserveFarestTwoLandmarks(
         for (size_t jj = ii + 1; jj < m_landmarkVerts.size(); jj++)
         {
             assert(
-                pfVertGeodesicDistance[ii * m_dwVertNumber + m_landmarkVerts[jj]] ==
-                pfVertGeodesicDistance[jj * m_dwVertNumber + m_landmarkVerts[ii]]);
+                GetLandmarkPairDistance(pfVertGeodesicDistance, ii, jj) ==
+                GetLandmarkPairDistance(pfVertGeodesicDistance, jj, ii));
 
-            if (pfVertGeodesicDistance[ii * m_dwVertNumber + m_landmarkVerts[jj]] > fMaxDistance)
+            float fDistance = GetLandmarkPairDistance(pfVertGeodesicDistance, ii, jj);
+            if (fDistance > fMaxDistance)
             {
-                fMaxDistance =
-                    pfVertGeodesicDistance[ii * m_dwVertNumber + m_landmarkVerts[jj]];
+                fMaxDistance = fDistance;
                 dwIdx[0] = static_cast<uint32_t>(ii);
                 dwIdx[1] = static_cast<uint32_t>(jj);
             }
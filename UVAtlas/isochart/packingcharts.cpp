@@ -105,9 +105,15 @@ namespace
     constexpr float STANDARD_UV_SIZE = 512;
     constexpr float STANDARD_GUTTER = 2;
 
-    // Tables for precomputed triangle values.
-    float g_PackingCosTable[CHART_ROTATION_NUMBER];
-    float g_PackingSinTable[CHART_ROTATION_NUMBER];
+    // Rotation of the chart for the dwRotationId-th pose. Computed on demand
+    // rather than kept in a shared table, so concurrent packings don't write
+    // to global state.
+    inline void GetPackingRotation(size_t dwRotationId, float &fCos, float &fSin)
+    {
+        float fAngle = float(dwRotationId) * 2.f * XM_PI / float(CHART_ROTATION_NUMBER);
+        fCos = cosf(fAngle);
+        fSin = sinf(fAngle);
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -2273,10 +2279,9 @@ float CIsochartMesh::GuranteeSmallestChartArea(
 
 // Performed before packing chart.
 // 1. Allocate packing information buffer for each chart
-// 2. Initialize global sin and cos table
-// 3. Align each chart along longest axis
-// 4. Adjust chart UV-area
-// 5. Initialize atlas information structure
+// 2. Align each chart along longest axis
+// 3. Adjust chart UV-area
+// 4. Initialize atlas information structure
 HRESULT CIsochartMesh::PreparePacking(
     ISOCHARTMESH_ARRAY &chartList,
     size_t dwWidth,
@@ -2291,25 +2296,17 @@ HRESULT CIsochartMesh::PreparePacking(
     // 1. Create data structure for each chart needed by Packing Charts.
     FAILURE_RETURN(CreateChartsPackingBuffer(chartList));
 
-    // 2. Initialize global sin and cos table needed in packing process.
-    for (size_t ii = 0; ii < CHART_ROTATION_NUMBER; ii++)
-    {
-        float fAngle = float(ii) * 2.f * XM_PI / float(CHART_ROTATION_NUMBER);
-        g_PackingCosTable[ii] = cosf(fAngle);
-        g_PackingSinTable[ii] = sinf(fAngle);
-    }
-
-    // 3. Gurantee All charts larger than a lower bound.
+    // 2. Gurantee All charts larger than a lower bound.
     float fTotalArea = GuranteeSmallestChartArea(chartList);
 
-    // 4. Align all charts according to the axis connecting the farthest
+    // 3. Align all charts according to the axis connecting the farthest
     // two vertices in the chart.
     AlignChartsWithLongestAxis(chartList);
 
-    // 5. Sort charts by some attribute (currently, by height).
+    // 4. Sort charts by some attribute (currently, by height).
     SortCharts(chartList);
 
-    // 6. Initialize atlas information structure
+    // 5. Initialize atlas information structure
     // Convert between metric specified by user ( in pixel ) and metric of original
     // mesh
     atlasInfo.fPixelLength =
@@ -2894,8 +2891,8 @@ void CIsochartMesh::RotateChartAroundCenter(
     ISOCHARTVERTEX **ppTopMostVertex,
     ISOCHARTVERTEX **ppBottomMostVertex)
 {
-    float fCos = g_PackingCosTable[dwRotationId];
-    float fSin = g_PackingSinTable[dwRotationId];
+    float fCos, fSin;
+    GetPackingRotation(dwRotationId, fCos, fSin);
 
     if (bOnlyRotateBoundaries)
     {
@@ -3252,8 +3249,8 @@ HRESULT CIsochartMesh::ScanAlongBoundayEdges(
 void CIsochartMesh::RotateBordersAroundCenter(
     size_t dwRotationId)
 {
-    float fCos = g_PackingCosTable[dwRotationId];
-    float fSin = g_PackingSinTable[dwRotationId];
+    float fCos, fSin;
+    GetPackingRotation(dwRotationId, fCos, fSin);
 
     ISOCHARTVERTEX *pVertex;
 
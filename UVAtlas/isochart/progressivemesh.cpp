@@ -78,6 +78,7 @@ CProgressiveMesh::CProgressiveMesh(
     m_dwFaceNumber(0),
     m_dwEdgeNumber(0),
     m_fBoxDiagLen(0),
+    m_bReportProgress(true),
     m_baseInfo(baseInfo),
     m_callbackSchemer(callbackSchemer)
 {}
@@ -100,11 +101,18 @@ void CProgressiveMesh::Clear()
     m_dwEdgeNumber = 0;
 }
 
-HRESULT CProgressiveMesh::Initialize(CIsochartMesh &mesh)
+// Without bReportProgress, neither the initialization nor the simplification
+// calls the callback, so that they can run on a worker of the parallel
+// partition.
+HRESULT CProgressiveMesh::Initialize(
+    const CIsochartMesh &mesh,
+    bool bReportProgress)
 {
     HRESULT hr = S_OK;
     Clear();
 
+    m_bReportProgress = bReportProgress;
+
     m_dwVertNumber = static_cast<uint32_t>(mesh.GetVertexNumber());
     m_dwFaceNumber = static_cast<uint32_t>(mesh.GetFaceNumber());
     m_dwEdgeNumber = static_cast<uint32_t>(mesh.GetEdgeNumber());
@@ -145,9 +153,10 @@ HRESULT CProgressiveMesh::Initialize(CIsochartMesh &mesh)
 // vanishment makes least distortion of whole mesh.
 // The order to delete the vertices decide the vertices's importance order.
 // See more detail in : [GH97]
-HRESULT CProgressiveMesh::Simplify()
+// The simplification stops at dwMinVertNumber vertices.
+HRESULT CProgressiveMesh::Simplify(
+    size_t dwMinVertNumber)
 {
-    uint32_t dwMinVertNumber = MIN_PM_VERT_NUMBER;
     float fMaxError = MAX_PM_ERROR;
 
     CCostHeap heap;
@@ -184,7 +193,7 @@ HRESULT CProgressiveMesh::Simplify()
     }
 
     DPF(3, "----Begin Simplify----");
-    HRESULT hr = m_callbackSchemer.CheckPointAdapt();
+    HRESULT hr = m_bReportProgress ? m_callbackSchemer.CheckPointAdapt() : S_OK;
     if (FAILED(hr))
         return hr;
 
@@ -311,6 +320,50 @@ HRESULT CProgressiveMesh::Simplify()
     return S_OK;
 }
 
+// Export the mesh left by Simplify(). vertList gets the ID of each vertex
+// not deleted, faceVertList gets the 3 indices into vertList of each face
+// not deleted.
+HRESULT CProgressiveMesh::ExportSimplifiedMesh(
+    std::vector<uint32_t> &vertList,
+    std::vector<uint32_t> &faceVertList) const
+{
+    try
+    {
+        std::vector<uint32_t> vertIndex(m_dwVertNumber, INVALID_VERT_ID);
+
+        vertList.clear();
+        for (uint32_t i = 0; i < m_dwVertNumber; i++)
+        {
+            if (!m_pVertArray[i].bIsDeleted)
+            {
+                vertIndex[i] = static_cast<uint32_t>(vertList.size());
+                vertList.push_back(m_pVertArray[i].dwID);
+            }
+        }
+
+        faceVertList.clear();
+        for (uint32_t i = 0; i < m_dwFaceNumber; i++)
+        {
+            const PMISOCHARTFACE &face = m_pFaceArray[i];
+            if (face.bIsDeleted)
+            {
+                continue;
+            }
+            for (size_t j = 0; j < 3; j++)
+            {
+                assert(vertIndex[face.dwVertexID[j]] != INVALID_VERT_ID);
+                faceVertList.push_back(vertIndex[face.dwVertexID[j]]);
+            }
+        }
+    }
+    catch (std::bad_alloc &)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    return S_OK;
+}
+
 // Decide if current edge can be deleted, which vertex of current edge
 // will be deleted, which will be reserved.
 bool CProgressiveMesh::PrepareDeletingEdge(
@@ -549,7 +602,10 @@ HRESULT CProgressiveMesh::DeleteCurrentEdge(
     // 5. Recompute the cost of edges connecting to the reserved vertex.
     UpdateSufferedEdgesCost(heap, pHeapItems, pReserveVertex);
 
-    hr = m_callbackSchemer.UpdateCallbackAdapt(1);
+    if (m_bReportProgress)
+    {
+        hr = m_callbackSchemer.UpdateCallbackAdapt(1);
+    }
 
     return hr;
 }
@@ -1016,7 +1072,7 @@ void CProgressiveMesh::UpdateSufferedEdgesCost(
     return;
 }
 
-HRESULT CProgressiveMesh::CreateProgressiveMesh(CIsochartMesh &mesh)
+HRESULT CProgressiveMesh::CreateProgressiveMesh(const CIsochartMesh &mesh)
 {
     ISOCHARTVERTEX *pOrgVerts = mesh.GetVertexBuffer();
     ISOCHARTFACE *pOrgFaces = mesh.GetFaceBuffer();
@@ -1120,20 +1176,29 @@ HRESULT CProgressiveMesh::CalculateQuadricErrorMetric()
 
     // 3. Calculate quadirc matrix for each vertex.
     FAILURE_RETURN(CalculateQuadricArray());
-    FAILURE_RETURN(m_callbackSchemer.UpdateCallbackAdapt(1));
+    if (m_bReportProgress)
+    {
+        FAILURE_RETURN(m_callbackSchemer.UpdateCallbackAdapt(1));
+    }
 
     // 4. Calculate quadric error for each vertex
     for (size_t i = 0; i < m_dwVertNumber; i++)
     {
         CalculateVertexQuadricError(m_pVertArray + i);
-        FAILURE_RETURN(m_callbackSchemer.UpdateCallbackAdapt(1));
+        if (m_bReportProgress)
+        {
+            FAILURE_RETURN(m_callbackSchemer.UpdateCallbackAdapt(1));
+        }
     }
 
     // 5. Calculate quadric error for each edge
     for (size_t i = 0; i < m_dwEdgeNumber; i++)
     {
         CalculateEdgeQuadricError(m_pEdgeArray + i);
-        FAILURE_RETURN(m_callbackSchemer.UpdateCallbackAdapt(1));
+        if (m_bReportProgress)
+        {
+            FAILURE_RETURN(m_callbackSchemer.UpdateCallbackAdapt(1));
+        }
     }
     return hr;
 }
@@ -89,11 +89,18 @@ namespace Isochart
 
         ~CProgressiveMesh();
 
-        HRESULT Initialize(CIsochartMesh &mesh);
+        HRESULT Initialize(
+            const CIsochartMesh &mesh,
+            bool bReportProgress = true);
 
         void Clear();
 
-        HRESULT Simplify();
+        HRESULT Simplify(
+            size_t dwMinVertNumber = MIN_PM_VERT_NUMBER);
+
+        HRESULT ExportSimplifiedMesh(
+            std::vector<uint32_t> &vertList,
+            std::vector<uint32_t> &faceVertList) const;
 
         int GetVertexImportance(uint32_t dwIndex) const
         {
@@ -173,7 +180,7 @@ namespace Isochart
             PMISOCHARTVERTEX *pReserveVertex);
 
         HRESULT CreateProgressiveMesh(
-            CIsochartMesh &mesh);
+            const CIsochartMesh &mesh);
 
         HRESULT CalculateQuadricErrorMetric();
 
@@ -200,6 +207,7 @@ namespace Isochart
         uint32_t m_dwFaceNumber;
         uint32_t m_dwEdgeNumber;
         float m_fBoxDiagLen;
+        bool m_bReportProgress;
 
         const CBaseMeshInfo &m_baseInfo;
         CCallbackSchemer &m_callbackSchemer;
@@ -9,8 +9,16 @@
 
 #pragma once
 
+#include "taskscheduler.h"
+
 namespace Isochart
 {
+    // Products of compressed matrices with at least this many rows are split
+    // between the workers of the executor, PARALLEL_SPMV_ROW_GRAIN rows at a
+    // time.
+    constexpr size_t PARALLEL_SPMV_MIN_ROWS = 0x4000;
+    constexpr size_t PARALLEL_SPMV_ROW_GRAIN = 0x400;
+
     template <class TYPE>
     class CVector : public std::vector<TYPE>
     {
@@ -443,15 +451,292 @@ namespace Isochart
 
             return true;
         }
+    };
+
+    // Sparse matrix in compressed sparse row (CSR) format, for the products of
+    // the linear solvers. It is built once from a matrix assembled in a
+    // CSparseMatrix. The items of a row keep their order in the CSparseMatrix
+    // row, so that the products are summed in the same order as on it.
+    template <class TYPE>
+    class CCGPreconditioner;
+
+    template <class TYPE>
+    class CCompressedSparseMatrix
+    {
+        friend class CCGPreconditioner<TYPE>;
+
+    public:
+        typedef size_t size_type;
+        typedef size_t pos_type;
+        typedef TYPE value_type;
+
+        CCompressedSparseMatrix() : m_colCount(0) {}
+
+        size_type rowCount() const { return m_rowStart.empty() ? 0 : m_rowStart.size() - 1; }
+        size_type colCount() const { return m_colCount; }
+        size_type itemCount() const { return m_colIdx.size(); }
+
+        bool compress(const CSparseMatrix<TYPE> &srcMat)
+        {
+            assert(srcMat.colCount() <= UINT32_MAX);
+
+            size_type dwItemCount = 0;
+            for (size_type ii = 0; ii < srcMat.rowCount(); ii++)
+            {
+                dwItemCount += srcMat.getRow(ii).size();
+            }
+
+            if (!allocate(srcMat.rowCount(), srcMat.colCount(), dwItemCount))
+            {
+                return false;
+            }
+
+            size_type dwItem = 0;
+            for (size_type ii = 0; ii < srcMat.rowCount(); ii++)
+            {
+                const auto &row = srcMat.getRow(ii);
+
+                m_rowStart[ii] = dwItem;
+                for (size_type jj = 0; jj < row.size(); jj++)
+                {
+                    assert(row[jj].colIdx < srcMat.colCount());
+                    m_colIdx[dwItem] = static_cast<uint32_t>(row[jj].colIdx);
+                    m_values[dwItem] = row[jj].value;
+                    dwItem++;
+                }
+            }
+            m_rowStart[srcMat.rowCount()] = dwItem;
+            return true;
+        }
 
+    private:
+        bool allocate(size_type dwRowCount, size_type dwColCount, size_type dwItemCount)
+        {
+            try
+            {
+                m_rowStart.resize(dwRowCount + 1);
+                m_colIdx.resize(dwItemCount);
+                m_values.resize(dwItemCount);
+            }
+            catch (std::bad_alloc &)
+            {
+                return false;
+            }
+            m_colCount = dwColCount;
+            return true;
+        }
+
+        // The rows of destMat are the columns of srcMat, each with the items of
+        // the column by increasing row.
+        static bool transpose(
+            CCompressedSparseMatrix &destMat,
+            const CCompressedSparseMatrix &srcMat)
+        {
+            assert(srcMat.rowCount() <= UINT32_MAX);
+
+            if (!destMat.allocate(srcMat.colCount(), srcMat.rowCount(), srcMat.itemCount()))
+            {
+                return false;
+            }
+
+            std::fill(destMat.m_rowStart.begin(), destMat.m_rowStart.end(), 0);
+            for (size_type kk = 0; kk < srcMat.itemCount(); kk++)
+            {
+                destMat.m_rowStart[srcMat.m_colIdx[kk] + 1]++;
+            }
+            for (size_type ii = 0; ii < destMat.rowCount(); ii++)
+            {
+                destMat.m_rowStart[ii + 1] += destMat.m_rowStart[ii];
+            }
+
+            std::vector<size_type> nextItem;
+            try
+            {
+                nextItem.assign(destMat.m_rowStart.begin(), destMat.m_rowStart.end() - 1);
+            }
+            catch (std::bad_alloc &)
+            {
+                return false;
+            }
+
+            for (size_type ii = 0; ii < srcMat.rowCount(); ii++)
+            {
+                for (size_type kk = srcMat.m_rowStart[ii]; kk < srcMat.m_rowStart[ii + 1]; kk++)
+                {
+                    size_type dwItem = nextItem[srcMat.m_colIdx[kk]]++;
+                    destMat.m_colIdx[dwItem] = static_cast<uint32_t>(ii);
+                    destMat.m_values[dwItem] = srcMat.m_values[kk];
+                }
+            }
+            return true;
+        }
+
+        std::vector<size_type> m_rowStart;
+        std::vector<uint32_t> m_colIdx;
+        std::vector<value_type> m_values;
+        size_type m_colCount;
+
+    public:
+        // v' = A * v. Rows are independent, so large matrices are split
+        // between the workers of pExecutor.
+        template <class T>
+        static bool Mat_Mul_Vec(
+            CVector<T> &destVec,
+            const CCompressedSparseMatrix<T> &srcMat,
+            const CVector<T> &srcVec,
+            const DirectX::UVAtlasExecutor *pExecutor = nullptr)
+        {
+            assert(srcMat.colCount() == srcVec.size());
+
+            try
+            {
+                destVec.resize(srcMat.rowCount());
+            }
+            catch (std::bad_alloc &)
+            {
+                return false;
+            }
+
+            const size_type *pRowStart = srcMat.m_rowStart.data();
+            const uint32_t *pColIdx = srcMat.m_colIdx.data();
+            const T *pValues = srcMat.m_values.data();
+            const T *pSrc = srcVec.data();
+            T *pDest = destVec.data();
+
+            auto mulRows = [=](size_t dwBegin, size_t dwEnd, size_t) -> HRESULT
+                {
+                    for (size_t ii = dwBegin; ii < dwEnd; ii++)
+                    {
+                        T sum = 0;
+                        for (size_type kk = pRowStart[ii]; kk < pRowStart[ii + 1]; kk++)
+                        {
+                            sum += pValues[kk] * pSrc[pColIdx[kk]];
+                        }
+                        pDest[ii] = sum;
+                    }
+                    return S_OK;
+                };
+
+            if (srcMat.rowCount() >= PARALLEL_SPMV_MIN_ROWS)
+            {
+                return SUCCEEDED(CTaskScheduler::NestedParallelFor(
+                    srcMat.rowCount(), PARALLEL_SPMV_ROW_GRAIN, mulRows, pExecutor));
+            }
+
+            mulRows(0, srcMat.rowCount(), 0);
+            return true;
+        }
+
+        // v' = A^T * v
+        template <class T>
+        static bool Mat_Trans_Mul_Vec(
+            CVector<T> &destVec,
+            const CCompressedSparseMatrix<T> &srcMat,
+            const CVector<T> &srcVec)
+        {
+            assert(srcMat.rowCount() == srcVec.size());
+
+            try
+            {
+                destVec.resize(srcMat.colCount());
+            }
+            catch (std::bad_alloc &)
+            {
+                return false;
+            }
+
+            destVec.setZero();
+            for (size_type ii = 0; ii < srcMat.rowCount(); ii++)
+            {
+                for (size_type kk = srcMat.m_rowStart[ii]; kk < srcMat.m_rowStart[ii + 1]; kk++)
+                {
+                    destVec[srcMat.m_colIdx[kk]] += srcMat.m_values[kk] * srcVec[ii];
+                }
+            }
+            return true;
+        }
+
+        // A' = A^T * A
+        // Row i of A' gathers, by increasing row r of A with an item in column
+        // i, the products of that item with the items of row r. A marker per
+        // column finds the item of A' a product is added to, instead of a
+        // search in the row.
+        template <class T>
+        static bool Mat_Trans_MUL_Mat(
+            CCompressedSparseMatrix<T> &destMat,
+            const CCompressedSparseMatrix<T> &srcMat)
+        {
+            CCompressedSparseMatrix<T> transMat;
+            if (!transpose(transMat, srcMat))
+            {
+                return false;
+            }
+
+            const size_type dwDimension = srcMat.colCount();
+            std::vector<size_type> itemOfCol;
+            try
+            {
+                itemOfCol.assign(dwDimension, SIZE_MAX);
+                destMat.m_rowStart.resize(dwDimension + 1);
+                destMat.m_colIdx.clear();
+                destMat.m_values.clear();
+                destMat.m_colIdx.reserve(srcMat.itemCount());
+                destMat.m_values.reserve(srcMat.itemCount());
+
+                for (size_type ii = 0; ii < dwDimension; ii++)
+                {
+                    const size_type dwRowStart = destMat.m_colIdx.size();
+                    destMat.m_rowStart[ii] = dwRowStart;
+
+                    for (size_type kk = transMat.m_rowStart[ii]; kk < transMat.m_rowStart[ii + 1]; kk++)
+                    {
+                        const size_type dwSrcRow = transMat.m_colIdx[kk];
+                        const T value1 = transMat.m_values[kk];
+
+                        for (size_type ll = srcMat.m_rowStart[dwSrcRow]; ll < srcMat.m_rowStart[dwSrcRow + 1]; ll++)
+                        {
+                            const uint32_t dwCol = srcMat.m_colIdx[ll];
+                            const size_type dwItem = itemOfCol[dwCol];
+                            if (dwItem != SIZE_MAX && dwItem >= dwRowStart)
+                            {
+                                destMat.m_values[dwItem] += value1 * srcMat.m_values[ll];
+                            }
+                            else
+                            {
+                                itemOfCol[dwCol] = destMat.m_colIdx.size();
+                                destMat.m_colIdx.push_back(dwCol);
+                                destMat.m_values.push_back(value1 * srcMat.m_values[ll]);
+                            }
+                        }
+                    }
+                }
+                destMat.m_rowStart[dwDimension] = destMat.m_colIdx.size();
+            }
+            catch (std::bad_alloc &)
+            {
+                return false;
+            }
+
+            destMat.m_colCount = dwDimension;
+            return true;
+        }
+
+        // Solves A * X = B, preconditioned by pPreconditioner when it isn't
+        // nullptr. The solve ends when the residual is epsilon times the
+        // initial one.
+        // fnIsStopped is optional, it is polled at each iteration and the solve
+        // fails when it returns true.
         template <class T>
         static bool ConjugateGradient(
             CVector<T> &X,
-            const CSparseMatrix<T> &A,
+            const CCompressedSparseMatrix<T> &A,
             const CVector<T> &B,
+            const CCGPreconditioner<T> *pPreconditioner,
             size_type maxIteration,
             T epsilon,
-            size_type &iter)
+            size_type &iter,
+            const std::function<bool()> &fnIsStopped = nullptr,
+            const DirectX::UVAtlasExecutor *pExecutor = nullptr)
         {
             if (X.size() != A.colCount())
             {
@@ -466,9 +751,12 @@ namespace Isochart
                 X.setZero();
             }
 
-            CVector<T> R, D, Q, tempV;
+            CVector<T> R, Z, D, Q, tempV;
 
-            if (!Mat_Mul_Vec(R, A, X))
+            // Without preconditioner, Z is R itself
+            const CVector<T> &PR = pPreconditioner ? Z : R;
+
+            if (!Mat_Mul_Vec(R, A, X, pExecutor))
             {
                 return false;
             }
@@ -476,21 +764,31 @@ namespace Isochart
             {
                 return false;
             }
-            if (!CVector<T>::assign(D, R))
+            if (pPreconditioner && !pPreconditioner->apply(Z, R))
+            {
+                return false;
+            }
+            if (!CVector<T>::assign(D, PR))
             {
                 return false;
             }
 
-            T deltaNew = CVector<T>::dot(R, R);
-            T deltaZero = deltaNew;
+            T deltaNew = CVector<T>::dot(R, PR);
+            T residualNew = pPreconditioner ? CVector<T>::dot(R, R) : deltaNew;
+            T residualZero = residualNew;
             T deltaOld = 0;
 
-            T errBound = deltaZero * epsilon * epsilon;
+            T errBound = residualZero * epsilon * epsilon;
 
             iter = 0;
-            while (iter < maxIteration && deltaNew > errBound)
+            while (iter < maxIteration && residualNew > errBound)
             {
-                if (!Mat_Mul_Vec(Q, A, D))
+                if (fnIsStopped && fnIsStopped())
+                {
+                    return false;
+                }
+
+                if (!Mat_Mul_Vec(Q, A, D, pExecutor))
                 {
                     return false;
                 }
@@ -508,7 +806,7 @@ namespace Isochart
 
                 if (iter % 10 == 0)
                 {
-                    if (!Mat_Mul_Vec(R, A, X))
+                    if (!Mat_Mul_Vec(R, A, X, pExecutor))
                     {
                         return false;
                     }
@@ -528,9 +826,14 @@ namespace Isochart
                         return false;
                     }
                 }
+                if (pPreconditioner && !pPreconditioner->apply(Z, R))
+                {
+                    return false;
+                }
                 deltaOld = deltaNew;
 
-                deltaNew = CVector<T>::dot(R, R);
+                deltaNew = CVector<T>::dot(R, PR);
+                residualNew = pPreconditioner ? CVector<T>::dot(R, R) : deltaNew;
 
                 T b = deltaNew / deltaOld;
 
@@ -538,7 +841,7 @@ namespace Isochart
                 {
                     return false;
                 }
-                if (!CVector<T>::addTogether(D, R, tempV))
+                if (!CVector<T>::addTogether(D, PR, tempV))
                 {
                     return false;
                 }
@@ -548,4 +851,334 @@ namespace Isochart
             return true;
         }
     };
+
+    // Preconditioners of CCompressedSparseMatrix::ConjugateGradient, with M
+    // approximating A:
+    // -CG_PRECONDITIONER_JACOBI: M = D, the diagonal of A.
+    // -CG_PRECONDITIONER_IC0: M = L * L^T, L the incomplete Cholesky factor of
+    //  A + s * D with the pattern of the lower triangle of A.
+    // -CG_PRECONDITIONER_SSOR: M = (D / w + L) * (D / w)^-1 * (D / w + L^T),
+    //  L the strict lower triangle of A and w = SSOR_RELAXATION.
+    enum CGPRECONDITIONER
+    {
+        CG_PRECONDITIONER_NONE,
+        CG_PRECONDITIONER_JACOBI,
+        CG_PRECONDITIONER_IC0,
+        CG_PRECONDITIONER_SSOR,
+    };
+
+    constexpr double SSOR_RELAXATION = 1.0;
+
+    // The incomplete Cholesky factorization is done on A + s * D, s being
+    // IC0_INITIAL_SHIFT. Without it, the tiny pivots of the normal equations
+    // of the parameterizations make the solves slower than unpreconditioned.
+    // When it meets a non positive pivot, it starts again with ten times the
+    // shift, at most IC0_MAX_SHIFTS times, and then Jacobi is used instead.
+    constexpr double IC0_INITIAL_SHIFT = 1.0e-2;
+    constexpr size_t IC0_MAX_SHIFTS = 4;
+
+    template <class TYPE>
+    class CCGPreconditioner
+    {
+    public:
+        typedef size_t size_type;
+        typedef TYPE value_type;
+
+        CCGPreconditioner() : m_type(CG_PRECONDITIONER_NONE), m_pMatrix(nullptr) {}
+
+        CGPRECONDITIONER type() const { return m_type; }
+
+        // Prepares M for A, which must outlive the preconditioner. If a
+        // diagonal item of A isn't positive, Jacobi is used, with 1 as the
+        // diagonal item of those rows.
+        bool init(const CCompressedSparseMatrix<TYPE> &A, CGPRECONDITIONER type)
+        {
+            m_type = type;
+            m_pMatrix = &A;
+
+            if (type == CG_PRECONDITIONER_NONE)
+            {
+                return true;
+            }
+
+            const size_type dwRowCount = A.rowCount();
+            try
+            {
+                m_diagonal.assign(dwRowCount, 0);
+            }
+            catch (std::bad_alloc &)
+            {
+                return false;
+            }
+
+            bool bPositive = true;
+            for (size_type ii = 0; ii < dwRowCount; ii++)
+            {
+                for (size_type kk = A.m_rowStart[ii]; kk < A.m_rowStart[ii + 1]; kk++)
+                {
+                    if (A.m_colIdx[kk] == ii)
+                    {
+                        m_diagonal[ii] += A.m_values[kk];
+                    }
+                }
+                if (!(m_diagonal[ii] > 0))
+                {
+                    bPositive = false;
+                    m_diagonal[ii] = 1;
+                }
+            }
+
+            if (!bPositive)
+            {
+                m_type = CG_PRECONDITIONER_JACOBI;
+            }
+
+            if (m_type == CG_PRECONDITIONER_IC0)
+            {
+                bool bFactored = false;
+                if (!factorIC0(A, bFactored))
+                {
+                    return false;
+                }
+                if (!bFactored)
+                {
+                    m_type = CG_PRECONDITIONER_JACOBI;
+                }
+            }
+            return true;
+        }
+
+        // z = M^-1 * r
+        bool apply(CVector<TYPE> &z, const CVector<TYPE> &r) const
+        {
+            try
+            {
+                z.resize(r.size());
+            }
+            catch (std::bad_alloc &)
+            {
+                return false;
+            }
+
+            switch (m_type)
+            {
+            case CG_PRECONDITIONER_JACOBI:
+                for (size_type ii = 0; ii < r.size(); ii++)
+                {
+                    z[ii] = r[ii] / m_diagonal[ii];
+                }
+                break;
+
+            case CG_PRECONDITIONER_IC0:
+                applyIC0(z, r);
+                break;
+
+            case CG_PRECONDITIONER_SSOR:
+                applySSOR(z, r);
+                break;
+
+            default:
+                memcpy(z.data(), r.data(), r.size() * sizeof(TYPE));
+                break;
+            }
+            return true;
+        }
+
+    private:
+        // Factors the lower triangle of A into m_factor, each row sorted by
+        // column and ending with its diagonal item. bFactored is false when
+        // every try met a non positive pivot.
+        bool factorIC0(const CCompressedSparseMatrix<TYPE> &A, bool &bFactored)
+        {
+            bFactored = false;
+
+            const size_type dwRowCount = A.rowCount();
+            size_type dwItemCount = 0;
+            for (size_type ii = 0; ii < dwRowCount; ii++)
+            {
+                for (size_type kk = A.m_rowStart[ii]; kk < A.m_rowStart[ii + 1]; kk++)
+                {
+                    if (A.m_colIdx[kk] <= ii)
+                    {
+                        dwItemCount++;
+                    }
+                }
+            }
+
+            if (!m_factor.allocate(dwRowCount, dwRowCount, dwItemCount))
+            {
+                return false;
+            }
+
+            std::vector<TYPE> lowerValues;
+            std::vector<size_type> itemOfCol;
+            try
+            {
+                lowerValues.resize(dwItemCount);
+                itemOfCol.assign(dwRowCount, SIZE_MAX);
+            }
+            catch (std::bad_alloc &)
+            {
+                return false;
+            }
+
+            size_type *pRowStart = m_factor.m_rowStart.data();
+            uint32_t *pColIdx = m_factor.m_colIdx.data();
+            TYPE *pValues = m_factor.m_values.data();
+
+            // 1. Copy the lower triangle of A, sorting each row by insertion.
+            // Since the diagonal items are positive, they end their rows.
+            size_type dwItem = 0;
+            for (size_type ii = 0; ii < dwRowCount; ii++)
+            {
+                pRowStart[ii] = dwItem;
+                for (size_type kk = A.m_rowStart[ii]; kk < A.m_rowStart[ii + 1]; kk++)
+                {
+                    const uint32_t dwCol = A.m_colIdx[kk];
+                    if (dwCol > ii)
+                    {
+                        continue;
+                    }
+
+                    size_type ll = dwItem++;
+                    while (ll > pRowStart[ii] && pColIdx[ll - 1] > dwCol)
+                    {
+                        pColIdx[ll] = pColIdx[ll - 1];
+                        lowerValues[ll] = lowerValues[ll - 1];
+                        ll--;
+                    }
+                    pColIdx[ll] = dwCol;
+                    lowerValues[ll] = A.m_values[kk];
+                }
+            }
+            pRowStart[dwRowCount] = dwItem;
+
+            // 2. Factor row by row:
+            // L(i, k) = (A(i, k) - sum(L(i, j) * L(k, j), j < k)) / L(k, k)
+            // L(i, i) = sqrt(A(i, i) * (1 + s) - sum(L(i, j) ^ 2, j < i))
+            double shift = IC0_INITIAL_SHIFT;
+            for (size_t dwTry = 0; dwTry <= IC0_MAX_SHIFTS && !bFactored; dwTry++, shift *= 10)
+            {
+                memcpy(pValues, lowerValues.data(), dwItemCount * sizeof(TYPE));
+
+                bFactored = true;
+                for (size_type ii = 0; ii < dwRowCount; ii++)
+                {
+                    const size_type dwDiagonal = pRowStart[ii + 1] - 1;
+                    for (size_type kk = pRowStart[ii]; kk < dwDiagonal; kk++)
+                    {
+                        itemOfCol[pColIdx[kk]] = kk;
+                    }
+
+                    TYPE diagonal = static_cast<TYPE>(pValues[dwDiagonal] * (1 + shift));
+                    for (size_type kk = pRowStart[ii]; kk < dwDiagonal; kk++)
+                    {
+                        const uint32_t dwCol = pColIdx[kk];
+                        const size_type dwColDiagonal = pRowStart[dwCol + 1] - 1;
+
+                        TYPE value = pValues[kk];
+                        for (size_type ll = pRowStart[dwCol]; ll < dwColDiagonal; ll++)
+                        {
+                            const size_type dwItemOfRow = itemOfCol[pColIdx[ll]];
+                            if (dwItemOfRow != SIZE_MAX)
+                            {
+                                value -= pValues[dwItemOfRow] * pValues[ll];
+                            }
+                        }
+                        value /= pValues[dwColDiagonal];
+
+                        pValues[kk] = value;
+                        diagonal -= value * value;
+                    }
+
+                    for (size_type kk = pRowStart[ii]; kk < dwDiagonal; kk++)
+                    {
+                        itemOfCol[pColIdx[kk]] = SIZE_MAX;
+                    }
+
+                    if (!(diagonal > 0) || !std::isfinite(diagonal))
+                    {
+                        bFactored = false;
+                        break;
+                    }
+                    pValues[dwDiagonal] = static_cast<TYPE>(sqrt(diagonal));
+                }
+            }
+            return true;
+        }
+
+        // Solves L * y = r, then L^T * z = y
+        void applyIC0(CVector<TYPE> &z, const CVector<TYPE> &r) const
+        {
+            const size_type *pRowStart = m_factor.m_rowStart.data();
+            const uint32_t *pColIdx = m_factor.m_colIdx.data();
+            const TYPE *pValues = m_factor.m_values.data();
+
+            for (size_type ii = 0; ii < r.size(); ii++)
+            {
+                const size_type dwDiagonal = pRowStart[ii + 1] - 1;
+
+                TYPE value = r[ii];
+                for (size_type kk = pRowStart[ii]; kk < dwDiagonal; kk++)
+                {
+                    value -= pValues[kk] * z[pColIdx[kk]];
+                }
+                z[ii] = value / pValues[dwDiagonal];
+            }
+
+            // The rows of L are the columns of L^T
+            for (size_type ii = r.size(); ii-- > 0;)
+            {
+                const size_type dwDiagonal = pRowStart[ii + 1] - 1;
+
+                z[ii] /= pValues[dwDiagonal];
+                for (size_type kk = pRowStart[ii]; kk < dwDiagonal; kk++)
+                {
+                    z[pColIdx[kk]] -= pValues[kk] * z[ii];
+                }
+            }
+        }
+
+        // Forward, then backward Gauss-Seidel sweep with relaxation. The
+        // factor w / (2 - w) of the symmetric SOR is left out of M, since CG
+        // does not depend on the scale of M.
+        void applySSOR(CVector<TYPE> &z, const CVector<TYPE> &r) const
+        {
+            const CCompressedSparseMatrix<TYPE> &A = *m_pMatrix;
+            const TYPE omega = static_cast<TYPE>(SSOR_RELAXATION);
+
+            // (D / w + L) * y = r
+            for (size_type ii = 0; ii < r.size(); ii++)
+            {
+                TYPE value = r[ii];
+                for (size_type kk = A.m_rowStart[ii]; kk < A.m_rowStart[ii + 1]; kk++)
+                {
+                    if (A.m_colIdx[kk] < ii)
+                    {
+                        value -= A.m_values[kk] * z[A.m_colIdx[kk]];
+                    }
+                }
+                z[ii] = value * omega / m_diagonal[ii];
+            }
+
+            // (D / w + L^T) * z = (D / w) * y
+            for (size_type ii = r.size(); ii-- > 0;)
+            {
+                TYPE value = z[ii] * m_diagonal[ii] / omega;
+                for (size_type kk = A.m_rowStart[ii]; kk < A.m_rowStart[ii + 1]; kk++)
+                {
+                    if (A.m_colIdx[kk] > ii)
+                    {
+                        value -= A.m_values[kk] * z[A.m_colIdx[kk]];
+                    }
+                }
+                z[ii] = value * omega / m_diagonal[ii];
+            }
+        }
+
+        CGPRECONDITIONER m_type;
+        const CCompressedSparseMatrix<TYPE> *m_pMatrix;
+        std::vector<TYPE> m_diagonal;
+        CCompressedSparseMatrix<TYPE> m_factor;
+    };
 }
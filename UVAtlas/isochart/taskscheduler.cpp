@@ -0,0 +1,485 @@
+//-------------------------------------------------------------------------------------
+// UVAtlas - taskscheduler.cpp
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//-------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "taskscheduler.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace Isochart;
+
+namespace
+{
+    // Workers submitted to the caller's job system can start after Run()
+    // returned, the gate lets them find out without touching the scheduler.
+    struct SUBMITGATE
+    {
+        std::mutex lock;
+        std::condition_variable signal;
+        size_t dwActive = 0;
+        bool bClosed = false;
+    };
+
+    // The scheduler and worker running the current thread's task, used by
+    // NestedParallelFor().
+    struct CURRENTWORKER
+    {
+        CTaskScheduler *pScheduler;
+        size_t dwWorker;
+    };
+
+    thread_local CURRENTWORKER s_currentWorker = { nullptr, 0 };
+}
+
+CTaskScheduler::CTaskScheduler(const DirectX::UVAtlasExecutor *pExecutor) :
+    m_executor{ 0, nullptr },
+    m_dwWorkerCount(0),
+    m_dwPending(0),
+    m_dwQueued(0),
+    m_dwNextWorker(1),
+    m_hrResult(S_OK),
+    m_idlePollInterval(0)
+{
+    if (pExecutor)
+    {
+        try
+        {
+            m_executor = *pExecutor;
+        }
+        catch (std::bad_alloc &)
+        {
+            m_executor.submit = nullptr;
+        }
+    }
+
+    m_dwWorkerCount = m_executor.maxThreadCount ? m_executor.maxThreadCount : GetDefaultWorkerCount();
+    m_queues.reset(new (std::nothrow) TASKQUEUE[m_dwWorkerCount]);
+}
+
+size_t CTaskScheduler::GetDefaultWorkerCount()
+{
+#ifdef _OPENMP
+    int nThreads = omp_get_max_threads();
+    return (nThreads > 0) ? static_cast<size_t>(nThreads) : 1;
+#else
+    unsigned int nThreads = std::thread::hardware_concurrency();
+    return (nThreads > 0) ? nThreads : 1;
+#endif
+}
+
+HRESULT CTaskScheduler::Spawn(size_t dwWorker, TASK task)
+{
+    assert(dwWorker < m_dwWorkerCount);
+
+    if (!m_queues)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    // Count the task as pending before it can be stolen, so the spawning
+    // task is never the last pending one while its child is running.
+    m_dwPending++;
+
+    TASKQUEUE &queue = m_queues[dwWorker];
+    try
+    {
+        std::lock_guard<std::mutex> lock(queue.lock);
+        queue.tasks.emplace_back(std::move(task));
+        m_dwQueued++;
+    }
+    catch (std::bad_alloc &)
+    {
+        m_dwPending--;
+        return E_OUTOFMEMORY;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_idleLock);
+    }
+    m_idleSignal.notify_one();
+    return S_OK;
+}
+
+void CTaskScheduler::SetIdlePoll(TASK poll, std::chrono::milliseconds interval)
+{
+    m_idlePoll = std::move(poll);
+    m_idlePollInterval = interval;
+}
+
+HRESULT CTaskScheduler::Run()
+{
+    if (!m_queues)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    m_dwNextWorker = 1;
+    if (m_dwWorkerCount <= 1)
+    {
+        WorkerLoop(0);
+    }
+    else if (m_executor.submit)
+    {
+        RunWithSubmit();
+    }
+    else
+    {
+    #ifdef _OPENMP
+        // The team may be smaller than requested, tasks left in the queue of
+        // a missing worker are stolen by the others.
+    #pragma omp parallel num_threads(static_cast<int>(m_dwWorkerCount))
+        {
+            WorkerLoop(static_cast<size_t>(omp_get_thread_num()));
+        }
+    #else
+        RunWithThreads();
+    #endif
+    }
+
+    assert(m_dwPending == 0);
+    return m_hrResult;
+}
+
+HRESULT CTaskScheduler::ParallelFor(size_t dwCount, size_t dwGrain, const RANGETASK &task)
+{
+    if (!dwGrain)
+    {
+        dwGrain = 1;
+    }
+
+    // Spawn the ranges backward, so worker 0 pops them in order and the
+    // thieves start from the end.
+    size_t dwRangeCount = (dwCount + dwGrain - 1) / dwGrain;
+    for (size_t i = dwRangeCount; i > 0; i--)
+    {
+        size_t dwBegin = (i - 1) * dwGrain;
+        size_t dwEnd = std::min(dwBegin + dwGrain, dwCount);
+
+        HRESULT hr = Spawn(0, [this, &task, dwBegin, dwEnd](size_t dwWorker) -> HRESULT
+            {
+                if (IsFailed())
+                {
+                    return S_OK;
+                }
+                return task(dwBegin, dwEnd, dwWorker);
+            });
+        if (FAILED(hr))
+        {
+            HRESULT hrExpected = S_OK;
+            m_hrResult.compare_exchange_strong(hrExpected, hr);
+            break;
+        }
+    }
+    return Run();
+}
+
+HRESULT CTaskScheduler::NestedParallelFor(
+    size_t dwCount,
+    size_t dwGrain,
+    const RANGETASK &task,
+    const DirectX::UVAtlasExecutor *pExecutor)
+{
+    const CURRENTWORKER current = s_currentWorker;
+    if (current.pScheduler)
+    {
+        return current.pScheduler->ParallelForInTask(current.dwWorker, dwCount, dwGrain, task);
+    }
+
+    CTaskScheduler scheduler(pExecutor);
+    return scheduler.ParallelFor(dwCount, dwGrain, task);
+}
+
+size_t CTaskScheduler::GetNestedWorkerCount(const DirectX::UVAtlasExecutor *pExecutor)
+{
+    if (s_currentWorker.pScheduler)
+    {
+        return s_currentWorker.pScheduler->m_dwWorkerCount;
+    }
+    return (pExecutor && pExecutor->maxThreadCount) ? pExecutor->maxThreadCount : GetDefaultWorkerCount();
+}
+
+HRESULT CTaskScheduler::ParallelForInTask(size_t dwWorker, size_t dwCount, size_t dwGrain, const RANGETASK &task)
+{
+    if (!dwGrain)
+    {
+        dwGrain = 1;
+    }
+
+    // The ranges refer to these, they are released only after the last range
+    // finished.
+    std::atomic<size_t> dwRemaining(0);
+    std::atomic<HRESULT> hrGroup(S_OK);
+
+    size_t dwRangeCount = (dwCount + dwGrain - 1) / dwGrain;
+    for (size_t i = dwRangeCount; i > 0; i--)
+    {
+        size_t dwBegin = (i - 1) * dwGrain;
+        size_t dwEnd = std::min(dwBegin + dwGrain, dwCount);
+
+        dwRemaining++;
+        HRESULT hr = Spawn(dwWorker, [this, &task, &dwRemaining, &hrGroup, dwBegin, dwEnd](size_t dwRangeWorker) -> HRESULT
+            {
+                if (SUCCEEDED(hrGroup.load()))
+                {
+                    HRESULT hrRange;
+                    try
+                    {
+                        hrRange = task(dwBegin, dwEnd, dwRangeWorker);
+                    }
+                    catch (std::bad_alloc &)
+                    {
+                        hrRange = E_OUTOFMEMORY;
+                    }
+                    if (FAILED(hrRange))
+                    {
+                        HRESULT hrExpected = S_OK;
+                        hrGroup.compare_exchange_strong(hrExpected, hrRange);
+                    }
+                }
+
+                if (--dwRemaining == 0)
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(m_idleLock);
+                    }
+                    m_idleSignal.notify_all();
+                }
+
+                // The failure is returned by ParallelForInTask(), the calling
+                // task decides what to do with it.
+                return S_OK;
+            });
+        if (FAILED(hr))
+        {
+            dwRemaining--;
+            HRESULT hrExpected = S_OK;
+            hrGroup.compare_exchange_strong(hrExpected, hr);
+            break;
+        }
+    }
+
+    // Run tasks, the ranges or any other, while the ranges are not done.
+    TASK otherTask;
+    while (dwRemaining > 0)
+    {
+        if (PopTask(dwWorker, otherTask) || StealTask(dwWorker, otherTask))
+        {
+            RunTask(dwWorker, otherTask);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_idleLock);
+        WaitForWork(dwWorker, lock, [this, &dwRemaining]()
+            {
+                return m_dwQueued > 0 || dwRemaining == 0;
+            });
+    }
+
+    return hrGroup;
+}
+
+void CTaskScheduler::RunWithSubmit()
+{
+    std::shared_ptr<SUBMITGATE> gate;
+    try
+    {
+        gate = std::make_shared<SUBMITGATE>();
+        for (size_t i = 1; i < m_dwWorkerCount; i++)
+        {
+            m_executor.submit([this, gate]()
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(gate->lock);
+                        if (gate->bClosed)
+                        {
+                            return;
+                        }
+                        gate->dwActive++;
+                    }
+
+                    WorkerLoop(m_dwNextWorker++);
+
+                    std::lock_guard<std::mutex> lock(gate->lock);
+                    if (--gate->dwActive == 0)
+                    {
+                        gate->signal.notify_all();
+                    }
+                });
+        }
+    }
+    catch (...)
+    {
+        // Run with the workers submitted so far.
+    }
+
+    WorkerLoop(0);
+
+    if (gate)
+    {
+        std::unique_lock<std::mutex> lock(gate->lock);
+        gate->bClosed = true;
+        gate->signal.wait(lock, [&gate]() { return gate->dwActive == 0; });
+    }
+}
+
+void CTaskScheduler::RunWithThreads()
+{
+    std::vector<std::thread> threads;
+    try
+    {
+        threads.reserve(m_dwWorkerCount - 1);
+        for (size_t i = 1; i < m_dwWorkerCount; i++)
+        {
+            threads.emplace_back([this]() { WorkerLoop(m_dwNextWorker++); });
+        }
+    }
+    catch (...)
+    {
+        // Run with the threads created so far.
+    }
+
+    WorkerLoop(0);
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+void CTaskScheduler::WorkerLoop(size_t dwWorker)
+{
+    if (dwWorker >= m_dwWorkerCount)
+    {
+        return;
+    }
+
+    const CURRENTWORKER previousWorker = s_currentWorker;
+    s_currentWorker = { this, dwWorker };
+
+    TASK task;
+    for (;;)
+    {
+        if (PopTask(dwWorker, task) || StealTask(dwWorker, task))
+        {
+            RunTask(dwWorker, task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_idleLock);
+        if (m_dwPending == 0)
+        {
+            break;
+        }
+
+        WaitForWork(dwWorker, lock, [this]()
+            {
+                return m_dwQueued > 0 || m_dwPending == 0;
+            });
+    }
+
+    s_currentWorker = previousWorker;
+}
+
+// Waits until isWorkReady returns true. Worker 0 runs the idle poll meanwhile.
+void CTaskScheduler::WaitForWork(
+    size_t dwWorker,
+    std::unique_lock<std::mutex> &lock,
+    const std::function<bool()> &isWorkReady)
+{
+    if (dwWorker != 0 || !m_idlePoll)
+    {
+        m_idleSignal.wait(lock, isWorkReady);
+    }
+    else if (!m_idleSignal.wait_for(lock, m_idlePollInterval, isWorkReady))
+    {
+        lock.unlock();
+
+        HRESULT hr;
+        try
+        {
+            hr = m_idlePoll(dwWorker);
+        }
+        catch (std::bad_alloc &)
+        {
+            hr = E_OUTOFMEMORY;
+        }
+        if (FAILED(hr))
+        {
+            HRESULT hrExpected = S_OK;
+            m_hrResult.compare_exchange_strong(hrExpected, hr);
+        }
+    }
+}
+
+void CTaskScheduler::RunTask(size_t dwWorker, TASK &task)
+{
+    HRESULT hr;
+    try
+    {
+        hr = task(dwWorker);
+    }
+    catch (std::bad_alloc &)
+    {
+        hr = E_OUTOFMEMORY;
+    }
+    task = nullptr;
+    FinishTask(hr);
+}
+
+bool CTaskScheduler::PopTask(size_t dwWorker, TASK &task)
+{
+    TASKQUEUE &queue = m_queues[dwWorker];
+
+    std::lock_guard<std::mutex> lock(queue.lock);
+    if (queue.tasks.empty())
+    {
+        return false;
+    }
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    m_dwQueued--;
+    return true;
+}
+
+bool CTaskScheduler::StealTask(size_t dwWorker, TASK &task)
+{
+    for (size_t i = 1; i < m_dwWorkerCount; i++)
+    {
+        TASKQUEUE &queue = m_queues[(dwWorker + i) % m_dwWorkerCount];
+
+        std::lock_guard<std::mutex> lock(queue.lock);
+        if (!queue.tasks.empty())
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            m_dwQueued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void CTaskScheduler::FinishTask(HRESULT hr)
+{
+    if (FAILED(hr))
+    {
+        HRESULT hrExpected = S_OK;
+        m_hrResult.compare_exchange_strong(hrExpected, hr);
+    }
+
+    if (--m_dwPending == 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_idleLock);
+        }
+        m_idleSignal.notify_all();
+    }
+}
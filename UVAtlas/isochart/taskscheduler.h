@@ -0,0 +1,118 @@
+//-------------------------------------------------------------------------------------
+// UVAtlas - taskscheduler.h
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=512686
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "UVAtlas.h"
+
+namespace Isochart
+{
+    // CTaskScheduler runs a set of tasks which can grow while running, for
+    // example when partitioning a chart produces children which must be
+    // partitioned again.
+    //
+    // Each worker owns a task deque:
+    // -Spawn() pushes a task to the back of the calling worker's deque, and the
+    //  worker pops tasks from the back. So a worker goes depth first through the
+    //  sub-tree it created.
+    // -An idle worker steals from the front of another worker's deque, which
+    //  holds the oldest and usually largest pending task of that worker.
+    //
+    // The calling thread of Run() is always worker 0. The other workers are
+    // taken, by order of preference, from the submit function of the executor,
+    // from an OpenMP parallel region, or from std::thread.
+    //
+    // Run() returns when all tasks, including the ones spawned by running tasks,
+    // have completed. After a task failed, IsFailed() returns true, the pending
+    // tasks still run and are expected to only release their resources.
+    //
+    // NestedParallelFor() splits a loop of a running task over the workers of
+    // its scheduler: the ranges are spawned on the calling worker, which runs
+    // tasks until they are done, so the idle workers steal them without adding
+    // threads.
+    //
+    // SetIdlePoll() gives worker 0 a task to run every interval while it waits
+    // for the others, for example to report progress from the calling thread.
+    // A failure of the poll fails the run as a failed task would.
+    class CTaskScheduler
+    {
+    public:
+        // dwWorker is the index of the worker running the task, it is passed
+        // back to Spawn() to schedule new tasks from inside the task.
+        typedef std::function<HRESULT(size_t dwWorker)> TASK;
+        typedef std::function<HRESULT(size_t dwBegin, size_t dwEnd, size_t dwWorker)> RANGETASK;
+
+        // pExecutor = nullptr uses the default worker count.
+        explicit CTaskScheduler(const DirectX::UVAtlasExecutor *pExecutor = nullptr);
+
+        CTaskScheduler(CTaskScheduler const &) = delete;
+        CTaskScheduler &operator=(CTaskScheduler const &) = delete;
+
+        HRESULT Spawn(size_t dwWorker, TASK task);
+        HRESULT Run();
+
+        void SetIdlePoll(TASK poll, std::chrono::milliseconds interval);
+
+        // Runs task on [0, dwCount), split in ranges of dwGrain items.
+        HRESULT ParallelFor(size_t dwCount, size_t dwGrain, const RANGETASK &task);
+
+        // As ParallelFor(), on the scheduler running the calling task. Called
+        // outside of a task, a scheduler is created with pExecutor.
+        static HRESULT NestedParallelFor(
+            size_t dwCount,
+            size_t dwGrain,
+            const RANGETASK &task,
+            const DirectX::UVAtlasExecutor *pExecutor);
+
+        // The worker indices passed to the task of NestedParallelFor() are
+        // below this count.
+        static size_t GetNestedWorkerCount(const DirectX::UVAtlasExecutor *pExecutor);
+
+        size_t GetWorkerCount() const { return m_dwWorkerCount; }
+        bool IsFailed() const { return FAILED(m_hrResult.load()); }
+
+        static size_t GetDefaultWorkerCount();
+
+    private:
+        struct TASKQUEUE
+        {
+            std::mutex lock;
+            std::deque<TASK> tasks;
+        };
+
+        void RunWithSubmit();
+        void RunWithThreads();
+
+        void WorkerLoop(size_t dwWorker);
+        void WaitForWork(
+            size_t dwWorker,
+            std::unique_lock<std::mutex> &lock,
+            const std::function<bool()> &isWorkReady);
+        void RunTask(size_t dwWorker, TASK &task);
+        HRESULT ParallelForInTask(size_t dwWorker, size_t dwCount, size_t dwGrain, const RANGETASK &task);
+        bool PopTask(size_t dwWorker, TASK &task);
+        bool StealTask(size_t dwWorker, TASK &task);
+        void FinishTask(HRESULT hr);
+
+        DirectX::UVAtlasExecutor m_executor;
+        size_t m_dwWorkerCount;
+        std::unique_ptr<TASKQUEUE[]> m_queues;
+
+        std::atomic<size_t> m_dwPending; // Spawned tasks not finished yet
+        std::atomic<size_t> m_dwQueued;  // Spawned tasks not started yet
+        std::atomic<size_t> m_dwNextWorker;
+        std::atomic<HRESULT> m_hrResult;
+
+        std::mutex m_idleLock;
+        std::condition_variable m_idleSignal;
+
+        TASK m_idlePoll;
+        std::chrono::milliseconds m_idlePollInterval;
+    };
+}
@@ -210,6 +210,16 @@ namespace Isochart
             return m_size;
         }
 
+        // removes all the items at once, without deleting them
+        void clear()
+        {
+            for (size_t i = 0; i < m_size; ++i)
+            {
+                m_items[i]->m_position = NOT_IN_HEAP;
+            }
+            m_size = 0;
+        }
+
         bool empty()
         {
             return (m_size == 0);
@@ -332,4 +342,178 @@ namespace Isochart
         bool m_bAutoMangeMemory;
         size_t m_size;
     };
+
+    // CMaxHeap of the items [0, n), such as the vertices of a mesh, with the
+    // weights stored in the heap entries instead of separate CMaxHeapItems.
+    // It moves the entries exactly as CMaxHeap does, so items of equal weight
+    // are cut in the same order.
+    template <class Ty1>
+    class CMaxIndexHeap
+    {
+    public:
+        typedef Ty1 weight_type;
+
+        CMaxIndexHeap() : m_size(0)
+        {}
+
+        // Empties the heap and sets the number of items
+        bool resize(size_t newsize)
+        {
+            try
+            {
+                m_entries.resize(newsize);
+                m_positions.assign(newsize, NOT_IN_HEAP_INDEX);
+            }
+            catch (std::bad_alloc &)
+            {
+                return false;
+            }
+            m_size = 0;
+            return true;
+        }
+
+        bool isItemInHeap(uint32_t item) const
+        {
+            return m_positions[item] != NOT_IN_HEAP_INDEX;
+        }
+
+        void insert(uint32_t item, weight_type weight)
+        {
+            assert(m_size < m_entries.size());
+            assert(!isItemInHeap(item));
+
+            m_entries[m_size].weight = weight;
+            m_entries[m_size].item = item;
+            m_positions[item] = static_cast<uint32_t>(m_size);
+            m_size++;
+
+            upheap(m_size - 1);
+        }
+
+        void update(uint32_t item, weight_type newweight)
+        {
+            uint32_t i = m_positions[item];
+            if (i == NOT_IN_HEAP_INDEX)
+            {
+                return;
+            }
+            weight_type oldweight = m_entries[i].weight;
+            m_entries[i].weight = newweight;
+            if (newweight < oldweight)
+            {
+                downheap(i);
+            }
+            else
+            {
+                upheap(i);
+            }
+        }
+
+        bool cutTop(uint32_t &item)
+        {
+            if (m_size == 0)
+            {
+                return false;
+            }
+
+            swapnode(0, m_size - 1);
+            m_size--;
+            item = m_entries[m_size].item;
+            m_positions[item] = NOT_IN_HEAP_INDEX;
+
+            if (m_entries[0].weight < m_entries[m_size].weight)
+            {
+                downheap(0);
+            }
+            else
+            {
+                upheap(0);
+            }
+            return true;
+        }
+
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        bool empty() const
+        {
+            return (m_size == 0);
+        }
+
+    private:
+        static constexpr uint32_t NOT_IN_HEAP_INDEX = 0xffffffff;
+
+        struct ENTRY
+        {
+            weight_type weight;
+            uint32_t item;
+        };
+
+        void swapnode(size_t i, size_t j)
+        {
+            if (i == j)
+                return;
+
+            std::swap(m_entries[i], m_entries[j]);
+            m_positions[m_entries[i].item] = static_cast<uint32_t>(i);
+            m_positions[m_entries[j].item] = static_cast<uint32_t>(j);
+        }
+
+        void downheap(size_t i)
+        {
+            while (i < m_size)
+            {
+                size_t larger = i;
+
+                size_t left = (i << 1) + 1;
+                size_t right = (i << 1) + 2;
+
+                weight_type maxweight = m_entries[i].weight;
+
+                if (left < m_size && m_entries[left].weight > maxweight)
+                {
+                    larger = left;
+                    maxweight = m_entries[left].weight;
+                }
+                if (right < m_size && m_entries[right].weight > maxweight)
+                {
+                    larger = right;
+                }
+
+                if (larger != i)
+                {
+                    swapnode(i, larger);
+                    i = larger;
+                }
+                else
+                {
+                    break;
+                }
+            }
+        }
+
+        void upheap(size_t i)
+        {
+            while (i > 0)
+            {
+                size_t parentPos = (i - 1) >> 1;
+                if (m_entries[i].weight > m_entries[parentPos].weight)
+                {
+                    swapnode(i, parentPos);
+                    i = parentPos;
+                }
+                else
+                {
+                    break;
+                }
+            }
+        }
+
+    private:
+        std::vector<ENTRY> m_entries;
+        std::vector<uint32_t> m_positions;
+        size_t m_size;
+    };
 }
@@ -85,19 +85,25 @@
 #include <cmath>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cfloat>
+#include <chrono>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
 #include <cstring>
+#include <condition_variable>
+#include <deque>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <new>
 #include <utility>
 #include <vector>
 #include <queue>
+#include <thread>
 #include <tuple>
 
 #ifdef UVATLAS_USE_EIGEN
@@ -121,11 +127,6 @@
 #pragma warning(pop)
 #endif
 
-#ifndef _WIN32
-#include <mutex>
-#include <thread>
-#endif
-
 #define _XM_NO_XMVECTOR_OVERLOADS_
 
 #include <DirectXMath.h>
@@ -169,3 +170,6 @@ extern void __cdecl UVAtlasDebugPrintf(unsigned int lvl, _In_z_ _Printf_format_s
 
 // HRESULT_FROM_WIN32(ERROR_INVALID_DATA)
 #define HRESULT_E_INVALID_DATA static_cast<HRESULT>(0x8007000DL)
+
+// HRESULT_FROM_WIN32(ERROR_TIMEOUT)
+#define HRESULT_E_TIMEOUT static_cast<HRESULT>(0x800705B4L)
@@ -109,6 +109,7 @@ namespace
         OPT_MAXSTRETCH,
         OPT_LIMIT_MERGE_STRETCH,
         OPT_LIMIT_FACE_STRETCH,
+        OPT_CG_PRECONDITIONER,
         OPT_GUTTER,
         OPT_WIDTH,
         OPT_HEIGHT,
@@ -161,6 +162,7 @@ namespace
         { L"st",        OPT_MAXSTRETCH },
         { L"lms",       OPT_LIMIT_MERGE_STRETCH },
         { L"lfs",       OPT_LIMIT_FACE_STRETCH },
+        { L"cg",        OPT_CG_PRECONDITIONER },
         { L"g",         OPT_GUTTER },
         { L"w",         OPT_WIDTH },
         { L"h",         OPT_HEIGHT },
@@ -208,6 +210,7 @@ namespace
 
     const SValue<uint64_t> g_pOptionsLong[] =
     {
+        { L"cg-preconditioner",         OPT_CG_PRECONDITIONER },
         { L"clockwise",                 OPT_CLOCKWISE },
         { L"color-format",              OPT_VERT_COLOR_FORMAT },
         { L"color-mesh",                OPT_COLOR_MESH },
@@ -328,11 +331,13 @@ namespace
             L"   -flist <filename>, --file-list <filename>\n"
             L"                       use text file with a list of input files (one per line)\n"
             L"\n"
-            L"   -q <level>, --quality <level>       sets quality level to DEFAULT, FAST or QUALITY\n"
+            L"   -q <level>, --quality <level>       sets quality level to DEFAULT, FAST, QUALITY, ADAPTIVE, HEAT or COARSE\n"
             L"   -n <number>, --max-charts <number>  maximum number of charts to generate (def: 0)\n"
             L"   -st <float>, --max-stretch <float>  maximum amount of stretch 0.0 to 1.0 (def: 0.16667)\n"
             L"   -lms, --limit-merge-stretch         enable limit merge stretch option\n"
             L"   -lfs, --limit-face-stretch          enable limit face stretch option\n"
+            L"   -cg <name>, --cg-preconditioner <name>\n"
+            L"                       sets the solver preconditioner to DEFAULT, NONE, JACOBI, IC0 or SSOR\n"
             L"   -g <float>, --gutter-width <float>  the gutter width betwen charts in texels (def: 2.0)\n"
             L"   -w <number>, --width <number>       texture width (def: 512)\n"
             L"   -h <number>, --height <number>      texture height (def: 512)\n"
@@ -435,6 +440,7 @@ int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
     CHANNELS perVertex = CHANNELS::NONE;
     UVATLAS uvOptions = UVATLAS_DEFAULT;
     UVATLAS uvOptionsEx = UVATLAS_DEFAULT;
+    UVATLAS uvPreconditioner = UVATLAS_DEFAULT;
     DXGI_FORMAT normalFormat = DXGI_FORMAT_R32G32B32_FLOAT;
     DXGI_FORMAT uvFormat = DXGI_FORMAT_R32G32_FLOAT;
     DXGI_FORMAT colorFormat = DXGI_FORMAT_B8G8R8A8_UNORM;
@@ -520,6 +526,7 @@ int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
             case OPT_MAXSTRETCH:
             case OPT_LIMIT_MERGE_STRETCH:
             case OPT_LIMIT_FACE_STRETCH:
+            case OPT_CG_PRECONDITIONER:
             case OPT_GUTTER:
             case OPT_WIDTH:
             case OPT_HEIGHT:
@@ -562,6 +569,7 @@ int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
             case OPT_QUALITY:
             case OPT_MAXCHARTS:
             case OPT_MAXSTRETCH:
+            case OPT_CG_PRECONDITIONER:
             case OPT_GUTTER:
             case OPT_WIDTH:
             case OPT_HEIGHT:
@@ -606,6 +614,18 @@ int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
                 {
                     uvOptions = UVATLAS_GEODESIC_QUALITY;
                 }
+                else if (!_wcsicmp(pValue, L"ADAPTIVE"))
+                {
+                    uvOptions = UVATLAS_GEODESIC_ADAPTIVE;
+                }
+                else if (!_wcsicmp(pValue, L"HEAT"))
+                {
+                    uvOptions = UVATLAS_GEODESIC_HEAT;
+                }
+                else if (!_wcsicmp(pValue, L"COARSE"))
+                {
+                    uvOptions = UVATLAS_GEODESIC_COARSE;
+                }
                 else
                 {
                     wprintf(L"Invalid value specified with -q (%ls)\n", pValue);
@@ -621,6 +641,34 @@ int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
                 uvOptionsEx |= UVATLAS_LIMIT_FACE_STRETCH;
                 break;
 
+            case OPT_CG_PRECONDITIONER:
+                if (!_wcsicmp(pValue, L"DEFAULT"))
+                {
+                    uvPreconditioner = UVATLAS_DEFAULT;
+                }
+                else if (!_wcsicmp(pValue, L"NONE"))
+                {
+                    uvPreconditioner = UVATLAS_CG_UNPRECONDITIONED;
+                }
+                else if (!_wcsicmp(pValue, L"JACOBI"))
+                {
+                    uvPreconditioner = UVATLAS_CG_JACOBI;
+                }
+                else if (!_wcsicmp(pValue, L"IC0"))
+                {
+                    uvPreconditioner = UVATLAS_CG_IC0;
+                }
+                else if (!_wcsicmp(pValue, L"SSOR"))
+                {
+                    uvPreconditioner = UVATLAS_CG_SSOR;
+                }
+                else
+                {
+                    wprintf(L"Invalid value specified with -cg (%ls)\n", pValue);
+                    return 1;
+                }
+                break;
+
             case OPT_MAXCHARTS:
                 if (swscanf_s(pValue, L"%zu", &maxCharts) != 1)
                 {
@@ -1269,7 +1317,7 @@ int __cdecl wmain(_In_ int argc, _In_z_count_(argc) wchar_t* argv[])
             inMesh->GetAdjacencyBuffer(), nullptr,
             IMTData.get(),
             UVAtlasCallback, UVATLAS_DEFAULT_CALLBACK_FREQUENCY,
-            uvOptions | uvOptionsEx, vb, ib,
+            uvOptions | uvOptionsEx | uvPreconditioner, vb, ib,
             &facePartitioning,
             &vertexRemapArray,
             &outStretch, &outCharts);